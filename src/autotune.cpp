@@ -0,0 +1,98 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "autotune.h"
+
+#include <stdio.h>
+#include <map>
+#include <string>
+
+namespace ncnn {
+
+static Mutex g_autotune_lock;
+static std::map<std::string, int> g_autotune_choices;
+
+int get_autotune_choice(const char* key)
+{
+    MutexLockGuard lock(g_autotune_lock);
+
+    std::map<std::string, int>::const_iterator it = g_autotune_choices.find(key);
+    if (it == g_autotune_choices.end())
+        return -1;
+
+    return it->second;
+}
+
+void set_autotune_choice(const char* key, int choice)
+{
+    MutexLockGuard lock(g_autotune_lock);
+
+    g_autotune_choices[key] = choice;
+}
+
+void clear_autotune_cache()
+{
+    MutexLockGuard lock(g_autotune_lock);
+
+    g_autotune_choices.clear();
+}
+
+#if NCNN_STDIO
+int load_autotune_cache(const char* path)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", path);
+        return -1;
+    }
+
+    MutexLockGuard lock(g_autotune_lock);
+
+    char key[256];
+    int choice;
+    while (fscanf(fp, "%255s %d", key, &choice) == 2)
+    {
+        g_autotune_choices[key] = choice;
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+
+int save_autotune_cache(const char* path)
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", path);
+        return -1;
+    }
+
+    MutexLockGuard lock(g_autotune_lock);
+
+    std::map<std::string, int>::const_iterator it = g_autotune_choices.begin();
+    for (; it != g_autotune_choices.end(); it++)
+    {
+        fprintf(fp, "%s %d\n", it->first.c_str(), it->second);
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+#endif // NCNN_STDIO
+
+} // namespace ncnn
@@ -0,0 +1,49 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef NCNN_AUTOTUNE_H
+#define NCNN_AUTOTUNE_H
+
+#include "platform.h"
+
+namespace ncnn {
+
+// with Option::use_autotune enabled, a layer times its candidate implementations
+// on the first forward of each layer shape and input shape, and keeps the fastest one
+// the choices live in a process wide cache keyed by the shape description
+
+// get the implementation chosen for key
+// return -1 if key is not tuned yet
+int get_autotune_choice(const char* key);
+
+// record the implementation chosen for key
+void set_autotune_choice(const char* key, int choice);
+
+// forget all choices
+void clear_autotune_cache();
+
+#if NCNN_STDIO
+// load choices saved by save_autotune_cache, existing choices of the same key are replaced
+// the choices depend on the machine, keep one cache file per host
+// return 0 if success
+int load_autotune_cache(const char* path);
+
+// save all choices as text, one key and implementation per line
+// return 0 if success
+int save_autotune_cache(const char* path);
+#endif // NCNN_STDIO
+
+} // namespace ncnn
+
+#endif // NCNN_AUTOTUNE_H
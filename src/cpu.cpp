@@ -28,6 +28,14 @@
 #include <stdint.h>
 #endif
 
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#define __X86__ 1
+#elif defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#define __X86__ 1
+#endif
+
 #if __APPLE__
 #include "TargetConditionals.h"
 #if TARGET_OS_IPHONE
@@ -191,6 +199,113 @@ int cpu_support_arm_asimdhp()
 #endif
 }
 
+#if __X86__
+static void x86_cpuid(int level, int sublevel, unsigned int cpuinfo[4])
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    __cpuidex((int*)cpuinfo, level, sublevel);
+#else
+    __cpuid_count(level, sublevel, cpuinfo[0], cpuinfo[1], cpuinfo[2], cpuinfo[3]);
+#endif
+}
+
+static unsigned long long x86_get_xcr0()
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0;
+    unsigned int edx = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+static int get_cpu_support_x86_avx512()
+{
+    unsigned int cpuinfo[4] = {0};
+
+    x86_cpuid(0, 0, cpuinfo);
+    if (cpuinfo[0] < 7)
+        return 0;
+
+    x86_cpuid(1, 0, cpuinfo);
+    // fma osxsave
+    if (!(cpuinfo[2] & (1u << 12)) || !(cpuinfo[2] & (1u << 27)))
+        return 0;
+
+    // xmm ymm opmask zmm_hi256 hi16_zmm state saved by os
+    if ((x86_get_xcr0() & 0xe6) != 0xe6)
+        return 0;
+
+    x86_cpuid(7, 0, cpuinfo);
+    // avx512f
+    return (cpuinfo[1] & (1u << 16)) ? 1 : 0;
+}
+
+static int g_cpu_support_x86_avx512 = get_cpu_support_x86_avx512();
+
+static int get_cpu_support_x86_avx512_vnni()
+{
+    if (!get_cpu_support_x86_avx512())
+        return 0;
+
+    unsigned int cpuinfo[4] = {0};
+
+    x86_cpuid(7, 0, cpuinfo);
+    // avx512_vnni
+    return (cpuinfo[2] & (1u << 11)) ? 1 : 0;
+}
+
+static int g_cpu_support_x86_avx512_vnni = get_cpu_support_x86_avx512_vnni();
+
+static int get_cpu_support_x86_f16c()
+{
+    unsigned int cpuinfo[4] = {0};
+
+    x86_cpuid(0, 0, cpuinfo);
+    if (cpuinfo[0] < 1)
+        return 0;
+
+    x86_cpuid(1, 0, cpuinfo);
+    // fma osxsave avx f16c
+    if (!(cpuinfo[2] & (1u << 12)) || !(cpuinfo[2] & (1u << 27)) || !(cpuinfo[2] & (1u << 28)) || !(cpuinfo[2] & (1u << 29)))
+        return 0;
+
+    // xmm ymm state saved by os
+    return (x86_get_xcr0() & 6) == 6 ? 1 : 0;
+}
+
+static int g_cpu_support_x86_f16c = get_cpu_support_x86_f16c();
+#endif // __X86__
+
+int cpu_support_x86_avx512()
+{
+#if __X86__
+    return g_cpu_support_x86_avx512;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_avx512_vnni()
+{
+#if __X86__
+    return g_cpu_support_x86_avx512_vnni;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_f16c()
+{
+#if __X86__
+    return g_cpu_support_x86_f16c;
+#else
+    return 0;
+#endif
+}
+
 static int get_cpucount()
 {
 #ifdef __ANDROID__
@@ -24,6 +24,12 @@ int cpu_support_arm_neon();
 int cpu_support_arm_vfpv4();
 // asimdhp = aarch64 asimd half precision
 int cpu_support_arm_asimdhp();
+// avx512 = x86 avx512f + fma with zmm state enabled by os
+int cpu_support_x86_avx512();
+// avx512vnni = x86 avx512f + avx512 vnni with zmm state enabled by os
+int cpu_support_x86_avx512_vnni();
+// f16c = x86 avx + f16c + fma with ymm state enabled by os
+int cpu_support_x86_f16c();
 
 // cpu info
 int get_cpu_count();
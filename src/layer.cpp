@@ -37,6 +37,7 @@ Layer::Layer()
     support_inplace = false;
     support_vulkan = false;
     support_packing = false;
+    support_fp16_storage = false;
 
 #if NCNN_VULKAN
     vkdev = 0;
@@ -70,6 +70,9 @@ public:
     // accept input blob with packed storage
     bool support_packing;
 
+    // accept fp16 input blob and keep it fp16 for cpu inference
+    bool support_fp16_storage;
+
 public:
     // implement inference
     // return 0 if success
@@ -33,6 +33,7 @@ int Cast::load_param(const ParamDict& pd)
 }
 
 // convert float to half precision floating point
+// round to nearest even, the same as the f16c instructions
 static unsigned short float32_to_float16(float value)
 {
     // 1 : 8 : 23
@@ -60,8 +61,8 @@ static unsigned short float32_to_float16(float value)
     }
     else if (exponent == 0xFF)
     {
-        // infinity or NaN
-        fp16 = (sign << 15) | (0x1F << 10) | (significand ? 0x200 : 0x00);
+        // infinity or NaN, NaN keeps the high payload bits and becomes quiet
+        fp16 = (sign << 15) | (0x1F << 10) | (significand ? (0x200 | (significand >> 13)) : 0x00);
     }
     else
     {
@@ -75,11 +76,18 @@ static unsigned short float32_to_float16(float value)
         else if (newexp <= 0)
         {
             // underflow
-            if (newexp >= -10)
+            if (newexp >= -11)
             {
-                // denormal half-precision
-                unsigned short sig = (significand | 0x800000) >> (14 - newexp);
-                fp16 = (sign << 15) | (0x00 << 10) | sig;
+                // denormal half-precision, rounding up the largest one gives the smallest normal
+                unsigned int shift = 14 - newexp;
+                unsigned int full = significand | 0x800000;
+                unsigned int sig = full >> shift;
+                unsigned int rem = full & ((1u << shift) - 1);
+                unsigned int halfway = 1u << (shift - 1);
+                if (rem > halfway || (rem == halfway && (sig & 1)))
+                    sig++;
+
+                fp16 = (sign << 15) | sig;
             }
             else
             {
@@ -89,7 +97,13 @@ static unsigned short float32_to_float16(float value)
         }
         else
         {
-            fp16 = (sign << 15) | (newexp << 10) | (significand >> 13);
+            // the carry of rounding up may reach the exponent, up to infinity
+            unsigned short h = (newexp << 10) | (significand >> 13);
+            unsigned int rem = significand & 0x1FFF;
+            if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+                h++;
+
+            fp16 = (sign << 15) | h;
         }
     }
 
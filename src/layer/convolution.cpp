@@ -203,6 +203,17 @@ int Convolution::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int Convolution::create_depthwise_fusion(const ConvolutionDepthWise* /*depthwise*/, const Convolution* /*expand*/, const Option& /*opt*/)
+{
+    // not supported by the generic implementation
+    return -1;
+}
+
+Mat Convolution::get_sgemm_weight_data() const
+{
+    return Mat();
+}
+
 int Convolution::create_requantize_op(void)
 {
     if (!use_int8_requantize)
@@ -19,6 +19,7 @@
 
 namespace ncnn {
 
+class ConvolutionDepthWise;
 class Convolution : public Layer
 {
 public:
@@ -33,6 +34,16 @@ public:
 
     virtual int create_requantize_op(void);
 
+    // run the depthwise convolution feeding this 1x1 convolution,
+    // and the optional 1x1 expand convolution before it, inside this layer
+    // return 0 if the block is supported and this layer takes the block input
+    virtual int create_depthwise_fusion(const ConvolutionDepthWise* depthwise, const Convolution* expand, const Option& opt);
+
+    // the weight this layer transformed for its 1x1 sgemm kernel,
+    // shared with the projection that fuses this layer as the expand
+    // empty if the implementation keeps none
+    virtual Mat get_sgemm_weight_data() const;
+
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
 public:
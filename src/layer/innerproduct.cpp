@@ -81,7 +81,7 @@ int InnerProduct::create_pipeline(const Option& opt)
         return -1;
     }
 
-    // initial the quantize,dequantize op layer
+    // initial the quantize op layer
     if (use_int8_inference)
     {
         quantize = ncnn::create_layer(ncnn::LayerType::Quantize);
@@ -93,33 +93,6 @@ int InnerProduct::create_pipeline(const Option& opt)
 
             quantize->create_pipeline(opt_cpu);
         }
-
-        dequantize_ops.resize(num_output);
-        for (int n=0; n<num_output; n++)
-        {
-            dequantize_ops[n] = ncnn::create_layer(ncnn::LayerType::Dequantize);
-
-            float top_rescale = 1.f;
-
-            if (weight_data_int8_scales[n] == 0)
-                top_rescale = 0;
-            else
-                top_rescale = 1.f / (bottom_blob_int8_scale * weight_data_int8_scales[n]);
-
-            ncnn::ParamDict pd;
-            pd.set(0, top_rescale);// scale
-            pd.set(1, bias_term);  // bias_term
-            pd.set(2, 1);          // bias_data_size
-
-            dequantize_ops[n]->load_param(pd);
-
-            ncnn::Mat weights[1];
-            weights[0] = bias_data.range(n, 1);
-
-            dequantize_ops[n]->load_model(ModelBinFromMatArray(weights));
-
-            dequantize_ops[n]->create_pipeline(opt_cpu);
-        }
     }
 
     // runtime quantize the weight data
@@ -171,13 +144,6 @@ int InnerProduct::destroy_pipeline(const Option& opt)
         quantize = 0;
     }
 
-    for (int i=0; i<(int)dequantize_ops.size(); i++)
-    {
-        dequantize_ops[i]->destroy_pipeline(opt_cpu);
-        delete dequantize_ops[i];
-    }
-    dequantize_ops.clear();
-
     return 0;
 }
 
@@ -56,7 +56,6 @@ public:
     bool use_int8_inference;
 
     ncnn::Layer* quantize;
-    std::vector<ncnn::Layer*> dequantize_ops;
 };
 
 } // namespace ncnn
@@ -0,0 +1,787 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "binaryop_x86.h"
+#include "x86_elementwise.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(BinaryOp_x86)
+
+BinaryOp_x86::BinaryOp_x86()
+{
+    // the result is written over the first blob when it has the output shape
+    support_inplace = true;
+}
+
+// outptr[i] = op(ptr[i], ptr1[i])
+template<typename Op>
+static void binary_op_vector_vector(const float* ptr, const float* ptr1, float* outptr, int size, const Op& op)
+{
+    int i = 0;
+#if __AVX__
+    for (; i+7<size; i+=8)
+    {
+        _mm256_storeu_ps(outptr, op.func_pack8(_mm256_loadu_ps(ptr), _mm256_loadu_ps(ptr1)));
+        ptr += 8;
+        ptr1 += 8;
+        outptr += 8;
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; i+3<size; i+=4)
+    {
+        _mm_storeu_ps(outptr, op.func_pack4(_mm_loadu_ps(ptr), _mm_loadu_ps(ptr1)));
+        ptr += 4;
+        ptr1 += 4;
+        outptr += 4;
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        *outptr++ = op.func(*ptr++, *ptr1++);
+    }
+}
+
+// outptr[i] = op(ptr[i], b)
+template<typename Op>
+static void binary_op_vector_scalar(const float* ptr, float b, float* outptr, int size, const Op& op)
+{
+    int i = 0;
+#if __AVX__
+    __m256 _b_avx = _mm256_set1_ps(b);
+    for (; i+7<size; i+=8)
+    {
+        _mm256_storeu_ps(outptr, op.func_pack8(_mm256_loadu_ps(ptr), _b_avx));
+        ptr += 8;
+        outptr += 8;
+    }
+#endif // __AVX__
+#if __SSE2__
+    __m128 _b = _mm_set1_ps(b);
+    for (; i+3<size; i+=4)
+    {
+        _mm_storeu_ps(outptr, op.func_pack4(_mm_loadu_ps(ptr), _b));
+        ptr += 4;
+        outptr += 4;
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        *outptr++ = op.func(*ptr++, b);
+    }
+}
+
+// outptr[i] = op(a, ptr1[i])
+template<typename Op>
+static void binary_op_scalar_vector(float a, const float* ptr1, float* outptr, int size, const Op& op)
+{
+    int i = 0;
+#if __AVX__
+    __m256 _a_avx = _mm256_set1_ps(a);
+    for (; i+7<size; i+=8)
+    {
+        _mm256_storeu_ps(outptr, op.func_pack8(_a_avx, _mm256_loadu_ps(ptr1)));
+        ptr1 += 8;
+        outptr += 8;
+    }
+#endif // __AVX__
+#if __SSE2__
+    __m128 _a = _mm_set1_ps(a);
+    for (; i+3<size; i+=4)
+    {
+        _mm_storeu_ps(outptr, op.func_pack4(_a, _mm_loadu_ps(ptr1)));
+        ptr1 += 4;
+        outptr += 4;
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        *outptr++ = op.func(a, *ptr1++);
+    }
+}
+
+// broadcasting rule
+// https://github.com/Tencent/ncnn/wiki/binaryop-broadcasting
+
+template<typename Op>
+static int binary_op(const Mat& a, const Mat& b, Mat& c, const Option& opt)
+{
+    Op op;
+
+    int w = a.w;
+    int h = a.h;
+    int channels = a.c;
+    int size = w * h;
+    size_t elemsize = a.elemsize;
+
+    int w1 = b.w;
+    int h1 = b.h;
+    int channels1 = b.c;
+    int size1 = w1 * h1;
+
+    if (a.dims == 3)
+    {
+        c.create(w, h, channels, elemsize, opt.blob_allocator);
+        if (c.empty())
+            return -100;
+
+        if (b.dims == 3)
+        {
+            if (b.w == 1 && b.h == 1)
+            {
+                // special type 1
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q=0; q<channels; q++)
+                {
+                    const float* b0 = b.channel(q);
+                    binary_op_vector_scalar(a.channel(q), b0[0], c.channel(q), size, op);
+                }
+
+                return 0;
+            }
+
+            // type 19
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                binary_op_vector_vector(a.channel(q), b.channel(q), c.channel(q), size, op);
+            }
+
+            return 0;
+        }
+
+        if (b.dims == 2)
+        {
+            // type 18
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const float* ptr = a.channel(q);
+                const float* ptr1 = b.row(q);
+                float* outptr = c.channel(q);
+
+                for (int y=0; y<h; y++)
+                {
+                    binary_op_vector_scalar(ptr, ptr1[y], outptr, w, op);
+
+                    ptr += w;
+                    outptr += w;
+                }
+            }
+
+            return 0;
+        }
+
+        if (b.dims == 1)
+        {
+            if (b.w == 1)
+            {
+                // type 16
+                const float b0 = b[0];
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q=0; q<channels; q++)
+                {
+                    binary_op_vector_scalar(a.channel(q), b0, c.channel(q), size, op);
+                }
+
+                return 0;
+            }
+
+            // type 17
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                binary_op_vector_scalar(a.channel(q), b[q], c.channel(q), size, op);
+            }
+
+            return 0;
+        }
+    }
+    else if (a.dims == 2)
+    {
+        if (b.dims == 3)
+        {
+            // type 14
+            c.create(w1, h1, channels1, elemsize, opt.blob_allocator);
+            if (c.empty())
+                return -100;
+
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels1; q++)
+            {
+                const float* ptr = a.row(q);
+                const float* ptr1 = b.channel(q);
+                float* outptr = c.channel(q);
+
+                for (int y=0; y<h1; y++)
+                {
+                    binary_op_scalar_vector(ptr[y], ptr1, outptr, w1, op);
+
+                    ptr1 += w1;
+                    outptr += w1;
+                }
+            }
+
+            return 0;
+        }
+
+        c.create(w, h, elemsize, opt.blob_allocator);
+        if (c.empty())
+            return -100;
+
+        if (b.dims == 2)
+        {
+            // type 13
+            binary_op_vector_vector(a, b, c, size, op);
+
+            return 0;
+        }
+
+        if (b.dims == 1)
+        {
+            if (b.w == 1)
+            {
+                // type 11
+                binary_op_vector_scalar(a, b[0], c, size, op);
+
+                return 0;
+            }
+
+            // type 12
+            const float* ptr = a;
+            float* outptr = c;
+
+            for (int y=0; y<h; y++)
+            {
+                binary_op_vector_scalar(ptr, b[y], outptr, w, op);
+
+                ptr += w;
+                outptr += w;
+            }
+
+            return 0;
+        }
+    }
+    else if (a.dims == 1)
+    {
+        if (a.w == 1)
+        {
+            if (b.dims == 3)
+            {
+                // type 4
+                c.create(w1, h1, channels1, elemsize, opt.blob_allocator);
+                if (c.empty())
+                    return -100;
+
+                const float a0 = a[0];
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q=0; q<channels1; q++)
+                {
+                    binary_op_scalar_vector(a0, b.channel(q), c.channel(q), size1, op);
+                }
+
+                return 0;
+            }
+
+            if (b.dims == 2)
+            {
+                // type 3
+                c.create(w1, h1, elemsize, opt.blob_allocator);
+                if (c.empty())
+                    return -100;
+
+                binary_op_scalar_vector(a[0], b, c, size1, op);
+
+                return 0;
+            }
+
+            if (b.dims == 1)
+            {
+                // type 2
+                c.create(w1, elemsize, opt.blob_allocator);
+                if (c.empty())
+                    return -100;
+
+                binary_op_scalar_vector(a[0], b, c, w1, op);
+
+                return 0;
+            }
+        }
+
+        if (b.dims == 3)
+        {
+            // type 9
+            c.create(w1, h1, channels1, elemsize, opt.blob_allocator);
+            if (c.empty())
+                return -100;
+
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels1; q++)
+            {
+                binary_op_scalar_vector(a[q], b.channel(q), c.channel(q), size1, op);
+            }
+
+            return 0;
+        }
+
+        if (b.dims == 2)
+        {
+            // type 8
+            c.create(w1, h1, elemsize, opt.blob_allocator);
+            if (c.empty())
+                return -100;
+
+            const float* ptr1 = b;
+            float* outptr = c;
+
+            for (int y=0; y<h1; y++)
+            {
+                binary_op_scalar_vector(a[y], ptr1, outptr, w1, op);
+
+                ptr1 += w1;
+                outptr += w1;
+            }
+
+            return 0;
+        }
+
+        if (b.dims == 1)
+        {
+            c.create(w, elemsize, opt.blob_allocator);
+            if (c.empty())
+                return -100;
+
+            if (b.w == 1)
+            {
+                // type 6
+                binary_op_vector_scalar(a, b[0], c, w, op);
+
+                return 0;
+            }
+
+            // type 7
+            binary_op_vector_vector(a, b, c, w, op);
+        }
+    }
+
+    return 0;
+}
+
+// the broadcast types where the output takes the shape of a
+static bool binary_op_output_is_a(const Mat& a, const Mat& b)
+{
+    if (a.dims > b.dims)
+        return true;
+
+    if (a.dims < b.dims)
+        return false;
+
+    // type 2
+    if (a.dims == 1 && a.w == 1 && b.w != 1)
+        return false;
+
+    return true;
+}
+
+template<typename Op>
+static int binary_op_inplace(Mat& a, const Mat& b, const Option& opt)
+{
+    Op op;
+
+    int w = a.w;
+    int h = a.h;
+    int channels = a.c;
+    int size = w * h;
+
+    if (a.dims == 3)
+    {
+        if (b.dims == 3)
+        {
+            if (b.w == 1 && b.h == 1)
+            {
+                // special type 1
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q=0; q<channels; q++)
+                {
+                    float* ptr = a.channel(q);
+                    const float* b0 = b.channel(q);
+                    binary_op_vector_scalar(ptr, b0[0], ptr, size, op);
+                }
+
+                return 0;
+            }
+
+            // type 19
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                float* ptr = a.channel(q);
+                binary_op_vector_vector(ptr, b.channel(q), ptr, size, op);
+            }
+
+            return 0;
+        }
+
+        if (b.dims == 2)
+        {
+            // type 18
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                float* ptr = a.channel(q);
+                const float* ptr1 = b.row(q);
+
+                for (int y=0; y<h; y++)
+                {
+                    binary_op_vector_scalar(ptr, ptr1[y], ptr, w, op);
+
+                    ptr += w;
+                }
+            }
+
+            return 0;
+        }
+
+        if (b.dims == 1)
+        {
+            // type 16 and 17
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                float* ptr = a.channel(q);
+                const float b0 = b.w == 1 ? b[0] : b[q];
+                binary_op_vector_scalar(ptr, b0, ptr, size, op);
+            }
+
+            return 0;
+        }
+    }
+    else if (a.dims == 2)
+    {
+        float* ptr = a;
+
+        if (b.dims == 2)
+        {
+            // type 13
+            binary_op_vector_vector(ptr, b, ptr, size, op);
+
+            return 0;
+        }
+
+        if (b.dims == 1)
+        {
+            if (b.w == 1)
+            {
+                // type 11
+                binary_op_vector_scalar(ptr, b[0], ptr, size, op);
+
+                return 0;
+            }
+
+            // type 12
+            for (int y=0; y<h; y++)
+            {
+                binary_op_vector_scalar(ptr, b[y], ptr, w, op);
+
+                ptr += w;
+            }
+
+            return 0;
+        }
+    }
+    else if (a.dims == 1)
+    {
+        float* ptr = a;
+
+        if (b.w == 1)
+        {
+            // type 2 and 6
+            binary_op_vector_scalar(ptr, b[0], ptr, w, op);
+
+            return 0;
+        }
+
+        // type 7
+        binary_op_vector_vector(ptr, b, ptr, w, op);
+    }
+
+    return 0;
+}
+
+template<typename Op>
+static int binary_op_scalar_inplace(Mat& a, float b, const Option& opt)
+{
+    Op op;
+
+    int w = a.w;
+    int h = a.h;
+    int channels = a.c;
+    int size = w * h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = a.channel(q);
+        binary_op_vector_scalar(ptr, b, ptr, size, op);
+    }
+
+    return 0;
+}
+
+struct binary_op_add
+{
+    float func(float x, float y) const { return x + y; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_add_ps(x, y); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_add_ps(x, y); }
+#endif
+};
+
+struct binary_op_sub
+{
+    float func(float x, float y) const { return x - y; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_sub_ps(x, y); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_sub_ps(x, y); }
+#endif
+};
+
+struct binary_op_mul
+{
+    float func(float x, float y) const { return x * y; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_mul_ps(x, y); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_mul_ps(x, y); }
+#endif
+};
+
+struct binary_op_div
+{
+    float func(float x, float y) const { return x / y; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_div_ps(x, y); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_div_ps(x, y); }
+#endif
+};
+
+struct binary_op_max
+{
+    float func(float x, float y) const { return std::max(x, y); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_max_ps(x, y); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_max_ps(x, y); }
+#endif
+};
+
+struct binary_op_min
+{
+    float func(float x, float y) const { return std::min(x, y); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_min_ps(x, y); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_min_ps(x, y); }
+#endif
+};
+
+// exp(log(x) * y) for positive x, lanes with x <= 0 go through pow()
+struct binary_op_pow
+{
+    float func(float x, float y) const { return pow(x, y); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const
+    {
+        if (_mm_movemask_ps(_mm_cmple_ps(x, _mm_setzero_ps())) != 0)
+        {
+            float tmpx[4];
+            float tmpy[4];
+            _mm_storeu_ps(tmpx, x);
+            _mm_storeu_ps(tmpy, y);
+            for (int k=0; k<4; k++)
+                tmpx[k] = pow(tmpx[k], tmpy[k]);
+            return _mm_loadu_ps(tmpx);
+        }
+
+        return exp_ps(_mm_mul_ps(log_ps(x), y));
+    }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const
+    {
+        if (_mm256_movemask_ps(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OQ)) != 0)
+        {
+            float tmpx[8];
+            float tmpy[8];
+            _mm256_storeu_ps(tmpx, x);
+            _mm256_storeu_ps(tmpy, y);
+            for (int k=0; k<8; k++)
+                tmpx[k] = pow(tmpx[k], tmpy[k]);
+            return _mm256_loadu_ps(tmpx);
+        }
+
+        return exp256_ps(_mm256_mul_ps(log256_ps(x), y));
+    }
+#endif
+};
+
+struct binary_op_rsub
+{
+    float func(float x, float y) const { return y - x; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_sub_ps(y, x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_sub_ps(y, x); }
+#endif
+};
+
+struct binary_op_rdiv
+{
+    float func(float x, float y) const { return y / x; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_div_ps(y, x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_div_ps(y, x); }
+#endif
+};
+
+int BinaryOp_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    const Mat& bottom_blob1 = bottom_blobs[1];
+
+    Mat& top_blob = top_blobs[0];
+
+    if (op_type == Operation_ADD)
+        return binary_op<binary_op_add>(bottom_blob, bottom_blob1, top_blob, opt);
+
+    if (op_type == Operation_SUB)
+        return binary_op<binary_op_sub>(bottom_blob, bottom_blob1, top_blob, opt);
+
+    if (op_type == Operation_MUL)
+        return binary_op<binary_op_mul>(bottom_blob, bottom_blob1, top_blob, opt);
+
+    if (op_type == Operation_DIV)
+        return binary_op<binary_op_div>(bottom_blob, bottom_blob1, top_blob, opt);
+
+    if (op_type == Operation_MAX)
+        return binary_op<binary_op_max>(bottom_blob, bottom_blob1, top_blob, opt);
+
+    if (op_type == Operation_MIN)
+        return binary_op<binary_op_min>(bottom_blob, bottom_blob1, top_blob, opt);
+
+    if (op_type == Operation_POW)
+        return binary_op<binary_op_pow>(bottom_blob, bottom_blob1, top_blob, opt);
+
+    if (op_type == Operation_RSUB)
+        return binary_op<binary_op_rsub>(bottom_blob, bottom_blob1, top_blob, opt);
+
+    if (op_type == Operation_RDIV)
+        return binary_op<binary_op_rdiv>(bottom_blob, bottom_blob1, top_blob, opt);
+
+    return 0;
+}
+
+int BinaryOp_x86::forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    Mat& bottom_top_blob = bottom_top_blobs[0];
+    const Mat& bottom_blob1 = bottom_top_blobs[1];
+
+    if (!binary_op_output_is_a(bottom_top_blob, bottom_blob1))
+    {
+        // output is larger than the first blob, no way to reuse it
+        std::vector<Mat> top_blobs(1);
+        int ret = forward(bottom_top_blobs, top_blobs, opt);
+        if (ret != 0)
+            return ret;
+
+        bottom_top_blob = top_blobs[0];
+        return 0;
+    }
+
+    if (op_type == Operation_ADD)
+        return binary_op_inplace<binary_op_add>(bottom_top_blob, bottom_blob1, opt);
+
+    if (op_type == Operation_SUB)
+        return binary_op_inplace<binary_op_sub>(bottom_top_blob, bottom_blob1, opt);
+
+    if (op_type == Operation_MUL)
+        return binary_op_inplace<binary_op_mul>(bottom_top_blob, bottom_blob1, opt);
+
+    if (op_type == Operation_DIV)
+        return binary_op_inplace<binary_op_div>(bottom_top_blob, bottom_blob1, opt);
+
+    if (op_type == Operation_MAX)
+        return binary_op_inplace<binary_op_max>(bottom_top_blob, bottom_blob1, opt);
+
+    if (op_type == Operation_MIN)
+        return binary_op_inplace<binary_op_min>(bottom_top_blob, bottom_blob1, opt);
+
+    if (op_type == Operation_POW)
+        return binary_op_inplace<binary_op_pow>(bottom_top_blob, bottom_blob1, opt);
+
+    if (op_type == Operation_RSUB)
+        return binary_op_inplace<binary_op_rsub>(bottom_top_blob, bottom_blob1, opt);
+
+    if (op_type == Operation_RDIV)
+        return binary_op_inplace<binary_op_rdiv>(bottom_top_blob, bottom_blob1, opt);
+
+    return 0;
+}
+
+int BinaryOp_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    if (op_type == Operation_ADD)
+        return binary_op_scalar_inplace<binary_op_add>(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_SUB)
+        return binary_op_scalar_inplace<binary_op_sub>(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_MUL)
+        return binary_op_scalar_inplace<binary_op_mul>(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_DIV)
+        return binary_op_scalar_inplace<binary_op_div>(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_MAX)
+        return binary_op_scalar_inplace<binary_op_max>(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_MIN)
+        return binary_op_scalar_inplace<binary_op_min>(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_POW)
+        return binary_op_scalar_inplace<binary_op_pow>(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_RSUB)
+        return binary_op_scalar_inplace<binary_op_rsub>(bottom_top_blob, b, opt);
+
+    if (op_type == Operation_RDIV)
+        return binary_op_scalar_inplace<binary_op_rdiv>(bottom_top_blob, b, opt);
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,111 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "cast_x86.h"
+#include "cpu.h"
+#include "x86_target.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Cast_x86)
+
+#if NCNN_F16C
+// round to nearest even, denormal and overflow are handled by the instruction
+NCNN_TARGET_F16C
+static void cast_fp32_to_fp16_f16c(const float* ptr, unsigned short* outptr, int size)
+{
+    int i = 0;
+    for (; i+15<size; i+=16)
+    {
+        __m128i _p0 = _mm256_cvtps_ph(_mm256_loadu_ps(ptr + i), _MM_FROUND_TO_NEAREST_INT);
+        __m128i _p1 = _mm256_cvtps_ph(_mm256_loadu_ps(ptr + i + 8), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*)(outptr + i), _p0);
+        _mm_storeu_si128((__m128i*)(outptr + i + 8), _p1);
+    }
+    for (; i+7<size; i+=8)
+    {
+        _mm_storeu_si128((__m128i*)(outptr + i), _mm256_cvtps_ph(_mm256_loadu_ps(ptr + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+    for (; i<size; i++)
+    {
+        outptr[i] = (unsigned short)_mm_extract_epi16(_mm_cvtps_ph(_mm_set_ss(ptr[i]), _MM_FROUND_TO_NEAREST_INT), 0);
+    }
+}
+
+NCNN_TARGET_F16C
+static void cast_fp16_to_fp32_f16c(const unsigned short* ptr, float* outptr, int size)
+{
+    int i = 0;
+    for (; i+15<size; i+=16)
+    {
+        __m256 _p0 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(ptr + i)));
+        __m256 _p1 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(ptr + i + 8)));
+        _mm256_storeu_ps(outptr + i, _p0);
+        _mm256_storeu_ps(outptr + i + 8, _p1);
+    }
+    for (; i+7<size; i+=8)
+    {
+        _mm256_storeu_ps(outptr + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(ptr + i))));
+    }
+    for (; i<size; i++)
+    {
+        outptr[i] = _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(ptr[i])));
+    }
+}
+#endif // NCNN_F16C
+
+int Cast_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+#if NCNN_F16C
+    const bool fp32_to_fp16 = type_from == 1 && type_to == 2;
+    const bool fp16_to_fp32 = type_from == 2 && type_to == 1;
+
+    if ((fp32_to_fp16 || fp16_to_fp32) && cpu_support_x86_f16c())
+    {
+        int w = bottom_blob.w;
+        int h = bottom_blob.h;
+        int channels = bottom_blob.c;
+        int dims = bottom_blob.dims;
+        int elempack = bottom_blob.elempack;
+
+        size_t out_elemsize = (fp32_to_fp16 ? 2 : 4) * elempack;
+
+        if (dims == 1)
+            top_blob.create(w, out_elemsize, elempack, opt.blob_allocator);
+        else if (dims == 2)
+            top_blob.create(w, h, out_elemsize, elempack, opt.blob_allocator);
+        else if (dims == 3)
+            top_blob.create(w, h, channels, out_elemsize, elempack, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        int size = w * h * elempack;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            if (fp32_to_fp16)
+                cast_fp32_to_fp16_f16c(bottom_blob.channel(q), top_blob.channel(q), size);
+            else
+                cast_fp16_to_fp32_f16c(bottom_blob.channel(q), top_blob.channel(q), size);
+        }
+
+        return 0;
+    }
+#endif // NCNN_F16C
+
+    return Cast::forward(bottom_blob, top_blob, opt);
+}
+
+} // namespace ncnn
@@ -12,7 +12,7 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
-static void conv1x1s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, const Option& opt)
+static void conv1x1s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int inch = bottom_blob.c;
 
@@ -102,11 +102,14 @@ static void conv1x1s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _ker
             }
 
         }
+
+        // all input channels are summed, activate while the channel is in cache
+        activation_inplace_sse(out, outw * outh, activation_type, activation_params);
     }
 
 }
 
-static void conv1x1s2_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, const Option& opt)
+static void conv1x1s2_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int w = bottom_blob.w;
     int inch = bottom_blob.c;
@@ -208,6 +211,9 @@ static void conv1x1s2_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _ker
             }
 
         }
+
+        // all input channels are summed, activate while the channel is in cache
+        activation_inplace_sse(out, outw * outh, activation_type, activation_params);
     }
 
 }
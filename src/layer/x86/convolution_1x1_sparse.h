@@ -0,0 +1,431 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+
+// blocked csr weight of a 1x1 convolution
+// outch is split into blocks of 4 outputs, the remain outputs are blocks of 1
+// rowptr = the first nonzero of each block, nn_block + 1 entries
+// index = the input channel of each nonzero
+// values = the 4 weights of each nonzero of the 4-blocks, then the weight of each nonzero of the 1-blocks
+// a nonzero of a 4-block is an input channel with any of the 4 weights nonzero
+// return -1 and keep the outputs empty if more than max_density of the blocks are nonzero
+static int conv1x1s1_sparse_transform_kernel_sse(const Mat& _kernel, Mat& kernel_values, Mat& kernel_index, Mat& kernel_rowptr, int inch, int outch, float max_density)
+{
+    const float* kernel = _kernel;
+
+    const int nn_outch = outch / 4;
+    const int nn_block = nn_outch + outch % 4;
+
+    // count the nonzeros
+    int nnz4 = 0;
+    int nnz1 = 0;
+    for (int pp=0; pp<nn_outch; pp++)
+    {
+        const float* k0 = kernel + inch * pp * 4;
+
+        for (int q=0; q<inch; q++)
+        {
+            if (k0[q] != 0.f || k0[inch + q] != 0.f || k0[inch * 2 + q] != 0.f || k0[inch * 3 + q] != 0.f)
+                nnz4++;
+        }
+    }
+    for (int p=nn_outch*4; p<outch; p++)
+    {
+        const float* k0 = kernel + inch * p;
+
+        for (int q=0; q<inch; q++)
+        {
+            if (k0[q] != 0.f)
+                nnz1++;
+        }
+    }
+
+    if (nnz4 * 4 + nnz1 > max_density * inch * outch)
+        return -1;
+
+    kernel_values.create(nnz4 * 4 + nnz1 + 1);
+    kernel_index.create(nnz4 + nnz1 + 1, (size_t)4u);
+    kernel_rowptr.create(nn_block + 1, (size_t)4u);
+    if (kernel_values.empty() || kernel_index.empty() || kernel_rowptr.empty())
+        return -100;
+
+    float* values = kernel_values;
+    int* index = kernel_index;
+    int* rowptr = kernel_rowptr;
+
+    int nnz = 0;
+    for (int pp=0; pp<nn_outch; pp++)
+    {
+        const float* k0 = kernel + inch * pp * 4;
+        const float* k1 = k0 + inch;
+        const float* k2 = k1 + inch;
+        const float* k3 = k2 + inch;
+
+        rowptr[pp] = nnz;
+
+        for (int q=0; q<inch; q++)
+        {
+            if (k0[q] == 0.f && k1[q] == 0.f && k2[q] == 0.f && k3[q] == 0.f)
+                continue;
+
+            index[nnz] = q;
+            values[0] = k0[q];
+            values[1] = k1[q];
+            values[2] = k2[q];
+            values[3] = k3[q];
+
+            values += 4;
+            nnz++;
+        }
+    }
+    for (int p=nn_outch*4; p<outch; p++)
+    {
+        const float* k0 = kernel + inch * p;
+
+        rowptr[nn_outch + p % 4] = nnz;
+
+        for (int q=0; q<inch; q++)
+        {
+            if (k0[q] == 0.f)
+                continue;
+
+            index[nnz] = q;
+            values[0] = k0[q];
+
+            values += 1;
+            nnz++;
+        }
+    }
+    rowptr[nn_block] = nnz;
+
+    return 0;
+}
+
+// outptr(p, j) = bias(p) + sum_k kernel(p, k) * bottom(index(k), j) for the 4 outputs of a block
+static void conv1x1s1_sparse_pack4_sse(const float* bottom, size_t cstep, int n, const float* kptr, const int* index, int nnz, const float* bias, float* outptr, size_t outstep, int activation_type, const Mat& activation_params)
+{
+    float* outptr0 = outptr;
+    float* outptr1 = outptr0 + outstep;
+    float* outptr2 = outptr1 + outstep;
+    float* outptr3 = outptr2 + outstep;
+
+    const float bias0 = bias ? bias[0] : 0.f;
+    const float bias1 = bias ? bias[1] : 0.f;
+    const float bias2 = bias ? bias[2] : 0.f;
+    const float bias3 = bias ? bias[3] : 0.f;
+
+    int j=0;
+#if __AVX__
+    for (; j+15<n; j+=16)
+    {
+        const float* kptr0 = kptr;
+
+        __m256 _sum00 = _mm256_set1_ps(bias0);
+        __m256 _sum01 = _sum00;
+        __m256 _sum10 = _mm256_set1_ps(bias1);
+        __m256 _sum11 = _sum10;
+        __m256 _sum20 = _mm256_set1_ps(bias2);
+        __m256 _sum21 = _sum20;
+        __m256 _sum30 = _mm256_set1_ps(bias3);
+        __m256 _sum31 = _sum30;
+
+        for (int k=0; k<nnz; k++)
+        {
+            const float* m = bottom + cstep * index[k] + j;
+
+            __m256 _val0 = _mm256_loadu_ps(m);
+            __m256 _val1 = _mm256_loadu_ps(m + 8);
+
+            __m256 _k0 = _mm256_broadcast_ss(kptr0);
+            __m256 _k1 = _mm256_broadcast_ss(kptr0 + 1);
+            __m256 _k2 = _mm256_broadcast_ss(kptr0 + 2);
+            __m256 _k3 = _mm256_broadcast_ss(kptr0 + 3);
+
+            _sum00 = _mm256_fmadd_ps(_k0, _val0, _sum00);
+            _sum01 = _mm256_fmadd_ps(_k0, _val1, _sum01);
+            _sum10 = _mm256_fmadd_ps(_k1, _val0, _sum10);
+            _sum11 = _mm256_fmadd_ps(_k1, _val1, _sum11);
+            _sum20 = _mm256_fmadd_ps(_k2, _val0, _sum20);
+            _sum21 = _mm256_fmadd_ps(_k2, _val1, _sum21);
+            _sum30 = _mm256_fmadd_ps(_k3, _val0, _sum30);
+            _sum31 = _mm256_fmadd_ps(_k3, _val1, _sum31);
+
+            kptr0 += 4;
+        }
+
+        _mm256_storeu_ps(outptr0 + j, activation_avx(_sum00, activation_type, activation_params));
+        _mm256_storeu_ps(outptr0 + j + 8, activation_avx(_sum01, activation_type, activation_params));
+        _mm256_storeu_ps(outptr1 + j, activation_avx(_sum10, activation_type, activation_params));
+        _mm256_storeu_ps(outptr1 + j + 8, activation_avx(_sum11, activation_type, activation_params));
+        _mm256_storeu_ps(outptr2 + j, activation_avx(_sum20, activation_type, activation_params));
+        _mm256_storeu_ps(outptr2 + j + 8, activation_avx(_sum21, activation_type, activation_params));
+        _mm256_storeu_ps(outptr3 + j, activation_avx(_sum30, activation_type, activation_params));
+        _mm256_storeu_ps(outptr3 + j + 8, activation_avx(_sum31, activation_type, activation_params));
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; j+3<n; j+=4)
+    {
+        const float* kptr0 = kptr;
+
+        __m128 _sum0 = _mm_set1_ps(bias0);
+        __m128 _sum1 = _mm_set1_ps(bias1);
+        __m128 _sum2 = _mm_set1_ps(bias2);
+        __m128 _sum3 = _mm_set1_ps(bias3);
+
+        for (int k=0; k<nnz; k++)
+        {
+            __m128 _val = _mm_loadu_ps(bottom + cstep * index[k] + j);
+
+            _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_load1_ps(kptr0), _val));
+            _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_mm_load1_ps(kptr0 + 1), _val));
+            _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_mm_load1_ps(kptr0 + 2), _val));
+            _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_mm_load1_ps(kptr0 + 3), _val));
+
+            kptr0 += 4;
+        }
+
+        _mm_storeu_ps(outptr0 + j, activation_sse(_sum0, activation_type, activation_params));
+        _mm_storeu_ps(outptr1 + j, activation_sse(_sum1, activation_type, activation_params));
+        _mm_storeu_ps(outptr2 + j, activation_sse(_sum2, activation_type, activation_params));
+        _mm_storeu_ps(outptr3 + j, activation_sse(_sum3, activation_type, activation_params));
+    }
+#endif // __SSE2__
+    for (; j<n; j++)
+    {
+        const float* kptr0 = kptr;
+
+        float sum0 = bias0;
+        float sum1 = bias1;
+        float sum2 = bias2;
+        float sum3 = bias3;
+
+        for (int k=0; k<nnz; k++)
+        {
+            const float val = bottom[cstep * index[k] + j];
+
+            sum0 += kptr0[0] * val;
+            sum1 += kptr0[1] * val;
+            sum2 += kptr0[2] * val;
+            sum3 += kptr0[3] * val;
+
+            kptr0 += 4;
+        }
+
+        outptr0[j] = activation_ss(sum0, activation_type, activation_params);
+        outptr1[j] = activation_ss(sum1, activation_type, activation_params);
+        outptr2[j] = activation_ss(sum2, activation_type, activation_params);
+        outptr3[j] = activation_ss(sum3, activation_type, activation_params);
+    }
+}
+
+// outptr(j) = bias + sum_k kernel(k) * bottom(index(k), j) for one output
+static void conv1x1s1_sparse_pack1_sse(const float* bottom, size_t cstep, int n, const float* kptr, const int* index, int nnz, float bias0, float* outptr, int activation_type, const Mat& activation_params)
+{
+    int j=0;
+#if __AVX__
+    for (; j+7<n; j+=8)
+    {
+        __m256 _sum = _mm256_set1_ps(bias0);
+
+        for (int k=0; k<nnz; k++)
+        {
+            _sum = _mm256_fmadd_ps(_mm256_broadcast_ss(kptr + k), _mm256_loadu_ps(bottom + cstep * index[k] + j), _sum);
+        }
+
+        _mm256_storeu_ps(outptr + j, activation_avx(_sum, activation_type, activation_params));
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; j+3<n; j+=4)
+    {
+        __m128 _sum = _mm_set1_ps(bias0);
+
+        for (int k=0; k<nnz; k++)
+        {
+            _sum = _mm_add_ps(_sum, _mm_mul_ps(_mm_load1_ps(kptr + k), _mm_loadu_ps(bottom + cstep * index[k] + j)));
+        }
+
+        _mm_storeu_ps(outptr + j, activation_sse(_sum, activation_type, activation_params));
+    }
+#endif // __SSE2__
+    for (; j<n; j++)
+    {
+        float sum = bias0;
+
+        for (int k=0; k<nnz; k++)
+        {
+            sum += kptr[k] * bottom[cstep * index[k] + j];
+        }
+
+        outptr[j] = activation_ss(sum, activation_type, activation_params);
+    }
+}
+
+#if NCNN_AVX512
+NCNN_AVX512_DIAGNOSTIC_PUSH
+// the 4 outputs of a block for 32 columns at once, the tail columns are masked
+NCNN_TARGET_AVX512
+static void conv1x1s1_sparse_pack4_avx512(const float* bottom, size_t cstep, int n, const float* kptr, const int* index, int nnz, const float* bias, float* outptr, size_t outstep, int activation_type, const Mat& activation_params)
+{
+    const float bias0 = bias ? bias[0] : 0.f;
+    const float bias1 = bias ? bias[1] : 0.f;
+    const float bias2 = bias ? bias[2] : 0.f;
+    const float bias3 = bias ? bias[3] : 0.f;
+
+    for (int j=0; j<n; j+=32)
+    {
+        const __mmask16 _mask0 = n - j >= 16 ? 0xffff : (__mmask16)((1u << (n - j)) - 1);
+        const __mmask16 _mask1 = n - j >= 32 ? 0xffff : n - j <= 16 ? 0 : (__mmask16)((1u << (n - j - 16)) - 1);
+
+        const float* kptr0 = kptr;
+
+        __m512 _sum00 = _mm512_set1_ps(bias0);
+        __m512 _sum01 = _sum00;
+        __m512 _sum10 = _mm512_set1_ps(bias1);
+        __m512 _sum11 = _sum10;
+        __m512 _sum20 = _mm512_set1_ps(bias2);
+        __m512 _sum21 = _sum20;
+        __m512 _sum30 = _mm512_set1_ps(bias3);
+        __m512 _sum31 = _sum30;
+
+        for (int k=0; k<nnz; k++)
+        {
+            const float* m = bottom + cstep * index[k] + j;
+
+            __m512 _val0 = _mm512_maskz_loadu_ps(_mask0, m);
+            __m512 _val1 = _mm512_maskz_loadu_ps(_mask1, m + 16);
+
+            __m512 _k0 = _mm512_set1_ps(kptr0[0]);
+            __m512 _k1 = _mm512_set1_ps(kptr0[1]);
+            __m512 _k2 = _mm512_set1_ps(kptr0[2]);
+            __m512 _k3 = _mm512_set1_ps(kptr0[3]);
+
+            _sum00 = _mm512_fmadd_ps(_k0, _val0, _sum00);
+            _sum01 = _mm512_fmadd_ps(_k0, _val1, _sum01);
+            _sum10 = _mm512_fmadd_ps(_k1, _val0, _sum10);
+            _sum11 = _mm512_fmadd_ps(_k1, _val1, _sum11);
+            _sum20 = _mm512_fmadd_ps(_k2, _val0, _sum20);
+            _sum21 = _mm512_fmadd_ps(_k2, _val1, _sum21);
+            _sum30 = _mm512_fmadd_ps(_k3, _val0, _sum30);
+            _sum31 = _mm512_fmadd_ps(_k3, _val1, _sum31);
+
+            kptr0 += 4;
+        }
+
+        __m512 _sum[8] = {_sum00, _sum01, _sum10, _sum11, _sum20, _sum21, _sum30, _sum31};
+        for (int q=0; q<4; q++)
+        {
+            float* outptr0 = outptr + outstep * q + j;
+            _mm512_mask_storeu_ps(outptr0, _mask0, activation_avx512(_sum[q * 2], activation_type, activation_params));
+            _mm512_mask_storeu_ps(outptr0 + 16, _mask1, activation_avx512(_sum[q * 2 + 1], activation_type, activation_params));
+        }
+    }
+}
+
+NCNN_TARGET_AVX512
+static void conv1x1s1_sparse_pack1_avx512(const float* bottom, size_t cstep, int n, const float* kptr, const int* index, int nnz, float bias0, float* outptr, int activation_type, const Mat& activation_params)
+{
+    for (int j=0; j<n; j+=16)
+    {
+        const __mmask16 _mask = n - j >= 16 ? 0xffff : (__mmask16)((1u << (n - j)) - 1);
+
+        __m512 _sum = _mm512_set1_ps(bias0);
+
+        for (int k=0; k<nnz; k++)
+        {
+            _sum = _mm512_fmadd_ps(_mm512_set1_ps(kptr[k]), _mm512_maskz_loadu_ps(_mask, bottom + cstep * index[k] + j), _sum);
+        }
+
+        _mm512_mask_storeu_ps(outptr + j, _mask, activation_avx512(_sum, activation_type, activation_params));
+    }
+}
+NCNN_AVX512_DIAGNOSTIC_POP
+#endif // NCNN_AVX512
+
+static void conv1x1s1_sparse_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_values, const Mat& kernel_index, const Mat& kernel_rowptr, const Mat& _bias, int activation_type, const Mat& activation_params, bool use_avx512, const Option& opt)
+{
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+
+    const int size = outw * outh;
+
+    const float* bias = _bias;
+
+    const float* values = kernel_values;
+    const int* index = kernel_index;
+    const int* rowptr = kernel_rowptr;
+
+    const int nn_outch = outch / 4;
+    const int nn_block = nn_outch + outch % 4;
+
+    // the 1-blocks follow the values of the 4-blocks
+    const float* values1 = values + rowptr[nn_outch] * 4 - rowptr[nn_outch];
+
+    // each tile is a range of output pixels for one block,
+    // the blocks of a tile run next to each other while its input columns stay in l1 cache
+    const int inch = bottom_blob.c;
+    const int tile_size = std::min(std::max(8192 / inch / 32 * 32, 32), 256);
+    const int nn_tile = (size + tile_size - 1) / tile_size;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t=0; t<nn_tile * nn_block; t++)
+    {
+        const int b = t % nn_block;
+        const int j = t / nn_block * tile_size;
+        const int n = std::min(tile_size, size - j);
+
+        const float* bottom = (const float*)bottom_blob + j;
+
+        const int nnz = rowptr[b + 1] - rowptr[b];
+
+        if (b < nn_outch)
+        {
+            const int p = b * 4;
+
+            const float* kptr = values + rowptr[b] * 4;
+            const float* biasptr = bias ? bias + p : 0;
+            float* outptr = top_blob.channel(p);
+
+#if NCNN_AVX512
+            if (use_avx512)
+                conv1x1s1_sparse_pack4_avx512(bottom, bottom_blob.cstep, n, kptr, index + rowptr[b], nnz, biasptr, outptr + j, top_blob.cstep, activation_type, activation_params);
+            else
+#endif
+            conv1x1s1_sparse_pack4_sse(bottom, bottom_blob.cstep, n, kptr, index + rowptr[b], nnz, biasptr, outptr + j, top_blob.cstep, activation_type, activation_params);
+        }
+        else
+        {
+            const int p = nn_outch * 4 + b - nn_outch;
+
+            const float* kptr = values1 + rowptr[b];
+            const float bias0 = bias ? bias[p] : 0.f;
+            float* outptr = top_blob.channel(p);
+
+#if NCNN_AVX512
+            if (use_avx512)
+                conv1x1s1_sparse_pack1_avx512(bottom, bottom_blob.cstep, n, kptr, index + rowptr[b], nnz, bias0, outptr + j, activation_type, activation_params);
+            else
+#endif
+            conv1x1s1_sparse_pack1_sse(bottom, bottom_blob.cstep, n, kptr, index + rowptr[b], nnz, bias0, outptr + j, activation_type, activation_params);
+        }
+    }
+}
@@ -13,7 +13,7 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
-static void conv3x3s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, const Option& opt)
+static void conv3x3s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int w = bottom_blob.w;
     int inch = bottom_blob.c;
@@ -136,6 +136,9 @@ static void conv3x3s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _ker
             }
 
         }
+
+        // all input channels are summed, activate while the channel is in cache
+        activation_inplace_sse(out, outw * outh, activation_type, activation_params);
     }
 
 }
@@ -737,56 +740,13 @@ static void conv3x3s1_winograd23_sse(const Mat& bottom_blob, Mat& top_blob, cons
     copy_cut_border(top_blob_bordered, top_blob, 0, top_blob_bordered.h - top_blob.h, 0, top_blob_bordered.w - top_blob.w, opt.blob_allocator, opt.num_threads);
 }
 
-static void conv3x3s1_winograd43_transform_kernel_sse(const Mat& kernel, std::vector<Mat> &kernel_tm2, int inch, int outch)
+// interleave transformed kernel by 8 / 4 / 1 outch for each group of 4 elements
+static void conv3x3s1_winograd_pack_kernel_sse(const Mat& kernel_tm, std::vector<Mat> &kernel_tm2, int inch, int outch)
 {
-    Mat kernel_tm(6*6, inch, outch);
-
-    // G
-    const float ktm[6][3] = {
-        {  1.0f/4,     0.0f,    0.0f},
-        { -1.0f/6,  -1.0f/6, -1.0f/6},
-        { -1.0f/6,   1.0f/6, -1.0f/6},
-        { 1.0f/24,  1.0f/12,  1.0f/6},
-        { 1.0f/24, -1.0f/12,  1.0f/6},
-        {    0.0f,     0.0f,    1.0f}
-    };
-
-    #pragma omp parallel for
-    for (int p = 0; p<outch; p++)
-    {
-        for (int q = 0; q<inch; q++)
-        {
-            const float* kernel0 = (const float*)kernel + p*inch * 9 + q * 9;
-            float* kernel_tm0 = kernel_tm.channel(p).row(q);
-
-            // transform kernel
-            const float* k0 = kernel0;
-            const float* k1 = kernel0 + 3;
-            const float* k2 = kernel0 + 6;
-
-            // h
-            float tmp[6][3];
-            for (int i=0; i<6; i++)
-            {
-                tmp[i][0] = k0[0] * ktm[i][0] + k0[1] * ktm[i][1] + k0[2] * ktm[i][2];
-                tmp[i][1] = k1[0] * ktm[i][0] + k1[1] * ktm[i][1] + k1[2] * ktm[i][2];
-                tmp[i][2] = k2[0] * ktm[i][0] + k2[1] * ktm[i][1] + k2[2] * ktm[i][2];
-            }
-
-            // U
-            for (int j=0; j<6; j++)
-            {
-                float* tmpp = &tmp[j][0];
+    const int tm_size = kernel_tm.w;
+    const int nr = tm_size / 4;
 
-                for (int i=0; i<6; i++)
-                {
-                    kernel_tm0[j*6 + i] = tmpp[0] * ktm[i][0] + tmpp[1] * ktm[i][1] + tmpp[2] * ktm[i][2];
-                }
-            }
-        }
-    }
-
-    for (int r=0; r<9; r++)
+    for (int r=0; r<nr; r++)
     {
         Mat kernel_tm_test(4*8, inch, outch/8 + (outch%8)/4 + outch%4);
 
@@ -847,14 +807,14 @@ static void conv3x3s1_winograd43_transform_kernel_sse(const Mat& kernel, std::ve
                 ktmp[31] = kernel7[r*4+3];
 
                 ktmp += 32;
-                kernel0 += 36;
-                kernel1 += 36;
-                kernel2 += 36;
-                kernel3 += 36;
-                kernel4 += 36;
-                kernel5 += 36;
-                kernel6 += 36;
-                kernel7 += 36;
+                kernel0 += tm_size;
+                kernel1 += tm_size;
+                kernel2 += tm_size;
+                kernel3 += tm_size;
+                kernel4 += tm_size;
+                kernel5 += tm_size;
+                kernel6 += tm_size;
+                kernel7 += tm_size;
             }
         }
 
@@ -890,10 +850,10 @@ static void conv3x3s1_winograd43_transform_kernel_sse(const Mat& kernel, std::ve
                 ktmp[15] = kernel3[r*4+3];
 
                 ktmp += 16;
-                kernel0 += 36;
-                kernel1 += 36;
-                kernel2 += 36;
-                kernel3 += 36;
+                kernel0 += tm_size;
+                kernel1 += tm_size;
+                kernel2 += tm_size;
+                kernel3 += tm_size;
             }
         }
 
@@ -911,868 +871,1315 @@ static void conv3x3s1_winograd43_transform_kernel_sse(const Mat& kernel, std::ve
                 ktmp[3] = kernel0[r*4+3];
 
                 ktmp += 4;
-                kernel0 += 36;
+                kernel0 += tm_size;
             }        
         }
         kernel_tm2.push_back(kernel_tm_test);
-    }    
+    }
 }
 
-static void conv3x3s1_winograd43_sse(const Mat& bottom_blob, Mat& top_blob, const std::vector<Mat> &kernel_tm_test, const Mat& _bias, const Option& opt)
+static void conv3x3s1_winograd43_transform_kernel_sse(const Mat& kernel, std::vector<Mat> &kernel_tm2, int inch, int outch)
 {
-    int w = bottom_blob.w;
-    int h = bottom_blob.h;
-    int inch = bottom_blob.c;
+    Mat kernel_tm(6*6, inch, outch);
 
-    int outw = top_blob.w;
-    int outh = top_blob.h;
-    int outch = top_blob.c;
+    // G
+    const float ktm[6][3] = {
+        {  1.0f/4,     0.0f,    0.0f},
+        { -1.0f/6,  -1.0f/6, -1.0f/6},
+        { -1.0f/6,   1.0f/6, -1.0f/6},
+        { 1.0f/24,  1.0f/12,  1.0f/6},
+        { 1.0f/24, -1.0f/12,  1.0f/6},
+        {    0.0f,     0.0f,    1.0f}
+    };
 
-    size_t elemsize = bottom_blob.elemsize;
-    const float* bias = _bias;    
+    #pragma omp parallel for
+    for (int p = 0; p<outch; p++)
+    {
+        for (int q = 0; q<inch; q++)
+        {
+            const float* kernel0 = (const float*)kernel + p*inch * 9 + q * 9;
+            float* kernel_tm0 = kernel_tm.channel(p).row(q);
 
-    // pad to 4n+2, winograd F(4,3)
-    Mat bottom_blob_bordered = bottom_blob;
+            // transform kernel
+            const float* k0 = kernel0;
+            const float* k1 = kernel0 + 3;
+            const float* k2 = kernel0 + 6;
 
-    outw = (outw + 3) / 4 * 4;
-    outh = (outh + 3) / 4 * 4;
+            // h
+            float tmp[6][3];
+            for (int i=0; i<6; i++)
+            {
+                tmp[i][0] = k0[0] * ktm[i][0] + k0[1] * ktm[i][1] + k0[2] * ktm[i][2];
+                tmp[i][1] = k1[0] * ktm[i][0] + k1[1] * ktm[i][1] + k1[2] * ktm[i][2];
+                tmp[i][2] = k2[0] * ktm[i][0] + k2[1] * ktm[i][1] + k2[2] * ktm[i][2];
+            }
 
-    w = outw + 2;
-    h = outh + 2;
+            // U
+            for (int j=0; j<6; j++)
+            {
+                float* tmpp = &tmp[j][0];
 
-    copy_make_border(bottom_blob, bottom_blob_bordered, 0, h - bottom_blob.h, 0, w - bottom_blob.w, 0, 0.f, opt.workspace_allocator, opt.num_threads);
+                for (int i=0; i<6; i++)
+                {
+                    kernel_tm0[j*6 + i] = tmpp[0] * ktm[i][0] + tmpp[1] * ktm[i][1] + tmpp[2] * ktm[i][2];
+                }
+            }
+        }
+    }
 
-    // BEGIN transform input
-    Mat bottom_blob_tm;
-    {
-        int w_tm = outw / 4 * 6;
-        int h_tm = outh / 4 * 6;
+    conv3x3s1_winograd_pack_kernel_sse(kernel_tm, kernel_tm2, inch, outch);
+}
 
-        int nColBlocks = h_tm/6; // may be the block num in Feathercnn
-        int nRowBlocks = w_tm/6;
+// transform the tiles [tile_start, tile_start + tiles) in row major tile order
+// bottom_blob_tm holds 4 x inch x tiles*9 for these tiles only
+static void conv3x3s1_winograd43_transform_input_tile_sse(const Mat& bottom_blob_bordered, Mat& bottom_blob_tm, int tile_start, int tiles, const Option& opt)
+{
+    int w = bottom_blob_bordered.w;
+    int inch = bottom_blob_bordered.c;
 
-        const int tiles = nColBlocks * nRowBlocks;
+    // bordered to 4n+2
+    int outw = w - 2;
 
-        bottom_blob_tm.create(4, inch, tiles*9, elemsize, opt.workspace_allocator);
+    int w_tm = outw / 4 * 6;
 
-        // BT
-        // const float itm[4][4] = {
-        //     {4.0f, 0.0f, -5.0f, 0.0f, 1.0f, 0.0f},
-        //     {0.0f,-4.0f, -4.0f, 1.0f, 1.0f, 0.0f},
-        //     {0.0f, 4.0f, -4.0f,-1.0f, 1.0f, 0.0f},
-        //     {0.0f,-2.0f, -1.0f, 2.0f, 1.0f, 0.0f},
-        //     {0.0f, 2.0f, -1.0f,-2.0f, 1.0f, 0.0f},
-        //     {0.0f, 4.0f,  0.0f,-5.0f, 0.0f, 1.0f}
-        // };
+    int nRowBlocks = w_tm/6;
+
+    // BT
+    // const float itm[4][4] = {
+    //     {4.0f, 0.0f, -5.0f, 0.0f, 1.0f, 0.0f},
+    //     {0.0f,-4.0f, -4.0f, 1.0f, 1.0f, 0.0f},
+    //     {0.0f, 4.0f, -4.0f,-1.0f, 1.0f, 0.0f},
+    //     {0.0f,-2.0f, -1.0f, 2.0f, 1.0f, 0.0f},
+    //     {0.0f, 2.0f, -1.0f,-2.0f, 1.0f, 0.0f},
+    //     {0.0f, 4.0f,  0.0f,-5.0f, 0.0f, 1.0f}
+    // };
 
 		// 0 =	4 * r00  - 5 * r02	+ r04
-        // 1 = -4 * (r01 + r02)  + r03 + r04
-        // 2 =	4 * (r01 - r02)  - r03 + r04
-        // 3 = -2 * r01 - r02 + 2 * r03 + r04
-        // 4 =	2 * r01 - r02 - 2 * r03 + r04
+    // 1 = -4 * (r01 + r02)  + r03 + r04
+    // 2 =	4 * (r01 - r02)  - r03 + r04
+    // 3 = -2 * r01 - r02 + 2 * r03 + r04
+    // 4 =	2 * r01 - r02 - 2 * r03 + r04
 		// 5 =	4 * r01 - 5 * r03 + r05
 
 		// 0 =	4 * r00  - 5 * r02	+ r04
-        // 1 = -4 * (r01 + r02)  + r03 + r04
-        // 2 =	4 * (r01 - r02)  - r03 + r04
-        // 3 = -2 * r01 - r02 + 2 * r03 + r04
-        // 4 =	2 * r01 - r02 - 2 * r03 + r04
+    // 1 = -4 * (r01 + r02)  + r03 + r04
+    // 2 =	4 * (r01 - r02)  - r03 + r04
+    // 3 = -2 * r01 - r02 + 2 * r03 + r04
+    // 4 =	2 * r01 - r02 - 2 * r03 + r04
 		// 5 =	4 * r01 - 5 * r03 + r05
 
 
 #if __AVX__
-        __m256 _1_n = _mm256_set1_ps(-1);
-        __m256 _2_p = _mm256_set1_ps(2);
-        __m256 _2_n = _mm256_set1_ps(-2);
-        __m256 _4_p = _mm256_set1_ps(4);
-        __m256 _4_n = _mm256_set1_ps(-4);
-        __m256 _5_n = _mm256_set1_ps(-5);
+    __m256 _1_n = _mm256_set1_ps(-1);
+    __m256 _2_p = _mm256_set1_ps(2);
+    __m256 _2_n = _mm256_set1_ps(-2);
+    __m256 _4_p = _mm256_set1_ps(4);
+    __m256 _4_n = _mm256_set1_ps(-4);
+    __m256 _5_n = _mm256_set1_ps(-5);
 #endif        
 
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q=0; q<inch; q++)
-        {
-            const float* img = bottom_blob_bordered.channel(q);
-
-            for (int j = 0; j < nColBlocks; j++)
-            {
-                const float* r0 = img + w * j * 4;
-                const float* r1 = r0 + w;
-                const float* r2 = r1 + w;
-                const float* r3 = r2 + w;
-                const float* r4 = r3 + w;
-                const float* r5 = r4 + w;
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<inch; q++)
+    {
+        const float* img = bottom_blob_bordered.channel(q);
 
-                for (int i = 0; i < nRowBlocks; i++)
-                {
-                    float* out_tm0 = bottom_blob_tm.channel(tiles*0+j*nRowBlocks+i).row(q);
-                    float* out_tm1 = bottom_blob_tm.channel(tiles*1+j*nRowBlocks+i).row(q);
-                    float* out_tm2 = bottom_blob_tm.channel(tiles*2+j*nRowBlocks+i).row(q);
-                    float* out_tm3 = bottom_blob_tm.channel(tiles*3+j*nRowBlocks+i).row(q);
-                    float* out_tm4 = bottom_blob_tm.channel(tiles*4+j*nRowBlocks+i).row(q);
-                    float* out_tm5 = bottom_blob_tm.channel(tiles*5+j*nRowBlocks+i).row(q);
-                    float* out_tm6 = bottom_blob_tm.channel(tiles*6+j*nRowBlocks+i).row(q);
-                    float* out_tm7 = bottom_blob_tm.channel(tiles*7+j*nRowBlocks+i).row(q);
-                    float* out_tm8 = bottom_blob_tm.channel(tiles*8+j*nRowBlocks+i).row(q);
+        for (int t = 0; t < tiles; t++)
+        {
+            const int j = (tile_start + t) / nRowBlocks;
+            const int i = (tile_start + t) % nRowBlocks;
+
+            const float* r0 = img + w * j * 4 + i * 4;
+            const float* r1 = r0 + w;
+            const float* r2 = r1 + w;
+            const float* r3 = r2 + w;
+            const float* r4 = r3 + w;
+            const float* r5 = r4 + w;
+
+            float* out_tm0 = bottom_blob_tm.channel(tiles*0+t).row(q);
+            float* out_tm1 = bottom_blob_tm.channel(tiles*1+t).row(q);
+            float* out_tm2 = bottom_blob_tm.channel(tiles*2+t).row(q);
+            float* out_tm3 = bottom_blob_tm.channel(tiles*3+t).row(q);
+            float* out_tm4 = bottom_blob_tm.channel(tiles*4+t).row(q);
+            float* out_tm5 = bottom_blob_tm.channel(tiles*5+t).row(q);
+            float* out_tm6 = bottom_blob_tm.channel(tiles*6+t).row(q);
+            float* out_tm7 = bottom_blob_tm.channel(tiles*7+t).row(q);
+            float* out_tm8 = bottom_blob_tm.channel(tiles*8+t).row(q);
 #if __AVX__
-                    __m256 _d0, _d1, _d2, _d3, _d4, _d5;
-                    __m256 _w0, _w1, _w2, _w3, _w4, _w5;
-                    __m256 _t0, _t1, _t2, _t3, _t4, _t5;
-                    __m256 _n0, _n1, _n2, _n3, _n4, _n5;
-                    // load
-                    _d0 = _mm256_loadu_ps(r0);
-                    _d1 = _mm256_loadu_ps(r1);
-                    _d2 = _mm256_loadu_ps(r2);
-                    _d3 = _mm256_loadu_ps(r3);
-                    _d4 = _mm256_loadu_ps(r4);
-                    _d5 = _mm256_loadu_ps(r5);
-
-                    // w = B_t * d
-                    _w0 = _mm256_mul_ps(_d0, _4_p);
-                    _w0 = _mm256_fmadd_ps(_d2, _5_n, _w0);
-                    _w0 = _mm256_add_ps(_w0, _d4);
-
-                    _w1 = _mm256_mul_ps(_d1, _4_n);
-                    _w1 = _mm256_fmadd_ps(_d2, _4_n, _w1);
-                    _w1 = _mm256_add_ps(_w1, _d3);
-                    _w1 = _mm256_add_ps(_w1, _d4);
-
-                    _w2 = _mm256_mul_ps(_d1, _4_p);
-                    _w2 = _mm256_fmadd_ps(_d2, _4_n, _w2);
-                    _w2 = _mm256_fmadd_ps(_d3, _1_n, _w2);
-                    _w2 = _mm256_add_ps(_w2, _d4);
-
-                    _w3 = _mm256_mul_ps(_d1, _2_n);
-                    _w3 = _mm256_fmadd_ps(_d2, _1_n, _w3);
-                    _w3 = _mm256_fmadd_ps(_d3, _2_p, _w3);
-                    _w3 = _mm256_add_ps(_w3, _d4);
-
-                    _w4 = _mm256_mul_ps(_d1, _2_p);
-                    _w4 = _mm256_fmadd_ps(_d2, _1_n, _w4);
-                    _w4 = _mm256_fmadd_ps(_d3, _2_n, _w4);
-                    _w4 = _mm256_add_ps(_w4, _d4);
-
-                    _w5 = _mm256_mul_ps(_d1, _4_p);
-                    _w5 = _mm256_fmadd_ps(_d3, _5_n, _w5);
-                    _w5 = _mm256_add_ps(_w5, _d5);
-                    // transpose d to d_t
+            __m256 _d0, _d1, _d2, _d3, _d4, _d5;
+            __m256 _w0, _w1, _w2, _w3, _w4, _w5;
+            __m256 _t0, _t1, _t2, _t3, _t4, _t5;
+            __m256 _n0, _n1, _n2, _n3, _n4, _n5;
+            // load
+            _d0 = _mm256_loadu_ps(r0);
+            _d1 = _mm256_loadu_ps(r1);
+            _d2 = _mm256_loadu_ps(r2);
+            _d3 = _mm256_loadu_ps(r3);
+            _d4 = _mm256_loadu_ps(r4);
+            _d5 = _mm256_loadu_ps(r5);
+
+            // w = B_t * d
+            _w0 = _mm256_mul_ps(_d0, _4_p);
+            _w0 = _mm256_fmadd_ps(_d2, _5_n, _w0);
+            _w0 = _mm256_add_ps(_w0, _d4);
+
+            _w1 = _mm256_mul_ps(_d1, _4_n);
+            _w1 = _mm256_fmadd_ps(_d2, _4_n, _w1);
+            _w1 = _mm256_add_ps(_w1, _d3);
+            _w1 = _mm256_add_ps(_w1, _d4);
+
+            _w2 = _mm256_mul_ps(_d1, _4_p);
+            _w2 = _mm256_fmadd_ps(_d2, _4_n, _w2);
+            _w2 = _mm256_fmadd_ps(_d3, _1_n, _w2);
+            _w2 = _mm256_add_ps(_w2, _d4);
+
+            _w3 = _mm256_mul_ps(_d1, _2_n);
+            _w3 = _mm256_fmadd_ps(_d2, _1_n, _w3);
+            _w3 = _mm256_fmadd_ps(_d3, _2_p, _w3);
+            _w3 = _mm256_add_ps(_w3, _d4);
+
+            _w4 = _mm256_mul_ps(_d1, _2_p);
+            _w4 = _mm256_fmadd_ps(_d2, _1_n, _w4);
+            _w4 = _mm256_fmadd_ps(_d3, _2_n, _w4);
+            _w4 = _mm256_add_ps(_w4, _d4);
+
+            _w5 = _mm256_mul_ps(_d1, _4_p);
+            _w5 = _mm256_fmadd_ps(_d3, _5_n, _w5);
+            _w5 = _mm256_add_ps(_w5, _d5);
+            // transpose d to d_t
 #ifdef _WIN32
-                    {
-                        _t0.m256_f32[0]=_w0.m256_f32[0]; _t1.m256_f32[0]=_w0.m256_f32[1]; _t2.m256_f32[0]=_w0.m256_f32[2]; _t3.m256_f32[0]=_w0.m256_f32[3]; _t4.m256_f32[0]=_w0.m256_f32[4]; _t5.m256_f32[0]=_w0.m256_f32[5];
-                        _t0.m256_f32[1]=_w1.m256_f32[0]; _t1.m256_f32[1]=_w1.m256_f32[1]; _t2.m256_f32[1]=_w1.m256_f32[2]; _t3.m256_f32[1]=_w1.m256_f32[3]; _t4.m256_f32[1]=_w1.m256_f32[4]; _t5.m256_f32[1]=_w1.m256_f32[5];
-                        _t0.m256_f32[2]=_w2.m256_f32[0]; _t1.m256_f32[2]=_w2.m256_f32[1]; _t2.m256_f32[2]=_w2.m256_f32[2]; _t3.m256_f32[2]=_w2.m256_f32[3]; _t4.m256_f32[2]=_w2.m256_f32[4]; _t5.m256_f32[2]=_w2.m256_f32[5];
-                        _t0.m256_f32[3]=_w3.m256_f32[0]; _t1.m256_f32[3]=_w3.m256_f32[1]; _t2.m256_f32[3]=_w3.m256_f32[2]; _t3.m256_f32[3]=_w3.m256_f32[3]; _t4.m256_f32[3]=_w3.m256_f32[4]; _t5.m256_f32[3]=_w3.m256_f32[5];
-                        _t0.m256_f32[4]=_w4.m256_f32[0]; _t1.m256_f32[4]=_w4.m256_f32[1]; _t2.m256_f32[4]=_w4.m256_f32[2]; _t3.m256_f32[4]=_w4.m256_f32[3]; _t4.m256_f32[4]=_w4.m256_f32[4]; _t5.m256_f32[4]=_w4.m256_f32[5];
-                        _t0.m256_f32[5]=_w5.m256_f32[0]; _t1.m256_f32[5]=_w5.m256_f32[1]; _t2.m256_f32[5]=_w5.m256_f32[2]; _t3.m256_f32[5]=_w5.m256_f32[3]; _t4.m256_f32[5]=_w5.m256_f32[4]; _t5.m256_f32[5]=_w5.m256_f32[5];
-                    }
+            {
+                _t0.m256_f32[0]=_w0.m256_f32[0]; _t1.m256_f32[0]=_w0.m256_f32[1]; _t2.m256_f32[0]=_w0.m256_f32[2]; _t3.m256_f32[0]=_w0.m256_f32[3]; _t4.m256_f32[0]=_w0.m256_f32[4]; _t5.m256_f32[0]=_w0.m256_f32[5];
+                _t0.m256_f32[1]=_w1.m256_f32[0]; _t1.m256_f32[1]=_w1.m256_f32[1]; _t2.m256_f32[1]=_w1.m256_f32[2]; _t3.m256_f32[1]=_w1.m256_f32[3]; _t4.m256_f32[1]=_w1.m256_f32[4]; _t5.m256_f32[1]=_w1.m256_f32[5];
+                _t0.m256_f32[2]=_w2.m256_f32[0]; _t1.m256_f32[2]=_w2.m256_f32[1]; _t2.m256_f32[2]=_w2.m256_f32[2]; _t3.m256_f32[2]=_w2.m256_f32[3]; _t4.m256_f32[2]=_w2.m256_f32[4]; _t5.m256_f32[2]=_w2.m256_f32[5];
+                _t0.m256_f32[3]=_w3.m256_f32[0]; _t1.m256_f32[3]=_w3.m256_f32[1]; _t2.m256_f32[3]=_w3.m256_f32[2]; _t3.m256_f32[3]=_w3.m256_f32[3]; _t4.m256_f32[3]=_w3.m256_f32[4]; _t5.m256_f32[3]=_w3.m256_f32[5];
+                _t0.m256_f32[4]=_w4.m256_f32[0]; _t1.m256_f32[4]=_w4.m256_f32[1]; _t2.m256_f32[4]=_w4.m256_f32[2]; _t3.m256_f32[4]=_w4.m256_f32[3]; _t4.m256_f32[4]=_w4.m256_f32[4]; _t5.m256_f32[4]=_w4.m256_f32[5];
+                _t0.m256_f32[5]=_w5.m256_f32[0]; _t1.m256_f32[5]=_w5.m256_f32[1]; _t2.m256_f32[5]=_w5.m256_f32[2]; _t3.m256_f32[5]=_w5.m256_f32[3]; _t4.m256_f32[5]=_w5.m256_f32[4]; _t5.m256_f32[5]=_w5.m256_f32[5];
+            }
 #else
-                    {
-                        _t0[0]=_w0[0]; _t1[0]=_w0[1]; _t2[0]=_w0[2]; _t3[0]=_w0[3]; _t4[0]=_w0[4]; _t5[0]=_w0[5];
-                        _t0[1]=_w1[0]; _t1[1]=_w1[1]; _t2[1]=_w1[2]; _t3[1]=_w1[3]; _t4[1]=_w1[4]; _t5[1]=_w1[5];
-                        _t0[2]=_w2[0]; _t1[2]=_w2[1]; _t2[2]=_w2[2]; _t3[2]=_w2[3]; _t4[2]=_w2[4]; _t5[2]=_w2[5];
-                        _t0[3]=_w3[0]; _t1[3]=_w3[1]; _t2[3]=_w3[2]; _t3[3]=_w3[3]; _t4[3]=_w3[4]; _t5[3]=_w3[5];
-                        _t0[4]=_w4[0]; _t1[4]=_w4[1]; _t2[4]=_w4[2]; _t3[4]=_w4[3]; _t4[4]=_w4[4]; _t5[4]=_w4[5];
-                        _t0[5]=_w5[0]; _t1[5]=_w5[1]; _t2[5]=_w5[2]; _t3[5]=_w5[3]; _t4[5]=_w5[4]; _t5[5]=_w5[5];
-                    } 
+            {
+                _t0[0]=_w0[0]; _t1[0]=_w0[1]; _t2[0]=_w0[2]; _t3[0]=_w0[3]; _t4[0]=_w0[4]; _t5[0]=_w0[5];
+                _t0[1]=_w1[0]; _t1[1]=_w1[1]; _t2[1]=_w1[2]; _t3[1]=_w1[3]; _t4[1]=_w1[4]; _t5[1]=_w1[5];
+                _t0[2]=_w2[0]; _t1[2]=_w2[1]; _t2[2]=_w2[2]; _t3[2]=_w2[3]; _t4[2]=_w2[4]; _t5[2]=_w2[5];
+                _t0[3]=_w3[0]; _t1[3]=_w3[1]; _t2[3]=_w3[2]; _t3[3]=_w3[3]; _t4[3]=_w3[4]; _t5[3]=_w3[5];
+                _t0[4]=_w4[0]; _t1[4]=_w4[1]; _t2[4]=_w4[2]; _t3[4]=_w4[3]; _t4[4]=_w4[4]; _t5[4]=_w4[5];
+                _t0[5]=_w5[0]; _t1[5]=_w5[1]; _t2[5]=_w5[2]; _t3[5]=_w5[3]; _t4[5]=_w5[4]; _t5[5]=_w5[5];
+            } 
 #endif
-                    // d = B_t * d_t
-                    _n0 = _mm256_mul_ps(_t0, _4_p);
-                    _n0 = _mm256_fmadd_ps(_t2, _5_n, _n0);
-                    _n0 = _mm256_add_ps(_n0, _t4);
-
-                    _n1 = _mm256_mul_ps(_t1, _4_n);
-                    _n1 = _mm256_fmadd_ps(_t2, _4_n, _n1);
-                    _n1 = _mm256_add_ps(_n1, _t3);
-                    _n1 = _mm256_add_ps(_n1, _t4);
-
-                    _n2 = _mm256_mul_ps(_t1, _4_p);
-                    _n2 = _mm256_fmadd_ps(_t2, _4_n, _n2);
-                    _n2 = _mm256_fmadd_ps(_t3, _1_n, _n2);
-                    _n2 = _mm256_add_ps(_n2, _t4);
-
-                    _n3 = _mm256_mul_ps(_t1, _2_n);
-                    _n3 = _mm256_fmadd_ps(_t2, _1_n, _n3);
-                    _n3 = _mm256_fmadd_ps(_t3, _2_p, _n3);
-                    _n3 = _mm256_add_ps(_n3, _t4);
-
-                    _n4 = _mm256_mul_ps(_t1, _2_p);
-                    _n4 = _mm256_fmadd_ps(_t2, _1_n, _n4);
-                    _n4 = _mm256_fmadd_ps(_t3, _2_n, _n4);
-                    _n4 = _mm256_add_ps(_n4, _t4);
-
-                    _n5 = _mm256_mul_ps(_t1, _4_p);
-                    _n5 = _mm256_fmadd_ps(_t3, _5_n, _n5);
-                    _n5 = _mm256_add_ps(_n5, _t5);
-                    // save to out_tm
-                    float output_n0[8] = {0.f};_mm256_storeu_ps(output_n0, _n0); 
-                    float output_n1[8] = {0.f};_mm256_storeu_ps(output_n1, _n1); 
-                    float output_n2[8] = {0.f};_mm256_storeu_ps(output_n2, _n2); 
-                    float output_n3[8] = {0.f};_mm256_storeu_ps(output_n3, _n3); 
-                    float output_n4[8] = {0.f};_mm256_storeu_ps(output_n4, _n4); 
-                    float output_n5[8] = {0.f};_mm256_storeu_ps(output_n5, _n5); 
+            // d = B_t * d_t
+            _n0 = _mm256_mul_ps(_t0, _4_p);
+            _n0 = _mm256_fmadd_ps(_t2, _5_n, _n0);
+            _n0 = _mm256_add_ps(_n0, _t4);
+
+            _n1 = _mm256_mul_ps(_t1, _4_n);
+            _n1 = _mm256_fmadd_ps(_t2, _4_n, _n1);
+            _n1 = _mm256_add_ps(_n1, _t3);
+            _n1 = _mm256_add_ps(_n1, _t4);
+
+            _n2 = _mm256_mul_ps(_t1, _4_p);
+            _n2 = _mm256_fmadd_ps(_t2, _4_n, _n2);
+            _n2 = _mm256_fmadd_ps(_t3, _1_n, _n2);
+            _n2 = _mm256_add_ps(_n2, _t4);
+
+            _n3 = _mm256_mul_ps(_t1, _2_n);
+            _n3 = _mm256_fmadd_ps(_t2, _1_n, _n3);
+            _n3 = _mm256_fmadd_ps(_t3, _2_p, _n3);
+            _n3 = _mm256_add_ps(_n3, _t4);
+
+            _n4 = _mm256_mul_ps(_t1, _2_p);
+            _n4 = _mm256_fmadd_ps(_t2, _1_n, _n4);
+            _n4 = _mm256_fmadd_ps(_t3, _2_n, _n4);
+            _n4 = _mm256_add_ps(_n4, _t4);
+
+            _n5 = _mm256_mul_ps(_t1, _4_p);
+            _n5 = _mm256_fmadd_ps(_t3, _5_n, _n5);
+            _n5 = _mm256_add_ps(_n5, _t5);
+            // save to out_tm
+            float output_n0[8] = {0.f};_mm256_storeu_ps(output_n0, _n0); 
+            float output_n1[8] = {0.f};_mm256_storeu_ps(output_n1, _n1); 
+            float output_n2[8] = {0.f};_mm256_storeu_ps(output_n2, _n2); 
+            float output_n3[8] = {0.f};_mm256_storeu_ps(output_n3, _n3); 
+            float output_n4[8] = {0.f};_mm256_storeu_ps(output_n4, _n4); 
+            float output_n5[8] = {0.f};_mm256_storeu_ps(output_n5, _n5); 
 					
-                    out_tm0[0]=output_n0[0];out_tm0[1]=output_n0[1];out_tm0[2]=output_n0[2];out_tm0[3]=output_n0[3];
-                    out_tm1[0]=output_n0[4];out_tm1[1]=output_n0[5];out_tm1[2]=output_n1[0];out_tm1[3]=output_n1[1];
-                    out_tm2[0]=output_n1[2];out_tm2[1]=output_n1[3];out_tm2[2]=output_n1[4];out_tm2[3]=output_n1[5];
+            out_tm0[0]=output_n0[0];out_tm0[1]=output_n0[1];out_tm0[2]=output_n0[2];out_tm0[3]=output_n0[3];
+            out_tm1[0]=output_n0[4];out_tm1[1]=output_n0[5];out_tm1[2]=output_n1[0];out_tm1[3]=output_n1[1];
+            out_tm2[0]=output_n1[2];out_tm2[1]=output_n1[3];out_tm2[2]=output_n1[4];out_tm2[3]=output_n1[5];
 
-                    out_tm3[0]=output_n2[0];out_tm3[1]=output_n2[1];out_tm3[2]=output_n2[2];out_tm3[3]=output_n2[3];
-                    out_tm4[0]=output_n2[4];out_tm4[1]=output_n2[5];out_tm4[2]=output_n3[0];out_tm4[3]=output_n3[1];
-                    out_tm5[0]=output_n3[2];out_tm5[1]=output_n3[3];out_tm5[2]=output_n3[4];out_tm5[3]=output_n3[5];
+            out_tm3[0]=output_n2[0];out_tm3[1]=output_n2[1];out_tm3[2]=output_n2[2];out_tm3[3]=output_n2[3];
+            out_tm4[0]=output_n2[4];out_tm4[1]=output_n2[5];out_tm4[2]=output_n3[0];out_tm4[3]=output_n3[1];
+            out_tm5[0]=output_n3[2];out_tm5[1]=output_n3[3];out_tm5[2]=output_n3[4];out_tm5[3]=output_n3[5];
 
-                    out_tm6[0]=output_n4[0];out_tm6[1]=output_n4[1];out_tm6[2]=output_n4[2];out_tm6[3]=output_n4[3];
-                    out_tm7[0]=output_n4[4];out_tm7[1]=output_n4[5];out_tm7[2]=output_n5[0];out_tm7[3]=output_n5[1];
-                    out_tm8[0]=output_n5[2];out_tm8[1]=output_n5[3];out_tm8[2]=output_n5[4];out_tm8[3]=output_n5[5];
+            out_tm6[0]=output_n4[0];out_tm6[1]=output_n4[1];out_tm6[2]=output_n4[2];out_tm6[3]=output_n4[3];
+            out_tm7[0]=output_n4[4];out_tm7[1]=output_n4[5];out_tm7[2]=output_n5[0];out_tm7[3]=output_n5[1];
+            out_tm8[0]=output_n5[2];out_tm8[1]=output_n5[3];out_tm8[2]=output_n5[4];out_tm8[3]=output_n5[5];
 #else
-                    float d0[6],d1[6],d2[6],d3[6],d4[6],d5[6];
-                    float w0[6],w1[6],w2[6],w3[6],w4[6],w5[6];
-                    float t0[6],t1[6],t2[6],t3[6],t4[6],t5[6];
+            float d0[6],d1[6],d2[6],d3[6],d4[6],d5[6];
+            float w0[6],w1[6],w2[6],w3[6],w4[6],w5[6];
+            float t0[6],t1[6],t2[6],t3[6],t4[6],t5[6];
 
-                    // load
-                    for (int n = 0; n < 6; n++)
-                    {
-                        d0[n] = r0[n];
-                        d1[n] = r1[n];
-                        d2[n] = r2[n];
-                        d3[n] = r3[n];
-                        d4[n] = r4[n];
-                        d5[n] = r5[n];
-                    }
-                    // w = B_t * d
-                    for (int n = 0; n < 6; n++)
-                    {   
-                        w0[n] =  4*d0[n]          - 5*d2[n]           + d4[n];
-                        w1[n] =          -4*d1[n] - 4*d2[n] +   d3[n] + d4[n];
-                        w2[n] =           4*d1[n] - 4*d2[n] -   d3[n] + d4[n];
-                        w3[n] =          -2*d1[n] -   d2[n] + 2*d3[n] + d4[n];
-                        w4[n] =           2*d1[n] -   d2[n] - 2*d3[n] + d4[n];
-                        w5[n] =           4*d1[n]           - 5*d3[n]          + d5[n];
-                    }
-                    // transpose d to d_t
-                    {
-                        t0[0]=w0[0]; t1[0]=w0[1]; t2[0]=w0[2]; t3[0]=w0[3]; t4[0]=w0[4]; t5[0]=w0[5];
-                        t0[1]=w1[0]; t1[1]=w1[1]; t2[1]=w1[2]; t3[1]=w1[3]; t4[1]=w1[4]; t5[1]=w1[5];
-                        t0[2]=w2[0]; t1[2]=w2[1]; t2[2]=w2[2]; t3[2]=w2[3]; t4[2]=w2[4]; t5[2]=w2[5];
-                        t0[3]=w3[0]; t1[3]=w3[1]; t2[3]=w3[2]; t3[3]=w3[3]; t4[3]=w3[4]; t5[3]=w3[5];
-                        t0[4]=w4[0]; t1[4]=w4[1]; t2[4]=w4[2]; t3[4]=w4[3]; t4[4]=w4[4]; t5[4]=w4[5];
-                        t0[5]=w5[0]; t1[5]=w5[1]; t2[5]=w5[2]; t3[5]=w5[3]; t4[5]=w5[4]; t5[5]=w5[5];
-                    }
-                    // d = B_t * d_t
-                    for (int n = 0; n < 6; n++)
-                    {   
-                        d0[n] =  4*t0[n]           - 5*t2[n]           + t4[n];
-                        d1[n] =          - 4*t1[n] - 4*t2[n] +   t3[n] + t4[n];
-                        d2[n] =            4*t1[n] - 4*t2[n] -   t3[n] + t4[n];
-                        d3[n] =          - 2*t1[n] -   t2[n] + 2*t3[n] + t4[n];
-                        d4[n] =            2*t1[n] -   t2[n] - 2*t3[n] + t4[n];
-                        d5[n] =            4*t1[n]           - 5*t3[n]          + t5[n];
-                    }
-                    // save to out_tm
-                    {
-                        out_tm0[0]=d0[0];out_tm0[1]=d0[1];out_tm0[2]=d0[2];out_tm0[3]=d0[3];
-                        out_tm1[0]=d0[4];out_tm1[1]=d0[5];out_tm1[2]=d1[0];out_tm1[3]=d1[1];
-                        out_tm2[0]=d1[2];out_tm2[1]=d1[3];out_tm2[2]=d1[4];out_tm2[3]=d1[5];
+            // load
+            for (int n = 0; n < 6; n++)
+            {
+                d0[n] = r0[n];
+                d1[n] = r1[n];
+                d2[n] = r2[n];
+                d3[n] = r3[n];
+                d4[n] = r4[n];
+                d5[n] = r5[n];
+            }
+            // w = B_t * d
+            for (int n = 0; n < 6; n++)
+            {   
+                w0[n] =  4*d0[n]          - 5*d2[n]           + d4[n];
+                w1[n] =          -4*d1[n] - 4*d2[n] +   d3[n] + d4[n];
+                w2[n] =           4*d1[n] - 4*d2[n] -   d3[n] + d4[n];
+                w3[n] =          -2*d1[n] -   d2[n] + 2*d3[n] + d4[n];
+                w4[n] =           2*d1[n] -   d2[n] - 2*d3[n] + d4[n];
+                w5[n] =           4*d1[n]           - 5*d3[n]          + d5[n];
+            }
+            // transpose d to d_t
+            {
+                t0[0]=w0[0]; t1[0]=w0[1]; t2[0]=w0[2]; t3[0]=w0[3]; t4[0]=w0[4]; t5[0]=w0[5];
+                t0[1]=w1[0]; t1[1]=w1[1]; t2[1]=w1[2]; t3[1]=w1[3]; t4[1]=w1[4]; t5[1]=w1[5];
+                t0[2]=w2[0]; t1[2]=w2[1]; t2[2]=w2[2]; t3[2]=w2[3]; t4[2]=w2[4]; t5[2]=w2[5];
+                t0[3]=w3[0]; t1[3]=w3[1]; t2[3]=w3[2]; t3[3]=w3[3]; t4[3]=w3[4]; t5[3]=w3[5];
+                t0[4]=w4[0]; t1[4]=w4[1]; t2[4]=w4[2]; t3[4]=w4[3]; t4[4]=w4[4]; t5[4]=w4[5];
+                t0[5]=w5[0]; t1[5]=w5[1]; t2[5]=w5[2]; t3[5]=w5[3]; t4[5]=w5[4]; t5[5]=w5[5];
+            }
+            // d = B_t * d_t
+            for (int n = 0; n < 6; n++)
+            {   
+                d0[n] =  4*t0[n]           - 5*t2[n]           + t4[n];
+                d1[n] =          - 4*t1[n] - 4*t2[n] +   t3[n] + t4[n];
+                d2[n] =            4*t1[n] - 4*t2[n] -   t3[n] + t4[n];
+                d3[n] =          - 2*t1[n] -   t2[n] + 2*t3[n] + t4[n];
+                d4[n] =            2*t1[n] -   t2[n] - 2*t3[n] + t4[n];
+                d5[n] =            4*t1[n]           - 5*t3[n]          + t5[n];
+            }
+            // save to out_tm
+            {
+                out_tm0[0]=d0[0];out_tm0[1]=d0[1];out_tm0[2]=d0[2];out_tm0[3]=d0[3];
+                out_tm1[0]=d0[4];out_tm1[1]=d0[5];out_tm1[2]=d1[0];out_tm1[3]=d1[1];
+                out_tm2[0]=d1[2];out_tm2[1]=d1[3];out_tm2[2]=d1[4];out_tm2[3]=d1[5];
 
-                        out_tm3[0]=d2[0];out_tm3[1]=d2[1];out_tm3[2]=d2[2];out_tm3[3]=d2[3];
-                        out_tm4[0]=d2[4];out_tm4[1]=d2[5];out_tm4[2]=d3[0];out_tm4[3]=d3[1];
-                        out_tm5[0]=d3[2];out_tm5[1]=d3[3];out_tm5[2]=d3[4];out_tm5[3]=d3[5];
+                out_tm3[0]=d2[0];out_tm3[1]=d2[1];out_tm3[2]=d2[2];out_tm3[3]=d2[3];
+                out_tm4[0]=d2[4];out_tm4[1]=d2[5];out_tm4[2]=d3[0];out_tm4[3]=d3[1];
+                out_tm5[0]=d3[2];out_tm5[1]=d3[3];out_tm5[2]=d3[4];out_tm5[3]=d3[5];
 
-                        out_tm6[0]=d4[0];out_tm6[1]=d4[1];out_tm6[2]=d4[2];out_tm6[3]=d4[3];
-                        out_tm7[0]=d4[4];out_tm7[1]=d4[5];out_tm7[2]=d5[0];out_tm7[3]=d5[1];
-                        out_tm8[0]=d5[2];out_tm8[1]=d5[3];out_tm8[2]=d5[4];out_tm8[3]=d5[5];
-                    }
-#endif // __AVX__
-                    r0 += 4;
-                    r1 += 4;
-                    r2 += 4;
-                    r3 += 4;
-                    r4 += 4;
-                    r5 += 4;
-                }
+                out_tm6[0]=d4[0];out_tm6[1]=d4[1];out_tm6[2]=d4[2];out_tm6[3]=d4[3];
+                out_tm7[0]=d4[4];out_tm7[1]=d4[5];out_tm7[2]=d5[0];out_tm7[3]=d5[1];
+                out_tm8[0]=d5[2];out_tm8[1]=d5[3];out_tm8[2]=d5[4];out_tm8[3]=d5[5];
             }
+#endif // __AVX__
         }
     }
-    bottom_blob_bordered = Mat();
+}
 
-    // BEGIN dot
-    Mat top_blob_tm;
-    {
-        int w_tm = outw / 4 * 6;
-        int h_tm = outh / 4 * 6;
+static void conv3x3s1_winograd_dot_sse(const Mat& bottom_blob_tm, Mat& top_blob_tm, const std::vector<Mat> &kernel_tm_test, int outch, const Option& opt)
+{
+    int inch = bottom_blob_tm.h;
+    size_t elemsize = bottom_blob_tm.elemsize;
 
-        int nColBlocks = h_tm/6; // may be the block num in Feathercnn
-        int nRowBlocks = w_tm/6;
+    // 9 for F(4,3), 16 for F(6,3)
+    const int nr = kernel_tm_test.size();
+    const int tiles = bottom_blob_tm.c / nr;
+    const int tm_size = nr * 4;
 
-        const int tiles = nColBlocks * nRowBlocks; 
+    top_blob_tm.create(tm_size, tiles, outch, elemsize, opt.workspace_allocator);
 
-        top_blob_tm.create(36, tiles, outch, elemsize, opt.workspace_allocator);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int r=0; r<nr; r++)
+    {
+        int nn_outch = 0;
+        int remain_outch_start = 0;
 
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int r=0; r<9; r++)
-        {
-            int nn_outch = 0;
-            int remain_outch_start = 0;
+        nn_outch = outch >> 3;
+        remain_outch_start = nn_outch << 3;
 
-            nn_outch = outch >> 3;
-            remain_outch_start = nn_outch << 3;
+        for (int pp=0; pp<nn_outch; pp++)
+        {
+            int p = pp * 8;
+
+            float* output0_tm = top_blob_tm.channel(p);
+            float* output1_tm = top_blob_tm.channel(p+1);
+            float* output2_tm = top_blob_tm.channel(p+2);
+            float* output3_tm = top_blob_tm.channel(p+3);
+            float* output4_tm = top_blob_tm.channel(p+4);
+            float* output5_tm = top_blob_tm.channel(p+5);
+            float* output6_tm = top_blob_tm.channel(p+6);
+            float* output7_tm = top_blob_tm.channel(p+7);
+
+            output0_tm = output0_tm + r*4;
+            output1_tm = output1_tm + r*4;
+            output2_tm = output2_tm + r*4;
+            output3_tm = output3_tm + r*4;
+            output4_tm = output4_tm + r*4;
+            output5_tm = output5_tm + r*4;
+            output6_tm = output6_tm + r*4;
+            output7_tm = output7_tm + r*4;
 
-            for (int pp=0; pp<nn_outch; pp++)
+            for (int i=0; i<tiles; i++)
             {
-                int p = pp * 8;
-
-                float* output0_tm = top_blob_tm.channel(p);
-                float* output1_tm = top_blob_tm.channel(p+1);
-                float* output2_tm = top_blob_tm.channel(p+2);
-                float* output3_tm = top_blob_tm.channel(p+3);
-                float* output4_tm = top_blob_tm.channel(p+4);
-                float* output5_tm = top_blob_tm.channel(p+5);
-                float* output6_tm = top_blob_tm.channel(p+6);
-                float* output7_tm = top_blob_tm.channel(p+7);
-
-                output0_tm = output0_tm + r*4;
-                output1_tm = output1_tm + r*4;
-                output2_tm = output2_tm + r*4;
-                output3_tm = output3_tm + r*4;
-                output4_tm = output4_tm + r*4;
-                output5_tm = output5_tm + r*4;
-                output6_tm = output6_tm + r*4;
-                output7_tm = output7_tm + r*4;
-
-                for (int i=0; i<tiles; i++)
-                {
-                    const float* kptr = kernel_tm_test[r].channel(p/8);
-                    const float* r0 = bottom_blob_tm.channel(tiles*r+i);
+                const float* kptr = kernel_tm_test[r].channel(p/8);
+                const float* r0 = bottom_blob_tm.channel(tiles*r+i);
 #if __AVX__ || __SSE__
 #if __AVX__
-                    float zero_val = 0.f;
-                    __m128 _sum0 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum1 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum2 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum3 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum4 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum5 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum6 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum7 = _mm_broadcast_ss(&zero_val);
+                float zero_val = 0.f;
+                __m128 _sum0 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum1 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum2 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum3 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum4 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum5 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum6 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum7 = _mm_broadcast_ss(&zero_val);
 #else
-                    __m128 _sum0 = _mm_set1_ps(0.f);
-                    __m128 _sum1 = _mm_set1_ps(0.f);
-                    __m128 _sum2 = _mm_set1_ps(0.f);
-                    __m128 _sum3 = _mm_set1_ps(0.f);
-                    __m128 _sum4 = _mm_set1_ps(0.f);
-                    __m128 _sum5 = _mm_set1_ps(0.f);
-                    __m128 _sum6 = _mm_set1_ps(0.f);
-                    __m128 _sum7 = _mm_set1_ps(0.f);
+                __m128 _sum0 = _mm_set1_ps(0.f);
+                __m128 _sum1 = _mm_set1_ps(0.f);
+                __m128 _sum2 = _mm_set1_ps(0.f);
+                __m128 _sum3 = _mm_set1_ps(0.f);
+                __m128 _sum4 = _mm_set1_ps(0.f);
+                __m128 _sum5 = _mm_set1_ps(0.f);
+                __m128 _sum6 = _mm_set1_ps(0.f);
+                __m128 _sum7 = _mm_set1_ps(0.f);
 #endif
-                    int q=0;
-                    for (; q+3<inch; q=q+4)
-                    {
-                        __m128 _r0 = _mm_loadu_ps(r0);
-                        __m128 _r1 = _mm_loadu_ps(r0+4);
-                        __m128 _r2 = _mm_loadu_ps(r0+8);
-                        __m128 _r3 = _mm_loadu_ps(r0+12);
-
-                        __m128 _k0 = _mm_loadu_ps(kptr);
-                        __m128 _k1 = _mm_loadu_ps(kptr+4);
-                        __m128 _k2 = _mm_loadu_ps(kptr+8);
-                        __m128 _k3 = _mm_loadu_ps(kptr+12);
-                        __m128 _k4 = _mm_loadu_ps(kptr+16);
-                        __m128 _k5 = _mm_loadu_ps(kptr+20);
-                        __m128 _k6 = _mm_loadu_ps(kptr+24);
-                        __m128 _k7 = _mm_loadu_ps(kptr+28);
+                int q=0;
+                for (; q+3<inch; q=q+4)
+                {
+                    __m128 _r0 = _mm_loadu_ps(r0);
+                    __m128 _r1 = _mm_loadu_ps(r0+4);
+                    __m128 _r2 = _mm_loadu_ps(r0+8);
+                    __m128 _r3 = _mm_loadu_ps(r0+12);
+
+                    __m128 _k0 = _mm_loadu_ps(kptr);
+                    __m128 _k1 = _mm_loadu_ps(kptr+4);
+                    __m128 _k2 = _mm_loadu_ps(kptr+8);
+                    __m128 _k3 = _mm_loadu_ps(kptr+12);
+                    __m128 _k4 = _mm_loadu_ps(kptr+16);
+                    __m128 _k5 = _mm_loadu_ps(kptr+20);
+                    __m128 _k6 = _mm_loadu_ps(kptr+24);
+                    __m128 _k7 = _mm_loadu_ps(kptr+28);
 #if __AVX__                        
-                        _sum0 = _mm_fmadd_ps(_r0, _k0, _sum0);
-                        _sum1 = _mm_fmadd_ps(_r0, _k1, _sum1);
-                        _sum2 = _mm_fmadd_ps(_r0, _k2, _sum2);
-                        _sum3 = _mm_fmadd_ps(_r0, _k3, _sum3);
-                        _sum4 = _mm_fmadd_ps(_r0, _k4, _sum4);
-                        _sum5 = _mm_fmadd_ps(_r0, _k5, _sum5);
-                        _sum6 = _mm_fmadd_ps(_r0, _k6, _sum6);
-                        _sum7 = _mm_fmadd_ps(_r0, _k7, _sum7);
+                    _sum0 = _mm_fmadd_ps(_r0, _k0, _sum0);
+                    _sum1 = _mm_fmadd_ps(_r0, _k1, _sum1);
+                    _sum2 = _mm_fmadd_ps(_r0, _k2, _sum2);
+                    _sum3 = _mm_fmadd_ps(_r0, _k3, _sum3);
+                    _sum4 = _mm_fmadd_ps(_r0, _k4, _sum4);
+                    _sum5 = _mm_fmadd_ps(_r0, _k5, _sum5);
+                    _sum6 = _mm_fmadd_ps(_r0, _k6, _sum6);
+                    _sum7 = _mm_fmadd_ps(_r0, _k7, _sum7);
 #else
-                        _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r0, _k0));
-                        _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r0, _k1));
-                        _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r0, _k2));
-                        _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r0, _k3));
-                        _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r0, _k4));
-                        _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r0, _k5));
-                        _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r0, _k6));
-                        _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r0, _k7));
+                    _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r0, _k0));
+                    _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r0, _k1));
+                    _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r0, _k2));
+                    _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r0, _k3));
+                    _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r0, _k4));
+                    _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r0, _k5));
+                    _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r0, _k6));
+                    _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r0, _k7));
 #endif
-                        kptr += 32;
-                        _k0 = _mm_loadu_ps(kptr);
-                        _k1 = _mm_loadu_ps(kptr+4);
-                        _k2 = _mm_loadu_ps(kptr+8);
-                        _k3 = _mm_loadu_ps(kptr+12);
-                        _k4 = _mm_loadu_ps(kptr+16);
-                        _k5 = _mm_loadu_ps(kptr+20);
-                        _k6 = _mm_loadu_ps(kptr+24);
-                        _k7 = _mm_loadu_ps(kptr+28);
+                    kptr += 32;
+                    _k0 = _mm_loadu_ps(kptr);
+                    _k1 = _mm_loadu_ps(kptr+4);
+                    _k2 = _mm_loadu_ps(kptr+8);
+                    _k3 = _mm_loadu_ps(kptr+12);
+                    _k4 = _mm_loadu_ps(kptr+16);
+                    _k5 = _mm_loadu_ps(kptr+20);
+                    _k6 = _mm_loadu_ps(kptr+24);
+                    _k7 = _mm_loadu_ps(kptr+28);
 #if __AVX__                        
-                        _sum0 = _mm_fmadd_ps(_r1, _k0, _sum0);
-                        _sum1 = _mm_fmadd_ps(_r1, _k1, _sum1);
-                        _sum2 = _mm_fmadd_ps(_r1, _k2, _sum2);
-                        _sum3 = _mm_fmadd_ps(_r1, _k3, _sum3);
-                        _sum4 = _mm_fmadd_ps(_r1, _k4, _sum4);
-                        _sum5 = _mm_fmadd_ps(_r1, _k5, _sum5);
-                        _sum6 = _mm_fmadd_ps(_r1, _k6, _sum6);
-                        _sum7 = _mm_fmadd_ps(_r1, _k7, _sum7); 
+                    _sum0 = _mm_fmadd_ps(_r1, _k0, _sum0);
+                    _sum1 = _mm_fmadd_ps(_r1, _k1, _sum1);
+                    _sum2 = _mm_fmadd_ps(_r1, _k2, _sum2);
+                    _sum3 = _mm_fmadd_ps(_r1, _k3, _sum3);
+                    _sum4 = _mm_fmadd_ps(_r1, _k4, _sum4);
+                    _sum5 = _mm_fmadd_ps(_r1, _k5, _sum5);
+                    _sum6 = _mm_fmadd_ps(_r1, _k6, _sum6);
+                    _sum7 = _mm_fmadd_ps(_r1, _k7, _sum7); 
 #else
-                        _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r1, _k0));
-                        _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r1, _k1));
-                        _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r1, _k2));
-                        _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r1, _k3));
-                        _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r1, _k4));
-                        _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r1, _k5));
-                        _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r1, _k6));
-                        _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r1, _k7));
+                    _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r1, _k0));
+                    _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r1, _k1));
+                    _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r1, _k2));
+                    _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r1, _k3));
+                    _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r1, _k4));
+                    _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r1, _k5));
+                    _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r1, _k6));
+                    _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r1, _k7));
 #endif
 
-                        kptr += 32;
-                        _k0 = _mm_loadu_ps(kptr);
-                        _k1 = _mm_loadu_ps(kptr+4);
-                        _k2 = _mm_loadu_ps(kptr+8);
-                        _k3 = _mm_loadu_ps(kptr+12);
-                        _k4 = _mm_loadu_ps(kptr+16);
-                        _k5 = _mm_loadu_ps(kptr+20);
-                        _k6 = _mm_loadu_ps(kptr+24);
-                        _k7 = _mm_loadu_ps(kptr+28);
+                    kptr += 32;
+                    _k0 = _mm_loadu_ps(kptr);
+                    _k1 = _mm_loadu_ps(kptr+4);
+                    _k2 = _mm_loadu_ps(kptr+8);
+                    _k3 = _mm_loadu_ps(kptr+12);
+                    _k4 = _mm_loadu_ps(kptr+16);
+                    _k5 = _mm_loadu_ps(kptr+20);
+                    _k6 = _mm_loadu_ps(kptr+24);
+                    _k7 = _mm_loadu_ps(kptr+28);
 #if __AVX__                        
-                        _sum0 = _mm_fmadd_ps(_r2, _k0, _sum0);
-                        _sum1 = _mm_fmadd_ps(_r2, _k1, _sum1);
-                        _sum2 = _mm_fmadd_ps(_r2, _k2, _sum2);
-                        _sum3 = _mm_fmadd_ps(_r2, _k3, _sum3);
-                        _sum4 = _mm_fmadd_ps(_r2, _k4, _sum4);
-                        _sum5 = _mm_fmadd_ps(_r2, _k5, _sum5);
-                        _sum6 = _mm_fmadd_ps(_r2, _k6, _sum6);
-                        _sum7 = _mm_fmadd_ps(_r2, _k7, _sum7);
+                    _sum0 = _mm_fmadd_ps(_r2, _k0, _sum0);
+                    _sum1 = _mm_fmadd_ps(_r2, _k1, _sum1);
+                    _sum2 = _mm_fmadd_ps(_r2, _k2, _sum2);
+                    _sum3 = _mm_fmadd_ps(_r2, _k3, _sum3);
+                    _sum4 = _mm_fmadd_ps(_r2, _k4, _sum4);
+                    _sum5 = _mm_fmadd_ps(_r2, _k5, _sum5);
+                    _sum6 = _mm_fmadd_ps(_r2, _k6, _sum6);
+                    _sum7 = _mm_fmadd_ps(_r2, _k7, _sum7);
 #else
-                        _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r2, _k0));
-                        _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r2, _k1));
-                        _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r2, _k2));
-                        _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r2, _k3));
-                        _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r2, _k4));
-                        _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r2, _k5));
-                        _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r2, _k6));
-                        _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r2, _k7));
+                    _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r2, _k0));
+                    _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r2, _k1));
+                    _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r2, _k2));
+                    _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r2, _k3));
+                    _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r2, _k4));
+                    _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r2, _k5));
+                    _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r2, _k6));
+                    _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r2, _k7));
 #endif
-                        kptr += 32;
-                        _k0 = _mm_loadu_ps(kptr);
-                        _k1 = _mm_loadu_ps(kptr+4);
-                        _k2 = _mm_loadu_ps(kptr+8);
-                        _k3 = _mm_loadu_ps(kptr+12);
-                        _k4 = _mm_loadu_ps(kptr+16);
-                        _k5 = _mm_loadu_ps(kptr+20);
-                        _k6 = _mm_loadu_ps(kptr+24);
-                        _k7 = _mm_loadu_ps(kptr+28);
+                    kptr += 32;
+                    _k0 = _mm_loadu_ps(kptr);
+                    _k1 = _mm_loadu_ps(kptr+4);
+                    _k2 = _mm_loadu_ps(kptr+8);
+                    _k3 = _mm_loadu_ps(kptr+12);
+                    _k4 = _mm_loadu_ps(kptr+16);
+                    _k5 = _mm_loadu_ps(kptr+20);
+                    _k6 = _mm_loadu_ps(kptr+24);
+                    _k7 = _mm_loadu_ps(kptr+28);
 #if __AVX__                        
-                        _sum0 = _mm_fmadd_ps(_r3, _k0, _sum0);
-                        _sum1 = _mm_fmadd_ps(_r3, _k1, _sum1);
-                        _sum2 = _mm_fmadd_ps(_r3, _k2, _sum2);
-                        _sum3 = _mm_fmadd_ps(_r3, _k3, _sum3);
-                        _sum4 = _mm_fmadd_ps(_r3, _k4, _sum4);
-                        _sum5 = _mm_fmadd_ps(_r3, _k5, _sum5);
-                        _sum6 = _mm_fmadd_ps(_r3, _k6, _sum6);
-                        _sum7 = _mm_fmadd_ps(_r3, _k7, _sum7);
+                    _sum0 = _mm_fmadd_ps(_r3, _k0, _sum0);
+                    _sum1 = _mm_fmadd_ps(_r3, _k1, _sum1);
+                    _sum2 = _mm_fmadd_ps(_r3, _k2, _sum2);
+                    _sum3 = _mm_fmadd_ps(_r3, _k3, _sum3);
+                    _sum4 = _mm_fmadd_ps(_r3, _k4, _sum4);
+                    _sum5 = _mm_fmadd_ps(_r3, _k5, _sum5);
+                    _sum6 = _mm_fmadd_ps(_r3, _k6, _sum6);
+                    _sum7 = _mm_fmadd_ps(_r3, _k7, _sum7);
 #else
-                        _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r3, _k0));
-                        _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r3, _k1));
-                        _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r3, _k2));
-                        _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r3, _k3));
-                        _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r3, _k4));
-                        _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r3, _k5));
-                        _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r3, _k6));
-                        _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r3, _k7));
+                    _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r3, _k0));
+                    _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r3, _k1));
+                    _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r3, _k2));
+                    _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r3, _k3));
+                    _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r3, _k4));
+                    _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r3, _k5));
+                    _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r3, _k6));
+                    _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r3, _k7));
 #endif
-                        kptr += 32;
-                        r0 += 16;
-                    }
+                    kptr += 32;
+                    r0 += 16;
+                }
 
-                    for (; q<inch; q++)
-                    {
-                        __m128 _r0 = _mm_loadu_ps(r0);
-                        __m128 _k0 = _mm_loadu_ps(kptr);
-                        __m128 _k1 = _mm_loadu_ps(kptr+4);
-                        __m128 _k2 = _mm_loadu_ps(kptr+8);
-                        __m128 _k3 = _mm_loadu_ps(kptr+12);
-                        __m128 _k4 = _mm_loadu_ps(kptr+16);
-                        __m128 _k5 = _mm_loadu_ps(kptr+20);
-                        __m128 _k6 = _mm_loadu_ps(kptr+24);
-                        __m128 _k7 = _mm_loadu_ps(kptr+28);
+                for (; q<inch; q++)
+                {
+                    __m128 _r0 = _mm_loadu_ps(r0);
+                    __m128 _k0 = _mm_loadu_ps(kptr);
+                    __m128 _k1 = _mm_loadu_ps(kptr+4);
+                    __m128 _k2 = _mm_loadu_ps(kptr+8);
+                    __m128 _k3 = _mm_loadu_ps(kptr+12);
+                    __m128 _k4 = _mm_loadu_ps(kptr+16);
+                    __m128 _k5 = _mm_loadu_ps(kptr+20);
+                    __m128 _k6 = _mm_loadu_ps(kptr+24);
+                    __m128 _k7 = _mm_loadu_ps(kptr+28);
 
 #if __AVX__                        
-                        _sum0 = _mm_fmadd_ps(_r0, _k0, _sum0);
-                        _sum1 = _mm_fmadd_ps(_r0, _k1, _sum1);
-                        _sum2 = _mm_fmadd_ps(_r0, _k2, _sum2);
-                        _sum3 = _mm_fmadd_ps(_r0, _k3, _sum3);
-                        _sum4 = _mm_fmadd_ps(_r0, _k4, _sum4);
-                        _sum5 = _mm_fmadd_ps(_r0, _k5, _sum5);
-                        _sum6 = _mm_fmadd_ps(_r0, _k6, _sum6);
-                        _sum7 = _mm_fmadd_ps(_r0, _k7, _sum7);
+                    _sum0 = _mm_fmadd_ps(_r0, _k0, _sum0);
+                    _sum1 = _mm_fmadd_ps(_r0, _k1, _sum1);
+                    _sum2 = _mm_fmadd_ps(_r0, _k2, _sum2);
+                    _sum3 = _mm_fmadd_ps(_r0, _k3, _sum3);
+                    _sum4 = _mm_fmadd_ps(_r0, _k4, _sum4);
+                    _sum5 = _mm_fmadd_ps(_r0, _k5, _sum5);
+                    _sum6 = _mm_fmadd_ps(_r0, _k6, _sum6);
+                    _sum7 = _mm_fmadd_ps(_r0, _k7, _sum7);
 #else
-                        _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r0, _k0));
-                        _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r0, _k1));
-                        _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r0, _k2));
-                        _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r0, _k3));
-                        _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r0, _k4));
-                        _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r0, _k5));
-                        _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r0, _k6));
-                        _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r0, _k7));
+                    _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r0, _k0));
+                    _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r0, _k1));
+                    _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r0, _k2));
+                    _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r0, _k3));
+                    _sum4 = _mm_add_ps(_sum4, _mm_mul_ps(_r0, _k4));
+                    _sum5 = _mm_add_ps(_sum5, _mm_mul_ps(_r0, _k5));
+                    _sum6 = _mm_add_ps(_sum6, _mm_mul_ps(_r0, _k6));
+                    _sum7 = _mm_add_ps(_sum7, _mm_mul_ps(_r0, _k7));
 #endif
 
-                        kptr += 32;
-                        r0 += 4;
-                    }
+                    kptr += 32;
+                    r0 += 4;
+                }
 
-                    _mm_storeu_ps(output0_tm, _sum0);
-                    _mm_storeu_ps(output1_tm, _sum1);
-                    _mm_storeu_ps(output2_tm, _sum2);
-                    _mm_storeu_ps(output3_tm, _sum3);
-                    _mm_storeu_ps(output4_tm, _sum4);
-                    _mm_storeu_ps(output5_tm, _sum5);
-                    _mm_storeu_ps(output6_tm, _sum6);
-                    _mm_storeu_ps(output7_tm, _sum7);
+                _mm_storeu_ps(output0_tm, _sum0);
+                _mm_storeu_ps(output1_tm, _sum1);
+                _mm_storeu_ps(output2_tm, _sum2);
+                _mm_storeu_ps(output3_tm, _sum3);
+                _mm_storeu_ps(output4_tm, _sum4);
+                _mm_storeu_ps(output5_tm, _sum5);
+                _mm_storeu_ps(output6_tm, _sum6);
+                _mm_storeu_ps(output7_tm, _sum7);
 #else
-                    float sum0[4] = {0};
-                    float sum1[4] = {0};
-                    float sum2[4] = {0};
-                    float sum3[4] = {0};
-                    float sum4[4] = {0};
-                    float sum5[4] = {0};
-                    float sum6[4] = {0};
-                    float sum7[4] = {0};
-
-                    for (int q=0; q<inch; q++)
-                    {
-                        for (int n=0; n<4; n++)
-                        {
-                            sum0[n] += r0[n] * kptr[n];
-                            sum1[n] += r0[n] * kptr[n+4];
-                            sum2[n] += r0[n] * kptr[n+8];
-                            sum3[n] += r0[n] * kptr[n+12];
-                            sum4[n] += r0[n] * kptr[n+16];
-                            sum5[n] += r0[n] * kptr[n+20];
-                            sum6[n] += r0[n] * kptr[n+24];
-                            sum7[n] += r0[n] * kptr[n+28];
-                        }
-                        kptr += 32;
-                        r0 += 4;
-                    }
-
+                float sum0[4] = {0};
+                float sum1[4] = {0};
+                float sum2[4] = {0};
+                float sum3[4] = {0};
+                float sum4[4] = {0};
+                float sum5[4] = {0};
+                float sum6[4] = {0};
+                float sum7[4] = {0};
+
+                for (int q=0; q<inch; q++)
+                {
                     for (int n=0; n<4; n++)
                     {
-                        output0_tm[n] = sum0[n];
-                        output1_tm[n] = sum1[n];
-                        output2_tm[n] = sum2[n];
-                        output3_tm[n] = sum3[n];
-                        output4_tm[n] = sum4[n];
-                        output5_tm[n] = sum5[n];
-                        output6_tm[n] = sum6[n];
-                        output7_tm[n] = sum7[n];
+                        sum0[n] += r0[n] * kptr[n];
+                        sum1[n] += r0[n] * kptr[n+4];
+                        sum2[n] += r0[n] * kptr[n+8];
+                        sum3[n] += r0[n] * kptr[n+12];
+                        sum4[n] += r0[n] * kptr[n+16];
+                        sum5[n] += r0[n] * kptr[n+20];
+                        sum6[n] += r0[n] * kptr[n+24];
+                        sum7[n] += r0[n] * kptr[n+28];
                     }
-#endif // __AVX__
-                    output0_tm += 36;
-                    output1_tm += 36;
-                    output2_tm += 36;
-                    output3_tm += 36;
-                    output4_tm += 36;
-                    output5_tm += 36;
-                    output6_tm += 36;
-                    output7_tm += 36;
+                    kptr += 32;
+                    r0 += 4;
+                }
+
+                for (int n=0; n<4; n++)
+                {
+                    output0_tm[n] = sum0[n];
+                    output1_tm[n] = sum1[n];
+                    output2_tm[n] = sum2[n];
+                    output3_tm[n] = sum3[n];
+                    output4_tm[n] = sum4[n];
+                    output5_tm[n] = sum5[n];
+                    output6_tm[n] = sum6[n];
+                    output7_tm[n] = sum7[n];
                 }
+#endif // __AVX__
+                output0_tm += tm_size;
+                output1_tm += tm_size;
+                output2_tm += tm_size;
+                output3_tm += tm_size;
+                output4_tm += tm_size;
+                output5_tm += tm_size;
+                output6_tm += tm_size;
+                output7_tm += tm_size;
             }
+        }
 
-            nn_outch = (outch - remain_outch_start) >> 2;
+        nn_outch = (outch - remain_outch_start) >> 2;
 
-            for (int pp=0; pp<nn_outch; pp++)
-            {
-                int p = remain_outch_start + pp * 4;
+        for (int pp=0; pp<nn_outch; pp++)
+        {
+            int p = remain_outch_start + pp * 4;
 
-                float* output0_tm = top_blob_tm.channel(p);
-                float* output1_tm = top_blob_tm.channel(p+1);
-                float* output2_tm = top_blob_tm.channel(p+2);
-                float* output3_tm = top_blob_tm.channel(p+3);
+            float* output0_tm = top_blob_tm.channel(p);
+            float* output1_tm = top_blob_tm.channel(p+1);
+            float* output2_tm = top_blob_tm.channel(p+2);
+            float* output3_tm = top_blob_tm.channel(p+3);
 
-                output0_tm = output0_tm + r*4;
-                output1_tm = output1_tm + r*4;
-                output2_tm = output2_tm + r*4;
-                output3_tm = output3_tm + r*4;
+            output0_tm = output0_tm + r*4;
+            output1_tm = output1_tm + r*4;
+            output2_tm = output2_tm + r*4;
+            output3_tm = output3_tm + r*4;
 
-                for (int i=0; i<tiles; i++)
-                {
-                    const float* kptr = kernel_tm_test[r].channel(p/8 + (p%8)/4);
-                    const float* r0 = bottom_blob_tm.channel(tiles*r+i);
+            for (int i=0; i<tiles; i++)
+            {
+                const float* kptr = kernel_tm_test[r].channel(p/8 + (p%8)/4);
+                const float* r0 = bottom_blob_tm.channel(tiles*r+i);
 #if __AVX__ || __SSE__
 #if __AVX__
-                    float zero_val = 0.f;
-                    __m128 _sum0 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum1 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum2 = _mm_broadcast_ss(&zero_val);
-                    __m128 _sum3 = _mm_broadcast_ss(&zero_val);
+                float zero_val = 0.f;
+                __m128 _sum0 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum1 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum2 = _mm_broadcast_ss(&zero_val);
+                __m128 _sum3 = _mm_broadcast_ss(&zero_val);
 #else
-                    __m128 _sum0 = _mm_set1_ps(0.f);
-                    __m128 _sum1 = _mm_set1_ps(0.f);
-                    __m128 _sum2 = _mm_set1_ps(0.f);
-                    __m128 _sum3 = _mm_set1_ps(0.f);
+                __m128 _sum0 = _mm_set1_ps(0.f);
+                __m128 _sum1 = _mm_set1_ps(0.f);
+                __m128 _sum2 = _mm_set1_ps(0.f);
+                __m128 _sum3 = _mm_set1_ps(0.f);
 #endif
-                    for (int q=0; q<inch; q++)
-                    {
-                        __m128 _r0 = _mm_loadu_ps(r0);
-                        __m128 _k0 = _mm_loadu_ps(kptr);
-                        __m128 _k1 = _mm_loadu_ps(kptr+4);
-                        __m128 _k2 = _mm_loadu_ps(kptr+8);
-                        __m128 _k3 = _mm_loadu_ps(kptr+12);
+                for (int q=0; q<inch; q++)
+                {
+                    __m128 _r0 = _mm_loadu_ps(r0);
+                    __m128 _k0 = _mm_loadu_ps(kptr);
+                    __m128 _k1 = _mm_loadu_ps(kptr+4);
+                    __m128 _k2 = _mm_loadu_ps(kptr+8);
+                    __m128 _k3 = _mm_loadu_ps(kptr+12);
 #if __AVX__                        
-                        _sum0 = _mm_fmadd_ps(_r0, _k0, _sum0);
-                        _sum1 = _mm_fmadd_ps(_r0, _k1, _sum1);
-                        _sum2 = _mm_fmadd_ps(_r0, _k2, _sum2);
-                        _sum3 = _mm_fmadd_ps(_r0, _k3, _sum3);
+                    _sum0 = _mm_fmadd_ps(_r0, _k0, _sum0);
+                    _sum1 = _mm_fmadd_ps(_r0, _k1, _sum1);
+                    _sum2 = _mm_fmadd_ps(_r0, _k2, _sum2);
+                    _sum3 = _mm_fmadd_ps(_r0, _k3, _sum3);
 #else
-                        _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r0, _k0));
-                        _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r0, _k1));
-                        _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r0, _k2));
-                        _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r0, _k3));
+                    _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r0, _k0));
+                    _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_r0, _k1));
+                    _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_r0, _k2));
+                    _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_r0, _k3));
 #endif
-                        kptr += 16;
-                        r0 += 4;
-                    }
+                    kptr += 16;
+                    r0 += 4;
+                }
 
-                    _mm_storeu_ps(output0_tm, _sum0);
-                    _mm_storeu_ps(output1_tm, _sum1);
-                    _mm_storeu_ps(output2_tm, _sum2);
-                    _mm_storeu_ps(output3_tm, _sum3);
+                _mm_storeu_ps(output0_tm, _sum0);
+                _mm_storeu_ps(output1_tm, _sum1);
+                _mm_storeu_ps(output2_tm, _sum2);
+                _mm_storeu_ps(output3_tm, _sum3);
 #else
-                    float sum0[4] = {0};
-                    float sum1[4] = {0};
-                    float sum2[4] = {0};
-                    float sum3[4] = {0};
-
-                    for (int q=0; q<inch; q++)
-                    {   
-                        for (int n=0; n<4; n++)
-                        {
-                            sum0[n] += r0[n] * kptr[n];
-                            sum1[n] += r0[n] * kptr[n+4];
-                            sum2[n] += r0[n] * kptr[n+8];
-                            sum3[n] += r0[n] * kptr[n+12];
-                        }
-                        kptr += 16;
-                        r0 += 4;
-                    }
+                float sum0[4] = {0};
+                float sum1[4] = {0};
+                float sum2[4] = {0};
+                float sum3[4] = {0};
 
+                for (int q=0; q<inch; q++)
+                {   
                     for (int n=0; n<4; n++)
                     {
-                        output0_tm[n] = sum0[n];
-                        output1_tm[n] = sum1[n];
-                        output2_tm[n] = sum2[n];
-                        output3_tm[n] = sum3[n];
+                        sum0[n] += r0[n] * kptr[n];
+                        sum1[n] += r0[n] * kptr[n+4];
+                        sum2[n] += r0[n] * kptr[n+8];
+                        sum3[n] += r0[n] * kptr[n+12];
                     }
-#endif // __AVX__
-                    output0_tm += 36;
-                    output1_tm += 36;
-                    output2_tm += 36;
-                    output3_tm += 36;
+                    kptr += 16;
+                    r0 += 4;
+                }
+
+                for (int n=0; n<4; n++)
+                {
+                    output0_tm[n] = sum0[n];
+                    output1_tm[n] = sum1[n];
+                    output2_tm[n] = sum2[n];
+                    output3_tm[n] = sum3[n];
                 }
+#endif // __AVX__
+                output0_tm += tm_size;
+                output1_tm += tm_size;
+                output2_tm += tm_size;
+                output3_tm += tm_size;
             }
+        }
 
-            remain_outch_start += nn_outch << 2;
+        remain_outch_start += nn_outch << 2;
 
-            for (int p=remain_outch_start; p<outch; p++)
-            {
-                float* output0_tm = top_blob_tm.channel(p);
+        for (int p=remain_outch_start; p<outch; p++)
+        {
+            float* output0_tm = top_blob_tm.channel(p);
 
-                output0_tm = output0_tm + r*4;
+            output0_tm = output0_tm + r*4;
 
-                for (int i=0; i<tiles; i++)
-                {
-                    const float* kptr = kernel_tm_test[r].channel(p/8 + (p%8)/4 + p%4);
-                    const float* r0 = bottom_blob_tm.channel(tiles*r+i);
+            for (int i=0; i<tiles; i++)
+            {
+                const float* kptr = kernel_tm_test[r].channel(p/8 + (p%8)/4 + p%4);
+                const float* r0 = bottom_blob_tm.channel(tiles*r+i);
 #if __AVX__ || __SSE__
 #if __AVX__
-                    float zero_val = 0.f;
-                    __m128 _sum0 = _mm_broadcast_ss(&zero_val);
+                float zero_val = 0.f;
+                __m128 _sum0 = _mm_broadcast_ss(&zero_val);
 #else
-                    __m128 _sum0 = _mm_set1_ps(0.f);
+                __m128 _sum0 = _mm_set1_ps(0.f);
 #endif
 
-                    for (int q=0; q<inch; q++)
-                    {
-                        __m128 _r0 = _mm_loadu_ps(r0);
-                        __m128 _k0 = _mm_loadu_ps(kptr);
+                for (int q=0; q<inch; q++)
+                {
+                    __m128 _r0 = _mm_loadu_ps(r0);
+                    __m128 _k0 = _mm_loadu_ps(kptr);
 #if __AVX__
-                        _sum0 = _mm_fmadd_ps(_r0, _k0, _sum0);
+                    _sum0 = _mm_fmadd_ps(_r0, _k0, _sum0);
 #else
-                        _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r0, _k0));
+                    _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_r0, _k0));
 #endif
-                        kptr += 16;
-                        r0 += 4;
-                    }
-                    _mm_storeu_ps(output0_tm, _sum0);
+                    kptr += 4;
+                    r0 += 4;
+                }
+                _mm_storeu_ps(output0_tm, _sum0);
 #else
-                    float sum0[4] = {0};
-
-                    for (int q=0; q<inch; q++)
-                    {
-                        for (int n=0; n<4; n++)
-                        {
-                            sum0[n] += (int)r0[n] * kptr[n];
-                        }
-                        kptr += 4; 
-                        r0 += 4;
-                    }
+                float sum0[4] = {0};
 
+                for (int q=0; q<inch; q++)
+                {
                     for (int n=0; n<4; n++)
                     {
-                        output0_tm[n] = sum0[n];
+                        sum0[n] += r0[n] * kptr[n];
                     }
-#endif // __AVX__ || __SSE__
-                    output0_tm += 36;
+                    kptr += 4; 
+                    r0 += 4;
                 }
-            }
 
-            // for (int p=0; p<outch; p++)
-            // {
-            //     Mat out0_tm = top_blob_tm.channel(p);
-            //     const Mat kernel0_tm = kernel_tm.channel(p);
-
-            //     for (int i=0; i<tiles; i++)
-            //     {
-            //         float* output0_tm = out0_tm.row<int>(i);
-
-            //         int sum0[36] = {0};
-
-            //         for (int q=0; q<inch; q++)
-            //         {
-            //             const float* r0 = bottom_blob_tm.channel(q).row<float>(i);
-            //             const float* k0 = kernel0_tm.row<float>(q);
-
-            //             for (int n=0; n<36; n++)
-            //             {
-            //                 sum0[n] += (int)r0[n] * k0[n];
-            //             }
-            //         }
-
-            //         for (int n=0; n<36; n++)
-            //         {
-            //             output0_tm[n] = sum0[n];
-            //         }
-            //     }
-            // }
+                for (int n=0; n<4; n++)
+                {
+                    output0_tm[n] = sum0[n];
+                }
+#endif // __AVX__ || __SSE__
+                output0_tm += tm_size;
+            }
         }
 
+        // for (int p=0; p<outch; p++)
+        // {
+        //     Mat out0_tm = top_blob_tm.channel(p);
+        //     const Mat kernel0_tm = kernel_tm.channel(p);
+
+        //     for (int i=0; i<tiles; i++)
+        //     {
+        //         float* output0_tm = out0_tm.row<int>(i);
+
+        //         int sum0[36] = {0};
+
+        //         for (int q=0; q<inch; q++)
+        //         {
+        //             const float* r0 = bottom_blob_tm.channel(q).row<float>(i);
+        //             const float* k0 = kernel0_tm.row<float>(q);
+
+        //             for (int n=0; n<36; n++)
+        //             {
+        //                 sum0[n] += (int)r0[n] * k0[n];
+        //             }
+        //         }
+
+        //         for (int n=0; n<36; n++)
+        //         {
+        //             output0_tm[n] = sum0[n];
+        //         }
+        //     }
+        // }
     }
-    bottom_blob_tm = Mat();
-    // END dot 
+}
 
-    // BEGIN transform output
-    Mat top_blob_bordered;
-    top_blob_bordered.create(outw, outh, outch, elemsize, opt.workspace_allocator);
-    {
-        // AT
-        // const float itm[4][6] = {
-        //     {1.0f, 1.0f,  1.0f, 1.0f,  1.0f, 0.0f},
-        //     {0.0f, 1.0f, -1.0f, 2.0f, -2.0f, 0.0f},
-        //     {0.0f, 1.0f,  1.0f, 4.0f,  4.0f, 0.0f},
-        //     {0.0f, 1.0f, -1.0f, 8.0f, -8.0f, 1.0f}
-        // };
+// inverse transform the tiles [tile_start, tile_start + tiles) in row major tile order
+// top_blob_tm holds 36 x tiles x outch for these tiles only
+static void conv3x3s1_winograd43_transform_output_tile_sse(const Mat& top_blob_tm, Mat& top_blob_bordered, const Mat& _bias, int activation_type, const Mat& activation_params, int tile_start, int tiles, const Option& opt)
+{
+    int outw = top_blob_bordered.w;
+    int outch = top_blob_bordered.c;
 
-        // 0 =	r00 + r01 + r02 + r03 +	r04
-        // 1 =		  r01 - r02 + 2 * (r03 - r04)
-        // 2 =		  r01 + r02 + 4 * (r03 + r04)
-        // 3 =		  r01 - r02 + 8 * (r03 - r04)  + r05
-        
+    const float* bias = _bias;
 
-        int w_tm = outw / 4 * 6;
-        int h_tm = outh / 4 * 6;
+    // AT
+    // const float itm[4][6] = {
+    //     {1.0f, 1.0f,  1.0f, 1.0f,  1.0f, 0.0f},
+    //     {0.0f, 1.0f, -1.0f, 2.0f, -2.0f, 0.0f},
+    //     {0.0f, 1.0f,  1.0f, 4.0f,  4.0f, 0.0f},
+    //     {0.0f, 1.0f, -1.0f, 8.0f, -8.0f, 1.0f}
+    // };
 
-        int nColBlocks = h_tm/6; // may be the block num in Feathercnn
-        int nRowBlocks = w_tm/6;
+    // 0 =	r00 + r01 + r02 + r03 +	r04
+    // 1 =		  r01 - r02 + 2 * (r03 - r04)
+    // 2 =		  r01 + r02 + 4 * (r03 + r04)
+    // 3 =		  r01 - r02 + 8 * (r03 - r04)  + r05
+    
 
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int p=0; p<outch; p++)
+    int w_tm = outw / 4 * 6;
+
+    int nRowBlocks = w_tm/6;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<outch; p++)
+    {
+        const float* out_tile = top_blob_tm.channel(p);
+
+        const float bias0 = bias ? bias[p] : 0.f;
+
+        for (int t=0; t<tiles; t++)
         {
-            float* out_tile = top_blob_tm.channel(p);
-            float* outRow0 = top_blob_bordered.channel(p);
+            const int j = (tile_start + t) / nRowBlocks;
+            const int i = (tile_start + t) % nRowBlocks;
+
+            float* outRow0 = top_blob_bordered.channel(p).row(j * 4) + i * 4;
             float* outRow1 = outRow0 + outw;
             float* outRow2 = outRow0 + outw * 2;
             float* outRow3 = outRow0 + outw * 3;
 
-            const float bias0 = bias ? bias[p] : 0.f;
+            // TODO AVX2
+            float s0[6],s1[6],s2[6],s3[6],s4[6],s5[6];
+            float w0[6],w1[6],w2[6],w3[6];
+            float d0[4],d1[4],d2[4],d3[4],d4[4],d5[4];
+            float o0[4],o1[4],o2[4],o3[4];
 
-            for (int j=0; j<nColBlocks; j++)
+            // load
+            for (int n = 0; n < 6; n++)
             {
-                for(int i=0; i<nRowBlocks; i++)
+                s0[n] = out_tile[n];
+                s1[n] = out_tile[n+ 6];
+                s2[n] = out_tile[n+12];
+                s3[n] = out_tile[n+18];
+                s4[n] = out_tile[n+24];
+                s5[n] = out_tile[n+30];
+            }
+            // w = A_T * W
+            for (int n = 0; n < 6; n++)
+            {
+                w0[n] = s0[n] + s1[n] + s2[n] +   s3[n] +   s4[n];
+                w1[n] =         s1[n] - s2[n] + 2*s3[n] - 2*s4[n];
+                w2[n] =         s1[n] + s2[n] + 4*s3[n] + 4*s4[n];
+                w3[n] =         s1[n] - s2[n] + 8*s3[n] - 8*s4[n] + s5[n];
+            }
+            // transpose w to w_t
+            {
+                d0[0] = w0[0]; d0[1] = w1[0]; d0[2] = w2[0]; d0[3] = w3[0];
+                d1[0] = w0[1]; d1[1] = w1[1]; d1[2] = w2[1]; d1[3] = w3[1];
+                d2[0] = w0[2]; d2[1] = w1[2]; d2[2] = w2[2]; d2[3] = w3[2];
+                d3[0] = w0[3]; d3[1] = w1[3]; d3[2] = w2[3]; d3[3] = w3[3];
+                d4[0] = w0[4]; d4[1] = w1[4]; d4[2] = w2[4]; d4[3] = w3[4];
+                d5[0] = w0[5]; d5[1] = w1[5]; d5[2] = w2[5]; d5[3] = w3[5];
+            }
+            // Y = A_T * w_t
+            for (int n = 0; n < 4; n++)
+            {
+                o0[n] = d0[n] + d1[n] + d2[n] +   d3[n] +   d4[n];
+                o1[n] =         d1[n] - d2[n] + 2*d3[n] - 2*d4[n];
+                o2[n] =         d1[n] + d2[n] + 4*d3[n] + 4*d4[n];
+                o3[n] =         d1[n] - d2[n] + 8*d3[n] - 8*d4[n] + d5[n];
+            }
+            // save to top blob tm, bias and activation fused
+#if __SSE2__
+            __m128 _bias0 = _mm_set1_ps(bias0);
+            _mm_storeu_ps(outRow0, activation_sse(_mm_add_ps(_mm_loadu_ps(o0), _bias0), activation_type, activation_params));
+            _mm_storeu_ps(outRow1, activation_sse(_mm_add_ps(_mm_loadu_ps(o1), _bias0), activation_type, activation_params));
+            _mm_storeu_ps(outRow2, activation_sse(_mm_add_ps(_mm_loadu_ps(o2), _bias0), activation_type, activation_params));
+            _mm_storeu_ps(outRow3, activation_sse(_mm_add_ps(_mm_loadu_ps(o3), _bias0), activation_type, activation_params));
+#else
+            for (int n = 0; n < 4; n++)
+            {
+                outRow0[n] = activation_ss(o0[n] + bias0, activation_type, activation_params);
+                outRow1[n] = activation_ss(o1[n] + bias0, activation_type, activation_params);
+                outRow2[n] = activation_ss(o2[n] + bias0, activation_type, activation_params);
+                outRow3[n] = activation_ss(o3[n] + bias0, activation_type, activation_params);
+            }
+#endif // __SSE2__
+
+            out_tile += 36;
+        }
+    }
+}
+
+typedef void (*conv3x3s1_winograd_dot_func)(const Mat&, Mat&, const std::vector<Mat>&, int, const Option&);
+
+static int conv3x3s1_winograd43_tile_size(int inch, int outch, int tiles, const Option& opt)
+{
+    // the whole feature map at once
+    if (opt.winograd_tile_size < 0)
+        return tiles;
+
+    if (opt.winograd_tile_size > 0)
+        return std::min(opt.winograd_tile_size, tiles);
+
+    // the transformed kernel is read once per group,
+    // keep the whole feature map when the kernel outweighs the input
+    if (outch > tiles)
+        return tiles;
+
+    // transformed input and output of one group in about 1m,
+    // and enough tiles to amortize the kernel read
+    int tile_size = 1024 * 1024 / ((inch + outch) * 36 * 4);
+    tile_size = std::min(std::max(tile_size, 32), 64);
+
+    return std::min(tile_size, tiles);
+}
+
+// the 4x4 output tiles are processed in groups, each group runs input transform,
+// dot and output transform back to back while its transformed blobs are in cache,
+// so the workspace is bounded by the group size instead of the feature map size
+static void conv3x3s1_winograd43_tiled_sse(const Mat& bottom_blob, Mat& top_blob, const std::vector<Mat> &kernel_tm_test, const Mat& _bias, int activation_type, const Mat& activation_params, conv3x3s1_winograd_dot_func dot, const Option& opt)
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int inch = bottom_blob.c;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+
+    size_t elemsize = bottom_blob.elemsize;
+
+    // pad to 4n+2, winograd F(4,3)
+    Mat bottom_blob_bordered = bottom_blob;
+
+    outw = (outw + 3) / 4 * 4;
+    outh = (outh + 3) / 4 * 4;
+
+    w = outw + 2;
+    h = outh + 2;
+
+    copy_make_border(bottom_blob, bottom_blob_bordered, 0, h - bottom_blob.h, 0, w - bottom_blob.w, 0, 0.f, opt.workspace_allocator, opt.num_threads);
+
+    // write to top_blob directly when there is no result pad
+    Mat top_blob_bordered = top_blob;
+    if (outw != top_blob.w || outh != top_blob.h)
+    {
+        top_blob_bordered.create(outw, outh, outch, elemsize, opt.workspace_allocator);
+    }
+
+    const int tiles = (outw / 4) * (outh / 4);
+    const int tile_size = conv3x3s1_winograd43_tile_size(inch, outch, tiles, opt);
+    const int nn_group = (tiles + tile_size - 1) / tile_size;
+
+    // one thread per group when there are enough groups,
+    // otherwise the groups run one by one with all threads
+    const int num_threads = nn_group >= opt.num_threads ? opt.num_threads : 1;
+
+    Option opt_g = opt;
+    if (num_threads > 1)
+        opt_g.num_threads = 1;
+
+    // transformed input and output of one group for each thread
+    Mat bottom_blob_tm_ws(4, inch, tile_size * 9 * num_threads, elemsize, opt.workspace_allocator);
+    Mat top_blob_tm_ws(36 * tile_size, outch, num_threads, elemsize, opt.workspace_allocator);
+
+    #pragma omp parallel for num_threads(num_threads)
+    for (int t=0; t<num_threads; t++)
+    {
+        for (int g=t; g<nn_group; g+=num_threads)
+        {
+            const int tile_start = g * tile_size;
+            const int n = std::min(tile_size, tiles - tile_start);
+
+            Mat bottom_blob_tm = bottom_blob_tm_ws.channel_range(tile_size * 9 * t, n * 9);
+
+            // the dot keeps this top_blob_tm as the shape matches
+            Mat top_blob_tm(36, n, outch, (float*)top_blob_tm_ws.channel(t), elemsize, opt.workspace_allocator);
+
+            conv3x3s1_winograd43_transform_input_tile_sse(bottom_blob_bordered, bottom_blob_tm, tile_start, n, opt_g);
+
+            dot(bottom_blob_tm, top_blob_tm, kernel_tm_test, outch, opt_g);
+
+            conv3x3s1_winograd43_transform_output_tile_sse(top_blob_tm, top_blob_bordered, _bias, activation_type, activation_params, tile_start, n, opt_g);
+        }
+    }
+
+    // cut result pad
+    if (top_blob_bordered.data != top_blob.data)
+    {
+        copy_cut_border(top_blob_bordered, top_blob, 0, top_blob_bordered.h - top_blob.h, 0, top_blob_bordered.w - top_blob.w, opt.blob_allocator, opt.num_threads);
+    }
+}
+
+static void conv3x3s1_winograd43_sse(const Mat& bottom_blob, Mat& top_blob, const std::vector<Mat> &kernel_tm_test, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    conv3x3s1_winograd43_tiled_sse(bottom_blob, top_blob, kernel_tm_test, _bias, activation_type, activation_params, conv3x3s1_winograd_dot_sse, opt);
+}
+
+static void conv3x3s1_winograd63_transform_kernel_sse(const Mat& kernel, std::vector<Mat> &kernel_tm2, int inch, int outch)
+{
+    Mat kernel_tm(8*8, inch, outch);
+
+    // G
+    const float ktm[8][3] = {
+        {   1.0f,     0.0f,     0.0f},
+        {-2.0f/9,  -2.0f/9,  -2.0f/9},
+        {-2.0f/9,   2.0f/9,  -2.0f/9},
+        {1.0f/90,  1.0f/45,  2.0f/45},
+        {1.0f/90, -1.0f/45,  2.0f/45},
+        {1.0f/45,  1.0f/90, 1.0f/180},
+        {1.0f/45, -1.0f/90, 1.0f/180},
+        {   0.0f,     0.0f,     1.0f}
+    };
+
+    #pragma omp parallel for
+    for (int p = 0; p<outch; p++)
+    {
+        for (int q = 0; q<inch; q++)
+        {
+            const float* kernel0 = (const float*)kernel + p*inch * 9 + q * 9;
+            float* kernel_tm0 = kernel_tm.channel(p).row(q);
+
+            // transform kernel
+            const float* k0 = kernel0;
+            const float* k1 = kernel0 + 3;
+            const float* k2 = kernel0 + 6;
+
+            // h
+            float tmp[8][3];
+            for (int i=0; i<8; i++)
+            {
+                tmp[i][0] = k0[0] * ktm[i][0] + k0[1] * ktm[i][1] + k0[2] * ktm[i][2];
+                tmp[i][1] = k1[0] * ktm[i][0] + k1[1] * ktm[i][1] + k1[2] * ktm[i][2];
+                tmp[i][2] = k2[0] * ktm[i][0] + k2[1] * ktm[i][1] + k2[2] * ktm[i][2];
+            }
+
+            // U, row major
+            for (int j=0; j<8; j++)
+            {
+                float* tmpp = &tmp[j][0];
+
+                for (int i=0; i<8; i++)
                 {
-                    // TODO AVX2
-                    float s0[6],s1[6],s2[6],s3[6],s4[6],s5[6];
-                    float w0[6],w1[6],w2[6],w3[6];
-                    float d0[4],d1[4],d2[4],d3[4],d4[4],d5[4];
-                    float o0[4],o1[4],o2[4],o3[4];
+                    kernel_tm0[i*8 + j] = tmpp[0] * ktm[i][0] + tmpp[1] * ktm[i][1] + tmpp[2] * ktm[i][2];
+                }
+            }
+        }
+    }
 
-                    // load
-                    for (int n = 0; n < 6; n++)
-                    {
-                        s0[n] = out_tile[n];
-                        s1[n] = out_tile[n+ 6];
-                        s2[n] = out_tile[n+12];
-                        s3[n] = out_tile[n+18];
-                        s4[n] = out_tile[n+24];
-                        s5[n] = out_tile[n+30];
-                    }
-                    // w = A_T * W
-                    for (int n = 0; n < 6; n++)
-                    {
-                        w0[n] = s0[n] + s1[n] + s2[n] +   s3[n] +   s4[n];
-                        w1[n] =         s1[n] - s2[n] + 2*s3[n] - 2*s4[n];
-                        w2[n] =         s1[n] + s2[n] + 4*s3[n] + 4*s4[n];
-                        w3[n] =         s1[n] - s2[n] + 8*s3[n] - 8*s4[n] + s5[n];
-                    }
-                    // transpose w to w_t
-                    {
-                        d0[0] = w0[0]; d0[1] = w1[0]; d0[2] = w2[0]; d0[3] = w3[0];
-                        d1[0] = w0[1]; d1[1] = w1[1]; d1[2] = w2[1]; d1[3] = w3[1];
-                        d2[0] = w0[2]; d2[1] = w1[2]; d2[2] = w2[2]; d2[3] = w3[2];
-                        d3[0] = w0[3]; d3[1] = w1[3]; d3[2] = w2[3]; d3[3] = w3[3];
-                        d4[0] = w0[4]; d4[1] = w1[4]; d4[2] = w2[4]; d4[3] = w3[4];
-                        d5[0] = w0[5]; d5[1] = w1[5]; d5[2] = w2[5]; d5[3] = w3[5];
-                    }
-                    // Y = A_T * w_t
-                    for (int n = 0; n < 4; n++)
-                    {
-                        o0[n] = d0[n] + d1[n] + d2[n] +   d3[n] +   d4[n];
-                        o1[n] =         d1[n] - d2[n] + 2*d3[n] - 2*d4[n];
-                        o2[n] =         d1[n] + d2[n] + 4*d3[n] + 4*d4[n];
-                        o3[n] =         d1[n] - d2[n] + 8*d3[n] - 8*d4[n] + d5[n];
-                    }
-                    // save to top blob tm
-                    for (int n = 0; n < 4; n++)
+    conv3x3s1_winograd_pack_kernel_sse(kernel_tm, kernel_tm2, inch, outch);
+}
+
+static void conv3x3s1_winograd63_transform_input_sse(const Mat& bottom_blob_bordered, Mat& bottom_blob_tm, const Option& opt)
+{
+    int w = bottom_blob_bordered.w;
+    int inch = bottom_blob_bordered.c;
+    size_t elemsize = bottom_blob_bordered.elemsize;
+
+    // bordered to 6n+2
+    int outw = w - 2;
+    int outh = bottom_blob_bordered.h - 2;
+
+    int nColBlocks = outh / 6;
+    int nRowBlocks = outw / 6;
+
+    const int tiles = nColBlocks * nRowBlocks;
+
+    bottom_blob_tm.create(4, inch, tiles*16, elemsize, opt.workspace_allocator);
+
+    // BT
+    // const float itm[8][8] = {
+    //     {1.0f,  0.0f, -5.25f,  0.00f,  5.25f,  0.00f, -1.0f, 0.0f},
+    //     {0.0f,  1.0f,  1.00f, -4.25f, -4.25f,  1.00f,  1.0f, 0.0f},
+    //     {0.0f, -1.0f,  1.00f,  4.25f, -4.25f, -1.00f,  1.0f, 0.0f},
+    //     {0.0f,  0.5f,  0.25f, -2.50f, -1.25f,  2.00f,  1.0f, 0.0f},
+    //     {0.0f, -0.5f,  0.25f,  2.50f, -1.25f, -2.00f,  1.0f, 0.0f},
+    //     {0.0f,  2.0f,  4.00f, -2.50f, -5.00f,  0.50f,  1.0f, 0.0f},
+    //     {0.0f, -2.0f,  4.00f,  2.50f, -5.00f, -0.50f,  1.0f, 0.0f},
+    //     {0.0f, -1.0f,  0.00f,  5.25f,  0.00f, -5.25f,  0.0f, 1.0f}
+    // };
+
+    // 0 = r00 - r06 + (r04 - r02) * 5.25
+    // 7 = r07 - r01 + (r03 - r05) * 5.25
+    // 1 = (r02 + r06 - r04 * 4.25) + (r01 - r03 * 4.25 + r05)
+    // 2 = (r02 + r06 - r04 * 4.25) - (r01 - r03 * 4.25 + r05)
+    // 3 = (r06 + r02 * 0.25 - r04 * 1.25) + (r01 * 0.5 - r03 * 2.5 + r05 * 2)
+    // 4 = (r06 + r02 * 0.25 - r04 * 1.25) - (r01 * 0.5 - r03 * 2.5 + r05 * 2)
+    // 5 = (r06 + (r02 - r04 * 1.25) * 4) + (r01 * 2 - r03 * 2.5 + r05 * 0.5)
+    // 6 = (r06 + (r02 - r04 * 1.25) * 4) - (r01 * 2 - r03 * 2.5 + r05 * 0.5)
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<inch; q++)
+    {
+        const float* img = bottom_blob_bordered.channel(q);
+
+        float tmp[8][8];
+
+        for (int j = 0; j < nColBlocks; j++)
+        {
+            for (int i = 0; i < nRowBlocks; i++)
+            {
+                const float* r0 = img + w * j * 6 + i * 6;
+
+                // d * B
+                for (int m=0; m<8; m++)
+                {
+                    float tmp12a = r0[2] + r0[6] - r0[4] * 4.25f;
+                    float tmp12b = r0[1] + r0[5] - r0[3] * 4.25f;
+                    float tmp34a = r0[6] + r0[2] * 0.25f - r0[4] * 1.25f;
+                    float tmp34b = r0[1] * 0.5f - r0[3] * 2.5f + r0[5] * 2.f;
+                    float tmp56a = r0[6] + (r0[2] - r0[4] * 1.25f) * 4.f;
+                    float tmp56b = r0[1] * 2.f - r0[3] * 2.5f + r0[5] * 0.5f;
+
+                    tmp[m][0] = r0[0] - r0[6] + (r0[4] - r0[2]) * 5.25f;
+                    tmp[m][1] = tmp12a + tmp12b;
+                    tmp[m][2] = tmp12a - tmp12b;
+                    tmp[m][3] = tmp34a + tmp34b;
+                    tmp[m][4] = tmp34a - tmp34b;
+                    tmp[m][5] = tmp56a + tmp56b;
+                    tmp[m][6] = tmp56a - tmp56b;
+                    tmp[m][7] = r0[7] - r0[1] + (r0[3] - r0[5]) * 5.25f;
+
+                    r0 += w;
+                }
+
+                // B_t * (d * B), 4 elements per tm channel
+                float d[8][8];
+                for (int n=0; n<8; n++)
+                {
+                    float tmp12a = tmp[2][n] + tmp[6][n] - tmp[4][n] * 4.25f;
+                    float tmp12b = tmp[1][n] + tmp[5][n] - tmp[3][n] * 4.25f;
+                    float tmp34a = tmp[6][n] + tmp[2][n] * 0.25f - tmp[4][n] * 1.25f;
+                    float tmp34b = tmp[1][n] * 0.5f - tmp[3][n] * 2.5f + tmp[5][n] * 2.f;
+                    float tmp56a = tmp[6][n] + (tmp[2][n] - tmp[4][n] * 1.25f) * 4.f;
+                    float tmp56b = tmp[1][n] * 2.f - tmp[3][n] * 2.5f + tmp[5][n] * 0.5f;
+
+                    d[0][n] = tmp[0][n] - tmp[6][n] + (tmp[4][n] - tmp[2][n]) * 5.25f;
+                    d[1][n] = tmp12a + tmp12b;
+                    d[2][n] = tmp12a - tmp12b;
+                    d[3][n] = tmp34a + tmp34b;
+                    d[4][n] = tmp34a - tmp34b;
+                    d[5][n] = tmp56a + tmp56b;
+                    d[6][n] = tmp56a - tmp56b;
+                    d[7][n] = tmp[7][n] - tmp[1][n] + (tmp[3][n] - tmp[5][n]) * 5.25f;
+                }
+
+                const float* dptr = &d[0][0];
+                for (int r=0; r<16; r++)
+                {
+                    float* out_tm = bottom_blob_tm.channel(tiles*r+j*nRowBlocks+i).row(q);
+
+                    out_tm[0] = dptr[0];
+                    out_tm[1] = dptr[1];
+                    out_tm[2] = dptr[2];
+                    out_tm[3] = dptr[3];
+
+                    dptr += 4;
+                }
+            }
+        }
+    }
+}
+
+static void conv3x3s1_winograd63_transform_output_sse(const Mat& top_blob_tm, Mat& top_blob_bordered, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    int outw = top_blob_bordered.w;
+    int outh = top_blob_bordered.h;
+    int outch = top_blob_bordered.c;
+
+    const float* bias = _bias;
+
+    // AT
+    // const float otm[6][8] = {
+    //     {1.0f,  1.0f,  1.0f,  1.0f,  1.0f, 32.0f, 32.0f, 0.0f},
+    //     {0.0f,  1.0f, -1.0f,  2.0f, -2.0f, 16.0f,-16.0f, 0.0f},
+    //     {0.0f,  1.0f,  1.0f,  4.0f,  4.0f,  8.0f,  8.0f, 0.0f},
+    //     {0.0f,  1.0f, -1.0f,  8.0f, -8.0f,  4.0f, -4.0f, 0.0f},
+    //     {0.0f,  1.0f,  1.0f, 16.0f, 16.0f,  2.0f,  2.0f, 0.0f},
+    //     {0.0f,  1.0f, -1.0f, 32.0f,-32.0f,  1.0f, -1.0f, 1.0f}
+    // };
+
+    // 0 = r0 + (r1 + r2) + (r3 + r4)     + (r5 + r6) * 32
+    // 1 =      (r1 - r2) + (r3 - r4) * 2 + (r5 - r6) * 16
+    // 2 =      (r1 + r2) + (r3 + r4) * 4 + (r5 + r6) * 8
+    // 3 =      (r1 - r2) + (r3 - r4) * 8 + (r5 - r6) * 4
+    // 4 =      (r1 + r2) + (r3 + r4) * 16+ (r5 + r6) * 2
+    // 5 = r7 + (r1 - r2) + (r3 - r4) * 32+ (r5 - r6)
+
+    int nColBlocks = outh / 6;
+    int nRowBlocks = outw / 6;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<outch; p++)
+    {
+        const float* out_tile = top_blob_tm.channel(p);
+        float* outptr = top_blob_bordered.channel(p);
+
+        const float bias0 = bias ? bias[p] : 0.f;
+
+        float tmp[8][6];
+
+        for (int j=0; j<nColBlocks; j++)
+        {
+            for (int i=0; i<nRowBlocks; i++)
+            {
+                // M * A
+                for (int m=0; m<8; m++)
+                {
+                    const float* r0 = out_tile + m * 8;
+
+                    float tmp024a = r0[1] + r0[2];
+                    float tmp135a = r0[1] - r0[2];
+                    float tmp024b = r0[3] + r0[4];
+                    float tmp135b = r0[3] - r0[4];
+                    float tmp024c = r0[5] + r0[6];
+                    float tmp135c = r0[5] - r0[6];
+
+                    tmp[m][0] = r0[0] + tmp024a + tmp024b + tmp024c * 32;
+                    tmp[m][2] = tmp024a + tmp024b * 4 + tmp024c * 8;
+                    tmp[m][4] = tmp024a + tmp024b * 16 + tmp024c + tmp024c;
+                    tmp[m][1] = tmp135a + tmp135b + tmp135b + tmp135c * 16;
+                    tmp[m][3] = tmp135a + tmp135b * 8 + tmp135c * 4;
+                    tmp[m][5] = r0[7] + tmp135a + tmp135b * 32 + tmp135c;
+                }
+
+                // A_t * (M * A) + bias
+                float out[6][6];
+
+                for (int n=0; n<6; n++)
+                {
+                    float tmp024a = tmp[1][n] + tmp[2][n];
+                    float tmp135a = tmp[1][n] - tmp[2][n];
+                    float tmp024b = tmp[3][n] + tmp[4][n];
+                    float tmp135b = tmp[3][n] - tmp[4][n];
+                    float tmp024c = tmp[5][n] + tmp[6][n];
+                    float tmp135c = tmp[5][n] - tmp[6][n];
+
+                    out[0][n] = bias0 + tmp[0][n] + tmp024a + tmp024b + tmp024c * 32;
+                    out[2][n] = bias0 + tmp024a + tmp024b * 4 + tmp024c * 8;
+                    out[4][n] = bias0 + tmp024a + tmp024b * 16 + tmp024c + tmp024c;
+                    out[1][n] = bias0 + tmp135a + tmp135b + tmp135b + tmp135c * 16;
+                    out[3][n] = bias0 + tmp135a + tmp135b * 8 + tmp135c * 4;
+                    out[5][n] = bias0 + tmp[7][n] + tmp135a + tmp135b * 32 + tmp135c;
+                }
+
+                // activation fused into the store
+                float* output0 = outptr + j * 6 * outw + i * 6;
+
+                for (int m=0; m<6; m++)
+                {
+#if __SSE2__
+                    // the two overlapping halves cover the 6 outputs of the row
+                    __m128 _out0 = activation_sse(_mm_loadu_ps(out[m]), activation_type, activation_params);
+                    __m128 _out1 = activation_sse(_mm_loadu_ps(out[m] + 2), activation_type, activation_params);
+                    _mm_storeu_ps(output0 + 2, _out1);
+                    _mm_storeu_ps(output0, _out0);
+#else
+                    for (int n=0; n<6; n++)
                     {
-                        outRow0[n] = o0[n] + bias0;
-                        outRow1[n] = o1[n] + bias0;
-                        outRow2[n] = o2[n] + bias0;
-                        outRow3[n] = o3[n] + bias0;
+                        output0[n] = activation_ss(out[m][n], activation_type, activation_params);
                     }
+#endif // __SSE2__
 
-                    out_tile += 36;
-
-                    outRow0 += 4;
-                    outRow1 += 4;
-                    outRow2 += 4;
-                    outRow3 += 4;
+                    output0 += outw;
                 }
 
-                outRow0 += outw * 3;
-                outRow1 += outw * 3;
-                outRow2 += outw * 3;
-                outRow3 += outw * 3;
+                out_tile += 64;
             }
         }
     }
+}
+
+static void conv3x3s1_winograd63_sse(const Mat& bottom_blob, Mat& top_blob, const std::vector<Mat> &kernel_tm_test, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+
+    size_t elemsize = bottom_blob.elemsize;
+
+    // pad to 6n+2, winograd F(6,3)
+    Mat bottom_blob_bordered = bottom_blob;
+
+    outw = (outw + 5) / 6 * 6;
+    outh = (outh + 5) / 6 * 6;
+
+    w = outw + 2;
+    h = outh + 2;
+
+    copy_make_border(bottom_blob, bottom_blob_bordered, 0, h - bottom_blob.h, 0, w - bottom_blob.w, 0, 0.f, opt.workspace_allocator, opt.num_threads);
+
+    // BEGIN transform input
+    Mat bottom_blob_tm;
+    conv3x3s1_winograd63_transform_input_sse(bottom_blob_bordered, bottom_blob_tm, opt);
+    bottom_blob_bordered = Mat();
+    // END transform input
+
+    // BEGIN dot
+    Mat top_blob_tm;
+    conv3x3s1_winograd_dot_sse(bottom_blob_tm, top_blob_tm, kernel_tm_test, outch, opt);
+    bottom_blob_tm = Mat();
+    // END dot
+
+    // BEGIN transform output
+    // write to top_blob directly when there is no result pad
+    Mat top_blob_bordered = top_blob;
+    if (outw != top_blob.w || outh != top_blob.h)
+    {
+        top_blob_bordered.create(outw, outh, outch, elemsize, opt.workspace_allocator);
+    }
+    conv3x3s1_winograd63_transform_output_sse(top_blob_tm, top_blob_bordered, _bias, activation_type, activation_params, opt);
+    top_blob_tm = Mat();
     // END transform output
 
     // cut result pad
-    copy_cut_border(top_blob_bordered, top_blob, 0, top_blob_bordered.h - top_blob.h, 0, top_blob_bordered.w - top_blob.w, opt.blob_allocator, opt.num_threads);
+    if (top_blob_bordered.data != top_blob.data)
+    {
+        copy_cut_border(top_blob_bordered, top_blob, 0, top_blob_bordered.h - top_blob.h, 0, top_blob_bordered.w - top_blob.w, opt.blob_allocator, opt.num_threads);
+    }
 }
 
-static void conv3x3s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Mat& _bias, const Option& opt)
+static void conv3x3s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int w = bottom_blob.w;
     int inch = bottom_blob.c;
@@ -1841,5 +2248,8 @@ static void conv3x3s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_ker
                 r2 += tailstep;
             }
         }
+
+        // all input channels are summed, activate while the channel is in cache
+        activation_inplace_sse(out, outw * outh, activation_type, activation_params);
     }
 }
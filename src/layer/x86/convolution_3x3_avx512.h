@@ -0,0 +1,332 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_AVX512
+NCNN_AVX512_DIAGNOSTIC_PUSH
+// same bottom_blob_tm top_blob_tm and kernel_tm layout as conv3x3s1_winograd_dot_sse
+// one zmm holds 4 outch x 4 elements, 4 tiles share each kernel load
+NCNN_TARGET_AVX512
+static void conv3x3s1_winograd_dot_avx512(const Mat& bottom_blob_tm, Mat& top_blob_tm, const std::vector<Mat> &kernel_tm_test, int outch, const Option& opt)
+{
+    int inch = bottom_blob_tm.h;
+    size_t elemsize = bottom_blob_tm.elemsize;
+
+    // 9 for F(4,3), 16 for F(6,3)
+    const int nr = kernel_tm_test.size();
+    const int tiles = bottom_blob_tm.c / nr;
+    const int tm_size = nr * 4;
+
+    top_blob_tm.create(tm_size, tiles, outch, elemsize, opt.workspace_allocator);
+
+    const int nn_outch = outch >> 3;
+    const int remain_outch_start = nn_outch << 3;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int rp=0; rp<nr*nn_outch; rp++)
+    {
+        const int r = rp / nn_outch;
+        const int p = rp % nn_outch * 8;
+
+        float* output0_tm = (float*)top_blob_tm.channel(p) + r*4;
+        float* output1_tm = (float*)top_blob_tm.channel(p+1) + r*4;
+        float* output2_tm = (float*)top_blob_tm.channel(p+2) + r*4;
+        float* output3_tm = (float*)top_blob_tm.channel(p+3) + r*4;
+        float* output4_tm = (float*)top_blob_tm.channel(p+4) + r*4;
+        float* output5_tm = (float*)top_blob_tm.channel(p+5) + r*4;
+        float* output6_tm = (float*)top_blob_tm.channel(p+6) + r*4;
+        float* output7_tm = (float*)top_blob_tm.channel(p+7) + r*4;
+
+        int i=0;
+        for (; i+3<tiles; i+=4)
+        {
+            const float* kptr = kernel_tm_test[r].channel(p/8);
+            const float* r0 = bottom_blob_tm.channel(tiles*r+i);
+            const float* r1 = bottom_blob_tm.channel(tiles*r+i+1);
+            const float* r2 = bottom_blob_tm.channel(tiles*r+i+2);
+            const float* r3 = bottom_blob_tm.channel(tiles*r+i+3);
+
+            __m512 _sum00 = _mm512_setzero_ps();
+            __m512 _sum01 = _mm512_setzero_ps();
+            __m512 _sum10 = _mm512_setzero_ps();
+            __m512 _sum11 = _mm512_setzero_ps();
+            __m512 _sum20 = _mm512_setzero_ps();
+            __m512 _sum21 = _mm512_setzero_ps();
+            __m512 _sum30 = _mm512_setzero_ps();
+            __m512 _sum31 = _mm512_setzero_ps();
+
+            for (int q=0; q<inch; q++)
+            {
+                __m512 _k0 = _mm512_loadu_ps(kptr);
+                __m512 _k1 = _mm512_loadu_ps(kptr+16);
+
+                __m512 _r0 = _mm512_broadcast_f32x4(_mm_loadu_ps(r0));
+                __m512 _r1 = _mm512_broadcast_f32x4(_mm_loadu_ps(r1));
+                __m512 _r2 = _mm512_broadcast_f32x4(_mm_loadu_ps(r2));
+                __m512 _r3 = _mm512_broadcast_f32x4(_mm_loadu_ps(r3));
+
+                _sum00 = _mm512_fmadd_ps(_r0, _k0, _sum00);
+                _sum01 = _mm512_fmadd_ps(_r0, _k1, _sum01);
+                _sum10 = _mm512_fmadd_ps(_r1, _k0, _sum10);
+                _sum11 = _mm512_fmadd_ps(_r1, _k1, _sum11);
+                _sum20 = _mm512_fmadd_ps(_r2, _k0, _sum20);
+                _sum21 = _mm512_fmadd_ps(_r2, _k1, _sum21);
+                _sum30 = _mm512_fmadd_ps(_r3, _k0, _sum30);
+                _sum31 = _mm512_fmadd_ps(_r3, _k1, _sum31);
+
+                kptr += 32;
+                r0 += 4;
+                r1 += 4;
+                r2 += 4;
+                r3 += 4;
+            }
+
+            _mm_storeu_ps(output0_tm, _mm512_extractf32x4_ps(_sum00, 0));
+            _mm_storeu_ps(output1_tm, _mm512_extractf32x4_ps(_sum00, 1));
+            _mm_storeu_ps(output2_tm, _mm512_extractf32x4_ps(_sum00, 2));
+            _mm_storeu_ps(output3_tm, _mm512_extractf32x4_ps(_sum00, 3));
+            _mm_storeu_ps(output4_tm, _mm512_extractf32x4_ps(_sum01, 0));
+            _mm_storeu_ps(output5_tm, _mm512_extractf32x4_ps(_sum01, 1));
+            _mm_storeu_ps(output6_tm, _mm512_extractf32x4_ps(_sum01, 2));
+            _mm_storeu_ps(output7_tm, _mm512_extractf32x4_ps(_sum01, 3));
+
+            _mm_storeu_ps(output0_tm + tm_size, _mm512_extractf32x4_ps(_sum10, 0));
+            _mm_storeu_ps(output1_tm + tm_size, _mm512_extractf32x4_ps(_sum10, 1));
+            _mm_storeu_ps(output2_tm + tm_size, _mm512_extractf32x4_ps(_sum10, 2));
+            _mm_storeu_ps(output3_tm + tm_size, _mm512_extractf32x4_ps(_sum10, 3));
+            _mm_storeu_ps(output4_tm + tm_size, _mm512_extractf32x4_ps(_sum11, 0));
+            _mm_storeu_ps(output5_tm + tm_size, _mm512_extractf32x4_ps(_sum11, 1));
+            _mm_storeu_ps(output6_tm + tm_size, _mm512_extractf32x4_ps(_sum11, 2));
+            _mm_storeu_ps(output7_tm + tm_size, _mm512_extractf32x4_ps(_sum11, 3));
+
+            _mm_storeu_ps(output0_tm + tm_size*2, _mm512_extractf32x4_ps(_sum20, 0));
+            _mm_storeu_ps(output1_tm + tm_size*2, _mm512_extractf32x4_ps(_sum20, 1));
+            _mm_storeu_ps(output2_tm + tm_size*2, _mm512_extractf32x4_ps(_sum20, 2));
+            _mm_storeu_ps(output3_tm + tm_size*2, _mm512_extractf32x4_ps(_sum20, 3));
+            _mm_storeu_ps(output4_tm + tm_size*2, _mm512_extractf32x4_ps(_sum21, 0));
+            _mm_storeu_ps(output5_tm + tm_size*2, _mm512_extractf32x4_ps(_sum21, 1));
+            _mm_storeu_ps(output6_tm + tm_size*2, _mm512_extractf32x4_ps(_sum21, 2));
+            _mm_storeu_ps(output7_tm + tm_size*2, _mm512_extractf32x4_ps(_sum21, 3));
+
+            _mm_storeu_ps(output0_tm + tm_size*3, _mm512_extractf32x4_ps(_sum30, 0));
+            _mm_storeu_ps(output1_tm + tm_size*3, _mm512_extractf32x4_ps(_sum30, 1));
+            _mm_storeu_ps(output2_tm + tm_size*3, _mm512_extractf32x4_ps(_sum30, 2));
+            _mm_storeu_ps(output3_tm + tm_size*3, _mm512_extractf32x4_ps(_sum30, 3));
+            _mm_storeu_ps(output4_tm + tm_size*3, _mm512_extractf32x4_ps(_sum31, 0));
+            _mm_storeu_ps(output5_tm + tm_size*3, _mm512_extractf32x4_ps(_sum31, 1));
+            _mm_storeu_ps(output6_tm + tm_size*3, _mm512_extractf32x4_ps(_sum31, 2));
+            _mm_storeu_ps(output7_tm + tm_size*3, _mm512_extractf32x4_ps(_sum31, 3));
+
+            output0_tm += tm_size*4;
+            output1_tm += tm_size*4;
+            output2_tm += tm_size*4;
+            output3_tm += tm_size*4;
+            output4_tm += tm_size*4;
+            output5_tm += tm_size*4;
+            output6_tm += tm_size*4;
+            output7_tm += tm_size*4;
+        }
+
+        for (; i<tiles; i++)
+        {
+            const float* kptr = kernel_tm_test[r].channel(p/8);
+            const float* r0 = bottom_blob_tm.channel(tiles*r+i);
+
+            __m512 _sum0 = _mm512_setzero_ps();
+            __m512 _sum1 = _mm512_setzero_ps();
+
+            for (int q=0; q<inch; q++)
+            {
+                __m512 _r0 = _mm512_broadcast_f32x4(_mm_loadu_ps(r0));
+
+                _sum0 = _mm512_fmadd_ps(_r0, _mm512_loadu_ps(kptr), _sum0);
+                _sum1 = _mm512_fmadd_ps(_r0, _mm512_loadu_ps(kptr+16), _sum1);
+
+                kptr += 32;
+                r0 += 4;
+            }
+
+            _mm_storeu_ps(output0_tm, _mm512_extractf32x4_ps(_sum0, 0));
+            _mm_storeu_ps(output1_tm, _mm512_extractf32x4_ps(_sum0, 1));
+            _mm_storeu_ps(output2_tm, _mm512_extractf32x4_ps(_sum0, 2));
+            _mm_storeu_ps(output3_tm, _mm512_extractf32x4_ps(_sum0, 3));
+            _mm_storeu_ps(output4_tm, _mm512_extractf32x4_ps(_sum1, 0));
+            _mm_storeu_ps(output5_tm, _mm512_extractf32x4_ps(_sum1, 1));
+            _mm_storeu_ps(output6_tm, _mm512_extractf32x4_ps(_sum1, 2));
+            _mm_storeu_ps(output7_tm, _mm512_extractf32x4_ps(_sum1, 3));
+
+            output0_tm += tm_size;
+            output1_tm += tm_size;
+            output2_tm += tm_size;
+            output3_tm += tm_size;
+            output4_tm += tm_size;
+            output5_tm += tm_size;
+            output6_tm += tm_size;
+            output7_tm += tm_size;
+        }
+    }
+
+    const int nn_outch4 = (outch - remain_outch_start) >> 2;
+    const int remain_outch4_start = remain_outch_start + (nn_outch4 << 2);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int r=0; r<nr; r++)
+    {
+        for (int pp=0; pp<nn_outch4; pp++)
+        {
+            int p = remain_outch_start + pp * 4;
+
+            float* output0_tm = (float*)top_blob_tm.channel(p) + r*4;
+            float* output1_tm = (float*)top_blob_tm.channel(p+1) + r*4;
+            float* output2_tm = (float*)top_blob_tm.channel(p+2) + r*4;
+            float* output3_tm = (float*)top_blob_tm.channel(p+3) + r*4;
+
+            for (int i=0; i<tiles; i++)
+            {
+                const float* kptr = kernel_tm_test[r].channel(p/8 + (p%8)/4);
+                const float* r0 = bottom_blob_tm.channel(tiles*r+i);
+
+                __m512 _sum0 = _mm512_setzero_ps();
+                __m512 _sum1 = _mm512_setzero_ps();
+
+                int q=0;
+                for (; q+1<inch; q+=2)
+                {
+                    _sum0 = _mm512_fmadd_ps(_mm512_broadcast_f32x4(_mm_loadu_ps(r0)), _mm512_loadu_ps(kptr), _sum0);
+                    _sum1 = _mm512_fmadd_ps(_mm512_broadcast_f32x4(_mm_loadu_ps(r0+4)), _mm512_loadu_ps(kptr+16), _sum1);
+
+                    kptr += 32;
+                    r0 += 8;
+                }
+
+                for (; q<inch; q++)
+                {
+                    _sum0 = _mm512_fmadd_ps(_mm512_broadcast_f32x4(_mm_loadu_ps(r0)), _mm512_loadu_ps(kptr), _sum0);
+
+                    kptr += 16;
+                    r0 += 4;
+                }
+
+                _sum0 = _mm512_add_ps(_sum0, _sum1);
+
+                _mm_storeu_ps(output0_tm, _mm512_extractf32x4_ps(_sum0, 0));
+                _mm_storeu_ps(output1_tm, _mm512_extractf32x4_ps(_sum0, 1));
+                _mm_storeu_ps(output2_tm, _mm512_extractf32x4_ps(_sum0, 2));
+                _mm_storeu_ps(output3_tm, _mm512_extractf32x4_ps(_sum0, 3));
+
+                output0_tm += tm_size;
+                output1_tm += tm_size;
+                output2_tm += tm_size;
+                output3_tm += tm_size;
+            }
+        }
+
+        for (int p=remain_outch4_start; p<outch; p++)
+        {
+            float* output0_tm = (float*)top_blob_tm.channel(p) + r*4;
+
+            for (int i=0; i<tiles; i++)
+            {
+                const float* kptr = kernel_tm_test[r].channel(p/8 + (p%8)/4 + p%4);
+                const float* r0 = bottom_blob_tm.channel(tiles*r+i);
+
+                // 4 input channels per zmm
+                __m512 _sum = _mm512_setzero_ps();
+
+                int q=0;
+                for (; q+3<inch; q+=4)
+                {
+                    _sum = _mm512_fmadd_ps(_mm512_loadu_ps(r0), _mm512_loadu_ps(kptr), _sum);
+
+                    kptr += 16;
+                    r0 += 16;
+                }
+
+                __m128 _sum0 = _mm_add_ps(_mm512_extractf32x4_ps(_sum, 0), _mm512_extractf32x4_ps(_sum, 1));
+                __m128 _sum1 = _mm_add_ps(_mm512_extractf32x4_ps(_sum, 2), _mm512_extractf32x4_ps(_sum, 3));
+                _sum0 = _mm_add_ps(_sum0, _sum1);
+
+                for (; q<inch; q++)
+                {
+                    _sum0 = _mm_fmadd_ps(_mm_loadu_ps(r0), _mm_loadu_ps(kptr), _sum0);
+
+                    kptr += 4;
+                    r0 += 4;
+                }
+
+                _mm_storeu_ps(output0_tm, _sum0);
+
+                output0_tm += tm_size;
+            }
+        }
+    }
+}
+
+static void conv3x3s1_winograd43_avx512(const Mat& bottom_blob, Mat& top_blob, const std::vector<Mat> &kernel_tm_test, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    conv3x3s1_winograd43_tiled_sse(bottom_blob, top_blob, kernel_tm_test, _bias, activation_type, activation_params, conv3x3s1_winograd_dot_avx512, opt);
+}
+
+static void conv3x3s1_winograd63_avx512(const Mat& bottom_blob, Mat& top_blob, const std::vector<Mat> &kernel_tm_test, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+
+    size_t elemsize = bottom_blob.elemsize;
+
+    // pad to 6n+2, winograd F(6,3)
+    Mat bottom_blob_bordered = bottom_blob;
+
+    outw = (outw + 5) / 6 * 6;
+    outh = (outh + 5) / 6 * 6;
+
+    w = outw + 2;
+    h = outh + 2;
+
+    copy_make_border(bottom_blob, bottom_blob_bordered, 0, h - bottom_blob.h, 0, w - bottom_blob.w, 0, 0.f, opt.workspace_allocator, opt.num_threads);
+
+    // BEGIN transform input
+    Mat bottom_blob_tm;
+    conv3x3s1_winograd63_transform_input_sse(bottom_blob_bordered, bottom_blob_tm, opt);
+    bottom_blob_bordered = Mat();
+    // END transform input
+
+    // BEGIN dot
+    Mat top_blob_tm;
+    conv3x3s1_winograd_dot_avx512(bottom_blob_tm, top_blob_tm, kernel_tm_test, outch, opt);
+    bottom_blob_tm = Mat();
+    // END dot
+
+    // BEGIN transform output
+    // write to top_blob directly when there is no result pad
+    Mat top_blob_bordered = top_blob;
+    if (outw != top_blob.w || outh != top_blob.h)
+    {
+        top_blob_bordered.create(outw, outh, outch, elemsize, opt.workspace_allocator);
+    }
+    conv3x3s1_winograd63_transform_output_sse(top_blob_tm, top_blob_bordered, _bias, activation_type, activation_params, opt);
+    top_blob_tm = Mat();
+    // END transform output
+
+    // cut result pad
+    if (top_blob_bordered.data != top_blob.data)
+    {
+        copy_cut_border(top_blob_bordered, top_blob, 0, top_blob_bordered.h - top_blob.h, 0, top_blob_bordered.w - top_blob.w, opt.blob_allocator, opt.num_threads);
+    }
+}
+NCNN_AVX512_DIAGNOSTIC_POP
+#endif // NCNN_AVX512
@@ -12,7 +12,7 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
-static void conv5x5s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, const Option& opt)
+static void conv5x5s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int w = bottom_blob.w;
     int inch = bottom_blob.c;
@@ -209,11 +209,14 @@ static void conv5x5s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _ker
             }
 
         }
+
+        // all input channels are summed, activate while the channel is in cache
+        activation_inplace_sse(out, outw * outh, activation_type, activation_params);
     }
 
 }
 
-static void conv5x5s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Mat& _bias, const Option& opt)
+static void conv5x5s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int kernel_w = 5;
     int kernel_h = 5;
@@ -221,5 +224,5 @@ static void conv5x5s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_ker
     int stride_w = 2;
     int stride_h = 2;
 
-    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, stride_w, stride_h, opt);
+    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, stride_w, stride_h, 0, 0, activation_type, activation_params, opt);
 }
\ No newline at end of file
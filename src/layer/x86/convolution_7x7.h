@@ -12,7 +12,7 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
-static void conv7x7s1_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Mat& _bias, const Option& opt)
+static void conv7x7s1_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int kernel_w = 7;
     int kernel_h = 7;
@@ -20,10 +20,10 @@ static void conv7x7s1_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_ker
     int stride_w = 1;
     int stride_h = 1;
 
-    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, stride_w, stride_h, opt);
+    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, stride_w, stride_h, 0, 0, activation_type, activation_params, opt);
 }
 
-static void conv7x7s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Mat& _bias, const Option& opt)
+static void conv7x7s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_kernel, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int kernel_w = 7;
     int kernel_h = 7;
@@ -31,5 +31,5 @@ static void conv7x7s2_sse(const Mat &bottom_blob, Mat &top_blob, const Mat &_ker
     int stride_w = 2;
     int stride_h = 2;
 
-    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, stride_w, stride_h, opt);
+    conv_im2col_sgemm_sse(bottom_blob, top_blob, _kernel, _bias, kernel_w, kernel_h, stride_w, stride_h, 0, 0, activation_type, activation_params, opt);
 }
\ No newline at end of file
@@ -111,9 +111,10 @@ static void conv_im2col_sgemm_transform_kernel_sse(const Mat& _kernel, Mat& kern
 }
 
 static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const Mat & kernel_tm, const Mat& _bias, \
-            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Option& opt)
+            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const int pad_left, const int pad_top, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int w = bottom_blob.w;
+    int h = bottom_blob.h;
     int inch = bottom_blob.c;
     size_t elemsize = bottom_blob.elemsize;
 
@@ -123,7 +124,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
 
     const float* bias = _bias;
 
-    // im2col
+    // im2col, the zero padding of pad_left and pad_top is filled in place
     Mat bottom_im2col(outw*outh, kernel_h*kernel_w*inch, elemsize, opt.workspace_allocator);
     {
         const int stride = kernel_h*kernel_w*outw*outh;
@@ -138,15 +139,38 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
             {
                 for (int v=0; v<kernel_w; v++)
                 {
+                    // columns [j0, j1) are inside the input
+                    int j0 = std::min((std::max(pad_left - v, 0) + stride_w - 1) / stride_w, outw);
+                    int j1 = j0;
+                    if (w - 1 + pad_left - v >= 0)
+                        j1 = std::max(std::min((w - 1 + pad_left - v) / stride_w + 1, outw), j0);
+
                     for (int i=0; i<outh; i++)
                     {
-                        for (int j=0; j<outw; j++)
+                        int row = u + i * stride_h - pad_top;
+                        if (row < 0 || row >= h)
+                        {
+                            for (int j=0; j<outw; j++)
+                            {
+                                ret[retID++] = 0.f;
+                            }
+                            continue;
+                        }
+
+                        const float* sptr = input + row * w + v - pad_left;
+
+                        int j=0;
+                        for (; j<j0; j++)
                         {
-                            int row = u + i * stride_h;
-                            int col = v + j * stride_w;
-                            int index = row * w + col;
-                            ret[retID] = input[index];
-                            retID++;
+                            ret[retID++] = 0.f;
+                        }
+                        for (; j<j1; j++)
+                        {
+                            ret[retID++] = sptr[j * stride_w];
+                        }
+                        for (; j<outw; j++)
+                        {
+                            ret[retID++] = 0.f;
                         }
                     }
                 }
@@ -368,14 +392,14 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     vb += 8;
                 }
 
-                _mm256_storeu_ps(output0, _sum0);
-                _mm256_storeu_ps(output1, _sum1); 
-                _mm256_storeu_ps(output2, _sum2);
-                _mm256_storeu_ps(output3, _sum3); 
-                _mm256_storeu_ps(output4, _sum4);
-                _mm256_storeu_ps(output5, _sum5); 
-                _mm256_storeu_ps(output6, _sum6);
-                _mm256_storeu_ps(output7, _sum7);                
+                _mm256_storeu_ps(output0, activation_avx(_sum0, activation_type, activation_params));
+                _mm256_storeu_ps(output1, activation_avx(_sum1, activation_type, activation_params)); 
+                _mm256_storeu_ps(output2, activation_avx(_sum2, activation_type, activation_params));
+                _mm256_storeu_ps(output3, activation_avx(_sum3, activation_type, activation_params)); 
+                _mm256_storeu_ps(output4, activation_avx(_sum4, activation_type, activation_params));
+                _mm256_storeu_ps(output5, activation_avx(_sum5, activation_type, activation_params)); 
+                _mm256_storeu_ps(output6, activation_avx(_sum6, activation_type, activation_params));
+                _mm256_storeu_ps(output7, activation_avx(_sum7, activation_type, activation_params));                
 #else                
                 float sum0[8] = {0};
                 float sum1[8] = {0};
@@ -496,14 +520,14 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
 
                 for (int n=0; n<8; n++)
                 {
-                    output0[n] = sum0[n] + biasptr[0];
-                    output1[n] = sum1[n] + biasptr[1];
-                    output2[n] = sum2[n] + biasptr[2];
-                    output3[n] = sum3[n] + biasptr[3];
-                    output4[n] = sum4[n] + biasptr[4];
-                    output5[n] = sum5[n] + biasptr[5];
-                    output6[n] = sum6[n] + biasptr[6];
-                    output7[n] = sum7[n] + biasptr[7];
+                    output0[n] = activation_ss(sum0[n] + biasptr[0], activation_type, activation_params);
+                    output1[n] = activation_ss(sum1[n] + biasptr[1], activation_type, activation_params);
+                    output2[n] = activation_ss(sum2[n] + biasptr[2], activation_type, activation_params);
+                    output3[n] = activation_ss(sum3[n] + biasptr[3], activation_type, activation_params);
+                    output4[n] = activation_ss(sum4[n] + biasptr[4], activation_type, activation_params);
+                    output5[n] = activation_ss(sum5[n] + biasptr[5], activation_type, activation_params);
+                    output6[n] = activation_ss(sum6[n] + biasptr[6], activation_type, activation_params);
+                    output7[n] = activation_ss(sum7[n] + biasptr[7], activation_type, activation_params);
                 }
 #endif // __AVX__
                 output0 += 8;
@@ -566,7 +590,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 }
 
                 float output_sum0_7[8] = {0.f};
-                _mm256_storeu_ps(output_sum0_7, _sum0_7); 
+                _mm256_storeu_ps(output_sum0_7, activation_avx(_sum0_7, activation_type, activation_params)); 
 
                 output0[0] = output_sum0_7[0];
                 output1[0] = output_sum0_7[1];
@@ -601,14 +625,14 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     vb += 1;
                 }
                 
-                output0[0] = sum0;
-                output1[0] = sum1;
-                output2[0] = sum2;
-                output3[0] = sum3;
-                output4[0] = sum4;
-                output5[0] = sum5;
-                output6[0] = sum6;
-                output7[0] = sum7;
+                output0[0] = activation_ss(sum0, activation_type, activation_params);
+                output1[0] = activation_ss(sum1, activation_type, activation_params);
+                output2[0] = activation_ss(sum2, activation_type, activation_params);
+                output3[0] = activation_ss(sum3, activation_type, activation_params);
+                output4[0] = activation_ss(sum4, activation_type, activation_params);
+                output5[0] = activation_ss(sum5, activation_type, activation_params);
+                output6[0] = activation_ss(sum6, activation_type, activation_params);
+                output7[0] = activation_ss(sum7, activation_type, activation_params);
 #endif // __AVX__
                 output0++;
                 output1++;
@@ -718,13 +742,13 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     _sum3 = _mm256_fmadd_ps(_vb0, _va3, _sum3);    // sum3 = (a00-a07) * k30
 
                     va += 4;
-                    vb += 4;
+                    vb += 8;
                 }
 
-                _mm256_storeu_ps(output0, _sum0);
-                _mm256_storeu_ps(output1, _sum1); 
-                _mm256_storeu_ps(output2, _sum2);
-                _mm256_storeu_ps(output3, _sum3);   
+                _mm256_storeu_ps(output0, activation_avx(_sum0, activation_type, activation_params));
+                _mm256_storeu_ps(output1, activation_avx(_sum1, activation_type, activation_params)); 
+                _mm256_storeu_ps(output2, activation_avx(_sum2, activation_type, activation_params));
+                _mm256_storeu_ps(output3, activation_avx(_sum3, activation_type, activation_params));   
 #else
                 float sum0[8] = {0};
                 float sum1[8] = {0};
@@ -805,10 +829,10 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
 
                 for (int n=0; n<8; n++)
                 {
-                    output0[n] = sum0[n] + biasptr[0];
-                    output1[n] = sum1[n] + biasptr[1];
-                    output2[n] = sum2[n] + biasptr[2];
-                    output3[n] = sum3[n] + biasptr[3];
+                    output0[n] = activation_ss(sum0[n] + biasptr[0], activation_type, activation_params);
+                    output1[n] = activation_ss(sum1[n] + biasptr[1], activation_type, activation_params);
+                    output2[n] = activation_ss(sum2[n] + biasptr[2], activation_type, activation_params);
+                    output3[n] = activation_ss(sum3[n] + biasptr[3], activation_type, activation_params);
                 }
 #endif // __AVX__
                 output0 += 8;
@@ -866,7 +890,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                 }         
 
                 float output_sum0_3[4] = {0.f};
-                _mm_storeu_ps(output_sum0_3, _sum0_3); 
+                _mm_storeu_ps(output_sum0_3, activation_sse(_sum0_3, activation_type, activation_params)); 
                 output0[0] = output_sum0_3[0];
                 output1[0] = output_sum0_3[1];
                 output2[0] = output_sum0_3[2];
@@ -888,10 +912,10 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     vb += 1;
                 }
                 
-                output0[0] = sum0;
-                output1[0] = sum1;
-                output2[0] = sum2;
-                output3[0] = sum3;
+                output0[0] = activation_ss(sum0, activation_type, activation_params);
+                output1[0] = activation_ss(sum1, activation_type, activation_params);
+                output2[0] = activation_ss(sum2, activation_type, activation_params);
+                output3[0] = activation_ss(sum3, activation_type, activation_params);
 #endif // __AVX__
                 output0++;
                 output1++;
@@ -948,10 +972,10 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     _sum0 = _mm256_fmadd_ps(_vb0, _va0, _sum0);    // sum0 = (a00-a07) * k00
 
                     va += 1;
-                    vb += 4;
+                    vb += 8;
                 }
 
-                _mm256_storeu_ps(output, _sum0); 
+                _mm256_storeu_ps(output, activation_avx(_sum0, activation_type, activation_params)); 
 #else                
                 float sum[8] = {0};
 
@@ -987,7 +1011,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
 
                 for (int n=0; n<8; n++)
                 {
-                    output[n] = sum[n] + bias0;
+                    output[n] = activation_ss(sum[n] + bias0, activation_type, activation_params);
                 }
 #endif // __AVX__
                 output += 8;
@@ -1028,7 +1052,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     va += 1;
                     vb += 1;
                 }
-                output[0] = sum0;
+                output[0] = activation_ss(sum0, activation_type, activation_params);
 
                 output++;
             }
@@ -1091,9 +1115,10 @@ static void conv_im2col_sgemm_transform_kernel_sse(const Mat& _kernel, Mat& kern
 }
 
 static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const Mat & kernel_tm, const Mat& _bias, \
-            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const Option& opt)
+            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const int pad_left, const int pad_top, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int w = bottom_blob.w;
+    int h = bottom_blob.h;
     int inch = bottom_blob.c;
     size_t elemsize = bottom_blob.elemsize;
 
@@ -1103,7 +1128,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
 
     const float* bias = _bias;
 
-    // im2col
+    // im2col, the zero padding of pad_left and pad_top is filled in place
     Mat bottom_im2col(outw*outh, kernel_h*kernel_w*inch, elemsize, opt.workspace_allocator);
     {
         const int stride = kernel_h*kernel_w*outw*outh;
@@ -1118,15 +1143,38 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
             {
                 for (int v=0; v<kernel_w; v++)
                 {
+                    // columns [j0, j1) are inside the input
+                    int j0 = std::min((std::max(pad_left - v, 0) + stride_w - 1) / stride_w, outw);
+                    int j1 = j0;
+                    if (w - 1 + pad_left - v >= 0)
+                        j1 = std::max(std::min((w - 1 + pad_left - v) / stride_w + 1, outw), j0);
+
                     for (int i=0; i<outh; i++)
                     {
-                        for (int j=0; j<outw; j++)
+                        int row = u + i * stride_h - pad_top;
+                        if (row < 0 || row >= h)
+                        {
+                            for (int j=0; j<outw; j++)
+                            {
+                                ret[retID++] = 0.f;
+                            }
+                            continue;
+                        }
+
+                        const float* sptr = input + row * w + v - pad_left;
+
+                        int j=0;
+                        for (; j<j0; j++)
+                        {
+                            ret[retID++] = 0.f;
+                        }
+                        for (; j<j1; j++)
+                        {
+                            ret[retID++] = sptr[j * stride_w];
+                        }
+                        for (; j<outw; j++)
                         {
-                            int row = u + i * stride_h;
-                            int col = v + j * stride_w;
-                            int index = row * w + col;
-                            ret[retID] = input[index];
-                            retID++;
+                            ret[retID++] = 0.f;
                         }
                     }
                 }
@@ -1289,10 +1337,10 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     va += 4;
                     vb += 4;
                 }
-                _mm_storeu_ps(output0, _sum0);
-                _mm_storeu_ps(output1, _sum1);
-                _mm_storeu_ps(output2, _sum2);
-                _mm_storeu_ps(output3, _sum3);
+                _mm_storeu_ps(output0, activation_sse(_sum0, activation_type, activation_params));
+                _mm_storeu_ps(output1, activation_sse(_sum1, activation_type, activation_params));
+                _mm_storeu_ps(output2, activation_sse(_sum2, activation_type, activation_params));
+                _mm_storeu_ps(output3, activation_sse(_sum3, activation_type, activation_params));
 #else
                 float sum0[4] = {0};
                 float sum1[4] = {0};
@@ -1373,10 +1421,10 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
 
                 for (int n=0; n<4; n++)
                 {
-                    output0[n] = sum0[n] + biasptr[0];
-                    output1[n] = sum1[n] + biasptr[1];
-                    output2[n] = sum2[n] + biasptr[2];
-                    output3[n] = sum3[n] + biasptr[3];
+                    output0[n] = activation_ss(sum0[n] + biasptr[0], activation_type, activation_params);
+                    output1[n] = activation_ss(sum1[n] + biasptr[1], activation_type, activation_params);
+                    output2[n] = activation_ss(sum2[n] + biasptr[2], activation_type, activation_params);
+                    output3[n] = activation_ss(sum3[n] + biasptr[3], activation_type, activation_params);
                 }
 #endif // __SSE__
                 output0 += 4;
@@ -1432,10 +1480,10 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     va += 4;
                     vb += 1;
                 }         
-                output0[0] = _sum0_3[0];
-                output1[0] = _sum0_3[1];
-                output2[0] = _sum0_3[2];
-                output3[0] = _sum0_3[3];
+                output0[0] = activation_ss(_sum0_3[0], activation_type, activation_params);
+                output1[0] = activation_ss(_sum0_3[1], activation_type, activation_params);
+                output2[0] = activation_ss(_sum0_3[2], activation_type, activation_params);
+                output3[0] = activation_ss(_sum0_3[3], activation_type, activation_params);
 #else
                 float sum0 = biasptr[0];
                 float sum1 = biasptr[1];
@@ -1453,10 +1501,10 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     vb += 1;
                 }
                 
-                output0[0] = sum0;
-                output1[0] = sum1;
-                output2[0] = sum2;
-                output3[0] = sum3;
+                output0[0] = activation_ss(sum0, activation_type, activation_params);
+                output1[0] = activation_ss(sum1, activation_type, activation_params);
+                output2[0] = activation_ss(sum2, activation_type, activation_params);
+                output3[0] = activation_ss(sum3, activation_type, activation_params);
 #endif // __SSE__
                 output0++;
                 output1++;
@@ -1513,7 +1561,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     va += 1;
                     vb += 4;
                 }
-                _mm_storeu_ps(output, _sum0); 
+                _mm_storeu_ps(output, activation_sse(_sum0, activation_type, activation_params)); 
 #else                
                 float sum[4] = {0};
 
@@ -1549,7 +1597,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
 
                 for (int n=0; n<4; n++)
                 {
-                    output[n] = sum[n] + bias0;
+                    output[n] = activation_ss(sum[n] + bias0, activation_type, activation_params);
                 }
 #endif // __SSE__
                 output += 4;
@@ -1584,7 +1632,7 @@ static void conv_im2col_sgemm_sse(const Mat &bottom_blob, Mat &top_blob, const M
                     va += 1;
                     vb += 1;
                 }
-                output[0] = sum0;
+                output[0] = activation_ss(sum0, activation_type, activation_params);
 
                 output++;
             }
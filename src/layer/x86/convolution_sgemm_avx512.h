@@ -0,0 +1,253 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_AVX512
+NCNN_AVX512_DIAGNOSTIC_PUSH
+static void conv_im2col_sgemm_transform_kernel_avx512(const Mat& _kernel, Mat& kernel_tm, int inch, int outch, int kernel_size)
+{
+    const float* kernel = _kernel;
+
+    // kernel memory packed 8 x inch*maxk, outch tail padded with zero
+    kernel_tm.create(8*kernel_size, inch, (outch + 7) / 8);
+    kernel_tm.fill(0.f);
+
+    for (int p=0; p<outch; p++)
+    {
+        const float* k0 = kernel + p*inch*kernel_size;
+
+        float* ktmp = (float*)kernel_tm.channel(p/8) + p%8;
+
+        for (int q=0; q<inch*kernel_size; q++)
+        {
+            ktmp[0] = k0[q];
+            ktmp += 8;
+        }
+    }
+}
+
+// bottom_tm holds 16 columns per channel, tail columns zero padded
+// top_blob = activation(kernel_tm x bottom_tm + bias), 8 outch x 16 columns per micro kernel
+NCNN_TARGET_AVX512
+static void conv_sgemm_pack16_avx512(const Mat& bottom_tm, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    int outch = top_blob.c;
+    int size = top_blob.w * top_blob.h;
+
+    const int L = bottom_tm.w * bottom_tm.h / 16;
+    const int nn_size = bottom_tm.c;
+    const int nn_outch = (outch + 7) / 8;
+
+    const float* bias = _bias;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_outch; pp++)
+    {
+        const int p = pp * 8;
+        const int np = std::min(8, outch - p);
+
+        float biasptr[8] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+        float* outptr[8];
+        for (int n=0; n<np; n++)
+        {
+            if (bias)
+                biasptr[n] = bias[p + n];
+
+            outptr[n] = top_blob.channel(p + n);
+        }
+
+        for (int ii=0; ii<nn_size; ii++)
+        {
+            const int i = ii * 16;
+            const __mmask16 _mask = (__mmask16)(size - i >= 16 ? 0xffff : (1 << (size - i)) - 1);
+
+            const float* va = kernel_tm.channel(pp);
+            const float* vb = bottom_tm.channel(ii);
+
+            __m512 _sum0 = _mm512_set1_ps(biasptr[0]);
+            __m512 _sum1 = _mm512_set1_ps(biasptr[1]);
+            __m512 _sum2 = _mm512_set1_ps(biasptr[2]);
+            __m512 _sum3 = _mm512_set1_ps(biasptr[3]);
+            __m512 _sum4 = _mm512_set1_ps(biasptr[4]);
+            __m512 _sum5 = _mm512_set1_ps(biasptr[5]);
+            __m512 _sum6 = _mm512_set1_ps(biasptr[6]);
+            __m512 _sum7 = _mm512_set1_ps(biasptr[7]);
+
+            int k=0;
+            for (; k+1<L; k+=2)
+            {
+                __m512 _vb0 = _mm512_loadu_ps(vb);
+                __m512 _vb1 = _mm512_loadu_ps(vb + 16);
+
+                _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(va[0]), _vb0, _sum0);
+                _sum1 = _mm512_fmadd_ps(_mm512_set1_ps(va[1]), _vb0, _sum1);
+                _sum2 = _mm512_fmadd_ps(_mm512_set1_ps(va[2]), _vb0, _sum2);
+                _sum3 = _mm512_fmadd_ps(_mm512_set1_ps(va[3]), _vb0, _sum3);
+                _sum4 = _mm512_fmadd_ps(_mm512_set1_ps(va[4]), _vb0, _sum4);
+                _sum5 = _mm512_fmadd_ps(_mm512_set1_ps(va[5]), _vb0, _sum5);
+                _sum6 = _mm512_fmadd_ps(_mm512_set1_ps(va[6]), _vb0, _sum6);
+                _sum7 = _mm512_fmadd_ps(_mm512_set1_ps(va[7]), _vb0, _sum7);
+
+                _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(va[8]), _vb1, _sum0);
+                _sum1 = _mm512_fmadd_ps(_mm512_set1_ps(va[9]), _vb1, _sum1);
+                _sum2 = _mm512_fmadd_ps(_mm512_set1_ps(va[10]), _vb1, _sum2);
+                _sum3 = _mm512_fmadd_ps(_mm512_set1_ps(va[11]), _vb1, _sum3);
+                _sum4 = _mm512_fmadd_ps(_mm512_set1_ps(va[12]), _vb1, _sum4);
+                _sum5 = _mm512_fmadd_ps(_mm512_set1_ps(va[13]), _vb1, _sum5);
+                _sum6 = _mm512_fmadd_ps(_mm512_set1_ps(va[14]), _vb1, _sum6);
+                _sum7 = _mm512_fmadd_ps(_mm512_set1_ps(va[15]), _vb1, _sum7);
+
+                va += 16;
+                vb += 32;
+            }
+
+            for (; k<L; k++)
+            {
+                __m512 _vb0 = _mm512_loadu_ps(vb);
+
+                _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(va[0]), _vb0, _sum0);
+                _sum1 = _mm512_fmadd_ps(_mm512_set1_ps(va[1]), _vb0, _sum1);
+                _sum2 = _mm512_fmadd_ps(_mm512_set1_ps(va[2]), _vb0, _sum2);
+                _sum3 = _mm512_fmadd_ps(_mm512_set1_ps(va[3]), _vb0, _sum3);
+                _sum4 = _mm512_fmadd_ps(_mm512_set1_ps(va[4]), _vb0, _sum4);
+                _sum5 = _mm512_fmadd_ps(_mm512_set1_ps(va[5]), _vb0, _sum5);
+                _sum6 = _mm512_fmadd_ps(_mm512_set1_ps(va[6]), _vb0, _sum6);
+                _sum7 = _mm512_fmadd_ps(_mm512_set1_ps(va[7]), _vb0, _sum7);
+
+                va += 8;
+                vb += 16;
+            }
+
+            __m512 _sum[8] = {_sum0, _sum1, _sum2, _sum3, _sum4, _sum5, _sum6, _sum7};
+            for (int n=0; n<np; n++)
+            {
+                _mm512_mask_storeu_ps(outptr[n] + i, _mask, activation_avx512(_sum[n], activation_type, activation_params));
+            }
+        }
+    }
+}
+
+NCNN_TARGET_AVX512
+static void conv1x1s1_sgemm_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    int inch = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    int size = top_blob.w * top_blob.h;
+
+    // bottom memory packed 16 columns, no im2col needed for 1x1s1
+    const int nn_size = (size + 15) / 16;
+
+    Mat bottom_tm(16, inch, nn_size, elemsize, opt.workspace_allocator);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ii=0; ii<nn_size; ii++)
+    {
+        const int i = ii * 16;
+        const __mmask16 _mask = (__mmask16)(size - i >= 16 ? 0xffff : (1 << (size - i)) - 1);
+
+        float* tmpptr = bottom_tm.channel(ii);
+
+        for (int q=0; q<inch; q++)
+        {
+            const float* img0 = (const float*)bottom_blob.channel(q) + i;
+
+            _mm512_storeu_ps(tmpptr, _mm512_maskz_loadu_ps(_mask, img0));
+
+            tmpptr += 16;
+        }
+    }
+
+    conv_sgemm_pack16_avx512(bottom_tm, top_blob, kernel_tm, _bias, activation_type, activation_params, opt);
+}
+
+NCNN_TARGET_AVX512
+static void conv_im2col_sgemm_avx512(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, \
+            const int kernel_w, const int kernel_h, const int stride_w, const int stride_h, const int pad_left, const int pad_top, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int inch = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    int outw = top_blob.w;
+    int size = top_blob.w * top_blob.h;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // im2col, bottom memory packed 16 columns
+    const int nn_size = (size + 15) / 16;
+
+    Mat bottom_tm(16*maxk, inch, nn_size, elemsize, opt.workspace_allocator);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ii=0; ii<nn_size; ii++)
+    {
+        const int i = ii * 16;
+        const int n = std::min(16, size - i);
+        const __mmask16 _mask = (__mmask16)(n == 16 ? 0xffff : (1 << n) - 1);
+
+        // input row and column of each output column, the zero padding is masked out
+        int rowbase[16] = {0};
+        int colbase[16] = {0};
+        for (int j=0; j<n; j++)
+        {
+            int row = (i + j) / outw;
+            int col = (i + j) % outw;
+            rowbase[j] = row * stride_h - pad_top;
+            colbase[j] = col * stride_w - pad_left;
+        }
+
+        // columns within one contiguous input span can be loaded directly
+        const bool contiguous = rowbase[n - 1] == rowbase[0] && colbase[n - 1] - colbase[0] == n - 1;
+
+        __m512i _rowbase = _mm512_loadu_si512((const __m512i*)rowbase);
+        __m512i _colbase = _mm512_loadu_si512((const __m512i*)colbase);
+        const __m512i _zero = _mm512_setzero_si512();
+        const __m512i _w = _mm512_set1_epi32(w);
+        const __m512i _h = _mm512_set1_epi32(h);
+
+        float* tmpptr = bottom_tm.channel(ii);
+
+        for (int q=0; q<inch; q++)
+        {
+            const float* img0 = bottom_blob.channel(q);
+
+            for (int u=0; u<kernel_h; u++)
+            {
+                __m512i _row = _mm512_add_epi32(_rowbase, _mm512_set1_epi32(u));
+                __mmask16 _rmask = _mask & _mm512_cmpge_epi32_mask(_row, _zero) & _mm512_cmplt_epi32_mask(_row, _h);
+
+                for (int v=0; v<kernel_w; v++)
+                {
+                    __m512i _col = _mm512_add_epi32(_colbase, _mm512_set1_epi32(v));
+                    __mmask16 _vmask = _rmask & _mm512_cmpge_epi32_mask(_col, _zero) & _mm512_cmplt_epi32_mask(_col, _w);
+
+                    __m512 _val;
+                    if (contiguous && _vmask == _mask)
+                        _val = _mm512_maskz_loadu_ps(_mask, img0 + (rowbase[0] + u) * w + colbase[0] + v);
+                    else
+                        _val = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), _vmask, _mm512_add_epi32(_mm512_mullo_epi32(_row, _w), _col), img0, sizeof(float));
+
+                    _mm512_storeu_ps(tmpptr, _val);
+
+                    tmpptr += 16;
+                }
+            }
+        }
+    }
+
+    conv_sgemm_pack16_avx512(bottom_tm, top_blob, kernel_tm, _bias, activation_type, activation_params, opt);
+}
+NCNN_AVX512_DIAGNOSTIC_POP
+#endif // NCNN_AVX512
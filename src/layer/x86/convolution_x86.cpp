@@ -22,13 +22,22 @@
 #include <immintrin.h>
 #endif
 
+#include <string.h>
+#include <algorithm>
+
+#include "x86_target.h"
+#include "cpu.h"
 #include "layer_type.h"
 #include "benchmark.h"
+#include "autotune.h"
+#include "x86_activation.h"
+#include "convolutiondepthwise.h"
 
 namespace ncnn {
 
 #include "convolution_sgemm.h"
 #include "convolution_1x1.h"
+#include "convolution_1x1_sparse.h"
 #include "convolution_3x3.h"
 #include "convolution_5x5.h"
 #include "convolution_7x7.h"
@@ -37,12 +46,30 @@ namespace ncnn {
 #include "convolution_3x3_int8.h"
 #include "convolution_5x5_int8.h"
 #include "convolution_7x7_int8.h"
+#include "convolution_sgemm_avx512.h"
+#include "convolution_3x3_avx512.h"
+#include "convolutiondepthwise_3x3.h"
+#include "convolutiondepthwise_kxk.h"
 
 DEFINE_LAYER_CREATOR(Convolution_x86)
 
+// fp32 implementations, the values are kept in the autotune cache
+enum
+{
+    conv_algorithm_sgemm = 0,
+    conv_algorithm_winograd43 = 1,
+    conv_algorithm_winograd63 = 2,
+    conv_algorithm_direct = 3,
+    conv_algorithm_sparse = 4
+};
+
 Convolution_x86::Convolution_x86()
 {
     activation = 0;
+    use_winograd63 = false;
+    use_avx512 = false;
+    fused_depthwise = 0;
+    fused_expand = 0;
 }
 
 int Convolution_x86::create_pipeline(const Option& opt)
@@ -50,14 +77,16 @@ int Convolution_x86::create_pipeline(const Option& opt)
     Option opt_cpu = opt;
     opt_cpu.use_vulkan_compute = false;
 
-    if (activation_type == 1)
+    // the fp32 kernels apply the activation at their store,
+    // only the int8 kernels run it as a separate layer
+    if (use_int8_inference && activation_type == 1)
     {
         activation = ncnn::create_layer(ncnn::LayerType::ReLU);
 
         ncnn::ParamDict pd;
         activation->load_param(pd);
     }
-    else if (activation_type == 2)
+    else if (use_int8_inference && activation_type == 2)
     {
         activation = ncnn::create_layer(ncnn::LayerType::ReLU);
 
@@ -65,7 +94,7 @@ int Convolution_x86::create_pipeline(const Option& opt)
         pd.set(0, activation_params[0]);// slope
         activation->load_param(pd);
     }
-    else if (activation_type == 3)
+    else if (use_int8_inference && activation_type == 3)
     {
         activation = ncnn::create_layer(ncnn::LayerType::Clip);
 
@@ -74,7 +103,7 @@ int Convolution_x86::create_pipeline(const Option& opt)
         pd.set(1, activation_params[1]);// max
         activation->load_param(pd);
     }
-    else if (activation_type == 4)
+    else if (use_int8_inference && activation_type == 4)
     {
         activation = ncnn::create_layer(ncnn::LayerType::Sigmoid);
 
@@ -87,7 +116,14 @@ int Convolution_x86::create_pipeline(const Option& opt)
         activation->create_pipeline(opt_cpu);
     }
 
+    // dilated convolution runs the sse kernels on weight_sgemm_data
+    use_avx512 = cpu_support_x86_avx512() && dilation_w == 1 && dilation_h == 1;
+#if !NCNN_AVX512
+    use_avx512 = false;
+#endif
+
     use_winograd3x3 = false;
+    use_winograd63 = false;
 
     if (opt.use_winograd_convolution && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
     {
@@ -95,9 +131,19 @@ int Convolution_x86::create_pipeline(const Option& opt)
         // winograd is slow on small channel count
         if(num_input >= 16 && num_output >= 16)
             use_winograd3x3 = true;
+
+        // winograd63 needs 21% less multiplies than winograd43 on wide feature map,
+        // but the 8x8 transformed kernel doubles the dot memory traffic on large channel count
+        // winograd23 never wins over winograd43 here
+        int max_winograd63_channels = use_avx512 ? 64 * 64 : 128 * 128;
+        if (use_winograd3x3 && use_int8_inference == false && num_input * num_output <= max_winograd63_channels)
+            use_winograd63 = true;
     }           
 
-    if (use_winograd3x3)
+    // the autotuner times both winograd variants whatever the channel count
+    bool tune_winograd = opt.use_autotune && use_int8_inference == false && opt.use_winograd_convolution && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1;
+
+    if (use_winograd3x3 || tune_winograd)
     {
         int num_input = weight_data_size / 9 / num_output;
 
@@ -105,8 +151,13 @@ int Convolution_x86::create_pipeline(const Option& opt)
             // conv3x3s1_winograd23_transform_kernel_int8_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
             conv3x3s1_winograd43_transform_kernel_int8_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
         else
-            // conv3x3s1_winograd23_transform_kernel_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
-            conv3x3s1_winograd43_transform_kernel_sse(weight_data, weight_3x3_winograd43_data, num_input, num_output);
+        {
+            if (use_winograd63 || tune_winograd)
+                conv3x3s1_winograd63_transform_kernel_sse(weight_data, weight_3x3_winograd63_data, num_input, num_output);
+            if (!use_winograd63 || tune_winograd)
+                // conv3x3s1_winograd23_transform_kernel_sse(weight_data, weight_3x3_winograd23_data, num_input, num_output);
+                conv3x3s1_winograd43_transform_kernel_sse(weight_data, weight_3x3_winograd43_data, num_input, num_output);
+        }
     }
 
     if (use_int8_inference == false)
@@ -114,9 +165,28 @@ int Convolution_x86::create_pipeline(const Option& opt)
         int kernel_size = kernel_w * kernel_h;
         int num_input = weight_data_size / kernel_size / num_output;
 
+#if NCNN_AVX512
+        if (use_avx512)
+            conv_im2col_sgemm_transform_kernel_avx512(weight_data, weight_sgemm_data, num_input, num_output, kernel_size);
+        else
+#endif
         conv_im2col_sgemm_transform_kernel_sse(weight_data, weight_sgemm_data, num_input, num_output, kernel_size);
     }       
 
+    weight_sparse_data.release();
+    weight_sparse_index.release();
+    weight_sparse_rowptr.release();
+
+    if (opt.use_sparse_weight && use_int8_inference == false && kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1)
+    {
+        int num_input = weight_data_size / num_output;
+
+        // the dense sgemm is faster unless most 4x1 weight blocks are zero
+        int ret = conv1x1s1_sparse_transform_kernel_sse(weight_data, weight_sparse_data, weight_sparse_index, weight_sparse_rowptr, num_input, num_output, 0.5f);
+        if (ret == -100)
+            return -100;
+    }
+
     return 0;
 }
 
@@ -135,6 +205,62 @@ int Convolution_x86::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int Convolution_x86::create_depthwise_fusion(const ConvolutionDepthWise* depthwise, const Convolution* expand, const Option& /*opt*/)
+{
+    fused_depthwise = 0;
+    fused_expand = 0;
+    weight_fused_expand_sgemm_data.release();
+
+    // fp32 1x1s1 projection without padding
+    if (use_int8_inference || kernel_w != 1 || kernel_h != 1 || stride_w != 1 || stride_h != 1 || dilation_w != 1 || dilation_h != 1)
+        return -1;
+    if (pad_w > 0 || pad_h > 0)
+        return -1;
+
+    const int channels = weight_data_size / num_output;
+
+    // depth-wise with the strides of convdw_sse
+    const int maxk = depthwise->kernel_w * depthwise->kernel_h;
+    if (depthwise->use_int8_inference || depthwise->group != channels || depthwise->num_output != channels || depthwise->weight_data_size != maxk * channels)
+        return -1;
+    if (depthwise->stride_w != 1 && depthwise->stride_w != 2)
+        return -1;
+    if ((depthwise->pad_w < 0 || depthwise->pad_h < 0) && (depthwise->pad_w != -233 || depthwise->pad_h != -233))
+        return -1;
+
+    if (expand)
+    {
+        // fp32 1x1s1 expand without padding
+        if (expand->use_int8_inference || expand->num_output != channels)
+            return -1;
+        if (expand->kernel_w != 1 || expand->kernel_h != 1 || expand->stride_w != 1 || expand->stride_h != 1)
+            return -1;
+        if (expand->pad_w > 0 || expand->pad_h > 0)
+            return -1;
+
+        // the expand layer stays in the graph with its own transformed weight,
+        // without dilation both layers pick the same avx512 or sse layout
+        if (expand->dilation_w != 1 || expand->dilation_h != 1)
+            return -1;
+
+        Mat expand_sgemm_data = expand->get_sgemm_weight_data();
+        if (expand_sgemm_data.empty())
+            return -1;
+
+        weight_fused_expand_sgemm_data = expand_sgemm_data;
+    }
+
+    fused_depthwise = depthwise;
+    fused_expand = expand;
+
+    return 0;
+}
+
+Mat Convolution_x86::get_sgemm_weight_data() const
+{
+    return weight_sgemm_data;
+}
+
 int Convolution_x86::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv_func conv, const Option& opt) const
 {
     int w = bottom_blob.w;
@@ -220,11 +346,11 @@ int Convolution_x86::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv
             if (kernel_size == 7)
             {
             // FIXME conv7x7s1_sse use sgemm
-            conv(inner_bottom_blob, inner_top_blob, weight_sgemm_data, bias_data, opt_g);
+            conv(inner_bottom_blob, inner_top_blob, weight_sgemm_data, bias_data, 0, Mat(), opt_g);
             }
             else
             {
-            conv(inner_bottom_blob, inner_top_blob, weight_data, bias_data, opt_g);
+            conv(inner_bottom_blob, inner_top_blob, weight_data, bias_data, 0, Mat(), opt_g);
             }
 
             #pragma omp parallel for num_threads(opt.num_threads)
@@ -236,7 +362,7 @@ int Convolution_x86::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv
                     const float* ptr = (const float *)inner_top_blob.channel(c) + i * inner_outw;
                     for (int j = 0; j < inner_outw; j ++)
                     {
-                        outptr[j*dilation] = ptr[j];
+                        outptr[j*dilation] = activation_ss(ptr[j], activation_type, activation_params);
                     }
                     outptr += dilation * outw;
                 }
@@ -247,11 +373,233 @@ int Convolution_x86::forwardDilation(const Mat& bottom_blob, Mat& top_blob, conv
     return 0;
 }
 
+// rows [y, y+h) of all channels, sharing the channel step of m
+static Mat mat_rows(const Mat& m, int y, int h)
+{
+    Mat rows(m.w, h, m.c, (float*)m.data + m.w * y, m.elemsize);
+    rows.cstep = m.cstep;
+    return rows;
+}
+
+static void conv1x1s1_sgemm_x86(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, int activation_type, const Mat& activation_params, bool use_avx512, const Option& opt)
+{
+#if NCNN_AVX512
+    if (use_avx512)
+    {
+        conv1x1s1_sgemm_avx512(bottom_blob, top_blob, kernel_tm, _bias, activation_type, activation_params, opt);
+        return;
+    }
+#else
+    (void)use_avx512;
+#endif
+    conv_im2col_sgemm_sse(bottom_blob, top_blob, kernel_tm, _bias, 1, 1, 1, 1, 0, 0, activation_type, activation_params, opt);
+}
+
+int Convolution_x86::forwardDepthWiseFusion(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const ConvolutionDepthWise* dw = fused_depthwise;
+
+    if (bottom_blob.dims != 3)
+    {
+        // layer by layer
+        Mat expand_top_blob = bottom_blob;
+        if (fused_expand)
+        {
+            int ret = fused_expand->forward(bottom_blob, expand_top_blob, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        Mat dw_top_blob;
+        int ret = dw->forward(expand_top_blob, dw_top_blob, opt);
+        if (ret != 0)
+            return ret;
+
+        return Convolution::forward(dw_top_blob, top_blob, opt);
+    }
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    size_t elemsize = bottom_blob.elemsize;
+
+    const int channels = dw->group;
+
+    const int kernel_extent_w = dw->dilation_w * (dw->kernel_w - 1) + 1;
+    const int kernel_extent_h = dw->dilation_h * (dw->kernel_h - 1) + 1;
+
+    int pad_left = dw->pad_w;
+    int pad_right = dw->pad_w;
+    int pad_top = dw->pad_h;
+    int pad_bottom = dw->pad_h;
+    if (dw->pad_w == -233 && dw->pad_h == -233)
+    {
+        int wpad = kernel_extent_w + (w - 1) / dw->stride_w * dw->stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / dw->stride_h * dw->stride_h - h;
+        pad_left = std::max(wpad, 0) / 2;
+        pad_right = std::max(wpad, 0) - pad_left;
+        pad_top = std::max(hpad, 0) / 2;
+        pad_bottom = std::max(hpad, 0) - pad_top;
+    }
+
+    const int wp = w + pad_left + pad_right;
+    const int hp = h + pad_top + pad_bottom;
+
+    int outw = (wp - kernel_extent_w) / dw->stride_w + 1;
+    int outh = (hp - kernel_extent_h) / dw->stride_h + 1;
+
+    top_blob.create(outw, outh, num_output, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // output rows of one band, the padded depthwise input, the expand output
+    // and the depthwise output of a band stay in about 256k,
+    // with enough columns for the sgemm
+    const int row_size = channels * (dw->stride_h * wp + outw + (fused_expand ? dw->stride_h * w : 0)) * 4;
+    int band_h = std::max(256 * 1024 / row_size, (64 + outw - 1) / outw);
+
+    // the 1x1 weights are read once per band, do not let them outweigh the feature maps
+    const int weight_size = (weight_data_size + (fused_expand ? fused_expand->weight_data_size : 0)) * 4;
+    band_h = std::max(band_h, weight_size / row_size);
+
+    band_h = std::min(band_h, outh);
+
+    const int band_rows = (band_h - 1) * dw->stride_h + kernel_extent_h;
+
+    // split the output rows among threads when each part has several bands,
+    // the input rows shared by neighbour parts are computed twice
+    int nn_part = 1;
+    if (opt.num_threads > 1 && outh >= opt.num_threads * band_h * 2)
+        nn_part = opt.num_threads;
+
+    Option opt_p = opt;
+    if (nn_part > 1)
+        opt_p.num_threads = 1;
+
+    Mat pad_workspace(wp, band_rows, channels * nn_part, elemsize, opt.workspace_allocator);
+    if (pad_workspace.empty())
+        return -100;
+
+    Mat expand_workspace;
+    if (fused_expand)
+    {
+        expand_workspace.create(w, band_rows, channels * nn_part, elemsize, opt.workspace_allocator);
+        if (expand_workspace.empty())
+            return -100;
+    }
+
+    Mat dw_workspace(outw, band_h, channels * nn_part, elemsize, opt.workspace_allocator);
+    if (dw_workspace.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(nn_part)
+    for (int t=0; t<nn_part; t++)
+    {
+        Mat pad_band = pad_workspace.channel_range(channels * t, channels);
+        Mat expand_band = fused_expand ? expand_workspace.channel_range(channels * t, channels) : Mat();
+        Mat dw_band = dw_workspace.channel_range(channels * t, channels);
+
+        const int y_start = outh * t / nn_part;
+        const int y_end = outh * (t + 1) / nn_part;
+
+        // padded input rows held in pad_band
+        int pad_y = 0;
+        int pad_rows = 0;
+
+        for (int y = y_start; y < y_end; y += band_h)
+        {
+            const int n = std::min(band_h, y_end - y);
+
+            const int ry = y * dw->stride_h;
+            const int rows = (n - 1) * dw->stride_h + kernel_extent_h;
+
+            // keep the rows shared with the previous band
+            int keep = 0;
+            if (ry >= pad_y && ry < pad_y + pad_rows)
+            {
+                keep = std::min(pad_y + pad_rows - ry, rows);
+
+                const int shift = ry - pad_y;
+                if (shift > 0)
+                {
+                    for (int q=0; q<channels; q++)
+                    {
+                        float* ptr = pad_band.channel(q);
+                        memmove(ptr, ptr + shift * wp, keep * wp * sizeof(float));
+                    }
+                }
+            }
+
+            pad_y = ry;
+            pad_rows = rows;
+
+            // source rows [sy0, sy1) of the new padded rows
+            const int sy0 = std::max(ry + keep - pad_top, 0);
+            const int sy1 = std::min(ry + rows - pad_top, h);
+
+            Mat src = bottom_blob;
+            if (fused_expand && sy1 > sy0)
+            {
+                Mat bottom_rows = mat_rows(bottom_blob, sy0, sy1 - sy0);
+                Mat expand_rows = mat_rows(expand_band, 0, sy1 - sy0);
+
+                conv1x1s1_sgemm_x86(bottom_rows, expand_rows, weight_fused_expand_sgemm_data, fused_expand->bias_data, fused_expand->activation_type, fused_expand->activation_params, use_avx512, opt_p);
+
+                src = expand_rows;
+            }
+
+            // copy with border
+            #pragma omp parallel for num_threads(opt_p.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const Mat m = src.channel(q);
+                float* outptr = pad_band.channel(q).row(keep);
+
+                for (int r = keep; r < rows; r++)
+                {
+                    const int sy = ry + r - pad_top;
+                    if (sy < 0 || sy >= h)
+                    {
+                        memset(outptr, 0, wp * sizeof(float));
+                    }
+                    else
+                    {
+                        const float* ptr = fused_expand ? m.row(sy - sy0) : m.row(sy);
+
+                        memset(outptr, 0, pad_left * sizeof(float));
+                        memcpy(outptr + pad_left, ptr, w * sizeof(float));
+                        memset(outptr + pad_left + w, 0, pad_right * sizeof(float));
+                    }
+
+                    outptr += wp;
+                }
+            }
+
+            // depth-wise, convdw_sse is faster than convdw3x3s1_sse but not for 3x3s2
+            Mat dw_rows = mat_rows(dw_band, 0, n);
+            if (dw->kernel_w == 3 && dw->kernel_h == 3 && dw->dilation_w == 1 && dw->dilation_h == 1 && dw->stride_w == 2 && dw->stride_h == 2)
+                convdw3x3s2_sse(pad_band, dw_rows, dw->weight_data, dw->bias_data, dw->activation_type, dw->activation_params, opt_p);
+            else
+                convdw_sse(pad_band, dw_rows, dw->weight_data, dw->bias_data, dw->kernel_w, dw->kernel_h, dw->dilation_w, dw->dilation_h, dw->stride_w, dw->stride_h, 0, 0, dw->activation_type, dw->activation_params, opt_p);
+
+            // projection
+            Mat top_rows = mat_rows(top_blob, y, n);
+            conv1x1s1_sgemm_x86(dw_rows, top_rows, weight_sgemm_data, bias_data, activation_type, activation_params, use_avx512, opt_p);
+        }
+    }
+
+    return 0;
+}
+
 int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     // convolv with NxN kernel
     // value = value + bias
 
+    if (fused_depthwise)
+    {
+        return forwardDepthWiseFusion(bottom_blob, top_blob, opt);
+    }
+
     if (bottom_blob.dims != 3)
     {
         return Convolution::forward(bottom_blob, top_blob, opt);
@@ -270,8 +618,6 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         return Convolution::forward(bottom_blob, top_blob, opt);
     }
 
-    typedef void (*conv_func)(const Mat&, Mat&, const Mat&, const Mat&, const Option&);
-
     // kernel_size x stride
     conv_func conv_func_table[7][4] =
     {
@@ -471,15 +817,16 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         bottom_blob_unbordered = bottom_blob_int8;
     }
 
-    Mat bottom_blob_bordered = bottom_blob_unbordered;
+    int pad_left = 0;
+    int pad_right = 0;
+    int pad_top = 0;
+    int pad_bottom = 0;
     if (pad_w > 0 || pad_h > 0)
     {
-        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_h, pad_h, pad_w, pad_w, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-        if (bottom_blob_bordered.empty())
-            return -100;
-
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
+        pad_left = pad_w;
+        pad_right = pad_w;
+        pad_top = pad_h;
+        pad_bottom = pad_h;
     }
     else if (pad_w == -233 && pad_h == -233)
     {
@@ -487,15 +834,27 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         int hpad = kernel_size + (h - 1) / stride * stride - h;
         if (wpad > 0 || hpad > 0)
         {
-            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-            if (bottom_blob_bordered.empty())
-                return -100;
+            pad_left = wpad / 2;
+            pad_right = wpad - wpad / 2;
+            pad_top = hpad / 2;
+            pad_bottom = hpad - hpad / 2;
         }
+    }
 
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
+    const bool padded = pad_left != 0 || pad_right != 0 || pad_top != 0 || pad_bottom != 0;
+
+    // the fp32 algorithms pad in forwardAlgorithm
+    Mat bottom_blob_bordered = bottom_blob_unbordered;
+    if (use_int8_inference && padded)
+    {
+        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
     }
 
+    w += pad_left + pad_right;
+    h += pad_top + pad_bottom;
+
     int outw = (w - kernel_size) / stride + 1;
     int outh = (h - kernel_size) / stride + 1;
 
@@ -555,7 +914,15 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
 
                     Mat top_blob_g = top_blob.channel_range(p, 1);
                     dequantize_ops[p]->forward_inplace(top_blob_g, opt_g);
+
+                    // activation while the channel is still in cache
+                    if (activation)
+                    {
+                        activation->forward_inplace(top_blob_g, opt_g);
+                    }
                 }
+
+                return 0;
             }
             else
                 conv_int8_dequant(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);     
@@ -574,19 +941,149 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     if (top_blob.empty())
         return -100;    
 
-    if (use_winograd3x3 && outw >= 8 && outh >=8)
+    const bool winograd_shape = outw >= 8 && outh >= 8;
+
+    int algorithm = conv_algorithm_sgemm;
+    if (!weight_sparse_data.empty())
+        algorithm = conv_algorithm_sparse;
+    else if (use_winograd3x3 && use_winograd63 && winograd_shape)
+        algorithm = conv_algorithm_winograd63;
+    else if (use_winograd3x3 && winograd_shape)
+        algorithm = conv_algorithm_winograd43;
+
+    if (opt.use_autotune)
     {
-        // conv3x3s1_winograd23_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd23_data, bias_data, opt);
-        conv3x3s1_winograd43_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd43_data, bias_data, opt);
+        // candidates with their weights prepared in create_pipeline
+        std::vector<int> candidates;
+        candidates.push_back(conv_algorithm_sgemm);
+        // the 5x5s2 and 7x7 entries of the table are im2col sgemm themselves
+        if (kernel_size <= 3 || (kernel_size == 5 && stride == 1))
+            candidates.push_back(conv_algorithm_direct);
+        if (!weight_3x3_winograd43_data.empty() && winograd_shape)
+            candidates.push_back(conv_algorithm_winograd43);
+        if (!weight_3x3_winograd63_data.empty() && winograd_shape)
+            candidates.push_back(conv_algorithm_winograd63);
+        if (!weight_sparse_data.empty())
+            candidates.push_back(conv_algorithm_sparse);
+
+        char key[256];
+        sprintf(key, "Convolution_k%dx%d_s%dx%d_c%d_o%d_in%dx%d_t%d%s", kernel_w, kernel_h, stride_w, stride_h, channels, num_output, w, h, opt.num_threads, weight_sparse_data.empty() ? "" : "_sparse");
+
+        int choice = get_autotune_choice(key);
+        if (choice == -1)
+        {
+            // best of three runs
+            double best_time = 0;
+            for (size_t i=0; i<candidates.size(); i++)
+            {
+                double time = 0;
+                for (int j=0; j<3; j++)
+                {
+                    double start = get_current_time();
+
+                    int ret = forwardAlgorithm(bottom_blob, top_blob, candidates[i], pad_left, pad_right, pad_top, pad_bottom, conv, opt);
+                    if (ret != 0)
+                        return ret;
+
+                    double end = get_current_time();
+
+                    if (j == 0 || end - start < time)
+                        time = end - start;
+                }
+
+                if (i == 0 || time < best_time)
+                {
+                    best_time = time;
+                    choice = candidates[i];
+                }
+            }
+
+            set_autotune_choice(key, choice);
+        }
+
+        // a cached choice may come from a build without its implementation
+        if (std::find(candidates.begin(), candidates.end(), choice) != candidates.end())
+            algorithm = choice;
     }
-    else
-        //conv(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
-        conv_im2col_sgemm_sse(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, opt);
 
-    if (activation)
+    return forwardAlgorithm(bottom_blob, top_blob, algorithm, pad_left, pad_right, pad_top, pad_bottom, conv, opt);
+}
+
+int Convolution_x86::forwardAlgorithm(const Mat& bottom_blob, Mat& top_blob, int algorithm, int pad_left, int pad_right, int pad_top, int pad_bottom, conv_func conv, const Option& opt) const
+{
+    const bool padded = pad_left != 0 || pad_right != 0 || pad_top != 0 || pad_bottom != 0;
+
+    // im2col fills the zero padding in place, no bordered copy
+    if (algorithm == conv_algorithm_sgemm && pad_left >= 0 && pad_top >= 0)
+    {
+#if NCNN_AVX512
+        if (use_avx512)
+        {
+            if (kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1 && !padded)
+                conv1x1s1_sgemm_avx512(bottom_blob, top_blob, weight_sgemm_data, bias_data, activation_type, activation_params, opt);
+            else
+                conv_im2col_sgemm_avx512(bottom_blob, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, pad_left, pad_top, activation_type, activation_params, opt);
+
+            return 0;
+        }
+#endif
+        conv_im2col_sgemm_sse(bottom_blob, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, pad_left, pad_top, activation_type, activation_params, opt);
+
+        return 0;
+    }
+
+    Mat bottom_blob_bordered = bottom_blob;
+    if (padded)
     {
-        activation->forward_inplace(top_blob, opt);
+        copy_make_border(bottom_blob, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
+    }
+
+    if (algorithm == conv_algorithm_winograd63)
+    {
+#if NCNN_AVX512
+        if (use_avx512)
+            conv3x3s1_winograd63_avx512(bottom_blob_bordered, top_blob, weight_3x3_winograd63_data, bias_data, activation_type, activation_params, opt);
+        else
+#endif
+        conv3x3s1_winograd63_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd63_data, bias_data, activation_type, activation_params, opt);
+    }
+    else if (algorithm == conv_algorithm_winograd43)
+    {
+#if NCNN_AVX512
+        if (use_avx512)
+        {
+            conv3x3s1_winograd43_avx512(bottom_blob_bordered, top_blob, weight_3x3_winograd43_data, bias_data, activation_type, activation_params, opt);
+        }
+        else
+#endif
+        {
+        // conv3x3s1_winograd23_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd23_data, bias_data, opt);
+        conv3x3s1_winograd43_sse(bottom_blob_bordered, top_blob, weight_3x3_winograd43_data, bias_data, activation_type, activation_params, opt);
+        }
+    }
+    else if (algorithm == conv_algorithm_sparse)
+    {
+        conv1x1s1_sparse_sse(bottom_blob_bordered, top_blob, weight_sparse_data, weight_sparse_index, weight_sparse_rowptr, bias_data, activation_type, activation_params, use_avx512, opt);
+    }
+    else if (algorithm == conv_algorithm_direct)
+    {
+        conv(bottom_blob_bordered, top_blob, weight_data, bias_data, activation_type, activation_params, opt);
     }
+#if NCNN_AVX512
+    else if (use_avx512)
+    {
+        if (kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1)
+            conv1x1s1_sgemm_avx512(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, activation_type, activation_params, opt);
+        else
+            conv_im2col_sgemm_avx512(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, 0, 0, activation_type, activation_params, opt);
+    }
+#endif
+    else
+        conv_im2col_sgemm_sse(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, stride_w, stride_h, 0, 0, activation_type, activation_params, opt);
+
+    // bias and activation are fused into the store of the winograd, sparse, sgemm and direct kernels
 
     return 0;
 }
@@ -19,7 +19,7 @@
 
 namespace ncnn {
 
-typedef void (*conv_func)(const Mat&, Mat&, const Mat&, const Mat&, const Option&);
+typedef void (*conv_func)(const Mat&, Mat&, const Mat&, const Mat&, int, const Mat&, const Option&);
 
 class Convolution_x86 : virtual public Convolution
 {
@@ -29,15 +29,34 @@ public:
     virtual int create_pipeline(const Option& opt);
     virtual int destroy_pipeline(const Option& opt);
 
+    virtual int create_depthwise_fusion(const ConvolutionDepthWise* depthwise, const Convolution* expand, const Option& opt);
+    virtual Mat get_sgemm_weight_data() const;
+
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
     virtual int forwardDilation(const Mat& bottom_blob, Mat &top_blob, conv_func conv, const Option& opt) const;
+    virtual int forwardDepthWiseFusion(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+    virtual int forwardAlgorithm(const Mat& bottom_blob, Mat& top_blob, int algorithm, int pad_left, int pad_right, int pad_top, int pad_bottom, conv_func conv, const Option& opt) const;
 
 public:
     Layer* activation;
     bool use_winograd3x3;
+    bool use_winograd63;
+    bool use_avx512;
     Mat weight_3x3_winograd23_data;
     Mat weight_sgemm_data;
     std::vector<Mat> weight_3x3_winograd43_data;
+    std::vector<Mat> weight_3x3_winograd63_data;
+
+    // blocked csr 1x1 weight, empty for dense weight
+    Mat weight_sparse_data;
+    Mat weight_sparse_index;
+    Mat weight_sparse_rowptr;
+
+    // depthwise block run by this 1x1 projection
+    const ConvolutionDepthWise* fused_depthwise;
+    const Convolution* fused_expand;
+    // shares the weight_sgemm_data of the expand layer
+    Mat weight_fused_expand_sgemm_data;
 };
 
 } // namespace ncnn
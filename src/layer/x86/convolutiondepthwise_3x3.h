@@ -130,7 +130,7 @@ static void convdw3x3s1_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _k
     }
 }
 
-static void convdw3x3s2_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, const Option& opt)
+static void convdw3x3s2_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
 {
     int w = bottom_blob.w;
 
@@ -184,7 +184,7 @@ static void convdw3x3s2_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _k
                 sum += r2[1] * k2[1];
                 sum += r2[2] * k2[2];
 
-                *outptr = sum;
+                *outptr = activation_ss(sum, activation_type, activation_params);
 
                 r0 += 2;
                 r1 += 2;
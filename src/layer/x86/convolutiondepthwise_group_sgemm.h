@@ -0,0 +1,335 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+
+static void convgroup_im2col_sgemm_transform_kernel_sse(const Mat& _kernel, Mat& kernel_tm, int inch_g, int outch_g, int group, int maxk)
+{
+    const int size = inch_g * maxk;
+
+    // src = maxk-inch_g-outch_g-group
+    // dst = 4-size-outch_g/4-group, remain outch_g keep the src layout
+    kernel_tm.create(4 * size, outch_g/4 + outch_g%4, group);
+
+    for (int g=0; g<group; g++)
+    {
+        const float* kernel = (const float*)_kernel + size * outch_g * g;
+
+        Mat kernel_tm_g = kernel_tm.channel(g);
+
+        int p=0;
+        for (; p+3<outch_g; p+=4)
+        {
+            const float* k0 = kernel + size * p;
+            const float* k1 = k0 + size;
+            const float* k2 = k1 + size;
+            const float* k3 = k2 + size;
+
+            float* ktmp = kernel_tm_g.row(p/4);
+
+            for (int k=0; k<size; k++)
+            {
+                ktmp[0] = k0[k];
+                ktmp[1] = k1[k];
+                ktmp[2] = k2[k];
+                ktmp[3] = k3[k];
+                ktmp += 4;
+            }
+        }
+        for (; p<outch_g; p++)
+        {
+            const float* k0 = kernel + size * p;
+
+            float* ktmp = kernel_tm_g.row(p/4 + p%4);
+
+            for (int k=0; k<size; k++)
+            {
+                ktmp[k] = k0[k];
+            }
+        }
+    }
+}
+
+// outptr(p, j) = bias(p) + sum_k kernel(p, k) * col(k, j) for 4 outputs
+static void convgroup_sgemm_pack4_sse(const float* colptr, size_t colstep, int size, int n, const float* kptr, const float* bias, float* outptr, size_t outstep)
+{
+    float* outptr0 = outptr;
+    float* outptr1 = outptr0 + outstep;
+    float* outptr2 = outptr1 + outstep;
+    float* outptr3 = outptr2 + outstep;
+
+    const float bias0 = bias ? bias[0] : 0.f;
+    const float bias1 = bias ? bias[1] : 0.f;
+    const float bias2 = bias ? bias[2] : 0.f;
+    const float bias3 = bias ? bias[3] : 0.f;
+
+    int j=0;
+#if __AVX__
+    for (; j+15<n; j+=16)
+    {
+        const float* kptr0 = kptr;
+        const float* m = colptr + j;
+
+        __m256 _sum00 = _mm256_set1_ps(bias0);
+        __m256 _sum01 = _sum00;
+        __m256 _sum10 = _mm256_set1_ps(bias1);
+        __m256 _sum11 = _sum10;
+        __m256 _sum20 = _mm256_set1_ps(bias2);
+        __m256 _sum21 = _sum20;
+        __m256 _sum30 = _mm256_set1_ps(bias3);
+        __m256 _sum31 = _sum30;
+
+        for (int k=0; k<size; k++)
+        {
+            __m256 _val0 = _mm256_loadu_ps(m);
+            __m256 _val1 = _mm256_loadu_ps(m + 8);
+
+            __m256 _k0 = _mm256_broadcast_ss(kptr0);
+            __m256 _k1 = _mm256_broadcast_ss(kptr0 + 1);
+            __m256 _k2 = _mm256_broadcast_ss(kptr0 + 2);
+            __m256 _k3 = _mm256_broadcast_ss(kptr0 + 3);
+
+            _sum00 = _mm256_fmadd_ps(_k0, _val0, _sum00);
+            _sum01 = _mm256_fmadd_ps(_k0, _val1, _sum01);
+            _sum10 = _mm256_fmadd_ps(_k1, _val0, _sum10);
+            _sum11 = _mm256_fmadd_ps(_k1, _val1, _sum11);
+            _sum20 = _mm256_fmadd_ps(_k2, _val0, _sum20);
+            _sum21 = _mm256_fmadd_ps(_k2, _val1, _sum21);
+            _sum30 = _mm256_fmadd_ps(_k3, _val0, _sum30);
+            _sum31 = _mm256_fmadd_ps(_k3, _val1, _sum31);
+
+            kptr0 += 4;
+            m += colstep;
+        }
+
+        _mm256_storeu_ps(outptr0 + j, _sum00);
+        _mm256_storeu_ps(outptr0 + j + 8, _sum01);
+        _mm256_storeu_ps(outptr1 + j, _sum10);
+        _mm256_storeu_ps(outptr1 + j + 8, _sum11);
+        _mm256_storeu_ps(outptr2 + j, _sum20);
+        _mm256_storeu_ps(outptr2 + j + 8, _sum21);
+        _mm256_storeu_ps(outptr3 + j, _sum30);
+        _mm256_storeu_ps(outptr3 + j + 8, _sum31);
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; j+3<n; j+=4)
+    {
+        const float* kptr0 = kptr;
+        const float* m = colptr + j;
+
+        __m128 _sum0 = _mm_set1_ps(bias0);
+        __m128 _sum1 = _mm_set1_ps(bias1);
+        __m128 _sum2 = _mm_set1_ps(bias2);
+        __m128 _sum3 = _mm_set1_ps(bias3);
+
+        for (int k=0; k<size; k++)
+        {
+            __m128 _val = _mm_loadu_ps(m);
+
+            _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_load1_ps(kptr0), _val));
+            _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_mm_load1_ps(kptr0 + 1), _val));
+            _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_mm_load1_ps(kptr0 + 2), _val));
+            _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_mm_load1_ps(kptr0 + 3), _val));
+
+            kptr0 += 4;
+            m += colstep;
+        }
+
+        _mm_storeu_ps(outptr0 + j, _sum0);
+        _mm_storeu_ps(outptr1 + j, _sum1);
+        _mm_storeu_ps(outptr2 + j, _sum2);
+        _mm_storeu_ps(outptr3 + j, _sum3);
+    }
+#endif // __SSE2__
+    for (; j<n; j++)
+    {
+        const float* kptr0 = kptr;
+        const float* m = colptr + j;
+
+        float sum0 = bias0;
+        float sum1 = bias1;
+        float sum2 = bias2;
+        float sum3 = bias3;
+
+        for (int k=0; k<size; k++)
+        {
+            sum0 += kptr0[0] * m[0];
+            sum1 += kptr0[1] * m[0];
+            sum2 += kptr0[2] * m[0];
+            sum3 += kptr0[3] * m[0];
+
+            kptr0 += 4;
+            m += colstep;
+        }
+
+        outptr0[j] = sum0;
+        outptr1[j] = sum1;
+        outptr2[j] = sum2;
+        outptr3[j] = sum3;
+    }
+}
+
+// outptr(j) = bias + sum_k kernel(k) * col(k, j) for one output
+static void convgroup_sgemm_pack1_sse(const float* colptr, size_t colstep, int size, int n, const float* kptr, float bias0, float* outptr)
+{
+    int j=0;
+#if __AVX__
+    for (; j+7<n; j+=8)
+    {
+        const float* m = colptr + j;
+
+        __m256 _sum = _mm256_set1_ps(bias0);
+
+        for (int k=0; k<size; k++)
+        {
+            _sum = _mm256_fmadd_ps(_mm256_broadcast_ss(kptr + k), _mm256_loadu_ps(m), _sum);
+
+            m += colstep;
+        }
+
+        _mm256_storeu_ps(outptr + j, _sum);
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; j+3<n; j+=4)
+    {
+        const float* m = colptr + j;
+
+        __m128 _sum = _mm_set1_ps(bias0);
+
+        for (int k=0; k<size; k++)
+        {
+            _sum = _mm_add_ps(_sum, _mm_mul_ps(_mm_load1_ps(kptr + k), _mm_loadu_ps(m)));
+
+            m += colstep;
+        }
+
+        _mm_storeu_ps(outptr + j, _sum);
+    }
+#endif // __SSE2__
+    for (; j<n; j++)
+    {
+        const float* m = colptr + j;
+
+        float sum = bias0;
+
+        for (int k=0; k<size; k++)
+        {
+            sum += kptr[k] * m[0];
+
+            m += colstep;
+        }
+
+        outptr[j] = sum;
+    }
+}
+
+static void convgroup_im2col_sgemm_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, int group, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    int inch = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+
+    const int inch_g = inch / group;
+    const int outch_g = outch / group;
+
+    const int maxk = kernel_w * kernel_h;
+    const int size = inch_g * maxk;
+    const int out_size = outw * outh;
+
+    const float* bias = _bias;
+
+    // the input channels of a group are the gemm rows already for 1x1s1
+    Mat bottom_im2col;
+    size_t colstep = bottom_blob.cstep;
+    if (maxk != 1 || stride_w != 1 || stride_h != 1)
+    {
+        // im2col, one channel per group
+        bottom_im2col.create(out_size, size, group, elemsize, opt.workspace_allocator);
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<inch; q++)
+        {
+            const Mat img = bottom_blob.channel(q);
+            float* ret = bottom_im2col.channel(q / inch_g).row(q % inch_g * maxk);
+
+            for (int u=0; u<kernel_h; u++)
+            {
+                for (int v=0; v<kernel_w; v++)
+                {
+                    for (int i=0; i<outh; i++)
+                    {
+                        const float* sptr = img.row(u * dilation_h + i * stride_h) + v * dilation_w;
+
+                        for (int j=0; j<outw; j++)
+                        {
+                            ret[j] = sptr[j * stride_w];
+                        }
+
+                        ret += outw;
+                    }
+                }
+            }
+        }
+
+        colstep = out_size;
+    }
+
+    // each tile is a group and a range of output pixels, and walks all outputs of the group
+    // so that the im2col range stays in cache while the weights of the group are reused
+    const int tile_size = 256;
+    const int nn_tile = (out_size + tile_size - 1) / tile_size;
+
+    const int nn_outch_g = outch_g / 4;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t=0; t<group * nn_tile; t++)
+    {
+        const int g = t / nn_tile;
+        const int j = t % nn_tile * tile_size;
+        const int n = std::min(tile_size, out_size - j);
+
+        const float* colptr = bottom_im2col.empty() ? bottom_blob.channel(inch_g * g) : bottom_im2col.channel(g);
+        colptr += j;
+
+        const Mat kernel_tm_g = kernel_tm.channel(g);
+
+        int p=0;
+        for (; p+3<outch_g; p+=4)
+        {
+            const float* kptr = kernel_tm_g.row(p/4);
+            const float* biasptr = bias ? bias + outch_g * g + p : 0;
+            float* outptr = top_blob.channel(outch_g * g + p);
+
+            convgroup_sgemm_pack4_sse(colptr, colstep, size, n, kptr, biasptr, outptr + j, top_blob.cstep);
+        }
+        for (; p<outch_g; p++)
+        {
+            const float* kptr = kernel_tm_g.row(nn_outch_g + p%4);
+            const float bias0 = bias ? bias[outch_g * g + p] : 0.f;
+            float* outptr = top_blob.channel(outch_g * g + p);
+
+            convgroup_sgemm_pack1_sse(colptr, colstep, size, n, kptr, bias0, outptr + j);
+        }
+    }
+}
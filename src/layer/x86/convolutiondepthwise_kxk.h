@@ -0,0 +1,218 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+
+// one output whose window starts at (sx, sy) of the input, the kernel rows [ky0, ky1)
+// are inside the input and the kernel columns outside of it are skipped
+static inline float convdw_border_sse(const Mat& m, const float* kptr, float bias0, int sx, int sy, int ky0, int ky1, int kernel_w, int dilation_w, int dilation_h)
+{
+    const int kx0 = sx < 0 ? (-sx + dilation_w - 1) / dilation_w : 0;
+    const int kx1 = sx >= m.w ? 0 : sx + (kernel_w - 1) * dilation_w >= m.w ? (m.w - 1 - sx) / dilation_w + 1 : kernel_w;
+
+    float sum = bias0;
+
+    for (int ky = ky0; ky < ky1; ky++)
+    {
+        const float* sptr = m.row(sy + ky * dilation_h) + sx;
+        const float* k0 = kptr + ky * kernel_w;
+
+        for (int kx = kx0; kx < kx1; kx++)
+        {
+            sum += sptr[kx * dilation_w] * k0[kx];
+        }
+    }
+
+    return sum;
+}
+
+// any kernel size and dilation, stride_w 1 or 2, any stride_h
+// outputs are vectorized along the row, one tap at a time
+// the input is zero padded by pad_left and pad_top virtually, the rows crossing the
+// top or bottom border only take the kernel rows inside the input and the outputs
+// crossing the left or right border are computed by convdw_border_sse
+static void convdw_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int pad_left, int pad_top, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+
+    const int group = bottom_blob.c;
+
+    const int maxk = kernel_w * kernel_h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    // outputs [inner_j0, inner_j1) of a row read inside the input only
+    int inner_j0 = std::min((pad_left + stride_w - 1) / stride_w, outw);
+    int inner_j1 = inner_j0;
+    if (w + pad_left >= kernel_extent_w)
+        inner_j1 = std::max(std::min((w + pad_left - kernel_extent_w) / stride_w + 1, outw), inner_j0);
+
+    // kernel offsets
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        int p2 = 0;
+        int gap = w * dilation_h - kernel_w * dilation_w;
+        for (int i = 0; i < kernel_h; i++)
+        {
+            for (int j = 0; j < kernel_w; j++)
+            {
+                space_ofs[p1] = p2;
+                p1++;
+                p2 += dilation_w;
+            }
+            p2 += gap;
+        }
+    }
+
+    const float* kernel = _kernel;
+    const float* bias = _bias;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int g=0; g<group; g++)
+    {
+        float* outptr = top_blob.channel(g);
+
+        const float bias0 = bias ? bias[g] : 0.f;
+
+        const float* kptr = kernel + maxk * g;
+
+        const Mat m = bottom_blob.channel(g);
+
+        for (int i = 0; i < outh; i++)
+        {
+            const int sy = i * stride_h - pad_top;
+
+            // kernel rows [ky0, ky1) are inside the input
+            const int ky0 = sy < 0 ? std::min((-sy + dilation_h - 1) / dilation_h, kernel_h) : 0;
+            const int ky1 = sy >= h ? ky0 : sy + kernel_extent_h > h ? std::max((h - 1 - sy) / dilation_h + 1, ky0) : kernel_h;
+            const int k0 = ky0 * kernel_w;
+            const int k1 = ky1 * kernel_w;
+
+            for (int j = 0; j < inner_j0; j++)
+            {
+                outptr[j] = activation_ss(convdw_border_sse(m, kptr, bias0, j * stride_w - pad_left, sy, ky0, ky1, kernel_w, dilation_w, dilation_h), activation_type, activation_params);
+            }
+
+            // the virtual padded row, only read inside the input
+            const float* sptr = (const float*)m + w * sy - pad_left;
+
+            int j = inner_j0;
+
+            if (stride_w == 1)
+            {
+#if __AVX__
+                for (; j+7<inner_j1; j+=8)
+                {
+                    __m256 _sum = _mm256_set1_ps(bias0);
+
+                    for (int k = k0; k < k1; k++)
+                    {
+                        __m256 _val = _mm256_loadu_ps(sptr + space_ofs[k] + j);
+                        _sum = _mm256_fmadd_ps(_mm256_broadcast_ss(kptr + k), _val, _sum);
+                    }
+
+                    _mm256_storeu_ps(outptr + j, activation_avx(_sum, activation_type, activation_params));
+                }
+#endif // __AVX__
+#if __SSE2__
+                for (; j+3<inner_j1; j+=4)
+                {
+                    __m128 _sum = _mm_set1_ps(bias0);
+
+                    for (int k = k0; k < k1; k++)
+                    {
+                        __m128 _val = _mm_loadu_ps(sptr + space_ofs[k] + j);
+                        _sum = _mm_add_ps(_sum, _mm_mul_ps(_mm_load1_ps(kptr + k), _val));
+                    }
+
+                    _mm_storeu_ps(outptr + j, activation_sse(_sum, activation_type, activation_params));
+                }
+#endif // __SSE2__
+            }
+            else if (stride_w == 2)
+            {
+                // the odd element past the last one is read,
+                // stop while the next output still covers it
+#if __AVX__
+                for (; j+8<inner_j1; j+=8)
+                {
+                    // even elements come out as outputs 0 1 4 5 2 3 6 7
+                    __m256 _sum = _mm256_set1_ps(bias0);
+
+                    for (int k = k0; k < k1; k++)
+                    {
+                        const float* p = sptr + space_ofs[k] + j*2;
+                        __m256 _val = _mm256_shuffle_ps(_mm256_loadu_ps(p), _mm256_loadu_ps(p + 8), _MM_SHUFFLE(2, 0, 2, 0));
+                        _sum = _mm256_fmadd_ps(_mm256_broadcast_ss(kptr + k), _val, _sum);
+                    }
+
+                    // restore the output order
+                    __m256 _swap = _mm256_permute2f128_ps(_sum, _sum, 0x01);
+                    __m256 _lo = _mm256_shuffle_ps(_sum, _swap, _MM_SHUFFLE(1, 0, 1, 0));
+                    __m256 _hi = _mm256_shuffle_ps(_swap, _sum, _MM_SHUFFLE(3, 2, 3, 2));
+                    _mm256_storeu_ps(outptr + j, activation_avx(_mm256_blend_ps(_lo, _hi, 0xf0), activation_type, activation_params));
+                }
+#endif // __AVX__
+#if __SSE2__
+                for (; j+4<inner_j1; j+=4)
+                {
+                    __m128 _sum = _mm_set1_ps(bias0);
+
+                    for (int k = k0; k < k1; k++)
+                    {
+                        const float* p = sptr + space_ofs[k] + j*2;
+                        __m128 _val = _mm_shuffle_ps(_mm_loadu_ps(p), _mm_loadu_ps(p + 4), _MM_SHUFFLE(2, 0, 2, 0));
+                        _sum = _mm_add_ps(_sum, _mm_mul_ps(_mm_load1_ps(kptr + k), _val));
+                    }
+
+                    _mm_storeu_ps(outptr + j, activation_sse(_sum, activation_type, activation_params));
+                }
+#endif // __SSE2__
+            }
+
+            for (; j < inner_j1; j++)
+            {
+                float sum = bias0;
+
+                const float* p = sptr + j*stride_w;
+
+                for (int k = k0; k < k1; k++)
+                {
+                    sum += p[ space_ofs[k] ] * kptr[k];
+                }
+
+                outptr[j] = activation_ss(sum, activation_type, activation_params);
+            }
+
+            for (; j < outw; j++)
+            {
+                outptr[j] = activation_ss(convdw_border_sse(m, kptr, bias0, j * stride_w - pad_left, sy, ky0, ky1, kernel_w, dilation_w, dilation_h), activation_type, activation_params);
+            }
+
+            outptr += outw;
+        }
+    }
+}
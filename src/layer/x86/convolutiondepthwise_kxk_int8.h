@@ -0,0 +1,222 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+#if __SSE2__
+// 8 signed char of the tap at p as short, every other one for stride 2
+static inline __m128i convdw_int8_load8_sse(const signed char* p, int stride_w)
+{
+    if (stride_w == 1)
+    {
+        __m128i _v = _mm_loadl_epi64((const __m128i*)p);
+        return _mm_unpacklo_epi8(_v, _mm_cmpgt_epi8(_mm_setzero_si128(), _v));
+    }
+
+    // sign extend the low byte of each short
+    __m128i _v = _mm_loadu_si128((const __m128i*)p);
+    return _mm_srai_epi16(_mm_slli_epi16(_v, 8), 8);
+}
+#endif // __SSE2__
+
+// sum of the int8 products for outw outputs of row i
+// taps are paired so that one madd covers two of them
+static void convdw_int8_row_sse(const signed char* sptr, int* sumptr, int outw, const signed char* kptr, const int* space_ofs, int maxk, int stride_w)
+{
+    int j = 0;
+#if __SSE2__
+    // kernel pairs as packed shorts, the last odd tap pairs with zero
+    int kpair[32];
+    const int nn_kpair = (maxk + 1) / 2;
+    const bool use_kpair = stride_w <= 2 && nn_kpair <= 32;
+    if (use_kpair)
+    {
+        for (int k = 0; k < nn_kpair; k++)
+        {
+            short k0 = kptr[k * 2];
+            short k1 = k * 2 + 1 < maxk ? kptr[k * 2 + 1] : 0;
+            kpair[k] = (unsigned short)k0 | ((int)k1 << 16);
+        }
+    }
+
+    // the byte past the last one is read for stride 2,
+    // stop while the next output still covers it
+    const int outw_simd = !use_kpair ? 0 : stride_w == 1 ? outw : outw - 1;
+
+    for (; j+7<outw_simd; j+=8)
+    {
+        __m128i _sum0 = _mm_setzero_si128();
+        __m128i _sum1 = _mm_setzero_si128();
+
+        const signed char* p = sptr + j*stride_w;
+
+        int k = 0;
+        for (; k+1 < maxk; k+=2)
+        {
+            __m128i _v0 = convdw_int8_load8_sse(p + space_ofs[k], stride_w);
+            __m128i _v1 = convdw_int8_load8_sse(p + space_ofs[k + 1], stride_w);
+            __m128i _k = _mm_set1_epi32(kpair[k / 2]);
+
+            _sum0 = _mm_add_epi32(_sum0, _mm_madd_epi16(_mm_unpacklo_epi16(_v0, _v1), _k));
+            _sum1 = _mm_add_epi32(_sum1, _mm_madd_epi16(_mm_unpackhi_epi16(_v0, _v1), _k));
+        }
+        if (k < maxk)
+        {
+            __m128i _v0 = convdw_int8_load8_sse(p + space_ofs[k], stride_w);
+            __m128i _k = _mm_set1_epi32(kpair[k / 2]);
+
+            _sum0 = _mm_add_epi32(_sum0, _mm_madd_epi16(_mm_unpacklo_epi16(_v0, _mm_setzero_si128()), _k));
+            _sum1 = _mm_add_epi32(_sum1, _mm_madd_epi16(_mm_unpackhi_epi16(_v0, _mm_setzero_si128()), _k));
+        }
+
+        _mm_storeu_si128((__m128i*)(sumptr + j), _sum0);
+        _mm_storeu_si128((__m128i*)(sumptr + j + 4), _sum1);
+    }
+#endif // __SSE2__
+    for (; j < outw; j++)
+    {
+        int sum = 0;
+
+        const signed char* p = sptr + j*stride_w;
+
+        for (int k = 0; k < maxk; k++)
+        {
+            sum += (int)p[ space_ofs[k] ] * (int)kptr[k];
+        }
+
+        sumptr[j] = sum;
+    }
+}
+
+static void convdw_int8_space_ofs(int* space_ofs, int w, int kernel_w, int kernel_h, int dilation_w, int dilation_h)
+{
+    int p1 = 0;
+    int p2 = 0;
+    int gap = w * dilation_h - kernel_w * dilation_w;
+    for (int i = 0; i < kernel_h; i++)
+    {
+        for (int j = 0; j < kernel_w; j++)
+        {
+            space_ofs[p1] = p2;
+            p1++;
+            p2 += dilation_w;
+        }
+        p2 += gap;
+    }
+}
+
+static void convdw_int8_dequant_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, std::vector<float> scales_dequant, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    int w = bottom_blob.w;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+
+    const int maxk = kernel_w * kernel_h;
+
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    convdw_int8_space_ofs(space_ofs, w, kernel_w, kernel_h, dilation_w, dilation_h);
+
+    const signed char* kernel = _kernel;
+    const float* bias = _bias;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p = 0; p < outch; p++)
+    {
+        float* outptr = top_blob.channel(p);
+
+        const float bias0 = bias ? bias[p] : 0.f;
+        const float scale_dequant = scales_dequant[p];
+
+        const signed char* kptr = kernel + maxk * p;
+
+        const Mat m = bottom_blob.channel(p);
+
+        std::vector<int> _sums(outw);
+        int* sumptr = &_sums[0];
+
+        for (int i = 0; i < outh; i++)
+        {
+            convdw_int8_row_sse(m.row<signed char>(i*stride_h), sumptr, outw, kptr, space_ofs, maxk, stride_w);
+
+            int j = 0;
+#if __SSE2__
+            __m128 _bias0 = _mm_set1_ps(bias0);
+            __m128 _scale = _mm_set1_ps(scale_dequant);
+            for (; j+3<outw; j+=4)
+            {
+                __m128 _sum = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(sumptr + j)));
+                _mm_storeu_ps(outptr + j, _mm_add_ps(_bias0, _mm_mul_ps(_sum, _scale)));
+            }
+#endif // __SSE2__
+            for (; j < outw; j++)
+            {
+                outptr[j] = bias0 + (float)sumptr[j] * scale_dequant;
+            }
+
+            outptr += outw;
+        }
+    }
+}
+
+static void convdw_int8_requant_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& _kernel, const Mat& _bias, std::vector<float> scales_requant, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    int w = bottom_blob.w;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+
+    const int maxk = kernel_w * kernel_h;
+
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    convdw_int8_space_ofs(space_ofs, w, kernel_w, kernel_h, dilation_w, dilation_h);
+
+    const signed char* kernel = _kernel;
+    const float* bias = _bias;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p = 0; p < outch; p++)
+    {
+        signed char* outptr = top_blob.channel(p);
+
+        const float bias0 = bias ? bias[p] : 0.f;
+        const float scale_requant_in = scales_requant[2*p];
+        const float scale_requant_out = scales_requant[2*p+1];
+
+        const signed char* kptr = kernel + maxk * p;
+
+        const Mat m = bottom_blob.channel(p);
+
+        std::vector<int> _sums(outw);
+        int* sumptr = &_sums[0];
+
+        for (int i = 0; i < outh; i++)
+        {
+            convdw_int8_row_sse(m.row<signed char>(i*stride_h), sumptr, outw, kptr, space_ofs, maxk, stride_w);
+
+            for (int j = 0; j < outw; j++)
+            {
+                outptr[j] = float2int8(((float)sumptr[j] * scale_requant_in + bias0) * scale_requant_out);
+            }
+
+            outptr += outw;
+        }
+    }
+}
@@ -13,18 +13,23 @@
 // specific language governing permissions and limitations under the License.
 
 #include "convolutiondepthwise_x86.h"
+#include <algorithm>
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
 #include "layer_type.h"
+#include "x86_activation.h"
 
 namespace ncnn {
 
 #include "convolutiondepthwise_3x3.h"
+#include "convolutiondepthwise_kxk.h"
+#include "convolutiondepthwise_group_sgemm.h"
 
 #include "convolutiondepthwise_3x3_int8.h"
+#include "convolutiondepthwise_kxk_int8.h"
 
 DEFINE_LAYER_CREATOR(ConvolutionDepthWise_x86)
 
@@ -86,19 +91,28 @@ int ConvolutionDepthWise_x86::create_pipeline(const Option& opt)
 
     if (channels == group && group == num_output)
     {
-        // depth-wise specific
-        if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1)
+        // depth-wise specific, any kernel size and dilation
+        if (stride_w == 1 || stride_w == 2)
         {
-            if ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2))
-            {
-                return 0;
-            }
+            return 0;
         }
     }    
 
     const int channels_g = channels / group;
     const int num_output_g = num_output / group;
 
+    // float32 runs all groups in one sgemm
+    if (weight_data.elemsize == (size_t)4u)
+    {
+        convgroup_im2col_sgemm_transform_kernel_sse(weight_data, weight_sgemm_data, channels_g, num_output_g, group, maxk);
+    }
+
+    // int8 keeps one Convolution op per group
+    if (int8_scale_term == 0)
+    {
+        return 0;
+    }
+
     group_ops.resize(group);     
 
     for (int g=0; g<group; g++)
@@ -231,15 +245,16 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
         bottom_blob_unbordered = bottom_blob_int8;       
     }     
 
-    Mat bottom_blob_bordered = bottom_blob_unbordered;
+    int pad_left = 0;
+    int pad_right = 0;
+    int pad_top = 0;
+    int pad_bottom = 0;
     if (pad_w > 0 || pad_h > 0)
     {
-        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_h, pad_h, pad_w, pad_w, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-        if (bottom_blob_bordered.empty())
-            return -100;
-
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
+        pad_left = pad_w;
+        pad_right = pad_w;
+        pad_top = pad_h;
+        pad_bottom = pad_h;
     }
     else if (pad_w == -233 && pad_h == -233)
     {
@@ -247,15 +262,32 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
         int hpad = kernel_extent_h + (h - 1) / stride_h * stride_h - h;
         if (wpad > 0 || hpad > 0)
         {
-            copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
-            if (bottom_blob_bordered.empty())
-                return -100;
+            pad_left = wpad / 2;
+            pad_right = wpad - wpad / 2;
+            pad_top = hpad / 2;
+            pad_bottom = hpad - hpad / 2;
         }
+    }
+
+    const bool padded = pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0;
+
+    const bool dw3x3s1 = kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1;
+    const bool dw3x3s2 = kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2;
 
-        w = bottom_blob_bordered.w;
-        h = bottom_blob_bordered.h;
+    // fp32 depth-wise convdw_sse reads the zero padding in place, others take a bordered copy
+    const bool pad_inplace = padded && pad_left >= 0 && pad_top >= 0 && pad_right >= 0 && pad_bottom >= 0 && !use_int8_inference && channels == group && group == num_output && (stride_w == 1 || stride_w == 2) && !dw3x3s2;
+
+    Mat bottom_blob_bordered = bottom_blob_unbordered;
+    if (padded && !pad_inplace)
+    {
+        copy_make_border(bottom_blob_unbordered, bottom_blob_bordered, pad_top, pad_bottom, pad_left, pad_right, BORDER_CONSTANT, 0.f, opt.workspace_allocator, opt.num_threads);
+        if (bottom_blob_bordered.empty())
+            return -100;
     }
 
+    w += pad_left + pad_right;
+    h += pad_top + pad_bottom;
+
     int outw = (w - kernel_extent_w) / stride_w + 1;
     int outh = (h - kernel_extent_h) / stride_h + 1;
 
@@ -276,26 +308,27 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
             // depth-wise
             if (channels == group && group == num_output)
             {                
-                if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1)
+                if (stride_w == 1 || stride_w == 2)
                 {
-                    if ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2))
+                    if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
+                    {
+                        convdw3x3s1_int8_requant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);
+                    }
+                    else if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
+                    {
+                        convdw3x3s2_int8_requant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);
+                    }
+                    else
                     {
-                        if (stride_w == 1 && stride_h == 1)
-                        {
-                            convdw3x3s1_int8_requant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);                          
-                        }
-                        else if (stride_w == 2 && stride_h == 2)
-                        {
-                            convdw3x3s2_int8_requant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, opt);                           
-                        }
-
-                        if (activation)
-                        {
-                            activation->forward_inplace(top_blob, opt);
-                        }
-
-                        return 0;
+                        convdw_int8_requant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, requantize_scales, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
                     }
+
+                    if (activation)
+                    {
+                        activation->forward_inplace(top_blob, opt);
+                    }
+
+                    return 0;
                 }
 
                 #pragma omp parallel for num_threads(opt.num_threads)
@@ -349,26 +382,27 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
             // depth-wise
             if (channels == group && group == num_output)
             {                
-                if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1)
+                if (stride_w == 1 || stride_w == 2)
                 {
-                    if ((stride_w == 1 && stride_h == 1) || (stride_w == 2 && stride_h == 2))
+                    if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
+                    {
+                        convdw3x3s1_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);
+                    }
+                    else if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 2 && stride_h == 2)
+                    {
+                        convdw3x3s2_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);
+                    }
+                    else
                     {
-                        if (stride_w == 1 && stride_h == 1)
-                        {
-                            convdw3x3s1_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);
-                        }
-                        else if (stride_w == 2 && stride_h == 2)
-                        {
-                            convdw3x3s2_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, opt);                          
-                        }
-
-                        if (activation)
-                        {
-                            activation->forward_inplace(top_blob, opt);
-                        }                        
-
-                        return 0;
+                        convdw_int8_dequant_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, dequantize_scales, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
                     }
+
+                    if (activation)
+                    {
+                        activation->forward_inplace(top_blob, opt);
+                    }
+
+                    return 0;
                 }
 
                 #pragma omp parallel for num_threads(opt.num_threads)
@@ -430,15 +464,23 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
     // depth-wise
     if (channels == group && group == num_output)
     {
-        if (kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1)
+        if (stride_w == 1 || stride_w == 2)
         {
-            if (stride_w == 1 && stride_h == 1)
+            if (dw3x3s1 && !padded)
             {
                 convdw3x3s1_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
             }
-            else if (stride_w == 2 && stride_h == 2)
+            else if (dw3x3s2)
             {
-                convdw3x3s2_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, opt);
+                convdw3x3s2_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, activation_type, activation_params, opt);
+
+                return 0;
+            }
+            else
+            {
+                convdw_sse(bottom_blob_bordered, top_blob, weight_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, pad_inplace ? pad_left : 0, pad_inplace ? pad_top : 0, activation_type, activation_params, opt);
+
+                return 0;
             }
 
             if (activation)
@@ -448,47 +490,10 @@ int ConvolutionDepthWise_x86::forward(const Mat& bottom_blob, Mat& top_blob, con
 
             return 0;
         }
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int g=0; g<group; g++)
-        {
-            const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(g, 1);
-            Mat top_blob_g = top_blob.channel_range(g, 1);
-
-            const ncnn::Layer* op = group_ops[g];
-
-            ncnn::Option opt_g = opt;
-            opt_g.num_threads = 1;
-            opt_g.blob_allocator = top_blob.allocator;
-
-         // forward
-            op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
-        }
-
-        if (activation)
-        {
-            activation->forward_inplace(top_blob, opt);
-        }
-
-        return 0;
     }
 
-    const int channels_g = channels / group;
-    const int num_output_g = num_output / group;
-
-    for (int g=0; g<group; g++)
-    {
-        const Mat bottom_blob_bordered_g = bottom_blob_bordered.channel_range(channels_g * g, channels_g);
-        Mat top_blob_g = top_blob.channel_range(num_output_g * g, num_output_g);
-
-        const ncnn::Layer* op = group_ops[g];
-
-        ncnn::Option opt_g = opt;
-        opt_g.blob_allocator = top_blob.allocator;
-
-        // forward
-        op->forward(bottom_blob_bordered_g, top_blob_g, opt_g);
-    }
+    // grouped, and depth-wise with other strides
+    convgroup_im2col_sgemm_sse(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, group, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
 
     if (activation)
     {
@@ -32,6 +32,9 @@ public:
 public:
     Layer* activation;
     std::vector<ncnn::Layer*> group_ops;
+
+    // float32 grouped convolution, 4 outputs interleaved for each group
+    Mat weight_sgemm_data;
 };
 
 } // namespace ncnn
@@ -0,0 +1,523 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "deconvolution_x86.h"
+#include <algorithm>
+
+#include "x86_activation.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Deconvolution_x86)
+
+int Deconvolution_x86::create_pipeline(const Option& /*opt*/)
+{
+    const int maxk = kernel_w * kernel_h;
+    int num_input = weight_data_size / maxk / num_output;
+
+    // src = maxk-inch-outch
+    // dst = 4-inch-maxk/4-outch, remain maxk keep inch contiguous
+    weight_data_packed.create(maxk * num_input, num_output);
+    if (weight_data_packed.empty())
+        return -100;
+
+    for (int p=0; p<num_output; p++)
+    {
+        const float* kptr = (const float*)weight_data + maxk * num_input * p;
+        float* g00 = weight_data_packed.row(p);
+
+        int k=0;
+        for (; k+3<maxk; k+=4)
+        {
+            for (int q=0; q<num_input; q++)
+            {
+                g00[0] = kptr[maxk * q + k];
+                g00[1] = kptr[maxk * q + k + 1];
+                g00[2] = kptr[maxk * q + k + 2];
+                g00[3] = kptr[maxk * q + k + 3];
+
+                g00 += 4;
+            }
+        }
+        for (; k<maxk; k++)
+        {
+            for (int q=0; q<num_input; q++)
+            {
+                g00[0] = kptr[maxk * q + k];
+
+                g00 += 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// col(k, j) = sum_q kernel(k, q) * bottom(q, j0 + j) for n columns
+static void deconvolution_gemm(const Mat& bottom_blob, int j0, int n, const float* kernel, int maxk, Mat& col)
+{
+    const int inch = bottom_blob.c;
+    const size_t cstep = bottom_blob.cstep;
+    const float* bptr = (const float*)bottom_blob + j0;
+
+    int k=0;
+    for (; k+3<maxk; k+=4)
+    {
+        float* outptr0 = col.row(k);
+        float* outptr1 = col.row(k + 1);
+        float* outptr2 = col.row(k + 2);
+        float* outptr3 = col.row(k + 3);
+
+        int j=0;
+#if __AVX__
+        for (; j+15<n; j+=16)
+        {
+            const float* kptr = kernel;
+            const float* m = bptr + j;
+
+            __m256 _sum00 = _mm256_setzero_ps();
+            __m256 _sum01 = _mm256_setzero_ps();
+            __m256 _sum10 = _mm256_setzero_ps();
+            __m256 _sum11 = _mm256_setzero_ps();
+            __m256 _sum20 = _mm256_setzero_ps();
+            __m256 _sum21 = _mm256_setzero_ps();
+            __m256 _sum30 = _mm256_setzero_ps();
+            __m256 _sum31 = _mm256_setzero_ps();
+
+            for (int q=0; q<inch; q++)
+            {
+                __m256 _val0 = _mm256_loadu_ps(m);
+                __m256 _val1 = _mm256_loadu_ps(m + 8);
+
+                __m256 _k0 = _mm256_broadcast_ss(kptr);
+                __m256 _k1 = _mm256_broadcast_ss(kptr + 1);
+                __m256 _k2 = _mm256_broadcast_ss(kptr + 2);
+                __m256 _k3 = _mm256_broadcast_ss(kptr + 3);
+
+                _sum00 = _mm256_fmadd_ps(_k0, _val0, _sum00);
+                _sum01 = _mm256_fmadd_ps(_k0, _val1, _sum01);
+                _sum10 = _mm256_fmadd_ps(_k1, _val0, _sum10);
+                _sum11 = _mm256_fmadd_ps(_k1, _val1, _sum11);
+                _sum20 = _mm256_fmadd_ps(_k2, _val0, _sum20);
+                _sum21 = _mm256_fmadd_ps(_k2, _val1, _sum21);
+                _sum30 = _mm256_fmadd_ps(_k3, _val0, _sum30);
+                _sum31 = _mm256_fmadd_ps(_k3, _val1, _sum31);
+
+                kptr += 4;
+                m += cstep;
+            }
+
+            _mm256_storeu_ps(outptr0 + j, _sum00);
+            _mm256_storeu_ps(outptr0 + j + 8, _sum01);
+            _mm256_storeu_ps(outptr1 + j, _sum10);
+            _mm256_storeu_ps(outptr1 + j + 8, _sum11);
+            _mm256_storeu_ps(outptr2 + j, _sum20);
+            _mm256_storeu_ps(outptr2 + j + 8, _sum21);
+            _mm256_storeu_ps(outptr3 + j, _sum30);
+            _mm256_storeu_ps(outptr3 + j + 8, _sum31);
+        }
+        for (; j+7<n; j+=8)
+        {
+            const float* kptr = kernel;
+            const float* m = bptr + j;
+
+            __m256 _sum0 = _mm256_setzero_ps();
+            __m256 _sum1 = _mm256_setzero_ps();
+            __m256 _sum2 = _mm256_setzero_ps();
+            __m256 _sum3 = _mm256_setzero_ps();
+
+            for (int q=0; q<inch; q++)
+            {
+                __m256 _val = _mm256_loadu_ps(m);
+
+                _sum0 = _mm256_fmadd_ps(_mm256_broadcast_ss(kptr), _val, _sum0);
+                _sum1 = _mm256_fmadd_ps(_mm256_broadcast_ss(kptr + 1), _val, _sum1);
+                _sum2 = _mm256_fmadd_ps(_mm256_broadcast_ss(kptr + 2), _val, _sum2);
+                _sum3 = _mm256_fmadd_ps(_mm256_broadcast_ss(kptr + 3), _val, _sum3);
+
+                kptr += 4;
+                m += cstep;
+            }
+
+            _mm256_storeu_ps(outptr0 + j, _sum0);
+            _mm256_storeu_ps(outptr1 + j, _sum1);
+            _mm256_storeu_ps(outptr2 + j, _sum2);
+            _mm256_storeu_ps(outptr3 + j, _sum3);
+        }
+#endif // __AVX__
+#if __SSE2__
+        for (; j+3<n; j+=4)
+        {
+            const float* kptr = kernel;
+            const float* m = bptr + j;
+
+            __m128 _sum0 = _mm_setzero_ps();
+            __m128 _sum1 = _mm_setzero_ps();
+            __m128 _sum2 = _mm_setzero_ps();
+            __m128 _sum3 = _mm_setzero_ps();
+
+            for (int q=0; q<inch; q++)
+            {
+                __m128 _val = _mm_loadu_ps(m);
+
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_load1_ps(kptr), _val));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_mm_load1_ps(kptr + 1), _val));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_mm_load1_ps(kptr + 2), _val));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_mm_load1_ps(kptr + 3), _val));
+
+                kptr += 4;
+                m += cstep;
+            }
+
+            _mm_storeu_ps(outptr0 + j, _sum0);
+            _mm_storeu_ps(outptr1 + j, _sum1);
+            _mm_storeu_ps(outptr2 + j, _sum2);
+            _mm_storeu_ps(outptr3 + j, _sum3);
+        }
+#endif // __SSE2__
+        for (; j<n; j++)
+        {
+            const float* kptr = kernel;
+            const float* m = bptr + j;
+
+            float sum0 = 0.f;
+            float sum1 = 0.f;
+            float sum2 = 0.f;
+            float sum3 = 0.f;
+
+            for (int q=0; q<inch; q++)
+            {
+                sum0 += kptr[0] * m[0];
+                sum1 += kptr[1] * m[0];
+                sum2 += kptr[2] * m[0];
+                sum3 += kptr[3] * m[0];
+
+                kptr += 4;
+                m += cstep;
+            }
+
+            outptr0[j] = sum0;
+            outptr1[j] = sum1;
+            outptr2[j] = sum2;
+            outptr3[j] = sum3;
+        }
+
+        kernel += 4 * inch;
+    }
+    for (; k<maxk; k++)
+    {
+        float* outptr = col.row(k);
+
+        int j=0;
+#if __AVX__
+        for (; j+7<n; j+=8)
+        {
+            const float* kptr = kernel;
+            const float* m = bptr + j;
+
+            __m256 _sum = _mm256_setzero_ps();
+
+            for (int q=0; q<inch; q++)
+            {
+                _sum = _mm256_fmadd_ps(_mm256_broadcast_ss(kptr), _mm256_loadu_ps(m), _sum);
+
+                kptr += 1;
+                m += cstep;
+            }
+
+            _mm256_storeu_ps(outptr + j, _sum);
+        }
+#endif // __AVX__
+#if __SSE2__
+        for (; j+3<n; j+=4)
+        {
+            const float* kptr = kernel;
+            const float* m = bptr + j;
+
+            __m128 _sum = _mm_setzero_ps();
+
+            for (int q=0; q<inch; q++)
+            {
+                _sum = _mm_add_ps(_sum, _mm_mul_ps(_mm_load1_ps(kptr), _mm_loadu_ps(m)));
+
+                kptr += 1;
+                m += cstep;
+            }
+
+            _mm_storeu_ps(outptr + j, _sum);
+        }
+#endif // __SSE2__
+        for (; j<n; j++)
+        {
+            const float* kptr = kernel;
+            const float* m = bptr + j;
+
+            float sum = 0.f;
+
+            for (int q=0; q<inch; q++)
+            {
+                sum += kptr[0] * m[0];
+
+                kptr += 1;
+                m += cstep;
+            }
+
+            outptr[j] = sum;
+        }
+
+        kernel += inch;
+    }
+}
+
+// outptr[x] += ptr[x]
+static void deconvolution_add_row(const float* ptr, float* outptr, int size)
+{
+    int x=0;
+#if __AVX__
+    for (; x+7<size; x+=8)
+    {
+        _mm256_storeu_ps(outptr + x, _mm256_add_ps(_mm256_loadu_ps(outptr + x), _mm256_loadu_ps(ptr + x)));
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; x+3<size; x+=4)
+    {
+        _mm_storeu_ps(outptr + x, _mm_add_ps(_mm_loadu_ps(outptr + x), _mm_loadu_ps(ptr + x)));
+    }
+#endif // __SSE2__
+    for (; x<size; x++)
+    {
+        outptr[x] += ptr[x];
+    }
+}
+
+// outptr[2x] += ptr0[x], outptr[2x+1] += ptr1[x]
+static void deconvolution_add_row_s2_pair(const float* ptr0, const float* ptr1, float* outptr, int size)
+{
+    int x=0;
+#if __AVX__
+    for (; x+7<size; x+=8)
+    {
+        __m256 _p0 = _mm256_loadu_ps(ptr0 + x);
+        __m256 _p1 = _mm256_loadu_ps(ptr1 + x);
+
+        // interleave within 128bit lanes, then restore the lane order
+        __m256 _lo = _mm256_unpacklo_ps(_p0, _p1);
+        __m256 _hi = _mm256_unpackhi_ps(_p0, _p1);
+        __m256 _r0 = _mm256_permute2f128_ps(_lo, _hi, 0x20);
+        __m256 _r1 = _mm256_permute2f128_ps(_lo, _hi, 0x31);
+
+        float* o = outptr + x * 2;
+        _mm256_storeu_ps(o, _mm256_add_ps(_mm256_loadu_ps(o), _r0));
+        _mm256_storeu_ps(o + 8, _mm256_add_ps(_mm256_loadu_ps(o + 8), _r1));
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; x+3<size; x+=4)
+    {
+        __m128 _p0 = _mm_loadu_ps(ptr0 + x);
+        __m128 _p1 = _mm_loadu_ps(ptr1 + x);
+
+        float* o = outptr + x * 2;
+        _mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_unpacklo_ps(_p0, _p1)));
+        _mm_storeu_ps(o + 4, _mm_add_ps(_mm_loadu_ps(o + 4), _mm_unpackhi_ps(_p0, _p1)));
+    }
+#endif // __SSE2__
+    for (; x<size; x++)
+    {
+        outptr[x * 2] += ptr0[x];
+        outptr[x * 2 + 1] += ptr1[x];
+    }
+}
+
+// scatter col rows of input rows [i0, i0 + rows) onto out
+// out(i * stride_h + ky * dilation_h, j * stride_w + kx * dilation_w) += col(ky * kernel_w + kx, (i - i0) * w + j)
+static void deconvolution_col2im(const Mat& col, int w, int i0, int rows, Mat& out, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h)
+{
+    for (int ky=0; ky<kernel_h; ky++)
+    {
+        int kx=0;
+
+        if (stride_w == 2 && dilation_w == 1)
+        {
+            // adjacent taps fill the even and odd output columns
+            for (; kx+1<kernel_w; kx+=2)
+            {
+                const float* ptr0 = col.row(ky * kernel_w + kx);
+                const float* ptr1 = col.row(ky * kernel_w + kx + 1);
+
+                for (int i=0; i<rows; i++)
+                {
+                    float* outptr = out.row((i0 + i) * stride_h + ky * dilation_h) + kx;
+
+                    deconvolution_add_row_s2_pair(ptr0 + i * w, ptr1 + i * w, outptr, w);
+                }
+            }
+        }
+
+        for (; kx<kernel_w; kx++)
+        {
+            const float* ptr = col.row(ky * kernel_w + kx);
+
+            for (int i=0; i<rows; i++)
+            {
+                float* outptr = out.row((i0 + i) * stride_h + ky * dilation_h) + kx * dilation_w;
+                const float* p = ptr + i * w;
+
+                if (stride_w == 1)
+                {
+                    deconvolution_add_row(p, outptr, w);
+                }
+                else
+                {
+                    for (int j=0; j<w; j++)
+                    {
+                        outptr[j * stride_w] += p[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// outptr[x] = activation(ptr[x]), ptr may be outptr
+static void deconvolution_activation_row(const float* ptr, float* outptr, int size, int activation_type, const Mat& activation_params)
+{
+    int x=0;
+#if __AVX__
+    for (; x+7<size; x+=8)
+    {
+        _mm256_storeu_ps(outptr + x, activation_avx(_mm256_loadu_ps(ptr + x), activation_type, activation_params));
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; x+3<size; x+=4)
+    {
+        _mm_storeu_ps(outptr + x, activation_sse(_mm_loadu_ps(ptr + x), activation_type, activation_params));
+    }
+#endif // __SSE2__
+    for (; x<size; x++)
+    {
+        outptr[x] = activation_ss(ptr[x], activation_type, activation_params);
+    }
+}
+
+int Deconvolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    // backward strided convolv with NxN kernel
+    // value = value + bias
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    int outw = (w - 1) * stride_w + kernel_extent_w + output_pad_w;
+    int outh = (h - 1) * stride_h + kernel_extent_h + output_pad_h;
+
+    const bool bordered = pad_w > 0 || pad_h > 0 || output_pad_w > 0 || output_pad_h > 0;
+
+    Mat top_blob_bordered;
+    if (bordered)
+    {
+        top_blob_bordered.create(outw, outh, num_output, elemsize, opt.workspace_allocator);
+        if (top_blob_bordered.empty())
+            return -100;
+
+        top_blob.create(outw - pad_w - pad_w, outh - pad_h - pad_h, num_output, elemsize, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+    }
+    else
+    {
+        top_blob.create(outw, outh, num_output, elemsize, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        top_blob_bordered = top_blob;
+    }
+
+    const int maxk = kernel_w * kernel_h;
+
+    // whole input rows per tile, keep the input tile and the col buffer in cache
+    int tile_h = std::max(1, 65536 / (channels + maxk) / w);
+    tile_h = std::min(tile_h, h);
+
+    // start from bias
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<num_output; p++)
+    {
+        Mat out = top_blob_bordered.channel(p);
+
+        const float bias = bias_term ? bias_data[p] : 0.f;
+
+        out.fill(bias);
+    }
+
+    for (int i0 = 0; i0 < h; i0 += tile_h)
+    {
+        const int rows = std::min(tile_h, h - i0);
+        const int n = rows * w;
+
+        // num_output
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p=0; p<num_output; p++)
+        {
+            Mat col(n, maxk, (size_t)4u, opt.workspace_allocator);
+
+            const float* kernel = weight_data_packed.row(p);
+
+            deconvolution_gemm(bottom_blob, i0 * w, n, kernel, maxk, col);
+
+            Mat out = top_blob_bordered.channel(p);
+
+            deconvolution_col2im(col, w, i0, rows, out, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h);
+        }
+    }
+
+    if (!bordered && activation_type == 0)
+        return 0;
+
+    // activation, and crop the border on the fly
+    const int top_w = top_blob.w;
+    const int top_h = top_blob.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<num_output; p++)
+    {
+        const Mat m = top_blob_bordered.channel(p);
+        Mat out = top_blob.channel(p);
+
+        if (!bordered)
+        {
+            deconvolution_activation_row(m, out, top_w * top_h, activation_type, activation_params);
+            continue;
+        }
+
+        for (int i=0; i<top_h; i++)
+        {
+            const float* ptr = m.row(i + pad_h) + pad_w;
+            float* outptr = out.row(i);
+
+            deconvolution_activation_row(ptr, outptr, top_w, activation_type, activation_params);
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
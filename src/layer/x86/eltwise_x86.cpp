@@ -0,0 +1,207 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "eltwise_x86.h"
+#include <algorithm>
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Eltwise_x86)
+
+Eltwise_x86::Eltwise_x86()
+{
+    // accumulate into the first blob
+    support_inplace = true;
+}
+
+// outptr = ptr * ptr1
+static void eltwise_prod(const float* ptr, const float* ptr1, float* outptr, int size)
+{
+    int i = 0;
+#if __AVX__
+    for (; i+7<size; i+=8)
+    {
+        _mm256_storeu_ps(outptr + i, _mm256_mul_ps(_mm256_loadu_ps(ptr + i), _mm256_loadu_ps(ptr1 + i)));
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; i+3<size; i+=4)
+    {
+        _mm_storeu_ps(outptr + i, _mm_mul_ps(_mm_loadu_ps(ptr + i), _mm_loadu_ps(ptr1 + i)));
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        outptr[i] = ptr[i] * ptr1[i];
+    }
+}
+
+// outptr = ptr + ptr1
+static void eltwise_sum(const float* ptr, const float* ptr1, float* outptr, int size)
+{
+    int i = 0;
+#if __AVX__
+    for (; i+7<size; i+=8)
+    {
+        _mm256_storeu_ps(outptr + i, _mm256_add_ps(_mm256_loadu_ps(ptr + i), _mm256_loadu_ps(ptr1 + i)));
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; i+3<size; i+=4)
+    {
+        _mm_storeu_ps(outptr + i, _mm_add_ps(_mm_loadu_ps(ptr + i), _mm_loadu_ps(ptr1 + i)));
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        outptr[i] = ptr[i] + ptr1[i];
+    }
+}
+
+// outptr = ptr * coeff + ptr1 * coeff1
+static void eltwise_sum_coeff(const float* ptr, float coeff, const float* ptr1, float coeff1, float* outptr, int size)
+{
+    int i = 0;
+#if __AVX__
+    __m256 _coeff_avx = _mm256_set1_ps(coeff);
+    __m256 _coeff1_avx = _mm256_set1_ps(coeff1);
+    for (; i+7<size; i+=8)
+    {
+        __m256 _p = _mm256_mul_ps(_mm256_loadu_ps(ptr + i), _coeff_avx);
+        _mm256_storeu_ps(outptr + i, _mm256_fmadd_ps(_mm256_loadu_ps(ptr1 + i), _coeff1_avx, _p));
+    }
+#endif // __AVX__
+#if __SSE2__
+    __m128 _coeff = _mm_set1_ps(coeff);
+    __m128 _coeff1 = _mm_set1_ps(coeff1);
+    for (; i+3<size; i+=4)
+    {
+        __m128 _p = _mm_mul_ps(_mm_loadu_ps(ptr + i), _coeff);
+        _mm_storeu_ps(outptr + i, _mm_add_ps(_p, _mm_mul_ps(_mm_loadu_ps(ptr1 + i), _coeff1)));
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        outptr[i] = ptr[i] * coeff + ptr1[i] * coeff1;
+    }
+}
+
+// outptr = max(ptr, ptr1)
+static void eltwise_max(const float* ptr, const float* ptr1, float* outptr, int size)
+{
+    int i = 0;
+#if __AVX__
+    for (; i+7<size; i+=8)
+    {
+        _mm256_storeu_ps(outptr + i, _mm256_max_ps(_mm256_loadu_ps(ptr + i), _mm256_loadu_ps(ptr1 + i)));
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; i+3<size; i+=4)
+    {
+        _mm_storeu_ps(outptr + i, _mm_max_ps(_mm_loadu_ps(ptr + i), _mm_loadu_ps(ptr1 + i)));
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        outptr[i] = std::max(ptr[i], ptr1[i]);
+    }
+}
+
+// reduce bottom_blobs into top_blob, which may be bottom_blobs[0] itself
+static void eltwise(const std::vector<Mat>& bottom_blobs, Mat& top_blob, int op_type, const Mat& coeffs, const Option& opt)
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    int channels = bottom_blob.c;
+    int size = bottom_blob.w * bottom_blob.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = bottom_blob.channel(q);
+        float* outptr = top_blob.channel(q);
+
+        for (size_t b=1; b<bottom_blobs.size(); b++)
+        {
+            const float* ptr1 = bottom_blobs[b].channel(q);
+
+            if (op_type == Eltwise::Operation_PROD)
+            {
+                eltwise_prod(ptr, ptr1, outptr, size);
+            }
+            else if (op_type == Eltwise::Operation_SUM)
+            {
+                if (coeffs.w == 0)
+                    eltwise_sum(ptr, ptr1, outptr, size);
+                else
+                    eltwise_sum_coeff(ptr, b == 1 ? coeffs[0] : 1.f, ptr1, coeffs[b], outptr, size);
+            }
+            else if (op_type == Eltwise::Operation_MAX)
+            {
+                eltwise_max(ptr, ptr1, outptr, size);
+            }
+
+            // accumulate on the output from now on
+            ptr = outptr;
+        }
+    }
+}
+
+int Eltwise_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(w, h, channels, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    eltwise(bottom_blobs, top_blob, op_type, coeffs, opt);
+
+    return 0;
+}
+
+int Eltwise_x86::forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    Mat& bottom_top_blob = bottom_top_blobs[0];
+
+    if (bottom_top_blob.dims != 3)
+    {
+        // the output is always 3-dim
+        std::vector<Mat> top_blobs(1);
+        int ret = forward(bottom_top_blobs, top_blobs, opt);
+        if (ret != 0)
+            return ret;
+
+        bottom_top_blob = top_blobs[0];
+        return 0;
+    }
+
+    eltwise(bottom_top_blobs, bottom_top_blob, op_type, coeffs, opt);
+
+    return 0;
+}
+
+} // namespace ncnn
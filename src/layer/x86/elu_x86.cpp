@@ -0,0 +1,32 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "elu_x86.h"
+#include "x86_elementwise.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(ELU_x86)
+
+ELU_x86::ELU_x86()
+{
+    support_fp16_storage = true;
+}
+
+int ELU_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    return unary_op_inplace_x86(bottom_top_blob, elementwise_elu(alpha, 1.f), opt);
+}
+
+} // namespace ncnn
@@ -0,0 +1,280 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+
+static inline signed char float2int8(float v)
+{
+    int int32 = round(v);
+    if (int32 > 127) return 127;
+    if (int32 < -128) return -128;
+    return (signed char)int32;
+}
+
+// num_input is padded with zero to a multiple of 64 so that the kernels need no tail
+static void innerproduct_transform_kernel_int8_sse(const Mat& weight_data, Mat& weight_tm, Mat& weight_sum, int num_input, int num_output)
+{
+    const int num_input_tm = (num_input + 63) / 64 * 64;
+
+    weight_tm.create(num_input_tm, num_output, (size_t)1u);
+    weight_sum.create(num_output, (size_t)4u);
+
+    for (int p=0; p<num_output; p++)
+    {
+        const signed char* kptr = (const signed char*)weight_data + num_input * p;
+        signed char* ktmp = weight_tm.row<signed char>(p);
+
+        int sum = 0;
+        for (int i=0; i<num_input; i++)
+        {
+            ktmp[i] = kptr[i];
+            sum += kptr[i];
+        }
+        for (int i=num_input; i<num_input_tm; i++)
+        {
+            ktmp[i] = 0;
+        }
+
+        // the vnni kernel runs on unsigned input with 128 added, subtract 128 * sum(kernel) back
+        ((int*)weight_sum)[p] = sum;
+    }
+}
+
+// quantize each row of bottom into the zero padded rows of bottom_tm
+static void innerproduct_quantize_int8_sse(const float* bottom, Mat& bottom_tm, int rows, int num_input, float scale, const Option& opt)
+{
+    const int num_input_tm = bottom_tm.w;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int j=0; j<rows; j++)
+    {
+        const float* ptr = bottom + num_input * j;
+        signed char* outptr = bottom_tm.row<signed char>(j);
+
+        for (int i=0; i<num_input; i++)
+        {
+            outptr[i] = float2int8(ptr[i] * scale);
+        }
+        for (int i=num_input; i<num_input_tm; i++)
+        {
+            outptr[i] = 0;
+        }
+    }
+}
+
+// top = activation(sum * scale + bias) for 4 outputs
+static inline void innerproduct_dequantize_pack4_sse(const int* sum, float* top, const float* scale, const float* bias, int activation_type, const Mat& activation_params)
+{
+#if __SSE2__
+    __m128 _out = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)sum)), _mm_loadu_ps(scale));
+    if (bias)
+        _out = _mm_add_ps(_out, _mm_loadu_ps(bias));
+
+    _mm_storeu_ps(top, activation_sse(_out, activation_type, activation_params));
+#else
+    for (int k=0; k<4; k++)
+    {
+        top[k] = activation_ss(sum[k] * scale[k] + (bias ? bias[k] : 0.f), activation_type, activation_params);
+    }
+#endif // __SSE2__
+}
+
+// dot product of one kernel row with one input row
+static inline int innerproduct_dot_int8_sse(const signed char* m, const signed char* kptr, int num_input_tm)
+{
+    int i=0;
+#if __SSE2__
+    __m128i _sum = _mm_setzero_si128();
+#if __AVX2__
+    __m256i _sum8 = _mm256_setzero_si256();
+    for (; i<num_input_tm; i+=16)
+    {
+        __m256i _x = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(m + i)));
+        __m256i _w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(kptr + i)));
+        _sum8 = _mm256_add_epi32(_sum8, _mm256_madd_epi16(_x, _w));
+    }
+    _sum = _mm_add_epi32(_mm256_castsi256_si128(_sum8), _mm256_extracti128_si256(_sum8, 1));
+#else
+    for (; i<num_input_tm; i+=16)
+    {
+        __m128i _x = _mm_loadu_si128((const __m128i*)(m + i));
+        __m128i _w = _mm_loadu_si128((const __m128i*)(kptr + i));
+
+        // sign extend to short
+        __m128i _xl = _mm_unpacklo_epi8(_x, _mm_cmpgt_epi8(_mm_setzero_si128(), _x));
+        __m128i _xh = _mm_unpackhi_epi8(_x, _mm_cmpgt_epi8(_mm_setzero_si128(), _x));
+        __m128i _wl = _mm_unpacklo_epi8(_w, _mm_cmpgt_epi8(_mm_setzero_si128(), _w));
+        __m128i _wh = _mm_unpackhi_epi8(_w, _mm_cmpgt_epi8(_mm_setzero_si128(), _w));
+
+        _sum = _mm_add_epi32(_sum, _mm_add_epi32(_mm_madd_epi16(_xl, _wl), _mm_madd_epi16(_xh, _wh)));
+    }
+#endif // __AVX2__
+
+    int sum4[4];
+    _mm_storeu_si128((__m128i*)sum4, _sum);
+    return sum4[0] + sum4[1] + sum4[2] + sum4[3];
+#else
+    int sum = 0;
+    for (; i<num_input_tm; i++)
+    {
+        sum += m[i] * kptr[i];
+    }
+    return sum;
+#endif // __SSE2__
+}
+
+static void innerproduct_int8_sse(const Mat& bottom_tm, float* top, int rows, int num_output, const Mat& weight_tm, const Mat& dequant_scales, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int num_input_tm = bottom_tm.w;
+
+    const float* scales = dequant_scales;
+    const float* bias = bias_data;
+
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        for (int j=0; j<rows; j++)
+        {
+            const signed char* m = bottom_tm.row<const signed char>(j);
+
+            int sum4[4];
+            for (int k=0; k<4; k++)
+            {
+                sum4[k] = innerproduct_dot_int8_sse(m, weight_tm.row<const signed char>(p + k), num_input_tm);
+            }
+
+            innerproduct_dequantize_pack4_sse(sum4, top + num_output * j + p, scales + p, bias ? bias + p : 0, activation_type, activation_params);
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        const float bias0 = bias ? bias[p] : 0.f;
+
+        for (int j=0; j<rows; j++)
+        {
+            int sum = innerproduct_dot_int8_sse(bottom_tm.row<const signed char>(j), weight_tm.row<const signed char>(p), num_input_tm);
+
+            top[num_output * j + p] = activation_ss(sum * scales[p] + bias0, activation_type, activation_params);
+        }
+    }
+}
+
+#if NCNN_AVX512VNNI
+NCNN_TARGET_AVX512VNNI
+static inline int innerproduct_reduce_add_avx512(__m512i _sum)
+{
+    int sum16[16];
+    _mm512_storeu_si512((void*)sum16, _sum);
+
+    int sum = 0;
+    for (int k=0; k<16; k++)
+    {
+        sum += sum16[k];
+    }
+    return sum;
+}
+
+// u8 x s8 dot products of 64 bytes at once, the input gets 128 added to be unsigned
+NCNN_TARGET_AVX512VNNI
+static void innerproduct_int8_avx512vnni(const Mat& bottom_tm, float* top, int rows, int num_output, const Mat& weight_tm, const Mat& weight_sum, const Mat& dequant_scales, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int num_input_tm = bottom_tm.w;
+
+    const int* ksum = weight_sum;
+    const float* scales = dequant_scales;
+    const float* bias = bias_data;
+
+    int nn_num_output = num_output >> 2;
+    int remain_num_output_start = nn_num_output << 2;
+
+    const __m512i _v128 = _mm512_set1_epi8((char)0x80);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+
+        const signed char* k0 = weight_tm.row<const signed char>(p);
+        const signed char* k1 = weight_tm.row<const signed char>(p + 1);
+        const signed char* k2 = weight_tm.row<const signed char>(p + 2);
+        const signed char* k3 = weight_tm.row<const signed char>(p + 3);
+
+        for (int j=0; j<rows; j++)
+        {
+            const signed char* m = bottom_tm.row<const signed char>(j);
+
+            __m512i _sum0 = _mm512_setzero_si512();
+            __m512i _sum1 = _mm512_setzero_si512();
+            __m512i _sum2 = _mm512_setzero_si512();
+            __m512i _sum3 = _mm512_setzero_si512();
+
+            for (int i=0; i<num_input_tm; i+=64)
+            {
+                __m512i _x = _mm512_xor_si512(_mm512_loadu_si512((const void*)(m + i)), _v128);
+
+                _sum0 = _mm512_dpbusd_epi32(_sum0, _x, _mm512_loadu_si512((const void*)(k0 + i)));
+                _sum1 = _mm512_dpbusd_epi32(_sum1, _x, _mm512_loadu_si512((const void*)(k1 + i)));
+                _sum2 = _mm512_dpbusd_epi32(_sum2, _x, _mm512_loadu_si512((const void*)(k2 + i)));
+                _sum3 = _mm512_dpbusd_epi32(_sum3, _x, _mm512_loadu_si512((const void*)(k3 + i)));
+            }
+
+            int sum4[4];
+            sum4[0] = innerproduct_reduce_add_avx512(_sum0) - 128 * ksum[p];
+            sum4[1] = innerproduct_reduce_add_avx512(_sum1) - 128 * ksum[p + 1];
+            sum4[2] = innerproduct_reduce_add_avx512(_sum2) - 128 * ksum[p + 2];
+            sum4[3] = innerproduct_reduce_add_avx512(_sum3) - 128 * ksum[p + 3];
+
+            innerproduct_dequantize_pack4_sse(sum4, top + num_output * j + p, scales + p, bias ? bias + p : 0, activation_type, activation_params);
+        }
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=remain_num_output_start; p<num_output; p++)
+    {
+        const signed char* k0 = weight_tm.row<const signed char>(p);
+
+        const float bias0 = bias ? bias[p] : 0.f;
+
+        for (int j=0; j<rows; j++)
+        {
+            const signed char* m = bottom_tm.row<const signed char>(j);
+
+            __m512i _sum0 = _mm512_setzero_si512();
+
+            for (int i=0; i<num_input_tm; i+=64)
+            {
+                __m512i _x = _mm512_xor_si512(_mm512_loadu_si512((const void*)(m + i)), _v128);
+
+                _sum0 = _mm512_dpbusd_epi32(_sum0, _x, _mm512_loadu_si512((const void*)(k0 + i)));
+            }
+
+            int sum = innerproduct_reduce_add_avx512(_sum0) - 128 * ksum[p];
+
+            top[num_output * j + p] = activation_ss(sum * scales[p] + bias0, activation_type, activation_params);
+        }
+    }
+}
+#endif // NCNN_AVX512VNNI
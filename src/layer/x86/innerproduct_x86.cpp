@@ -0,0 +1,864 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "innerproduct_x86.h"
+
+#include "cpu.h"
+#include "x86_activation.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(InnerProduct_x86)
+
+#include "innerproduct_int8.h"
+
+#if __SSE2__
+#if __AVX__
+// the last pack of outputs may be partial, its packed weights are zero padded
+static inline __m256 innerproduct_load_bias_avx(const float* bias, int p, int np)
+{
+    if (!bias)
+        return _mm256_setzero_ps();
+
+    if (np == 8)
+        return _mm256_loadu_ps(bias + p);
+
+    float bias8[8] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    for (int k=0; k<np; k++)
+    {
+        bias8[k] = bias[p + k];
+    }
+
+    return _mm256_loadu_ps(bias8);
+}
+
+static inline void innerproduct_store_avx(float* outptr, __m256 _v, int np)
+{
+    if (np == 8)
+    {
+        _mm256_storeu_ps(outptr, _v);
+        return;
+    }
+
+    float sum8[8];
+    _mm256_storeu_ps(sum8, _v);
+    for (int k=0; k<np; k++)
+    {
+        outptr[k] = sum8[k];
+    }
+}
+
+static void innerproduct_sgemm_pack8_avx(const float* bottom, float* top, int rows, int num_input, int num_output, const Mat& weight_data_pack8, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const float* bias = bias_data;
+
+    int nn_num_output = (num_output + 7) / 8;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 8;
+        const int np = std::min(8, num_output - p);
+
+        __m256 _bias = innerproduct_load_bias_avx(bias, p, np);
+
+        // 4 rows share each weight load
+        int j=0;
+        for (; j+3<rows; j+=4)
+        {
+            const float* kptr = weight_data_pack8.row(pp);
+            const float* m0 = bottom + num_input * j;
+            const float* m1 = m0 + num_input;
+            const float* m2 = m1 + num_input;
+            const float* m3 = m2 + num_input;
+
+            __m256 _sum0 = _bias;
+            __m256 _sum1 = _bias;
+            __m256 _sum2 = _bias;
+            __m256 _sum3 = _bias;
+
+            for (int i=0; i<num_input; i++)
+            {
+                __m256 _w = _mm256_loadu_ps(kptr);
+
+                _sum0 = _mm256_fmadd_ps(_mm256_broadcast_ss(m0 + i), _w, _sum0);
+                _sum1 = _mm256_fmadd_ps(_mm256_broadcast_ss(m1 + i), _w, _sum1);
+                _sum2 = _mm256_fmadd_ps(_mm256_broadcast_ss(m2 + i), _w, _sum2);
+                _sum3 = _mm256_fmadd_ps(_mm256_broadcast_ss(m3 + i), _w, _sum3);
+
+                kptr += 8;
+            }
+
+            float* outptr = top + num_output * j + p;
+            innerproduct_store_avx(outptr, activation_avx(_sum0, activation_type, activation_params), np);
+            innerproduct_store_avx(outptr + num_output, activation_avx(_sum1, activation_type, activation_params), np);
+            innerproduct_store_avx(outptr + num_output * 2, activation_avx(_sum2, activation_type, activation_params), np);
+            innerproduct_store_avx(outptr + num_output * 3, activation_avx(_sum3, activation_type, activation_params), np);
+        }
+
+        for (; j<rows; j++)
+        {
+            const float* kptr = weight_data_pack8.row(pp);
+            const float* m = bottom + num_input * j;
+
+            __m256 _sum0 = _bias;
+            __m256 _sum1 = _mm256_setzero_ps();
+            __m256 _sum2 = _mm256_setzero_ps();
+            __m256 _sum3 = _mm256_setzero_ps();
+
+            int i=0;
+            for (; i+3<num_input; i+=4)
+            {
+                _sum0 = _mm256_fmadd_ps(_mm256_broadcast_ss(m), _mm256_loadu_ps(kptr), _sum0);
+                _sum1 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + 1), _mm256_loadu_ps(kptr + 8), _sum1);
+                _sum2 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + 2), _mm256_loadu_ps(kptr + 16), _sum2);
+                _sum3 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + 3), _mm256_loadu_ps(kptr + 24), _sum3);
+
+                m += 4;
+                kptr += 32;
+            }
+            for (; i<num_input; i++)
+            {
+                _sum0 = _mm256_fmadd_ps(_mm256_broadcast_ss(m), _mm256_loadu_ps(kptr), _sum0);
+
+                m++;
+                kptr += 8;
+            }
+
+            _sum0 = _mm256_add_ps(_mm256_add_ps(_sum0, _sum1), _mm256_add_ps(_sum2, _sum3));
+
+            innerproduct_store_avx(top + num_output * j + p, activation_avx(_sum0, activation_type, activation_params), np);
+        }
+    }
+}
+
+// weight_sparse_data holds the 8 weights of each input with any of them nonzero
+static void innerproduct_sparse_pack8_avx(const float* bottom, float* top, int rows, int num_input, int num_output, const Mat& weight_sparse_data, const Mat& weight_sparse_index, const Mat& weight_sparse_rowptr, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const float* bias = bias_data;
+
+    const int* index = weight_sparse_index;
+    const int* rowptr = weight_sparse_rowptr;
+
+    int nn_num_output = (num_output + 7) / 8;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 8;
+        const int np = std::min(8, num_output - p);
+
+        const int* kidx = index + rowptr[pp];
+        const int nnz = rowptr[pp + 1] - rowptr[pp];
+
+        __m256 _bias = innerproduct_load_bias_avx(bias, p, np);
+
+        // 4 rows share each weight load
+        int j=0;
+        for (; j+3<rows; j+=4)
+        {
+            const float* kptr = (const float*)weight_sparse_data + rowptr[pp] * 8;
+            const float* m0 = bottom + num_input * j;
+            const float* m1 = m0 + num_input;
+            const float* m2 = m1 + num_input;
+            const float* m3 = m2 + num_input;
+
+            __m256 _sum0 = _bias;
+            __m256 _sum1 = _bias;
+            __m256 _sum2 = _bias;
+            __m256 _sum3 = _bias;
+
+            for (int k=0; k<nnz; k++)
+            {
+                const int i = kidx[k];
+
+                __m256 _w = _mm256_loadu_ps(kptr);
+
+                _sum0 = _mm256_fmadd_ps(_mm256_broadcast_ss(m0 + i), _w, _sum0);
+                _sum1 = _mm256_fmadd_ps(_mm256_broadcast_ss(m1 + i), _w, _sum1);
+                _sum2 = _mm256_fmadd_ps(_mm256_broadcast_ss(m2 + i), _w, _sum2);
+                _sum3 = _mm256_fmadd_ps(_mm256_broadcast_ss(m3 + i), _w, _sum3);
+
+                kptr += 8;
+            }
+
+            float* outptr = top + num_output * j + p;
+            innerproduct_store_avx(outptr, activation_avx(_sum0, activation_type, activation_params), np);
+            innerproduct_store_avx(outptr + num_output, activation_avx(_sum1, activation_type, activation_params), np);
+            innerproduct_store_avx(outptr + num_output * 2, activation_avx(_sum2, activation_type, activation_params), np);
+            innerproduct_store_avx(outptr + num_output * 3, activation_avx(_sum3, activation_type, activation_params), np);
+        }
+
+        for (; j<rows; j++)
+        {
+            const float* kptr = (const float*)weight_sparse_data + rowptr[pp] * 8;
+            const float* m = bottom + num_input * j;
+
+            __m256 _sum0 = _bias;
+            __m256 _sum1 = _mm256_setzero_ps();
+            __m256 _sum2 = _mm256_setzero_ps();
+            __m256 _sum3 = _mm256_setzero_ps();
+
+            int k=0;
+            for (; k+3<nnz; k+=4)
+            {
+                _sum0 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + kidx[k]), _mm256_loadu_ps(kptr), _sum0);
+                _sum1 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + kidx[k + 1]), _mm256_loadu_ps(kptr + 8), _sum1);
+                _sum2 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + kidx[k + 2]), _mm256_loadu_ps(kptr + 16), _sum2);
+                _sum3 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + kidx[k + 3]), _mm256_loadu_ps(kptr + 24), _sum3);
+
+                kptr += 32;
+            }
+            for (; k<nnz; k++)
+            {
+                _sum0 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + kidx[k]), _mm256_loadu_ps(kptr), _sum0);
+
+                kptr += 8;
+            }
+
+            _sum0 = _mm256_add_ps(_mm256_add_ps(_sum0, _sum1), _mm256_add_ps(_sum2, _sum3));
+
+            innerproduct_store_avx(top + num_output * j + p, activation_avx(_sum0, activation_type, activation_params), np);
+        }
+    }
+}
+#else // __AVX__
+// the last pack of outputs may be partial, its packed weights are zero padded
+static inline __m128 innerproduct_load_bias_sse(const float* bias, int p, int np)
+{
+    if (!bias)
+        return _mm_setzero_ps();
+
+    if (np == 4)
+        return _mm_loadu_ps(bias + p);
+
+    float bias4[4] = {0.f, 0.f, 0.f, 0.f};
+    for (int k=0; k<np; k++)
+    {
+        bias4[k] = bias[p + k];
+    }
+
+    return _mm_loadu_ps(bias4);
+}
+
+static inline void innerproduct_store_sse(float* outptr, __m128 _v, int np)
+{
+    if (np == 4)
+    {
+        _mm_storeu_ps(outptr, _v);
+        return;
+    }
+
+    float sum4[4];
+    _mm_storeu_ps(sum4, _v);
+    for (int k=0; k<np; k++)
+    {
+        outptr[k] = sum4[k];
+    }
+}
+
+static void innerproduct_sgemm_pack4_sse(const float* bottom, float* top, int rows, int num_input, int num_output, const Mat& weight_data_pack4, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const float* bias = bias_data;
+
+    int nn_num_output = (num_output + 3) / 4;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+        const int np = std::min(4, num_output - p);
+
+        __m128 _bias = innerproduct_load_bias_sse(bias, p, np);
+
+        // 4 rows share each weight load
+        int j=0;
+        for (; j+3<rows; j+=4)
+        {
+            const float* kptr = weight_data_pack4.row(pp);
+            const float* m0 = bottom + num_input * j;
+            const float* m1 = m0 + num_input;
+            const float* m2 = m1 + num_input;
+            const float* m3 = m2 + num_input;
+
+            __m128 _sum0 = _bias;
+            __m128 _sum1 = _bias;
+            __m128 _sum2 = _bias;
+            __m128 _sum3 = _bias;
+
+            for (int i=0; i<num_input; i++)
+            {
+                __m128 _w = _mm_loadu_ps(kptr);
+
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_set1_ps(m0[i]), _w));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_mm_set1_ps(m1[i]), _w));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_mm_set1_ps(m2[i]), _w));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_mm_set1_ps(m3[i]), _w));
+
+                kptr += 4;
+            }
+
+            float* outptr = top + num_output * j + p;
+            innerproduct_store_sse(outptr, activation_sse(_sum0, activation_type, activation_params), np);
+            innerproduct_store_sse(outptr + num_output, activation_sse(_sum1, activation_type, activation_params), np);
+            innerproduct_store_sse(outptr + num_output * 2, activation_sse(_sum2, activation_type, activation_params), np);
+            innerproduct_store_sse(outptr + num_output * 3, activation_sse(_sum3, activation_type, activation_params), np);
+        }
+
+        for (; j<rows; j++)
+        {
+            const float* kptr = weight_data_pack4.row(pp);
+            const float* m = bottom + num_input * j;
+
+            __m128 _sum0 = _bias;
+            __m128 _sum1 = _mm_setzero_ps();
+            __m128 _sum2 = _mm_setzero_ps();
+            __m128 _sum3 = _mm_setzero_ps();
+
+            int i=0;
+            for (; i+3<num_input; i+=4)
+            {
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_set1_ps(m[0]), _mm_loadu_ps(kptr)));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_mm_set1_ps(m[1]), _mm_loadu_ps(kptr + 4)));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_mm_set1_ps(m[2]), _mm_loadu_ps(kptr + 8)));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_mm_set1_ps(m[3]), _mm_loadu_ps(kptr + 12)));
+
+                m += 4;
+                kptr += 16;
+            }
+            for (; i<num_input; i++)
+            {
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_set1_ps(m[0]), _mm_loadu_ps(kptr)));
+
+                m++;
+                kptr += 4;
+            }
+
+            _sum0 = _mm_add_ps(_mm_add_ps(_sum0, _sum1), _mm_add_ps(_sum2, _sum3));
+
+            innerproduct_store_sse(top + num_output * j + p, activation_sse(_sum0, activation_type, activation_params), np);
+        }
+    }
+}
+
+// weight_sparse_data holds the 4 weights of each input with any of them nonzero
+static void innerproduct_sparse_pack4_sse(const float* bottom, float* top, int rows, int num_input, int num_output, const Mat& weight_sparse_data, const Mat& weight_sparse_index, const Mat& weight_sparse_rowptr, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const float* bias = bias_data;
+
+    const int* index = weight_sparse_index;
+    const int* rowptr = weight_sparse_rowptr;
+
+    int nn_num_output = (num_output + 3) / 4;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 4;
+        const int np = std::min(4, num_output - p);
+
+        const int* kidx = index + rowptr[pp];
+        const int nnz = rowptr[pp + 1] - rowptr[pp];
+
+        __m128 _bias = innerproduct_load_bias_sse(bias, p, np);
+
+        // 4 rows share each weight load
+        int j=0;
+        for (; j+3<rows; j+=4)
+        {
+            const float* kptr = (const float*)weight_sparse_data + rowptr[pp] * 4;
+            const float* m0 = bottom + num_input * j;
+            const float* m1 = m0 + num_input;
+            const float* m2 = m1 + num_input;
+            const float* m3 = m2 + num_input;
+
+            __m128 _sum0 = _bias;
+            __m128 _sum1 = _bias;
+            __m128 _sum2 = _bias;
+            __m128 _sum3 = _bias;
+
+            for (int k=0; k<nnz; k++)
+            {
+                const int i = kidx[k];
+
+                __m128 _w = _mm_loadu_ps(kptr);
+
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_set1_ps(m0[i]), _w));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_mm_set1_ps(m1[i]), _w));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_mm_set1_ps(m2[i]), _w));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_mm_set1_ps(m3[i]), _w));
+
+                kptr += 4;
+            }
+
+            float* outptr = top + num_output * j + p;
+            innerproduct_store_sse(outptr, activation_sse(_sum0, activation_type, activation_params), np);
+            innerproduct_store_sse(outptr + num_output, activation_sse(_sum1, activation_type, activation_params), np);
+            innerproduct_store_sse(outptr + num_output * 2, activation_sse(_sum2, activation_type, activation_params), np);
+            innerproduct_store_sse(outptr + num_output * 3, activation_sse(_sum3, activation_type, activation_params), np);
+        }
+
+        for (; j<rows; j++)
+        {
+            const float* kptr = (const float*)weight_sparse_data + rowptr[pp] * 4;
+            const float* m = bottom + num_input * j;
+
+            __m128 _sum0 = _bias;
+            __m128 _sum1 = _mm_setzero_ps();
+            __m128 _sum2 = _mm_setzero_ps();
+            __m128 _sum3 = _mm_setzero_ps();
+
+            int k=0;
+            for (; k+3<nnz; k+=4)
+            {
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_set1_ps(m[kidx[k]]), _mm_loadu_ps(kptr)));
+                _sum1 = _mm_add_ps(_sum1, _mm_mul_ps(_mm_set1_ps(m[kidx[k + 1]]), _mm_loadu_ps(kptr + 4)));
+                _sum2 = _mm_add_ps(_sum2, _mm_mul_ps(_mm_set1_ps(m[kidx[k + 2]]), _mm_loadu_ps(kptr + 8)));
+                _sum3 = _mm_add_ps(_sum3, _mm_mul_ps(_mm_set1_ps(m[kidx[k + 3]]), _mm_loadu_ps(kptr + 12)));
+
+                kptr += 16;
+            }
+            for (; k<nnz; k++)
+            {
+                _sum0 = _mm_add_ps(_sum0, _mm_mul_ps(_mm_set1_ps(m[kidx[k]]), _mm_loadu_ps(kptr)));
+
+                kptr += 4;
+            }
+
+            _sum0 = _mm_add_ps(_mm_add_ps(_sum0, _sum1), _mm_add_ps(_sum2, _sum3));
+
+            innerproduct_store_sse(top + num_output * j + p, activation_sse(_sum0, activation_type, activation_params), np);
+        }
+    }
+}
+#endif // __AVX__
+
+#if NCNN_F16C
+// weight_data_fp16 = 8 outputs x num_input in fp16 per row, the last row padded with zero
+NCNN_TARGET_F16C
+static void innerproduct_fp16_pack8_f16c(const float* bottom, float* top, int rows, int num_input, int num_output, const Mat& weight_data_fp16, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const float* bias = bias_data;
+
+    int nn_num_output = (num_output + 7) / 8;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_num_output; pp++)
+    {
+        int p = pp * 8;
+        const int np = std::min(8, num_output - p);
+
+        float bias8[8] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+        for (int k=0; bias && k<np; k++)
+        {
+            bias8[k] = bias[p + k];
+        }
+
+        __m256 _bias = _mm256_loadu_ps(bias8);
+
+        // 4 rows share each weight conversion
+        int j=0;
+        for (; j+3<rows; j+=4)
+        {
+            const unsigned short* kptr = weight_data_fp16.row<const unsigned short>(pp);
+            const float* m0 = bottom + num_input * j;
+            const float* m1 = m0 + num_input;
+            const float* m2 = m1 + num_input;
+            const float* m3 = m2 + num_input;
+
+            __m256 _sum[4] = {_bias, _bias, _bias, _bias};
+
+            for (int i=0; i<num_input; i++)
+            {
+                __m256 _w = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)kptr));
+
+                _sum[0] = _mm256_fmadd_ps(_mm256_broadcast_ss(m0 + i), _w, _sum[0]);
+                _sum[1] = _mm256_fmadd_ps(_mm256_broadcast_ss(m1 + i), _w, _sum[1]);
+                _sum[2] = _mm256_fmadd_ps(_mm256_broadcast_ss(m2 + i), _w, _sum[2]);
+                _sum[3] = _mm256_fmadd_ps(_mm256_broadcast_ss(m3 + i), _w, _sum[3]);
+
+                kptr += 8;
+            }
+
+            for (int r=0; r<4; r++)
+            {
+                float sum8[8];
+                _mm_storeu_ps(sum8, activation_sse(_mm256_castps256_ps128(_sum[r]), activation_type, activation_params));
+                _mm_storeu_ps(sum8 + 4, activation_sse(_mm256_extractf128_ps(_sum[r], 1), activation_type, activation_params));
+
+                float* outptr = top + num_output * (j + r) + p;
+                for (int k=0; k<np; k++)
+                {
+                    outptr[k] = sum8[k];
+                }
+            }
+        }
+
+        for (; j<rows; j++)
+        {
+            const unsigned short* kptr = weight_data_fp16.row<const unsigned short>(pp);
+            const float* m = bottom + num_input * j;
+
+            __m256 _sum0 = _bias;
+            __m256 _sum1 = _mm256_setzero_ps();
+            __m256 _sum2 = _mm256_setzero_ps();
+            __m256 _sum3 = _mm256_setzero_ps();
+
+            int i=0;
+            for (; i+3<num_input; i+=4)
+            {
+                __m256i _w01 = _mm256_loadu_si256((const __m256i*)kptr);
+                __m256i _w23 = _mm256_loadu_si256((const __m256i*)(kptr + 16));
+
+                _sum0 = _mm256_fmadd_ps(_mm256_broadcast_ss(m), _mm256_cvtph_ps(_mm256_castsi256_si128(_w01)), _sum0);
+                _sum1 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + 1), _mm256_cvtph_ps(_mm256_extractf128_si256(_w01, 1)), _sum1);
+                _sum2 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + 2), _mm256_cvtph_ps(_mm256_castsi256_si128(_w23)), _sum2);
+                _sum3 = _mm256_fmadd_ps(_mm256_broadcast_ss(m + 3), _mm256_cvtph_ps(_mm256_extractf128_si256(_w23, 1)), _sum3);
+
+                m += 4;
+                kptr += 32;
+            }
+            for (; i<num_input; i++)
+            {
+                _sum0 = _mm256_fmadd_ps(_mm256_broadcast_ss(m), _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)kptr)), _sum0);
+
+                m++;
+                kptr += 8;
+            }
+
+            _sum0 = _mm256_add_ps(_mm256_add_ps(_sum0, _sum1), _mm256_add_ps(_sum2, _sum3));
+
+            float sum8[8];
+            _mm_storeu_ps(sum8, activation_sse(_mm256_castps256_ps128(_sum0), activation_type, activation_params));
+            _mm_storeu_ps(sum8 + 4, activation_sse(_mm256_extractf128_ps(_sum0, 1), activation_type, activation_params));
+
+            float* outptr = top + num_output * j + p;
+            for (int k=0; k<np; k++)
+            {
+                outptr[k] = sum8[k];
+            }
+        }
+    }
+}
+#endif // NCNN_F16C
+#endif // __SSE2__
+
+int InnerProduct_x86::create_pipeline(const Option& opt)
+{
+#if __SSE2__
+    int num_input = weight_data_size / num_output;
+
+    if (use_int8_inference)
+    {
+        use_avx512_vnni = false;
+#if NCNN_AVX512VNNI
+        use_avx512_vnni = cpu_support_x86_avx512_vnni();
+#endif // NCNN_AVX512VNNI
+
+        // the base layer has quantized weight_data to int8 already
+        innerproduct_transform_kernel_int8_sse(weight_data, weight_data_int8_packed, weight_data_int8_sums, num_input, num_output);
+        if (weight_data_int8_packed.empty() || weight_data_int8_sums.empty())
+            return -100;
+
+        dequant_scales.create(num_output);
+        if (dequant_scales.empty())
+            return -100;
+
+        for (int p=0; p<num_output; p++)
+        {
+            if (weight_data_int8_scales[p] == 0)
+                dequant_scales[p] = 0.f;
+            else
+                dequant_scales[p] = 1.f / (bottom_blob_int8_scale * weight_data_int8_scales[p]);
+        }
+
+        return 0;
+    }
+
+#if __AVX__
+    const int out_pack = 8;
+#else
+    const int out_pack = 4;
+#endif
+
+    // src = inch-outch
+    // dst = pack-inch-outch/pack, outch tail padded with zero
+    weight_data_packed.create(num_input * out_pack, (num_output + out_pack - 1) / out_pack);
+    if (weight_data_packed.empty())
+        return -100;
+
+    weight_data_packed.fill(0.f);
+
+    for (int q=0; q<num_output; q++)
+    {
+        float* g00 = weight_data_packed.row(q / out_pack);
+
+        for (int p=0; p<num_input; p++)
+        {
+            g00[p * out_pack + q % out_pack] = weight_data[num_input * q + p];
+        }
+    }
+
+    weight_sparse_data.release();
+    weight_sparse_index.release();
+    weight_sparse_rowptr.release();
+
+    if (opt.use_sparse_weight)
+    {
+        const int nn_num_output = weight_data_packed.h;
+
+        // blocked csr, keep the inputs with any of the pack weights nonzero
+        int nnz = 0;
+        for (int pp=0; pp<nn_num_output; pp++)
+        {
+            const float* g00 = weight_data_packed.row(pp);
+
+            for (int p=0; p<num_input; p++)
+            {
+                for (int k=0; k<out_pack; k++)
+                {
+                    if (g00[k] != 0.f)
+                    {
+                        nnz++;
+                        break;
+                    }
+                }
+
+                g00 += out_pack;
+            }
+        }
+
+        // the dense gemv is faster unless most weight blocks are zero
+        if (nnz <= num_input * nn_num_output / 2)
+        {
+            weight_sparse_data.create(nnz * out_pack + 1);
+            weight_sparse_index.create(nnz + 1, (size_t)4u);
+            weight_sparse_rowptr.create(nn_num_output + 1, (size_t)4u);
+            if (weight_sparse_data.empty() || weight_sparse_index.empty() || weight_sparse_rowptr.empty())
+                return -100;
+
+            float* values = weight_sparse_data;
+            int* index = weight_sparse_index;
+            int* rowptr = weight_sparse_rowptr;
+
+            nnz = 0;
+            for (int pp=0; pp<nn_num_output; pp++)
+            {
+                const float* g00 = weight_data_packed.row(pp);
+
+                rowptr[pp] = nnz;
+
+                for (int p=0; p<num_input; p++)
+                {
+                    bool nonzero = false;
+                    for (int k=0; k<out_pack; k++)
+                    {
+                        nonzero = nonzero || g00[k] != 0.f;
+                    }
+
+                    if (nonzero)
+                    {
+                        index[nnz] = p;
+                        for (int k=0; k<out_pack; k++)
+                        {
+                            values[k] = g00[k];
+                        }
+
+                        values += out_pack;
+                        nnz++;
+                    }
+
+                    g00 += out_pack;
+                }
+            }
+            rowptr[nn_num_output] = nnz;
+
+            weight_data_packed.release();
+        }
+    }
+
+    weight_data_fp16.release();
+
+#if NCNN_F16C
+    if (opt.use_weight_fp16_storage && weight_sparse_data.empty() && cpu_support_x86_f16c())
+    {
+        // src = inch-outch
+        // dst = 8-inch-outch/8, outch tail padded with zero
+        Mat weight_data_pack8(num_input * 8, (num_output + 7) / 8);
+        if (weight_data_pack8.empty())
+            return -100;
+
+        weight_data_pack8.fill(0.f);
+
+        for (int q=0; q<num_output; q++)
+        {
+            float* g00 = weight_data_pack8.row(q / 8);
+
+            for (int p=0; p<num_input; p++)
+            {
+                g00[p * 8 + q % 8] = weight_data[num_input * q + p];
+            }
+        }
+
+        cast_float32_to_float16(weight_data_pack8, weight_data_fp16);
+        if (weight_data_fp16.empty())
+            return -100;
+
+        // nothing reads the fp32 weight once the fp16 one exists
+        weight_data_packed.release();
+        weight_data.release();
+    }
+#endif // NCNN_F16C
+
+    // the packed weight covers all outputs
+    if (opt.lightmode)
+        weight_data.release();
+#endif // __SSE2__
+
+    return 0;
+}
+
+int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+#if __SSE2__
+    if (use_int8_inference)
+    {
+        return forwardInt8(bottom_blob, top_blob, opt);
+    }
+
+    int num_input = weight_data_size / num_output;
+
+    size_t elemsize = bottom_blob.elemsize;
+
+    Mat bottom_blob_flattened = bottom_blob;
+    int rows = 1;
+
+    if (bottom_blob.dims == 2 && bottom_blob.w == num_input && bottom_blob.h > 1)
+    {
+        // gemm, one output row for each input row
+        rows = bottom_blob.h;
+
+        top_blob.create(num_output, rows, elemsize, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+    }
+    else
+    {
+        // gemv
+        if (bottom_blob.dims != 1)
+        {
+            bottom_blob_flattened = bottom_blob.reshape(bottom_blob.w * bottom_blob.h * bottom_blob.c, opt.workspace_allocator);
+            if (bottom_blob_flattened.empty())
+                return -100;
+        }
+
+        top_blob.create(num_output, elemsize, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+    }
+
+#if NCNN_F16C
+    if (!weight_data_fp16.empty())
+    {
+        innerproduct_fp16_pack8_f16c(bottom_blob_flattened, top_blob, rows, num_input, num_output, weight_data_fp16, bias_data, activation_type, activation_params, opt);
+        return 0;
+    }
+#endif // NCNN_F16C
+
+    if (!weight_sparse_data.empty())
+    {
+#if __AVX__
+        innerproduct_sparse_pack8_avx(bottom_blob_flattened, top_blob, rows, num_input, num_output, weight_sparse_data, weight_sparse_index, weight_sparse_rowptr, bias_data, activation_type, activation_params, opt);
+#else
+        innerproduct_sparse_pack4_sse(bottom_blob_flattened, top_blob, rows, num_input, num_output, weight_sparse_data, weight_sparse_index, weight_sparse_rowptr, bias_data, activation_type, activation_params, opt);
+#endif
+        return 0;
+    }
+
+#if __AVX__
+    innerproduct_sgemm_pack8_avx(bottom_blob_flattened, top_blob, rows, num_input, num_output, weight_data_packed, bias_data, activation_type, activation_params, opt);
+#else
+    innerproduct_sgemm_pack4_sse(bottom_blob_flattened, top_blob, rows, num_input, num_output, weight_data_packed, bias_data, activation_type, activation_params, opt);
+#endif
+
+    return 0;
+#else
+    return InnerProduct::forward(bottom_blob, top_blob, opt);
+#endif // __SSE2__
+}
+
+int InnerProduct_x86::forwardInt8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int num_input = weight_data_size / num_output;
+
+    const int num_input_tm = weight_data_int8_packed.w;
+
+    Mat bottom_blob_flattened = bottom_blob;
+    int rows = 1;
+
+    if (bottom_blob.dims == 2 && bottom_blob.w == num_input && bottom_blob.h > 1)
+    {
+        // gemm, one output row for each input row
+        rows = bottom_blob.h;
+
+        top_blob.create(num_output, rows, (size_t)4u, opt.blob_allocator);
+    }
+    else
+    {
+        // gemv
+        if (bottom_blob.dims != 1)
+        {
+            bottom_blob_flattened = bottom_blob.reshape(bottom_blob.w * bottom_blob.h * bottom_blob.c, opt.workspace_allocator);
+            if (bottom_blob_flattened.empty())
+                return -100;
+        }
+
+        top_blob.create(num_output, (size_t)4u, opt.blob_allocator);
+    }
+    if (top_blob.empty())
+        return -100;
+
+    // quantize, scale and round to nearest into the zero padded rows
+    Mat bottom_blob_int8(num_input_tm, rows, (size_t)1u, opt.workspace_allocator);
+    if (bottom_blob_int8.empty())
+        return -100;
+
+    if (bottom_blob_flattened.elemsize == 1)
+    {
+        bottom_blob_int8.fill(0);
+
+        for (int j=0; j<rows; j++)
+        {
+            memcpy(bottom_blob_int8.row<signed char>(j), (const signed char*)bottom_blob_flattened + num_input * j, num_input);
+        }
+    }
+    else
+    {
+        innerproduct_quantize_int8_sse(bottom_blob_flattened, bottom_blob_int8, rows, num_input, bottom_blob_int8_scale, opt);
+    }
+
+#if NCNN_AVX512VNNI
+    if (use_avx512_vnni)
+    {
+        innerproduct_int8_avx512vnni(bottom_blob_int8, top_blob, rows, num_output, weight_data_int8_packed, weight_data_int8_sums, dequant_scales, bias_data, activation_type, activation_params, opt);
+        return 0;
+    }
+#endif // NCNN_AVX512VNNI
+
+    innerproduct_int8_sse(bottom_blob_int8, top_blob, rows, num_output, weight_data_int8_packed, dequant_scales, bias_data, activation_type, activation_params, opt);
+
+    return 0;
+}
+
+} // namespace ncnn
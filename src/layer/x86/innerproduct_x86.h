@@ -0,0 +1,51 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_INNERPRODUCT_X86_H
+#define LAYER_INNERPRODUCT_X86_H
+
+#include "innerproduct.h"
+
+namespace ncnn {
+
+class InnerProduct_x86 : virtual public InnerProduct
+{
+public:
+    virtual int create_pipeline(const Option& opt);
+
+    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+    virtual int forwardInt8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+
+public:
+    // 8 (avx) or 4 (sse) outputs interleaved for each input, outch tail padded with zero
+    Mat weight_data_packed;
+
+    // blocked csr of the packed weight, replaces weight_data_packed for pruned weight
+    Mat weight_sparse_data;
+    Mat weight_sparse_index;
+    Mat weight_sparse_rowptr;
+
+    // fp16 weight, 8 outputs interleaved for each input, outch tail padded with zero
+    Mat weight_data_fp16;
+
+    // int8 weight, num_input padded with zero to a multiple of 64
+    bool use_avx512_vnni;
+    Mat weight_data_int8_packed;
+    Mat weight_data_int8_sums;
+    Mat dequant_scales;
+};
+
+} // namespace ncnn
+
+#endif // LAYER_INNERPRODUCT_X86_H
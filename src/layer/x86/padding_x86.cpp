@@ -0,0 +1,113 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "padding_x86.h"
+#include <string.h>
+#include <algorithm>
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Padding_x86)
+
+static void padding_fill_sse(float* ptr, int size, float v)
+{
+    int i = 0;
+#if __AVX__
+    __m256 _v8 = _mm256_set1_ps(v);
+    for (; i+7<size; i+=8)
+    {
+        _mm256_storeu_ps(ptr + i, _v8);
+    }
+#endif // __AVX__
+#if __SSE2__
+    __m128 _v = _mm_set1_ps(v);
+    for (; i+3<size; i+=4)
+    {
+        _mm_storeu_ps(ptr + i, _v);
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        ptr[i] = v;
+    }
+}
+
+int Padding_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    if (top == 0 && bottom == 0 && left == 0 && right == 0)
+    {
+        top_blob = bottom_blob;
+        return 0;
+    }
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    int dims = bottom_blob.dims;
+    size_t elemsize = bottom_blob.elemsize;
+
+    // fp32 image with constant or replicate border
+    if (dims == 1 || elemsize != 4 || (type != 0 && type != 1) || top < 0 || bottom < 0 || left < 0 || right < 0)
+    {
+        return Padding::forward(bottom_blob, top_blob, opt);
+    }
+
+    int outw = w + left + right;
+    int outh = h + top + bottom;
+
+    if (dims == 2)
+        top_blob.create(outw, outh, elemsize, opt.blob_allocator);
+    else
+        top_blob.create(outw, outh, channels, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // the rows of all channels are split among threads,
+    // so that a few large channels keep every thread busy
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int qy=0; qy<channels * outh; qy++)
+    {
+        const int q = qy / outh;
+        const int y = qy % outh;
+
+        const Mat m = bottom_blob.channel(q);
+        float* outptr = top_blob.channel(q).row(y);
+
+        int sy = y - top;
+        if (type == 0 && (sy < 0 || sy >= h))
+        {
+            padding_fill_sse(outptr, outw, value);
+            continue;
+        }
+
+        sy = std::min(std::max(sy, 0), h - 1);
+
+        const float* ptr = m.row(sy);
+
+        padding_fill_sse(outptr, left, type == 0 ? value : ptr[0]);
+        memcpy(outptr + left, ptr, w * sizeof(float));
+        padding_fill_sse(outptr + left + w, right, type == 0 ? value : ptr[w - 1]);
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
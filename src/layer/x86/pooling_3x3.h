@@ -0,0 +1,116 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// vptr holds the vertically reduced rows, left padding included
+static void pooling3x3s1_max_row_sse(const float* vptr, float* outptr, int outw)
+{
+    int j = 0;
+#if __SSE2__
+    for (; j+3<outw; j+=4)
+    {
+        __m128 _v0 = _mm_loadu_ps(vptr);
+        __m128 _v1 = _mm_loadu_ps(vptr + 1);
+        __m128 _v2 = _mm_loadu_ps(vptr + 2);
+
+        _mm_storeu_ps(outptr + j, _mm_max_ps(_mm_max_ps(_v0, _v1), _v2));
+
+        vptr += 4;
+    }
+#endif // __SSE2__
+    for (; j<outw; j++)
+    {
+        outptr[j] = std::max(std::max(vptr[0], vptr[1]), vptr[2]);
+
+        vptr += 1;
+    }
+}
+
+static void pooling3x3s1_sum_row_sse(const float* vptr, float* outptr, int outw)
+{
+    int j = 0;
+#if __SSE2__
+    for (; j+3<outw; j+=4)
+    {
+        __m128 _v0 = _mm_loadu_ps(vptr);
+        __m128 _v1 = _mm_loadu_ps(vptr + 1);
+        __m128 _v2 = _mm_loadu_ps(vptr + 2);
+
+        _mm_storeu_ps(outptr + j, _mm_add_ps(_mm_add_ps(_v0, _v1), _v2));
+
+        vptr += 4;
+    }
+#endif // __SSE2__
+    for (; j<outw; j++)
+    {
+        outptr[j] = vptr[0] + vptr[1] + vptr[2];
+
+        vptr += 1;
+    }
+}
+
+static void pooling3x3s2_max_row_sse(const float* vptr, float* outptr, int outw)
+{
+    int j = 0;
+#if __SSE2__
+    for (; j+3<outw; j+=4)
+    {
+        __m128 _v0 = _mm_loadu_ps(vptr);
+        __m128 _v1 = _mm_loadu_ps(vptr + 4);
+        __m128 _v2 = _mm_loadu_ps(vptr + 2);
+        __m128 _v3 = _mm_loadu_ps(vptr + 6);
+
+        __m128 _even = _mm_shuffle_ps(_v0, _v1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 _odd = _mm_shuffle_ps(_v0, _v1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 _even2 = _mm_shuffle_ps(_v2, _v3, _MM_SHUFFLE(2, 0, 2, 0));
+
+        _mm_storeu_ps(outptr + j, _mm_max_ps(_mm_max_ps(_even, _odd), _even2));
+
+        vptr += 8;
+    }
+#endif // __SSE2__
+    for (; j<outw; j++)
+    {
+        outptr[j] = std::max(std::max(vptr[0], vptr[1]), vptr[2]);
+
+        vptr += 2;
+    }
+}
+
+static void pooling3x3s2_sum_row_sse(const float* vptr, float* outptr, int outw)
+{
+    int j = 0;
+#if __SSE2__
+    for (; j+3<outw; j+=4)
+    {
+        __m128 _v0 = _mm_loadu_ps(vptr);
+        __m128 _v1 = _mm_loadu_ps(vptr + 4);
+        __m128 _v2 = _mm_loadu_ps(vptr + 2);
+        __m128 _v3 = _mm_loadu_ps(vptr + 6);
+
+        __m128 _even = _mm_shuffle_ps(_v0, _v1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 _odd = _mm_shuffle_ps(_v0, _v1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 _even2 = _mm_shuffle_ps(_v2, _v3, _MM_SHUFFLE(2, 0, 2, 0));
+
+        _mm_storeu_ps(outptr + j, _mm_add_ps(_mm_add_ps(_even, _odd), _even2));
+
+        vptr += 8;
+    }
+#endif // __SSE2__
+    for (; j<outw; j++)
+    {
+        outptr[j] = vptr[0] + vptr[1] + vptr[2];
+
+        vptr += 2;
+    }
+}
@@ -0,0 +1,355 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "pooling_x86.h"
+#include <float.h>
+#include <algorithm>
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+namespace ncnn {
+
+#include "pooling_2x2.h"
+#include "pooling_3x3.h"
+
+DEFINE_LAYER_CREATOR(Pooling_x86)
+
+int Pooling_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    // max value in NxN window
+    // avg value in NxN window
+
+    if (pooling_type != PoolMethod_MAX && pooling_type != PoolMethod_AVE)
+    {
+        return Pooling::forward(bottom_blob, top_blob, opt);
+    }
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    if (global_pooling)
+    {
+        top_blob.create(channels, elemsize, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        int size = w * h;
+
+        if (pooling_type == PoolMethod_MAX)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const float* ptr = bottom_blob.channel(q);
+
+                float max = ptr[0];
+
+                int i = 0;
+#if __SSE2__
+                __m128 _max0 = _mm_set1_ps(max);
+                __m128 _max1 = _max0;
+                for (; i+7<size; i+=8)
+                {
+                    _max0 = _mm_max_ps(_max0, _mm_loadu_ps(ptr + i));
+                    _max1 = _mm_max_ps(_max1, _mm_loadu_ps(ptr + i + 4));
+                }
+                _max0 = _mm_max_ps(_max0, _max1);
+
+                float max4[4];
+                _mm_storeu_ps(max4, _max0);
+                max = std::max(std::max(max4[0], max4[1]), std::max(max4[2], max4[3]));
+#endif // __SSE2__
+                for (; i<size; i++)
+                {
+                    max = std::max(max, ptr[i]);
+                }
+
+                top_blob[q] = max;
+            }
+        }
+        else if (pooling_type == PoolMethod_AVE)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const float* ptr = bottom_blob.channel(q);
+
+                float sum = 0.f;
+
+                int i = 0;
+#if __SSE2__
+                __m128 _sum0 = _mm_setzero_ps();
+                __m128 _sum1 = _mm_setzero_ps();
+                for (; i+7<size; i+=8)
+                {
+                    _sum0 = _mm_add_ps(_sum0, _mm_loadu_ps(ptr + i));
+                    _sum1 = _mm_add_ps(_sum1, _mm_loadu_ps(ptr + i + 4));
+                }
+                _sum0 = _mm_add_ps(_sum0, _sum1);
+
+                float sum4[4];
+                _mm_storeu_ps(sum4, _sum0);
+                sum = sum4[0] + sum4[1] + sum4[2] + sum4[3];
+#endif // __SSE2__
+                for (; i<size; i++)
+                {
+                    sum += ptr[i];
+                }
+
+                top_blob[q] = sum / size;
+            }
+        }
+
+        return 0;
+    }
+
+    float pad_value = 0.f;
+    if (pooling_type == PoolMethod_MAX)
+    {
+        pad_value = -FLT_MAX;
+    }
+    else if (pooling_type == PoolMethod_AVE)
+    {
+        pad_value = 0.f;
+    }
+
+    // padding is resolved inside the kernel, no bordered copy
+    int wpad_left = 0;
+    int wpad_right = 0;
+    int hpad_top = 0;
+    int hpad_bottom = 0;
+
+    int wtailpad = 0;
+    int htailpad = 0;
+
+    if (pad_mode == 0) // full padding
+    {
+        int wtail = (w + pad_left + pad_right - kernel_w) % stride_w;
+        int htail = (h + pad_top + pad_bottom - kernel_h) % stride_h;
+
+        if (wtail != 0)
+            wtailpad = stride_w - wtail;
+        if (htail != 0)
+            htailpad = stride_h - htail;
+
+        wpad_left = pad_left;
+        wpad_right = pad_right + wtailpad;
+        hpad_top = pad_top;
+        hpad_bottom = pad_bottom + htailpad;
+    }
+    else if (pad_mode == 1) // valid padding
+    {
+        wpad_left = pad_left;
+        wpad_right = pad_right;
+        hpad_top = pad_top;
+        hpad_bottom = pad_bottom;
+    }
+    else if (pad_mode == 2) // tensorflow padding=SAME
+    {
+        int wpad = kernel_w + (w - 1) / stride_w * stride_w - w;
+        int hpad = kernel_h + (h - 1) / stride_h * stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            wpad_left = wpad / 2;
+            wpad_right = wpad - wpad / 2;
+            hpad_top = hpad / 2;
+            hpad_bottom = hpad - hpad / 2;
+        }
+    }
+
+    int outw = (w + wpad_left + wpad_right - kernel_w) / stride_w + 1;
+    int outh = (h + hpad_top + hpad_bottom - kernel_h) / stride_h + 1;
+
+    top_blob.create(outw, outh, channels, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // avg pooling rescales the border outputs the same way as Pooling
+    float scale_top = 1.f;
+    float scale_bottom = 1.f;
+    float scale_left = 1.f;
+    float scale_right = 1.f;
+    if (pooling_type == PoolMethod_AVE)
+    {
+        if (pad_top != 0)
+            scale_top = (float)kernel_h / (kernel_h - pad_top);
+        if (pad_bottom + htailpad != 0)
+            scale_bottom = (float)kernel_h / (kernel_h - pad_bottom - htailpad);
+        if (pad_left != 0)
+            scale_left = (float)kernel_w / (kernel_w - pad_left);
+        if (pad_right + wtailpad != 0)
+            scale_right = (float)kernel_w / (kernel_w - pad_right - wtailpad);
+    }
+
+    // one row of vertically reduced input with left and right padding
+    // and some tail room for vector loads
+    const int vrow_w = std::max(wpad_left + w, (outw - 1) * stride_w + kernel_w) + 8;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const Mat m = bottom_blob.channel(q);
+        float* outptr = top_blob.channel(q);
+
+        Mat vrow(vrow_w, (size_t)4u, opt.workspace_allocator);
+        vrow.fill(pad_value);
+
+        float* vptr = (float*)vrow + wpad_left;
+
+        for (int i = 0; i < outh; i++)
+        {
+            // reduce the valid input rows of the window
+            const int y0 = i * stride_h - hpad_top;
+            const int ky_start = std::max(0, -y0);
+            const int ky_end = std::min(kernel_h, h - y0);
+
+            if (ky_start >= ky_end)
+            {
+                for (int x = 0; x < w; x++)
+                    vptr[x] = pad_value;
+            }
+            else
+            {
+                const float* r0 = m.row(y0 + ky_start);
+                for (int x = 0; x < w; x++)
+                    vptr[x] = r0[x];
+
+                for (int ky = ky_start + 1; ky < ky_end; ky++)
+                {
+                    const float* r = m.row(y0 + ky);
+
+                    int x = 0;
+                    if (pooling_type == PoolMethod_MAX)
+                    {
+#if __SSE2__
+                        for (; x+3<w; x+=4)
+                        {
+                            _mm_storeu_ps(vptr + x, _mm_max_ps(_mm_loadu_ps(vptr + x), _mm_loadu_ps(r + x)));
+                        }
+#endif // __SSE2__
+                        for (; x<w; x++)
+                        {
+                            vptr[x] = std::max(vptr[x], r[x]);
+                        }
+                    }
+                    else
+                    {
+#if __SSE2__
+                        for (; x+3<w; x+=4)
+                        {
+                            _mm_storeu_ps(vptr + x, _mm_add_ps(_mm_loadu_ps(vptr + x), _mm_loadu_ps(r + x)));
+                        }
+#endif // __SSE2__
+                        for (; x<w; x++)
+                        {
+                            vptr[x] += r[x];
+                        }
+                    }
+                }
+            }
+
+            // reduce horizontally
+            const float* sptr = vrow;
+
+            if (kernel_w == 2 && stride_w == 2)
+            {
+                if (pooling_type == PoolMethod_MAX)
+                    pooling2x2s2_max_row_sse(sptr, outptr, outw);
+                else
+                    pooling2x2s2_sum_row_sse(sptr, outptr, outw);
+            }
+            else if (kernel_w == 3 && stride_w == 1)
+            {
+                if (pooling_type == PoolMethod_MAX)
+                    pooling3x3s1_max_row_sse(sptr, outptr, outw);
+                else
+                    pooling3x3s1_sum_row_sse(sptr, outptr, outw);
+            }
+            else if (kernel_w == 3 && stride_w == 2)
+            {
+                if (pooling_type == PoolMethod_MAX)
+                    pooling3x3s2_max_row_sse(sptr, outptr, outw);
+                else
+                    pooling3x3s2_sum_row_sse(sptr, outptr, outw);
+            }
+            else if (pooling_type == PoolMethod_MAX)
+            {
+                for (int j = 0; j < outw; j++)
+                {
+                    float max = sptr[0];
+                    for (int k = 1; k < kernel_w; k++)
+                    {
+                        max = std::max(max, sptr[k]);
+                    }
+
+                    outptr[j] = max;
+
+                    sptr += stride_w;
+                }
+            }
+            else
+            {
+                for (int j = 0; j < outw; j++)
+                {
+                    float sum = 0.f;
+                    for (int k = 0; k < kernel_w; k++)
+                    {
+                        sum += sptr[k];
+                    }
+
+                    outptr[j] = sum;
+
+                    sptr += stride_w;
+                }
+            }
+
+            if (pooling_type == PoolMethod_AVE)
+            {
+                float scale = 1.f / maxk;
+                if (i == 0)
+                    scale *= scale_top;
+                if (i == outh - 1)
+                    scale *= scale_bottom;
+
+                int j = 0;
+#if __SSE2__
+                __m128 _scale = _mm_set1_ps(scale);
+                for (; j+3<outw; j+=4)
+                {
+                    _mm_storeu_ps(outptr + j, _mm_mul_ps(_mm_loadu_ps(outptr + j), _scale));
+                }
+#endif // __SSE2__
+                for (; j<outw; j++)
+                {
+                    outptr[j] *= scale;
+                }
+
+                outptr[0] *= scale_left;
+                outptr[outw - 1] *= scale_right;
+            }
+
+            outptr += outw;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,86 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "scale_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Scale_x86)
+
+int Scale_x86::forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    Mat& bottom_top_blob = bottom_top_blobs[0];
+    const Mat& scale_blob = bottom_top_blobs[1];
+
+    int dims = bottom_top_blob.dims;
+
+    if (dims != 3)
+        return Scale::forward_inplace(bottom_top_blobs, opt);
+
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    int size = w * h;
+
+    const float* scale_ptr = scale_blob;
+    const float* bias_ptr = bias_data;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+
+        float s = scale_ptr[q];
+        float bias = bias_term ? bias_ptr[q] : 0.f;
+
+        int i=0;
+#if __AVX__
+        __m256 _s8 = _mm256_set1_ps(s);
+        __m256 _bias8 = _mm256_set1_ps(bias);
+        for (; i+7<size; i+=8)
+        {
+            _mm256_storeu_ps(ptr, _mm256_fmadd_ps(_mm256_loadu_ps(ptr), _s8, _bias8));
+
+            ptr += 8;
+        }
+#endif // __AVX__
+#if __SSE2__
+        __m128 _s = _mm_set1_ps(s);
+        __m128 _bias = _mm_set1_ps(bias);
+        for (; i+3<size; i+=4)
+        {
+            _mm_storeu_ps(ptr, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ptr), _s), _bias));
+
+            ptr += 4;
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            *ptr = *ptr * s + bias;
+
+            ptr++;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
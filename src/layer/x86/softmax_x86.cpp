@@ -0,0 +1,376 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "softmax_x86.h"
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#endif // __AVX__
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(Softmax_x86)
+
+// softmax over size contiguous values
+static void softmax(float* ptr, int size)
+{
+    // max
+    float max = -FLT_MAX;
+    {
+        int i = 0;
+#if __AVX__
+        __m256 _max_avx = _mm256_set1_ps(-FLT_MAX);
+        for (; i+7<size; i+=8)
+        {
+            _max_avx = _mm256_max_ps(_max_avx, _mm256_loadu_ps(ptr + i));
+        }
+        __m128 _max = _mm_max_ps(_mm256_castps256_ps128(_max_avx), _mm256_extractf128_ps(_max_avx, 1));
+#elif __SSE2__
+        __m128 _max = _mm_set1_ps(-FLT_MAX);
+#endif
+#if __SSE2__
+        for (; i+3<size; i+=4)
+        {
+            _max = _mm_max_ps(_max, _mm_loadu_ps(ptr + i));
+        }
+        _max = _mm_max_ps(_max, _mm_shuffle_ps(_max, _max, _MM_SHUFFLE(1, 0, 3, 2)));
+        _max = _mm_max_ps(_max, _mm_shuffle_ps(_max, _max, _MM_SHUFFLE(2, 3, 0, 1)));
+        max = _mm_cvtss_f32(_max);
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            max = std::max(max, ptr[i]);
+        }
+    }
+
+    // exp(x - max) and sum in one pass
+    float sum = 0.f;
+    {
+        int i = 0;
+#if __AVX__
+        __m256 _max_avx = _mm256_set1_ps(max);
+        __m256 _sum_avx = _mm256_setzero_ps();
+        for (; i+7<size; i+=8)
+        {
+            __m256 _p = exp256_ps(_mm256_sub_ps(_mm256_loadu_ps(ptr + i), _max_avx));
+            _mm256_storeu_ps(ptr + i, _p);
+            _sum_avx = _mm256_add_ps(_sum_avx, _p);
+        }
+        __m128 _sum = _mm_add_ps(_mm256_castps256_ps128(_sum_avx), _mm256_extractf128_ps(_sum_avx, 1));
+#elif __SSE2__
+        __m128 _sum = _mm_setzero_ps();
+#endif
+#if __SSE2__
+        __m128 _max = _mm_set1_ps(max);
+        for (; i+3<size; i+=4)
+        {
+            __m128 _p = exp_ps(_mm_sub_ps(_mm_loadu_ps(ptr + i), _max));
+            _mm_storeu_ps(ptr + i, _p);
+            _sum = _mm_add_ps(_sum, _p);
+        }
+        _sum = _mm_add_ps(_sum, _mm_shuffle_ps(_sum, _sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        _sum = _mm_add_ps(_sum, _mm_shuffle_ps(_sum, _sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        sum = _mm_cvtss_f32(_sum);
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            ptr[i] = exp(ptr[i] - max);
+            sum += ptr[i];
+        }
+    }
+
+    // normalize
+    {
+        float scale = 1.f / sum;
+
+        int i = 0;
+#if __AVX__
+        __m256 _scale_avx = _mm256_set1_ps(scale);
+        for (; i+7<size; i+=8)
+        {
+            _mm256_storeu_ps(ptr + i, _mm256_mul_ps(_mm256_loadu_ps(ptr + i), _scale_avx));
+        }
+#endif // __AVX__
+#if __SSE2__
+        __m128 _scale = _mm_set1_ps(scale);
+        for (; i+3<size; i+=4)
+        {
+            _mm_storeu_ps(ptr + i, _mm_mul_ps(_mm_loadu_ps(ptr + i), _scale));
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            ptr[i] *= scale;
+        }
+    }
+}
+
+// softmax across rows, each column of size values is independent
+// row r starts at ptr + r * rowstep
+// maxptr and sumptr are workspace of size values
+static void softmax_rows(float* ptr, int rows, int size, size_t rowstep, float* maxptr, float* sumptr)
+{
+    // max
+    for (int j=0; j<size; j++)
+    {
+        maxptr[j] = ptr[j];
+    }
+    for (int r=1; r<rows; r++)
+    {
+        const float* p = ptr + r * rowstep;
+
+        int j = 0;
+#if __AVX__
+        for (; j+7<size; j+=8)
+        {
+            _mm256_storeu_ps(maxptr + j, _mm256_max_ps(_mm256_loadu_ps(maxptr + j), _mm256_loadu_ps(p + j)));
+        }
+#endif // __AVX__
+#if __SSE2__
+        for (; j+3<size; j+=4)
+        {
+            _mm_storeu_ps(maxptr + j, _mm_max_ps(_mm_loadu_ps(maxptr + j), _mm_loadu_ps(p + j)));
+        }
+#endif // __SSE2__
+        for (; j<size; j++)
+        {
+            maxptr[j] = std::max(maxptr[j], p[j]);
+        }
+    }
+
+    // exp(x - max) and sum in one pass
+    for (int j=0; j<size; j++)
+    {
+        sumptr[j] = 0.f;
+    }
+    for (int r=0; r<rows; r++)
+    {
+        float* p = ptr + r * rowstep;
+
+        int j = 0;
+#if __AVX__
+        for (; j+7<size; j+=8)
+        {
+            __m256 _p = exp256_ps(_mm256_sub_ps(_mm256_loadu_ps(p + j), _mm256_loadu_ps(maxptr + j)));
+            _mm256_storeu_ps(p + j, _p);
+            _mm256_storeu_ps(sumptr + j, _mm256_add_ps(_mm256_loadu_ps(sumptr + j), _p));
+        }
+#endif // __AVX__
+#if __SSE2__
+        for (; j+3<size; j+=4)
+        {
+            __m128 _p = exp_ps(_mm_sub_ps(_mm_loadu_ps(p + j), _mm_loadu_ps(maxptr + j)));
+            _mm_storeu_ps(p + j, _p);
+            _mm_storeu_ps(sumptr + j, _mm_add_ps(_mm_loadu_ps(sumptr + j), _p));
+        }
+#endif // __SSE2__
+        for (; j<size; j++)
+        {
+            p[j] = exp(p[j] - maxptr[j]);
+            sumptr[j] += p[j];
+        }
+    }
+
+    // normalize
+    for (int j=0; j<size; j++)
+    {
+        sumptr[j] = 1.f / sumptr[j];
+    }
+    for (int r=0; r<rows; r++)
+    {
+        float* p = ptr + r * rowstep;
+
+        int j = 0;
+#if __AVX__
+        for (; j+7<size; j+=8)
+        {
+            _mm256_storeu_ps(p + j, _mm256_mul_ps(_mm256_loadu_ps(p + j), _mm256_loadu_ps(sumptr + j)));
+        }
+#endif // __AVX__
+#if __SSE2__
+        for (; j+3<size; j+=4)
+        {
+            _mm_storeu_ps(p + j, _mm_mul_ps(_mm_loadu_ps(p + j), _mm_loadu_ps(sumptr + j)));
+        }
+#endif // __SSE2__
+        for (; j<size; j++)
+        {
+            p[j] *= sumptr[j];
+        }
+    }
+}
+
+int Softmax_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    // value = exp( value - global max value )
+    // sum all value
+    // value = value / sum
+
+    int dims = bottom_top_blob.dims;
+    size_t elemsize = bottom_top_blob.elemsize;
+
+    if (dims == 1) // axis == 0
+    {
+        int w = bottom_top_blob.w;
+
+        float* ptr = bottom_top_blob;
+
+        softmax(ptr, w);
+
+        return 0;
+    }
+
+    if (dims == 2 && axis == 0)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+
+        // columns are independent, split them among threads
+        const int tile = 64;
+        int nn_tile = (w + tile - 1) / tile;
+
+        Mat max;
+        max.create(w, elemsize, opt.workspace_allocator);
+        if (max.empty())
+            return -100;
+
+        Mat sum;
+        sum.create(w, elemsize, opt.workspace_allocator);
+        if (sum.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int t=0; t<nn_tile; t++)
+        {
+            int j = t * tile;
+            int size = std::min(tile, w - j);
+
+            float* ptr = bottom_top_blob;
+            softmax_rows(ptr + j, h, size, w, (float*)max + j, (float*)sum + j);
+        }
+
+        return 0;
+    }
+
+    if (dims == 2 && axis == 1)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i=0; i<h; i++)
+        {
+            float* ptr = bottom_top_blob.row(i);
+
+            softmax(ptr, w);
+        }
+
+        return 0;
+    }
+
+    if (dims == 3 && axis == 0)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int channels = bottom_top_blob.c;
+        int size = w * h;
+
+        // positions are independent, split them among threads
+        const int tile = 64;
+        int nn_tile = (size + tile - 1) / tile;
+
+        Mat max;
+        max.create(size, elemsize, opt.workspace_allocator);
+        if (max.empty())
+            return -100;
+
+        Mat sum;
+        sum.create(size, elemsize, opt.workspace_allocator);
+        if (sum.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int t=0; t<nn_tile; t++)
+        {
+            int i = t * tile;
+            int tile_size = std::min(tile, size - i);
+
+            float* ptr = bottom_top_blob;
+            softmax_rows(ptr + i, channels, tile_size, bottom_top_blob.cstep, (float*)max + i, (float*)sum + i);
+        }
+
+        return 0;
+    }
+
+    if (dims == 3 && axis == 1)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int channels = bottom_top_blob.c;
+
+        Mat max;
+        max.create(w, channels, elemsize, opt.workspace_allocator);
+        if (max.empty())
+            return -100;
+
+        Mat sum;
+        sum.create(w, channels, elemsize, opt.workspace_allocator);
+        if (sum.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+            softmax_rows(ptr, h, w, w, max.row(q), sum.row(q));
+        }
+
+        return 0;
+    }
+
+    if (dims == 3 && axis == 2)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int channels = bottom_top_blob.c;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+            for (int i=0; i<h; i++)
+            {
+                softmax(ptr, w);
+
+                ptr += w;
+            }
+        }
+
+        return 0;
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -29,6 +29,13 @@
   (this is the zlib license)
 */
 
+#ifndef SSE_MATHFUN_H
+#define SSE_MATHFUN_H
+
+#if __SSE2__ && !defined(USE_SSE2)
+#define USE_SSE2 1
+#endif
+
 #include <xmmintrin.h>
 
 /* yes I know, the top of this file is quite ugly */
@@ -109,7 +116,7 @@ typedef union xmm_mm_union {
 /* natural logarithm computed for 4 simultaneous float 
    return NaN for x <= 0
 */
-v4sf log_ps(v4sf x) {
+static inline v4sf log_ps(v4sf x) {
 #ifdef USE_SSE2
   v4si emm0;
 #else
@@ -211,7 +218,7 @@ _PS_CONST(cephes_exp_p3, 4.1665795894E-2);
 _PS_CONST(cephes_exp_p4, 1.6666665459E-1);
 _PS_CONST(cephes_exp_p5, 5.0000001201E-1);
 
-v4sf exp_ps(v4sf x) {
+static inline v4sf exp_ps(v4sf x) {
   v4sf tmp = _mm_setzero_ps(), fx;
 #ifdef USE_SSE2
   v4si emm0;
@@ -225,24 +232,26 @@ v4sf exp_ps(v4sf x) {
 
   /* express exp(x) as exp(g + n*log(2)) */
   fx = _mm_mul_ps(x, *(v4sf*)_ps_cephes_LOG2EF);
+
+#ifdef USE_SSE2
+  /* n = round(x * log2(e)), keep it for building 2^n */
+  emm0 = _mm_cvtps_epi32(fx);
+  fx = _mm_cvtepi32_ps(emm0);
+#else
   fx = _mm_add_ps(fx, *(v4sf*)_ps_0p5);
 
   /* how to perform a floorf with SSE: just below */
-#ifndef USE_SSE2
   /* step 1 : cast to int */
   tmp = _mm_movehl_ps(tmp, fx);
   mm0 = _mm_cvttps_pi32(fx);
   mm1 = _mm_cvttps_pi32(tmp);
   /* step 2 : cast back to float */
   tmp = _mm_cvtpi32x2_ps(mm0, mm1);
-#else
-  emm0 = _mm_cvttps_epi32(fx);
-  tmp  = _mm_cvtepi32_ps(emm0);
-#endif
   /* if greater, substract 1 */
   v4sf mask = _mm_cmpgt_ps(tmp, fx);    
   mask = _mm_and_ps(mask, one);
   fx = _mm_sub_ps(tmp, mask);
+#endif
 
   tmp = _mm_mul_ps(fx, *(v4sf*)_ps_cephes_exp_C1);
   v4sf z = _mm_mul_ps(fx, *(v4sf*)_ps_cephes_exp_C2);
@@ -280,7 +289,6 @@ v4sf exp_ps(v4sf x) {
   COPY_MM_TO_XMM(mm0, mm1, pow2n);
   _mm_empty();
 #else
-  emm0 = _mm_cvttps_epi32(fx);
   emm0 = _mm_add_epi32(emm0, *(v4si*)_pi32_0x7f);
   emm0 = _mm_slli_epi32(emm0, 23);
   v4sf pow2n = _mm_castsi128_ps(emm0);
@@ -329,7 +337,7 @@ _PS_CONST(cephes_FOPI, 1.27323954473516); // 4 / M_PI
    Since it is based on SSE intrinsics, it has to be compiled at -O2 to
    deliver full speed.
 */
-v4sf sin_ps(v4sf x) { // any x
+static inline v4sf sin_ps(v4sf x) { // any x
   v4sf xmm1, xmm2 = _mm_setzero_ps(), xmm3, sign_bit, y;
 
 #ifdef USE_SSE2
@@ -446,7 +454,7 @@ v4sf sin_ps(v4sf x) { // any x
 }
 
 /* almost the same as sin_ps */
-v4sf cos_ps(v4sf x) { // any x
+static inline v4sf cos_ps(v4sf x) { // any x
   v4sf xmm1, xmm2 = _mm_setzero_ps(), xmm3, y;
 #ifdef USE_SSE2
   v4si emm0, emm2;
@@ -565,7 +573,7 @@ v4sf cos_ps(v4sf x) { // any x
 
 /* since sin_ps and cos_ps are almost identical, sincos_ps could replace both of them..
    it is almost as fast, and gives you a free cosine with your sine */
-void sincos_ps(v4sf x, v4sf *s, v4sf *c) {
+static inline void sincos_ps(v4sf x, v4sf *s, v4sf *c) {
   v4sf xmm1, xmm2, xmm3 = _mm_setzero_ps(), sign_bit_sin, y;
 #ifdef USE_SSE2
   v4si emm0, emm2, emm4;
@@ -709,3 +717,4 @@ void sincos_ps(v4sf x, v4sf *s, v4sf *c) {
   *c = _mm_xor_ps(xmm2, sign_bit_cos);
 }
 
+#endif // SSE_MATHFUN_H
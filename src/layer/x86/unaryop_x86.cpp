@@ -0,0 +1,70 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "unaryop_x86.h"
+#include "x86_elementwise.h"
+
+namespace ncnn {
+
+DEFINE_LAYER_CREATOR(UnaryOp_x86)
+
+int UnaryOp_x86::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    if (op_type == Operation_ABS)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_abs(), opt);
+
+    if (op_type == Operation_NEG)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_neg(), opt);
+
+    if (op_type == Operation_FLOOR)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_floor(), opt);
+
+    if (op_type == Operation_CEIL)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_ceil(), opt);
+
+    if (op_type == Operation_SQUARE)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_power(2.f, 1.f, 0.f), opt);
+
+    if (op_type == Operation_SQRT)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_sqrt(), opt);
+
+    if (op_type == Operation_RSQRT)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_rsqrt(), opt);
+
+    if (op_type == Operation_EXP)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_exp(1.f, 0.f), opt);
+
+    if (op_type == Operation_LOG)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_log(1.f, 0.f, 1.f), opt);
+
+    if (op_type == Operation_SIN)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_sin(), opt);
+
+    if (op_type == Operation_COS)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_cos(), opt);
+
+    if (op_type == Operation_TAN)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_tan(), opt);
+
+    if (op_type == Operation_RECIPROCAL)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_reciprocal(), opt);
+
+    if (op_type == Operation_TANH)
+        return unary_op_inplace_x86(bottom_top_blob, elementwise_tanh(), opt);
+
+    // asin acos atan
+    return UnaryOp::forward_inplace(bottom_top_blob, opt);
+}
+
+} // namespace ncnn
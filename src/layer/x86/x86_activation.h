@@ -0,0 +1,213 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef X86_ACTIVATION_H
+#define X86_ACTIVATION_H
+
+#include <math.h>
+#include <algorithm>
+#include "mat.h"
+#include "x86_target.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#endif
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#endif
+
+namespace ncnn {
+
+// 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid
+static inline float activation_ss(float v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 1)
+    {
+        v = std::max(v, 0.f);
+    }
+    else if (activation_type == 2)
+    {
+        float slope = activation_params[0];
+        v = v > 0.f ? v : v * slope;
+    }
+    else if (activation_type == 3)
+    {
+        float min = activation_params[0];
+        float max = activation_params[1];
+        if (v < min)
+            v = min;
+        if (v > max)
+            v = max;
+    }
+    else if (activation_type == 4)
+    {
+        v = 1.f / (1.f + exp(-v));
+    }
+
+    return v;
+}
+
+#if __SSE2__
+static inline __m128 activation_sse(__m128 _v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 1)
+    {
+        _v = _mm_max_ps(_v, _mm_setzero_ps());
+    }
+    else if (activation_type == 2)
+    {
+        __m128 _zero = _mm_setzero_ps();
+        __m128 _slope = _mm_set1_ps(activation_params[0]);
+        _v = _mm_add_ps(_mm_max_ps(_v, _zero), _mm_mul_ps(_slope, _mm_min_ps(_v, _zero)));
+    }
+    else if (activation_type == 3)
+    {
+        __m128 _min = _mm_set1_ps(activation_params[0]);
+        __m128 _max = _mm_set1_ps(activation_params[1]);
+        _v = _mm_min_ps(_mm_max_ps(_v, _min), _max);
+    }
+    else if (activation_type == 4)
+    {
+        __m128 _one = _mm_set1_ps(1.f);
+        _v = _mm_div_ps(_one, _mm_add_ps(_one, exp_ps(_mm_sub_ps(_mm_setzero_ps(), _v))));
+    }
+
+    return _v;
+}
+#endif // __SSE2__
+
+#if __AVX__
+static inline __m256 activation_avx(__m256 _v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 1)
+    {
+        _v = _mm256_max_ps(_v, _mm256_setzero_ps());
+    }
+    else if (activation_type == 2)
+    {
+        __m256 _zero = _mm256_setzero_ps();
+        __m256 _slope = _mm256_set1_ps(activation_params[0]);
+        _v = _mm256_fmadd_ps(_slope, _mm256_min_ps(_v, _zero), _mm256_max_ps(_v, _zero));
+    }
+    else if (activation_type == 3)
+    {
+        __m256 _min = _mm256_set1_ps(activation_params[0]);
+        __m256 _max = _mm256_set1_ps(activation_params[1]);
+        _v = _mm256_min_ps(_mm256_max_ps(_v, _min), _max);
+    }
+    else if (activation_type == 4)
+    {
+        __m256 _one = _mm256_set1_ps(1.f);
+        _v = _mm256_div_ps(_one, _mm256_add_ps(_one, exp256_ps(_mm256_sub_ps(_mm256_setzero_ps(), _v))));
+    }
+
+    return _v;
+}
+#endif // __AVX__
+
+// apply the activation to size floats in place
+static inline void activation_inplace_sse(float* ptr, int size, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 0)
+        return;
+
+    int i = 0;
+#if __AVX__
+    for (; i+7<size; i+=8)
+    {
+        _mm256_storeu_ps(ptr + i, activation_avx(_mm256_loadu_ps(ptr + i), activation_type, activation_params));
+    }
+#endif // __AVX__
+#if __SSE2__
+    for (; i+3<size; i+=4)
+    {
+        _mm_storeu_ps(ptr + i, activation_sse(_mm_loadu_ps(ptr + i), activation_type, activation_params));
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        ptr[i] = activation_ss(ptr[i], activation_type, activation_params);
+    }
+}
+
+#if NCNN_AVX512
+NCNN_AVX512_DIAGNOSTIC_PUSH
+// the cephes exp of avx_mathfun.h, 16 at once
+NCNN_TARGET_AVX512
+static inline __m512 exp512_ps(__m512 x)
+{
+    x = _mm512_min_ps(x, _mm512_set1_ps(88.3762626647949f));
+    x = _mm512_max_ps(x, _mm512_set1_ps(-88.3762626647949f));
+
+    // express exp(x) as exp(g + n*log(2))
+    __m512 fx = _mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f));
+    fx = _mm512_roundscale_ps(fx, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(0.693359375f), x);
+    x = _mm512_fnmadd_ps(fx, _mm512_set1_ps(-2.12194440e-4f), x);
+
+    __m512 z = _mm512_mul_ps(x, x);
+
+    __m512 y = _mm512_set1_ps(1.9875691500E-4f);
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.3981999507E-3f));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(8.3334519073E-3f));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(4.1665795894E-2f));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(1.6666665459E-1f));
+    y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(5.0000001201E-1f));
+    y = _mm512_fmadd_ps(y, z, x);
+    y = _mm512_add_ps(y, _mm512_set1_ps(1.f));
+
+    // build 2^n
+    __m512i imm0 = _mm512_cvtps_epi32(fx);
+    imm0 = _mm512_add_epi32(imm0, _mm512_set1_epi32(0x7f));
+    imm0 = _mm512_slli_epi32(imm0, 23);
+
+    return _mm512_mul_ps(y, _mm512_castsi512_ps(imm0));
+}
+
+NCNN_TARGET_AVX512
+static inline __m512 activation_avx512(__m512 _v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 1)
+    {
+        _v = _mm512_max_ps(_v, _mm512_setzero_ps());
+    }
+    else if (activation_type == 2)
+    {
+        __m512 _zero = _mm512_setzero_ps();
+        __m512 _slope = _mm512_set1_ps(activation_params[0]);
+        _v = _mm512_fmadd_ps(_slope, _mm512_min_ps(_v, _zero), _mm512_max_ps(_v, _zero));
+    }
+    else if (activation_type == 3)
+    {
+        __m512 _min = _mm512_set1_ps(activation_params[0]);
+        __m512 _max = _mm512_set1_ps(activation_params[1]);
+        _v = _mm512_min_ps(_mm512_max_ps(_v, _min), _max);
+    }
+    else if (activation_type == 4)
+    {
+        __m512 _one = _mm512_set1_ps(1.f);
+        _v = _mm512_div_ps(_one, _mm512_add_ps(_one, exp512_ps(_mm512_sub_ps(_mm512_setzero_ps(), _v))));
+    }
+
+    return _v;
+}
+NCNN_AVX512_DIAGNOSTIC_POP
+#endif // NCNN_AVX512
+
+} // namespace ncnn
+
+#endif // X86_ACTIVATION_H
@@ -0,0 +1,581 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef X86_ELEMENTWISE_H
+#define X86_ELEMENTWISE_H
+
+#include <math.h>
+#include <algorithm>
+#include "mat.h"
+#include "option.h"
+#include "x86_target.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#endif
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#endif
+
+namespace ncnn {
+
+#if __SSE2__
+// mask ? a : b
+static inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 abs_ps(__m128 x)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.f), x);
+}
+
+static inline __m128 floor_ps(__m128 x)
+{
+#if __SSE4_1__
+    return _mm_floor_ps(x);
+#else
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    t = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.f)));
+    // values beyond 2^23 are integral already and may not fit in int32
+    __m128 big = _mm_cmpge_ps(abs_ps(x), _mm_set1_ps(8388608.f));
+    return select_ps(big, x, t);
+#endif
+}
+
+static inline __m128 ceil_ps(__m128 x)
+{
+#if __SSE4_1__
+    return _mm_ceil_ps(x);
+#else
+    return _mm_sub_ps(_mm_setzero_ps(), floor_ps(_mm_sub_ps(_mm_setzero_ps(), x)));
+#endif
+}
+
+static inline __m128 sigmoid_ps(__m128 x)
+{
+    __m128 _one = _mm_set1_ps(1.f);
+    return _mm_div_ps(_one, _mm_add_ps(_one, exp_ps(_mm_sub_ps(_mm_setzero_ps(), x))));
+}
+
+// rational approximation of tanh on [-9, 9], saturates beyond
+static inline __m128 tanh_ps(__m128 x)
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-9.f)), _mm_set1_ps(9.f));
+
+    __m128 x2 = _mm_mul_ps(x, x);
+
+    __m128 p = _mm_set1_ps(-2.76076847742355e-16f);
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(2.00018790482477e-13f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-8.60467152213735e-11f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(5.12229709037114e-08f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.48572235717979e-05f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(6.37261928875436e-04f));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(4.89352455891786e-03f));
+    p = _mm_mul_ps(p, x);
+
+    __m128 q = _mm_set1_ps(1.19825839466702e-06f);
+    q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(1.18534705686654e-04f));
+    q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(2.26843463243900e-03f));
+    q = _mm_add_ps(_mm_mul_ps(q, x2), _mm_set1_ps(4.89352518554385e-03f));
+
+    return _mm_div_ps(p, q);
+}
+#endif // __SSE2__
+
+#if __AVX__
+static inline __m256 abs256_ps(__m256 x)
+{
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.f), x);
+}
+
+static inline __m256 sigmoid256_ps(__m256 x)
+{
+    __m256 _one = _mm256_set1_ps(1.f);
+    return _mm256_div_ps(_one, _mm256_add_ps(_one, exp256_ps(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+}
+
+static inline __m256 tanh256_ps(__m256 x)
+{
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-9.f)), _mm256_set1_ps(9.f));
+
+    __m256 x2 = _mm256_mul_ps(x, x);
+
+    __m256 p = _mm256_set1_ps(-2.76076847742355e-16f);
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(2.00018790482477e-13f));
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(-8.60467152213735e-11f));
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(5.12229709037114e-08f));
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(1.48572235717979e-05f));
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(6.37261928875436e-04f));
+    p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(4.89352455891786e-03f));
+    p = _mm256_mul_ps(p, x);
+
+    __m256 q = _mm256_set1_ps(1.19825839466702e-06f);
+    q = _mm256_fmadd_ps(q, x2, _mm256_set1_ps(1.18534705686654e-04f));
+    q = _mm256_fmadd_ps(q, x2, _mm256_set1_ps(2.26843463243900e-03f));
+    q = _mm256_fmadd_ps(q, x2, _mm256_set1_ps(4.89352518554385e-03f));
+
+    return _mm256_div_ps(p, q);
+}
+#endif // __AVX__
+
+#if NCNN_F16C && __SSE2__
+// fp16 blob storage, the elements are converted to fp32 in registers around op
+template<typename Op>
+NCNN_TARGET_F16C
+static void unary_op_inplace_fp16_f16c(Mat& a, const Op& op, const Option& opt)
+{
+    int w = a.w;
+    int h = a.h;
+    int channels = a.c;
+    int size = w * h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        unsigned short* ptr = a.channel(q);
+
+        int i = 0;
+        for (; i+7<size; i+=8)
+        {
+            __m128i _p = _mm_loadu_si128((const __m128i*)ptr);
+#if __AVX__
+            __m256 _v = op.func_pack8(_mm256_cvtph_ps(_p));
+            _mm_storeu_si128((__m128i*)ptr, _mm256_cvtps_ph(_v, _MM_FROUND_TO_NEAREST_INT));
+#else
+            __m128 _v0 = op.func_pack4(_mm_cvtph_ps(_p));
+            __m128 _v1 = op.func_pack4(_mm_cvtph_ps(_mm_unpackhi_epi64(_p, _p)));
+            _mm_storeu_si128((__m128i*)ptr, _mm_unpacklo_epi64(_mm_cvtps_ph(_v0, _MM_FROUND_TO_NEAREST_INT), _mm_cvtps_ph(_v1, _MM_FROUND_TO_NEAREST_INT)));
+#endif // __AVX__
+            ptr += 8;
+        }
+        for (; i<size; i++)
+        {
+            float v = _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(*ptr)));
+            *ptr = (unsigned short)_mm_extract_epi16(_mm_cvtps_ph(_mm_set_ss(op.func(v)), _MM_FROUND_TO_NEAREST_INT), 0);
+            ptr++;
+        }
+    }
+}
+#endif // NCNN_F16C && __SSE2__
+
+// apply op to every element of every channel in place
+// op provides func(float), func_pack4(__m128) with sse2 and func_pack8(__m256) with avx
+// fp16 blobs (elemsize 2) are only passed in by layers with support_fp16_storage
+template<typename Op>
+static int unary_op_inplace_x86(Mat& a, const Op& op, const Option& opt)
+{
+#if NCNN_F16C && __SSE2__
+    if (a.elemsize == 2u)
+    {
+        unary_op_inplace_fp16_f16c(a, op, opt);
+        return 0;
+    }
+#endif // NCNN_F16C && __SSE2__
+
+    int w = a.w;
+    int h = a.h;
+    int channels = a.c;
+    int size = w * h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = a.channel(q);
+
+        int i = 0;
+#if __AVX__
+        for (; i+7<size; i+=8)
+        {
+            _mm256_storeu_ps(ptr, op.func_pack8(_mm256_loadu_ps(ptr)));
+            ptr += 8;
+        }
+#endif // __AVX__
+#if __SSE2__
+        for (; i+3<size; i+=4)
+        {
+            _mm_storeu_ps(ptr, op.func_pack4(_mm_loadu_ps(ptr)));
+            ptr += 4;
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            *ptr = op.func(*ptr);
+            ptr++;
+        }
+    }
+
+    return 0;
+}
+
+struct elementwise_relu
+{
+    float func(float x) const { return std::max(x, 0.f); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return _mm_max_ps(x, _mm_setzero_ps()); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return _mm256_max_ps(x, _mm256_setzero_ps()); }
+#endif
+};
+
+struct elementwise_leakyrelu
+{
+    elementwise_leakyrelu(float _slope) : slope(_slope) {}
+
+    float func(float x) const { return x < 0.f ? x * slope : x; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const
+    {
+        __m128 _zero = _mm_setzero_ps();
+        return _mm_add_ps(_mm_max_ps(x, _zero), _mm_mul_ps(_mm_set1_ps(slope), _mm_min_ps(x, _zero)));
+    }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const
+    {
+        __m256 _zero = _mm256_setzero_ps();
+        return _mm256_fmadd_ps(_mm256_set1_ps(slope), _mm256_min_ps(x, _zero), _mm256_max_ps(x, _zero));
+    }
+#endif
+
+    float slope;
+};
+
+struct elementwise_clip
+{
+    elementwise_clip(float _min, float _max) : min(_min), max(_max) {}
+
+    float func(float x) const { return std::min(std::max(x, min), max); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(min)), _mm_set1_ps(max)); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(min)), _mm256_set1_ps(max)); }
+#endif
+
+    float min;
+    float max;
+};
+
+struct elementwise_sigmoid
+{
+    float func(float x) const { return 1.f / (1.f + exp(-x)); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return sigmoid_ps(x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return sigmoid256_ps(x); }
+#endif
+};
+
+struct elementwise_tanh
+{
+    float func(float x) const { return tanh(x); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return tanh_ps(x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return tanh256_ps(x); }
+#endif
+};
+
+// x < 0 ? (exp(x) - 1) * alpha : x * lambda
+struct elementwise_elu
+{
+    elementwise_elu(float _alpha, float _lambda) : alpha(_alpha), lambda(_lambda) {}
+
+    float func(float x) const { return x < 0.f ? (exp(x) - 1.f) * alpha : x * lambda; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const
+    {
+        __m128 _zero = _mm_setzero_ps();
+        __m128 _neg = _mm_mul_ps(_mm_sub_ps(exp_ps(_mm_min_ps(x, _zero)), _mm_set1_ps(1.f)), _mm_set1_ps(alpha));
+        return select_ps(_mm_cmplt_ps(x, _zero), _neg, _mm_mul_ps(x, _mm_set1_ps(lambda)));
+    }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const
+    {
+        __m256 _zero = _mm256_setzero_ps();
+        __m256 _neg = _mm256_mul_ps(_mm256_sub_ps(exp256_ps(_mm256_min_ps(x, _zero)), _mm256_set1_ps(1.f)), _mm256_set1_ps(alpha));
+        return _mm256_blendv_ps(_mm256_mul_ps(x, _mm256_set1_ps(lambda)), _neg, _mm256_cmp_ps(x, _zero, _CMP_LT_OQ));
+    }
+#endif
+
+    float alpha;
+    float lambda;
+};
+
+// x < lower ? 0 : x > upper ? 1 : x * alpha + beta
+struct elementwise_hardsigmoid
+{
+    elementwise_hardsigmoid(float _alpha, float _beta, float _lower, float _upper) : alpha(_alpha), beta(_beta), lower(_lower), upper(_upper) {}
+
+    float func(float x) const { return x < lower ? 0.f : x > upper ? 1.f : x * alpha + beta; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const
+    {
+        __m128 v = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(alpha)), _mm_set1_ps(beta));
+        v = select_ps(_mm_cmpgt_ps(x, _mm_set1_ps(upper)), _mm_set1_ps(1.f), v);
+        v = select_ps(_mm_cmplt_ps(x, _mm_set1_ps(lower)), _mm_setzero_ps(), v);
+        return v;
+    }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const
+    {
+        __m256 v = _mm256_fmadd_ps(x, _mm256_set1_ps(alpha), _mm256_set1_ps(beta));
+        v = _mm256_blendv_ps(v, _mm256_set1_ps(1.f), _mm256_cmp_ps(x, _mm256_set1_ps(upper), _CMP_GT_OQ));
+        v = _mm256_blendv_ps(v, _mm256_setzero_ps(), _mm256_cmp_ps(x, _mm256_set1_ps(lower), _CMP_LT_OQ));
+        return v;
+    }
+#endif
+
+    float alpha;
+    float beta;
+    float lower;
+    float upper;
+};
+
+struct elementwise_abs
+{
+    float func(float x) const { return fabs(x); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return abs_ps(x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return abs256_ps(x); }
+#endif
+};
+
+struct elementwise_neg
+{
+    float func(float x) const { return -x; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return _mm_xor_ps(x, _mm_set1_ps(-0.f)); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return _mm256_xor_ps(x, _mm256_set1_ps(-0.f)); }
+#endif
+};
+
+struct elementwise_floor
+{
+    float func(float x) const { return floor(x); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return floor_ps(x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return _mm256_floor_ps(x); }
+#endif
+};
+
+struct elementwise_ceil
+{
+    float func(float x) const { return ceil(x); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return ceil_ps(x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return _mm256_ceil_ps(x); }
+#endif
+};
+
+struct elementwise_sqrt
+{
+    float func(float x) const { return sqrt(x); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return _mm_sqrt_ps(x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return _mm256_sqrt_ps(x); }
+#endif
+};
+
+struct elementwise_rsqrt
+{
+    float func(float x) const { return 1.f / sqrt(x); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(x)); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(x)); }
+#endif
+};
+
+struct elementwise_reciprocal
+{
+    float func(float x) const { return 1.f / x; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return _mm_div_ps(_mm_set1_ps(1.f), x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return _mm256_div_ps(_mm256_set1_ps(1.f), x); }
+#endif
+};
+
+struct elementwise_sin
+{
+    float func(float x) const { return sin(x); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return sin_ps(x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return sin256_ps(x); }
+#endif
+};
+
+struct elementwise_cos
+{
+    float func(float x) const { return cos(x); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return cos_ps(x); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return cos256_ps(x); }
+#endif
+};
+
+struct elementwise_tan
+{
+    float func(float x) const { return tan(x); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const
+    {
+        __m128 s, c;
+        sincos_ps(x, &s, &c);
+        return _mm_div_ps(s, c);
+    }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const
+    {
+        __m256 s, c;
+        sincos256_ps(x, &s, &c);
+        return _mm256_div_ps(s, c);
+    }
+#endif
+};
+
+// exp(x * scale + shift)
+struct elementwise_exp
+{
+    elementwise_exp(float _scale, float _shift) : scale(_scale), shift(_shift) {}
+
+    float func(float x) const { return exp(x * scale + shift); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return exp_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(scale)), _mm_set1_ps(shift))); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return exp256_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(scale), _mm256_set1_ps(shift))); }
+#endif
+
+    float scale;
+    float shift;
+};
+
+// log(x * scale + shift) * log_base_inv
+struct elementwise_log
+{
+    elementwise_log(float _scale, float _shift, float _log_base_inv) : scale(_scale), shift(_shift), log_base_inv(_log_base_inv) {}
+
+    float func(float x) const { return log(x * scale + shift) * log_base_inv; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const { return _mm_mul_ps(log_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(scale)), _mm_set1_ps(shift))), _mm_set1_ps(log_base_inv)); }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const { return _mm256_mul_ps(log256_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(scale), _mm256_set1_ps(shift))), _mm256_set1_ps(log_base_inv)); }
+#endif
+
+    float scale;
+    float shift;
+    float log_base_inv;
+};
+
+// pow(x * scale + shift, power) for power 1, 2, 0.5, -0.5 and -1
+struct elementwise_power
+{
+    elementwise_power(float _power, float _scale, float _shift) : power(_power), scale(_scale), shift(_shift) {}
+
+    static bool supported(float power)
+    {
+        return power == 1.f || power == 2.f || power == 0.5f || power == -0.5f || power == -1.f;
+    }
+
+    float func(float x) const { return pow(x * scale + shift, power); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const
+    {
+        __m128 v = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(scale)), _mm_set1_ps(shift));
+        if (power == 2.f)
+            return _mm_mul_ps(v, v);
+        if (power == 0.5f)
+            return _mm_sqrt_ps(v);
+        if (power == -0.5f)
+            return _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(v));
+        if (power == -1.f)
+            return _mm_div_ps(_mm_set1_ps(1.f), v);
+        return v;
+    }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const
+    {
+        __m256 v = _mm256_fmadd_ps(x, _mm256_set1_ps(scale), _mm256_set1_ps(shift));
+        if (power == 2.f)
+            return _mm256_mul_ps(v, v);
+        if (power == 0.5f)
+            return _mm256_sqrt_ps(v);
+        if (power == -0.5f)
+            return _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(v));
+        if (power == -1.f)
+            return _mm256_div_ps(_mm256_set1_ps(1.f), v);
+        return v;
+    }
+#endif
+
+    float power;
+    float scale;
+    float shift;
+};
+
+// max(x, 0) + log(1 + exp(-|x|))
+struct elementwise_bnll
+{
+    float func(float x) const { return x > 0.f ? x + log(1.f + exp(-x)) : log(1.f + exp(x)); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x) const
+    {
+        __m128 _one = _mm_set1_ps(1.f);
+        __m128 _e = exp_ps(_mm_sub_ps(_mm_setzero_ps(), abs_ps(x)));
+        return _mm_add_ps(_mm_max_ps(x, _mm_setzero_ps()), log_ps(_mm_add_ps(_one, _e)));
+    }
+#endif
+#if __AVX__
+    __m256 func_pack8(__m256 x) const
+    {
+        __m256 _one = _mm256_set1_ps(1.f);
+        __m256 _e = exp256_ps(_mm256_sub_ps(_mm256_setzero_ps(), abs256_ps(x)));
+        return _mm256_add_ps(_mm256_max_ps(x, _mm256_setzero_ps()), log256_ps(_mm256_add_ps(_one, _e)));
+    }
+#endif
+};
+
+} // namespace ncnn
+
+#endif // X86_ELEMENTWISE_H
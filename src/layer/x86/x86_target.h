@@ -0,0 +1,47 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef X86_TARGET_H
+#define X86_TARGET_H
+
+#include "platform.h"
+
+#if NCNN_AVX512 || NCNN_F16C
+#include <immintrin.h>
+#endif
+
+// kernels tagged with these attributes are built for the extended instruction set
+// regardless of the global compiler flags, call them only after the matching
+// cpu_support_x86_xxx() runtime check
+#if defined(_MSC_VER) && !defined(__clang__)
+#define NCNN_TARGET_AVX512
+#define NCNN_TARGET_AVX512VNNI
+#define NCNN_TARGET_F16C
+#else
+#define NCNN_TARGET_AVX512 __attribute__((target("avx512f,fma")))
+#define NCNN_TARGET_AVX512VNNI __attribute__((target("avx512f,avx512vnni,fma")))
+#define NCNN_TARGET_F16C __attribute__((target("avx,fma,f16c")))
+#endif
+
+// gcc passes _mm512_undefined_ps() as the passthrough operand inside its avx512
+// intrinsics and then reports it with -Wmaybe-uninitialized, wrap the kernels in these
+#if defined(__GNUC__) && !defined(__clang__)
+#define NCNN_AVX512_DIAGNOSTIC_PUSH _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define NCNN_AVX512_DIAGNOSTIC_POP _Pragma("GCC diagnostic pop")
+#else
+#define NCNN_AVX512_DIAGNOSTIC_PUSH
+#define NCNN_AVX512_DIAGNOSTIC_POP
+#endif
+
+#endif // X86_TARGET_H
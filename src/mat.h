@@ -161,15 +161,45 @@ public:
         PIXEL_RGBA2BGR  = PIXEL_RGBA | (PIXEL_BGR << PIXEL_CONVERT_SHIFT),
         PIXEL_RGBA2GRAY = PIXEL_RGBA | (PIXEL_GRAY << PIXEL_CONVERT_SHIFT),
     };
+    enum
+    {
+        YUV420SP_NV21   = 1,
+        YUV420SP_NV12   = 2,
+        YUV420P_I420    = 3,
+    };
     // convenient construct from pixel data
     static Mat from_pixels(const unsigned char* pixels, int type, int w, int h, Allocator* allocator = 0);
     // convenient construct from pixel data and resize to specific size
     static Mat from_pixels_resize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height, Allocator* allocator = 0);
+    // convenient construct from pixel data and resize to specific size, the resize rows are split across num_threads
+    static Mat from_pixels_resize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height, Allocator* allocator, int num_threads);
+    // convenient construct from the roiw x roih region at (roix, roiy) of pixel data and resize to specific size
+    // stride is the byte offset between image rows, the region is read in place without copying
+    static Mat from_pixels_roi_resize(const unsigned char* pixels, int type, int w, int h, int stride, int roix, int roiy, int roiw, int roih, int target_width, int target_height, Allocator* allocator = 0, int num_threads = 1);
+    // convenient construct from many regions of pixel data, rois holds roix roiy roiw roih of each region
+    // the regions are processed in parallel and stored to mats[0..count)
+    static void from_pixels_roi_resize_batch(const unsigned char* pixels, int type, int w, int h, int stride, const int* rois, int count, int target_width, int target_height, Mat* mats, Allocator* allocator = 0, int num_threads = 1);
+    // convenient construct from the region of pixel data as from_pixels_roi_resize, then
+    // convert color, substract mean, normalize and pack in the same pass without full size intermediates
+    // mean_vals and norm_vals work as in substract_mean_normalize, pass 0 to skip
+    // elempack falls back to 1 when it does not divide the channel count
+    static Mat from_pixels_roi_resize_normalize(const unsigned char* pixels, int type, int w, int h, int stride, int roix, int roiy, int roiw, int roih, int target_width, int target_height, const float* mean_vals, const float* norm_vals, int elempack = 1, Allocator* allocator = 0, int num_threads = 1);
+    // convenient construct from pixel data warped by tm as warpaffine_bilinear, then
+    // convert color, substract mean, normalize and pack in the same pass as from_pixels_roi_resize_normalize
+    static Mat from_pixels_warpaffine_normalize(const unsigned char* pixels, int type, int w, int h, int stride, const float* tm, int target_width, int target_height, int border_type, unsigned int border_value, const float* mean_vals, const float* norm_vals, int elempack = 1, Allocator* allocator = 0, int num_threads = 1);
+    // convenient construct from yuv420 frame of yuv_type, resize in the yuv domain to specific size, then
+    // convert to type PIXEL_RGB PIXEL_BGR or PIXEL_GRAY, substract mean and normalize in the same pass
+    // w and h must be even and at least 4, otherwise an empty Mat is returned
+    // the chroma planes are bilinearly resized on their own before the color conversion, so on
+    // high frequency chroma the result may differ from yuv420sp2rgb + from_pixels_resize by more than 100
+    static Mat from_yuv420_resize_normalize(const unsigned char* yuv, int yuv_type, int w, int h, int type, int target_width, int target_height, const float* mean_vals, const float* norm_vals, Allocator* allocator = 0, int num_threads = 1);
 
     // convenient export to pixel data
     void to_pixels(unsigned char* pixels, int type) const;
     // convenient export to pixel data and resize to specific size
     void to_pixels_resize(unsigned char* pixels, int type, int target_width, int target_height) const;
+    // convenient export to pixel data and resize to specific size, the resize rows are split across num_threads
+    void to_pixels_resize(unsigned char* pixels, int type, int target_width, int target_height, int num_threads) const;
 #endif // NCNN_PIXEL
 
     // substract channel-wise mean values, then multiply by normalize values, pass 0 to skip
@@ -358,8 +388,26 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
 void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h);
 void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h);
 void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h);
+// image pixel bilinear resize, the output rows are split across num_threads
+void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads);
+void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads);
+void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads);
+void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads);
 // image pixel bilinear resize, convenient wrapper for yuv420sp(nv21)
 void resize_bilinear_yuv420sp(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h);
+void resize_bilinear_yuv420sp(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads);
+// image pixel bilinear affine warp, the output rows are split across num_threads
+// tm is the 2x3 matrix from dst to src, sx = tm[0] * x + tm[1] * y + tm[2], sy = tm[3] * x + tm[4] * y + tm[5]
+// type is BORDER_CONSTANT or BORDER_REPLICATE, the constant border color has channel 0 in the lowest byte of v
+void warpaffine_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, const float* tm, int type = 0, unsigned int v = 0, int num_threads = 1);
+void warpaffine_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, const float* tm, int type = 0, unsigned int v = 0, int num_threads = 1);
+void warpaffine_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, const float* tm, int type = 0, unsigned int v = 0, int num_threads = 1);
+// image pixel bilinear affine warp, srcstride and stride are the byte offsets between rows
+void warpaffine_bilinear_c1(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h, int stride, const float* tm, int type = 0, unsigned int v = 0, int num_threads = 1);
+void warpaffine_bilinear_c3(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h, int stride, const float* tm, int type = 0, unsigned int v = 0, int num_threads = 1);
+void warpaffine_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h, int stride, const float* tm, int type = 0, unsigned int v = 0, int num_threads = 1);
+// invert the 2x3 affine matrix, turns a src to dst transform into the tm of warpaffine_bilinear
+void invert_affine_transform(const float* tm, float* tm_inv);
 #endif // NCNN_PIXEL
 
 // mat process
@@ -19,11 +19,145 @@
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif // __ARM_NEON
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
 #include "platform.h"
 
 namespace ncnn {
 
 #if NCNN_PIXEL
+#if __SSE2__
+// 16 uchar to 16 float
+static inline void cvt_u8_f32_sse(__m128i _u8, float* ptr)
+{
+#if __AVX2__
+    _mm256_storeu_ps(ptr, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_u8)));
+    _mm256_storeu_ps(ptr + 8, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(_u8, 8))));
+#else
+    __m128i _zero = _mm_setzero_si128();
+    __m128i _u16l = _mm_unpacklo_epi8(_u8, _zero);
+    __m128i _u16h = _mm_unpackhi_epi8(_u8, _zero);
+
+    _mm_storeu_ps(ptr, _mm_cvtepi32_ps(_mm_unpacklo_epi16(_u16l, _zero)));
+    _mm_storeu_ps(ptr + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(_u16l, _zero)));
+    _mm_storeu_ps(ptr + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(_u16h, _zero)));
+    _mm_storeu_ps(ptr + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(_u16h, _zero)));
+#endif // __AVX2__
+}
+
+// 16 float to 16 uchar, truncate and saturate like SATURATE_CAST_UCHAR
+static inline __m128i cvt_f32_u8_sse(const float* ptr)
+{
+    __m128i _i0 = _mm_cvttps_epi32(_mm_loadu_ps(ptr));
+    __m128i _i1 = _mm_cvttps_epi32(_mm_loadu_ps(ptr + 4));
+    __m128i _i2 = _mm_cvttps_epi32(_mm_loadu_ps(ptr + 8));
+    __m128i _i3 = _mm_cvttps_epi32(_mm_loadu_ps(ptr + 12));
+
+    return _mm_packus_epi16(_mm_packs_epi32(_i0, _i1), _mm_packs_epi32(_i2, _i3));
+}
+
+// (r * R2Y + g * G2Y + b * B2Y) >> Y_shift of 16 pixels to 16 float
+static inline void rgb2gray_u8_f32_sse(__m128i _r, __m128i _g, __m128i _b, float* ptr)
+{
+    const __m128i _zero = _mm_setzero_si128();
+    const __m128i _R2Y = _mm_set1_epi16(77);
+    const __m128i _G2Y = _mm_set1_epi16(150);
+    const __m128i _B2Y = _mm_set1_epi16(29);
+
+    // at most 255 * 256, fits in ushort
+    __m128i _yl = _mm_mullo_epi16(_mm_unpacklo_epi8(_r, _zero), _R2Y);
+    _yl = _mm_add_epi16(_yl, _mm_mullo_epi16(_mm_unpacklo_epi8(_g, _zero), _G2Y));
+    _yl = _mm_add_epi16(_yl, _mm_mullo_epi16(_mm_unpacklo_epi8(_b, _zero), _B2Y));
+
+    __m128i _yh = _mm_mullo_epi16(_mm_unpackhi_epi8(_r, _zero), _R2Y);
+    _yh = _mm_add_epi16(_yh, _mm_mullo_epi16(_mm_unpackhi_epi8(_g, _zero), _G2Y));
+    _yh = _mm_add_epi16(_yh, _mm_mullo_epi16(_mm_unpackhi_epi8(_b, _zero), _B2Y));
+
+    cvt_u8_f32_sse(_mm_packus_epi16(_mm_srli_epi16(_yl, 8), _mm_srli_epi16(_yh, 8)), ptr);
+}
+
+// sse2 has no vld3/vst3, the channels are separated by repeated byte zip / unzip,
+// each zip round multiplies the byte index by 2 modulo (bytes - 1)
+
+// 32 rgb pixels in v[0..5] to r in v[0..1], g in v[2..3], b in v[4..5]
+static inline void deinterleave3_u8_sse(__m128i* v)
+{
+    for (int r=0; r<5; r++)
+    {
+        __m128i t[6];
+        for (int k=0; k<3; k++)
+        {
+            t[k * 2] = _mm_unpacklo_epi8(v[k], v[k + 3]);
+            t[k * 2 + 1] = _mm_unpackhi_epi8(v[k], v[k + 3]);
+        }
+        for (int k=0; k<6; k++)
+        {
+            v[k] = t[k];
+        }
+    }
+}
+
+// r in v[0..1], g in v[2..3], b in v[4..5] to 32 rgb pixels in v[0..5]
+static inline void interleave3_u8_sse(__m128i* v)
+{
+    const __m128i _mask = _mm_set1_epi16(0x00ff);
+
+    for (int r=0; r<5; r++)
+    {
+        __m128i t[6];
+        for (int k=0; k<3; k++)
+        {
+            t[k] = _mm_packus_epi16(_mm_and_si128(v[k * 2], _mask), _mm_and_si128(v[k * 2 + 1], _mask));
+            t[k + 3] = _mm_packus_epi16(_mm_srli_epi16(v[k * 2], 8), _mm_srli_epi16(v[k * 2 + 1], 8));
+        }
+        for (int k=0; k<6; k++)
+        {
+            v[k] = t[k];
+        }
+    }
+}
+
+// r g b a in v[0] v[1] v[2] v[3] to 16 rgba pixels in v[0..3]
+static inline void interleave4_u8_sse(__m128i* v)
+{
+    const __m128i _mask = _mm_set1_epi16(0x00ff);
+
+    for (int r=0; r<4; r++)
+    {
+        __m128i t[4];
+        for (int k=0; k<2; k++)
+        {
+            t[k] = _mm_packus_epi16(_mm_and_si128(v[k * 2], _mask), _mm_and_si128(v[k * 2 + 1], _mask));
+            t[k + 2] = _mm_packus_epi16(_mm_srli_epi16(v[k * 2], 8), _mm_srli_epi16(v[k * 2 + 1], 8));
+        }
+        for (int k=0; k<4; k++)
+        {
+            v[k] = t[k];
+        }
+    }
+}
+
+static inline void load_u8_sse(const unsigned char* ptr, __m128i* v, int n)
+{
+    for (int k=0; k<n; k++)
+    {
+        v[k] = _mm_loadu_si128((const __m128i*)(ptr + k * 16));
+    }
+}
+
+static inline void store_u8_sse(unsigned char* ptr, const __m128i* v, int n)
+{
+    for (int k=0; k<n; k++)
+    {
+        _mm_storeu_si128((__m128i*)(ptr + k * 16), v[k]);
+    }
+}
+#endif // __SSE2__
+
 static Mat from_rgb(const unsigned char* rgb, int w, int h, Allocator* allocator)
 {
     Mat m(w, h, 3, 4u, allocator);
@@ -39,6 +173,9 @@ static Mat from_rgb(const unsigned char* rgb, int w, int h, Allocator* allocator
 #if __ARM_NEON
     int nn = size >> 3;
     int remain = size - (nn << 3);
+#elif __SSE2__
+    int nn = size >> 5;
+    int remain = size - (nn << 5);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -113,6 +250,26 @@ static Mat from_rgb(const unsigned char* rgb, int w, int h, Allocator* allocator
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        __m128i _v[6];
+        load_u8_sse(rgb, _v, 6);
+        deinterleave3_u8_sse(_v);
+
+        cvt_u8_f32_sse(_v[0], ptr0);
+        cvt_u8_f32_sse(_v[1], ptr0 + 16);
+        cvt_u8_f32_sse(_v[2], ptr1);
+        cvt_u8_f32_sse(_v[3], ptr1 + 16);
+        cvt_u8_f32_sse(_v[4], ptr2);
+        cvt_u8_f32_sse(_v[5], ptr2 + 16);
+
+        rgb += 3*32;
+        ptr0 += 32;
+        ptr1 += 32;
+        ptr2 += 32;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr0 = rgb[0];
@@ -138,7 +295,33 @@ static void to_rgb(const Mat& m, unsigned char* rgb)
 
 #define SATURATE_CAST_UCHAR(X) (unsigned char)::std::min(::std::max((int)(X), 0), 255);
 
+#if __SSE2__
+    int nn = size >> 5;
+    int remain = size - (nn << 5);
+#else
     int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        __m128i _v[6];
+        _v[0] = cvt_f32_u8_sse(ptr0);
+        _v[1] = cvt_f32_u8_sse(ptr0 + 16);
+        _v[2] = cvt_f32_u8_sse(ptr1);
+        _v[3] = cvt_f32_u8_sse(ptr1 + 16);
+        _v[4] = cvt_f32_u8_sse(ptr2);
+        _v[5] = cvt_f32_u8_sse(ptr2 + 16);
+
+        interleave3_u8_sse(_v);
+        store_u8_sse(rgb, _v, 6);
+
+        rgb += 3*32;
+        ptr0 += 32;
+        ptr1 += 32;
+        ptr2 += 32;
+    }
+#endif // __SSE2__
 
     for (; remain>0; remain--)
     {
@@ -168,6 +351,9 @@ static Mat from_gray(const unsigned char* gray, int w, int h, Allocator* allocat
 #if __ARM_NEON
     int nn = size >> 4;
     int remain = size - (nn << 4);
+#elif __SSE2__
+    int nn = size >> 4;
+    int remain = size - (nn << 4);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -225,6 +411,15 @@ static Mat from_gray(const unsigned char* gray, int w, int h, Allocator* allocat
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        cvt_u8_f32_sse(_mm_loadu_si128((const __m128i*)gray), ptr);
+
+        gray += 16;
+        ptr += 16;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr = *gray;
@@ -244,7 +439,22 @@ static void to_gray(const Mat& m, unsigned char* gray)
 
 #define SATURATE_CAST_UCHAR(X) (unsigned char)::std::min(::std::max((int)(X), 0), 255);
 
+#if __SSE2__
+    int nn = size >> 4;
+    int remain = size - (nn << 4);
+#else
     int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        _mm_storeu_si128((__m128i*)gray, cvt_f32_u8_sse(ptr));
+
+        gray += 16;
+        ptr += 16;
+    }
+#endif // __SSE2__
 
     for (; remain>0; remain--)
     {
@@ -273,6 +483,9 @@ static Mat from_rgba(const unsigned char* rgba, int w, int h, Allocator* allocat
 #if __ARM_NEON
     int nn = size >> 3;
     int remain = size - (nn << 3);
+#elif __SSE2__
+    int nn = size >> 2;
+    int remain = size - (nn << 2);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -361,6 +574,25 @@ static Mat from_rgba(const unsigned char* rgba, int w, int h, Allocator* allocat
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    // one pixel in each int
+    const __m128i _mask = _mm_set1_epi32(0xff);
+    for (; nn>0; nn--)
+    {
+        __m128i _rgba = _mm_loadu_si128((const __m128i*)rgba);
+
+        _mm_storeu_ps(ptr0, _mm_cvtepi32_ps(_mm_and_si128(_rgba, _mask)));
+        _mm_storeu_ps(ptr1, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(_rgba, 8), _mask)));
+        _mm_storeu_ps(ptr2, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(_rgba, 16), _mask)));
+        _mm_storeu_ps(ptr3, _mm_cvtepi32_ps(_mm_srli_epi32(_rgba, 24)));
+
+        rgba += 4*4;
+        ptr0 += 4;
+        ptr1 += 4;
+        ptr2 += 4;
+        ptr3 += 4;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr0 = rgba[0];
@@ -389,7 +621,32 @@ static void to_rgba(const Mat& m, unsigned char* rgba)
 
 #define SATURATE_CAST_UCHAR(X) (unsigned char)::std::min(::std::max((int)(X), 0), 255);
 
+#if __SSE2__
+    int nn = size >> 4;
+    int remain = size - (nn << 4);
+#else
     int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        __m128i _v[4];
+        _v[0] = cvt_f32_u8_sse(ptr0);
+        _v[1] = cvt_f32_u8_sse(ptr1);
+        _v[2] = cvt_f32_u8_sse(ptr2);
+        _v[3] = cvt_f32_u8_sse(ptr3);
+
+        interleave4_u8_sse(_v);
+        store_u8_sse(rgba, _v, 4);
+
+        rgba += 4*16;
+        ptr0 += 16;
+        ptr1 += 16;
+        ptr2 += 16;
+        ptr3 += 16;
+    }
+#endif // __SSE2__
 
     for (; remain>0; remain--)
     {
@@ -423,6 +680,9 @@ static Mat from_rgb2bgr(const unsigned char* rgb, int w, int h, Allocator* alloc
 #if __ARM_NEON
     int nn = size >> 3;
     int remain = size - (nn << 3);
+#elif __SSE2__
+    int nn = size >> 5;
+    int remain = size - (nn << 5);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -497,6 +757,26 @@ static Mat from_rgb2bgr(const unsigned char* rgb, int w, int h, Allocator* alloc
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        __m128i _v[6];
+        load_u8_sse(rgb, _v, 6);
+        deinterleave3_u8_sse(_v);
+
+        cvt_u8_f32_sse(_v[4], ptr0);
+        cvt_u8_f32_sse(_v[5], ptr0 + 16);
+        cvt_u8_f32_sse(_v[2], ptr1);
+        cvt_u8_f32_sse(_v[3], ptr1 + 16);
+        cvt_u8_f32_sse(_v[0], ptr2);
+        cvt_u8_f32_sse(_v[1], ptr2 + 16);
+
+        rgb += 3*32;
+        ptr0 += 32;
+        ptr1 += 32;
+        ptr2 += 32;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr0 = rgb[2];
@@ -522,7 +802,33 @@ static void to_bgr2rgb(const Mat& m, unsigned char* rgb)
 
 #define SATURATE_CAST_UCHAR(X) (unsigned char)::std::min(::std::max((int)(X), 0), 255);
 
+#if __SSE2__
+    int nn = size >> 5;
+    int remain = size - (nn << 5);
+#else
     int remain = size;
+#endif // __SSE2__
+
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        __m128i _v[6];
+        _v[0] = cvt_f32_u8_sse(ptr2);
+        _v[1] = cvt_f32_u8_sse(ptr2 + 16);
+        _v[2] = cvt_f32_u8_sse(ptr1);
+        _v[3] = cvt_f32_u8_sse(ptr1 + 16);
+        _v[4] = cvt_f32_u8_sse(ptr0);
+        _v[5] = cvt_f32_u8_sse(ptr0 + 16);
+
+        interleave3_u8_sse(_v);
+        store_u8_sse(rgb, _v, 6);
+
+        rgb += 3*32;
+        ptr0 += 32;
+        ptr1 += 32;
+        ptr2 += 32;
+    }
+#endif // __SSE2__
 
     for (; remain>0; remain--)
     {
@@ -558,6 +864,9 @@ static Mat from_rgb2gray(const unsigned char* rgb, int w, int h, Allocator* allo
 #if __ARM_NEON
     int nn = size >> 3;
     int remain = size - (nn << 3);
+#elif __SSE2__
+    int nn = size >> 5;
+    int remain = size - (nn << 5);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -620,6 +929,20 @@ static Mat from_rgb2gray(const unsigned char* rgb, int w, int h, Allocator* allo
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        __m128i _v[6];
+        load_u8_sse(rgb, _v, 6);
+        deinterleave3_u8_sse(_v);
+
+        rgb2gray_u8_f32_sse(_v[0], _v[2], _v[4], ptr);
+        rgb2gray_u8_f32_sse(_v[1], _v[3], _v[5], ptr + 16);
+
+        rgb += 3*32;
+        ptr += 32;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr = (rgb[0] * R2Y + rgb[1] * G2Y + rgb[2] * B2Y) >> Y_shift;
@@ -650,6 +973,9 @@ static Mat from_bgr2gray(const unsigned char* bgr, int w, int h, Allocator* allo
 #if __ARM_NEON
     int nn = size >> 3;
     int remain = size - (nn << 3);
+#elif __SSE2__
+    int nn = size >> 5;
+    int remain = size - (nn << 5);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -712,6 +1038,20 @@ static Mat from_bgr2gray(const unsigned char* bgr, int w, int h, Allocator* allo
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        __m128i _v[6];
+        load_u8_sse(bgr, _v, 6);
+        deinterleave3_u8_sse(_v);
+
+        rgb2gray_u8_f32_sse(_v[4], _v[2], _v[0], ptr);
+        rgb2gray_u8_f32_sse(_v[5], _v[3], _v[1], ptr + 16);
+
+        bgr += 3*32;
+        ptr += 32;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr = (bgr[2] * R2Y + bgr[1] * G2Y + bgr[0] * B2Y) >> Y_shift;
@@ -738,6 +1078,9 @@ static Mat from_gray2rgb(const unsigned char* gray, int w, int h, Allocator* all
 #if __ARM_NEON
     int nn = size >> 4;
     int remain = size - (nn << 4);
+#elif __SSE2__
+    int nn = size >> 4;
+    int remain = size - (nn << 4);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -815,6 +1158,19 @@ static Mat from_gray2rgb(const unsigned char* gray, int w, int h, Allocator* all
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    for (; nn>0; nn--)
+    {
+        cvt_u8_f32_sse(_mm_loadu_si128((const __m128i*)gray), ptr0);
+        memcpy(ptr1, ptr0, 16 * sizeof(float));
+        memcpy(ptr2, ptr0, 16 * sizeof(float));
+
+        gray += 16;
+        ptr0 += 16;
+        ptr1 += 16;
+        ptr2 += 16;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr0 = *gray;
@@ -845,6 +1201,9 @@ static Mat from_rgba2rgb(const unsigned char* rgba, int w, int h, Allocator* all
 #if __ARM_NEON
     int nn = size >> 3;
     int remain = size - (nn << 3);
+#elif __SSE2__
+    int nn = size >> 2;
+    int remain = size - (nn << 2);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -919,6 +1278,23 @@ static Mat from_rgba2rgb(const unsigned char* rgba, int w, int h, Allocator* all
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    // one pixel in each int
+    const __m128i _mask = _mm_set1_epi32(0xff);
+    for (; nn>0; nn--)
+    {
+        __m128i _rgba = _mm_loadu_si128((const __m128i*)rgba);
+
+        _mm_storeu_ps(ptr0, _mm_cvtepi32_ps(_mm_and_si128(_rgba, _mask)));
+        _mm_storeu_ps(ptr1, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(_rgba, 8), _mask)));
+        _mm_storeu_ps(ptr2, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(_rgba, 16), _mask)));
+
+        rgba += 4*4;
+        ptr0 += 4;
+        ptr1 += 4;
+        ptr2 += 4;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr0 = rgba[0];
@@ -949,6 +1325,9 @@ static Mat from_rgba2bgr(const unsigned char* rgba, int w, int h, Allocator* all
 #if __ARM_NEON
     int nn = size >> 3;
     int remain = size - (nn << 3);
+#elif __SSE2__
+    int nn = size >> 2;
+    int remain = size - (nn << 2);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -1023,6 +1402,23 @@ static Mat from_rgba2bgr(const unsigned char* rgba, int w, int h, Allocator* all
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    // one pixel in each int
+    const __m128i _mask = _mm_set1_epi32(0xff);
+    for (; nn>0; nn--)
+    {
+        __m128i _rgba = _mm_loadu_si128((const __m128i*)rgba);
+
+        _mm_storeu_ps(ptr2, _mm_cvtepi32_ps(_mm_and_si128(_rgba, _mask)));
+        _mm_storeu_ps(ptr1, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(_rgba, 8), _mask)));
+        _mm_storeu_ps(ptr0, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(_rgba, 16), _mask)));
+
+        rgba += 4*4;
+        ptr0 += 4;
+        ptr1 += 4;
+        ptr2 += 4;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr0 = rgba[2];
@@ -1057,6 +1453,9 @@ static Mat from_rgba2gray(const unsigned char* rgba, int w, int h, Allocator* al
 #if __ARM_NEON
     int nn = size >> 3;
     int remain = size - (nn << 3);
+#elif __SSE2__
+    int nn = size >> 2;
+    int remain = size - (nn << 2);
 #else
     int remain = size;
 #endif // __ARM_NEON
@@ -1119,6 +1518,27 @@ static Mat from_rgba2gray(const unsigned char* rgba, int w, int h, Allocator* al
     }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+    // one pixel in each int
+    const __m128i _mask = _mm_set1_epi32(0xff);
+    const __m128i _R2Y = _mm_set1_epi32(R2Y);
+    const __m128i _G2Y = _mm_set1_epi32(G2Y);
+    const __m128i _B2Y = _mm_set1_epi32(B2Y);
+    for (; nn>0; nn--)
+    {
+        __m128i _rgba = _mm_loadu_si128((const __m128i*)rgba);
+
+        // the products fit in the low short of each int
+        __m128i _y = _mm_mullo_epi16(_mm_and_si128(_rgba, _mask), _R2Y);
+        _y = _mm_add_epi32(_y, _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(_rgba, 8), _mask), _G2Y));
+        _y = _mm_add_epi32(_y, _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(_rgba, 16), _mask), _B2Y));
+
+        _mm_storeu_ps(ptr, _mm_cvtepi32_ps(_mm_srli_epi32(_y, Y_shift)));
+
+        rgba += 4*4;
+        ptr += 4;
+    }
+#endif // __SSE2__
     for (; remain>0; remain--)
     {
         *ptr = (rgba[0] * R2Y + rgba[1] * G2Y + rgba[2] * B2Y) >> Y_shift;
@@ -1141,6 +1561,14 @@ void yuv420sp2rgb(const unsigned char* yuv420sp, int w, int h, unsigned char* rg
     int8x8_t _v46 = vdup_n_s8(46);
     int8x8_t _v22 = vdup_n_s8(22);
     int8x8_t _v113 = vdup_n_s8(113);
+#elif __SSE2__
+    const __m128i _zero = _mm_setzero_si128();
+    const __m128i _mask = _mm_set1_epi16(0x00ff);
+    const __m128i _v128 = _mm_set1_epi16(128);
+    const __m128i _v90 = _mm_set1_epi16(90);
+    const __m128i _vn46 = _mm_set1_epi16(-46);
+    const __m128i _vn22 = _mm_set1_epi16(-22);
+    const __m128i _v113 = _mm_set1_epi16(113);
 #endif // __ARM_NEON
 
     for (int y=0; y<h; y+=2)
@@ -1153,6 +1581,9 @@ void yuv420sp2rgb(const unsigned char* yuv420sp, int w, int h, unsigned char* rg
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 5;
+        int remain = w - (nn << 5);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -1263,6 +1694,62 @@ void yuv420sp2rgb(const unsigned char* yuv420sp, int w, int h, unsigned char* rg
 #endif // __aarch64__
 #endif // __ARM_NEON
 
+#if __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _rgb0[6];
+            __m128i _rgb1[6];
+
+            for (int k=0; k<2; k++)
+            {
+                // 8 vu pairs shared by 16 pixels of both rows
+                __m128i _vu = _mm_loadu_si128((const __m128i*)(vuptr + k * 16));
+                __m128i _vv = _mm_sub_epi16(_mm_and_si128(_vu, _mask), _v128);
+                __m128i _uu = _mm_sub_epi16(_mm_srli_epi16(_vu, 8), _v128);
+
+                __m128i _ruv = _mm_mullo_epi16(_vv, _v90);
+                __m128i _guv = _mm_add_epi16(_mm_mullo_epi16(_vv, _vn46), _mm_mullo_epi16(_uu, _vn22));
+                __m128i _buv = _mm_mullo_epi16(_uu, _v113);
+
+                __m128i _ruvl = _mm_unpacklo_epi16(_ruv, _ruv);
+                __m128i _ruvh = _mm_unpackhi_epi16(_ruv, _ruv);
+                __m128i _guvl = _mm_unpacklo_epi16(_guv, _guv);
+                __m128i _guvh = _mm_unpackhi_epi16(_guv, _guv);
+                __m128i _buvl = _mm_unpacklo_epi16(_buv, _buv);
+                __m128i _buvh = _mm_unpackhi_epi16(_buv, _buv);
+
+                // at most 255 * 64 + 113 * 127, fits in short
+                __m128i _y0 = _mm_loadu_si128((const __m128i*)(yptr0 + k * 16));
+                __m128i _yy0l = _mm_slli_epi16(_mm_unpacklo_epi8(_y0, _zero), 6);
+                __m128i _yy0h = _mm_slli_epi16(_mm_unpackhi_epi8(_y0, _zero), 6);
+
+                _rgb0[k] = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy0l, _ruvl), 6), _mm_srai_epi16(_mm_add_epi16(_yy0h, _ruvh), 6));
+                _rgb0[2 + k] = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy0l, _guvl), 6), _mm_srai_epi16(_mm_add_epi16(_yy0h, _guvh), 6));
+                _rgb0[4 + k] = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy0l, _buvl), 6), _mm_srai_epi16(_mm_add_epi16(_yy0h, _buvh), 6));
+
+                __m128i _y1 = _mm_loadu_si128((const __m128i*)(yptr1 + k * 16));
+                __m128i _yy1l = _mm_slli_epi16(_mm_unpacklo_epi8(_y1, _zero), 6);
+                __m128i _yy1h = _mm_slli_epi16(_mm_unpackhi_epi8(_y1, _zero), 6);
+
+                _rgb1[k] = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy1l, _ruvl), 6), _mm_srai_epi16(_mm_add_epi16(_yy1h, _ruvh), 6));
+                _rgb1[2 + k] = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy1l, _guvl), 6), _mm_srai_epi16(_mm_add_epi16(_yy1h, _guvh), 6));
+                _rgb1[4 + k] = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy1l, _buvl), 6), _mm_srai_epi16(_mm_add_epi16(_yy1h, _buvh), 6));
+            }
+
+            interleave3_u8_sse(_rgb0);
+            interleave3_u8_sse(_rgb1);
+
+            store_u8_sse(rgb0, _rgb0, 6);
+            store_u8_sse(rgb1, _rgb1, 6);
+
+            yptr0 += 32;
+            yptr1 += 32;
+            vuptr += 32;
+            rgb0 += 96;
+            rgb1 += 96;
+        }
+#endif // __SSE2__
+
 #define SATURATE_CAST_UCHAR(X) (unsigned char)::std::min(::std::max((int)(X), 0), 255);
         for (; remain>0; remain-=2)
         {
@@ -1367,6 +1854,11 @@ Mat Mat::from_pixels(const unsigned char* pixels, int type, int w, int h, Alloca
 }
 
 Mat Mat::from_pixels_resize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height, Allocator* allocator)
+{
+    return Mat::from_pixels_resize(pixels, type, w, h, target_width, target_height, allocator, 1);
+}
+
+Mat Mat::from_pixels_resize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height, Allocator* allocator, int num_threads)
 {
     if (w == target_width && h == target_height)
         return Mat::from_pixels(pixels, type, w, h);
@@ -1379,7 +1871,7 @@ Mat Mat::from_pixels_resize(const unsigned char* pixels, int type, int w, int h,
     {
         Mat dst(target_width, target_height, (size_t)3u, 3);
 
-        resize_bilinear_c3(pixels, w, h, dst, target_width, target_height);
+        resize_bilinear_c3(pixels, w, h, dst, target_width, target_height, num_threads);
 
         m = Mat::from_pixels(dst, type, target_width, target_height, allocator);
     }
@@ -1387,7 +1879,7 @@ Mat Mat::from_pixels_resize(const unsigned char* pixels, int type, int w, int h,
     {
         Mat dst(target_width, target_height, (size_t)1u, 1);
 
-        resize_bilinear_c1(pixels, w, h, dst, target_width, target_height);
+        resize_bilinear_c1(pixels, w, h, dst, target_width, target_height, num_threads);
 
         m = Mat::from_pixels(dst, type, target_width, target_height, allocator);
     }
@@ -1395,7 +1887,7 @@ Mat Mat::from_pixels_resize(const unsigned char* pixels, int type, int w, int h,
     {
         Mat dst(target_width, target_height, (size_t)4u, 4);
 
-        resize_bilinear_c4(pixels, w, h, dst, target_width, target_height);
+        resize_bilinear_c4(pixels, w, h, dst, target_width, target_height, num_threads);
 
         m = Mat::from_pixels(dst, type, target_width, target_height, allocator);
     }
@@ -1424,6 +1916,11 @@ void Mat::to_pixels(unsigned char* pixels, int type) const
 }
 
 void Mat::to_pixels_resize(unsigned char* pixels, int type, int target_width, int target_height) const
+{
+    to_pixels_resize(pixels, type, target_width, target_height, 1);
+}
+
+void Mat::to_pixels_resize(unsigned char* pixels, int type, int target_width, int target_height, int num_threads) const
 {
     if (w == target_width && h == target_height)
         return to_pixels(pixels, type);
@@ -1436,7 +1933,7 @@ void Mat::to_pixels_resize(unsigned char* pixels, int type, int target_width, in
 
         to_pixels(src, type);
 
-        resize_bilinear_c3(src, w, h, pixels, target_width, target_height);
+        resize_bilinear_c3(src, w, h, pixels, target_width, target_height, num_threads);
     }
     else if (type_to == PIXEL_GRAY)
     {
@@ -1444,7 +1941,7 @@ void Mat::to_pixels_resize(unsigned char* pixels, int type, int target_width, in
 
         to_pixels(src, type);
 
-        resize_bilinear_c1(src, w, h, pixels, target_width, target_height);
+        resize_bilinear_c1(src, w, h, pixels, target_width, target_height, num_threads);
     }
     else if (type_to == PIXEL_RGBA)
     {
@@ -1452,7 +1949,7 @@ void Mat::to_pixels_resize(unsigned char* pixels, int type, int target_width, in
 
         to_pixels(src, type);
 
-        resize_bilinear_c4(src, w, h, pixels, target_width, target_height);
+        resize_bilinear_c4(src, w, h, pixels, target_width, target_height, num_threads);
     }
 }
 #endif // NCNN_PIXEL
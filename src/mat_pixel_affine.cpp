@@ -0,0 +1,327 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "mat.h"
+#include <limits.h>
+#include <math.h>
+#include <algorithm>
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#include "platform.h"
+
+namespace ncnn {
+
+#if NCNN_PIXEL
+// source coordinates are fixed point with 10 fractional bits
+// out = ((((p00 * (1024 - fx) + p01 * fx) >> 4) * (1024 - fy) + ((p10 * (1024 - fx) + p11 * fx) >> 4) * fy) + (1 << 15)) >> 16
+#define WARPAFFINE_BITS 10
+#define WARPAFFINE_ONE (1 << WARPAFFINE_BITS)
+
+static inline int warpaffine_fixed(double v)
+{
+    v = v * WARPAFFINE_ONE;
+    v = v + (v >= 0.0 ? 0.5 : -0.5);
+    return (int)std::min(std::max(v, (double)INT_MIN), (double)INT_MAX);
+}
+
+static inline void warpaffine_blend(const unsigned char* p00, const unsigned char* p01, const unsigned char* p10, const unsigned char* p11, int fx, int fy, int cn, unsigned char* outptr)
+{
+    for (int k=0; k<cn; k++)
+    {
+        int h0 = (p00[k] * (WARPAFFINE_ONE - fx) + p01[k] * fx) >> 4;
+        int h1 = (p10[k] * (WARPAFFINE_ONE - fx) + p11[k] * fx) >> 4;
+
+        outptr[k] = (h0 * (WARPAFFINE_ONE - fy) + h1 * fy + (1 << 15)) >> 16;
+    }
+}
+
+#if __SSE2__
+// blend one pixel of 3 or 4 channels, all four samples are inside the image
+static inline void warpaffine_blend_sse(const unsigned char* p0, const unsigned char* p1, int fx, int fy, int cn, unsigned char* outptr)
+{
+    const __m128i _zero = _mm_setzero_si128();
+
+    __m128i _p00 = _mm_cvtsi32_si128(*(const int*)p0);
+    __m128i _p10 = _mm_cvtsi32_si128(*(const int*)p1);
+    __m128i _p01;
+    __m128i _p11;
+    if (cn == 4)
+    {
+        _p01 = _mm_cvtsi32_si128(*(const int*)(p0 + 4));
+        _p11 = _mm_cvtsi32_si128(*(const int*)(p1 + 4));
+    }
+    else
+    {
+        // the right pixel ends at p + 6, read it from p + 2 and drop the leading byte
+        _p01 = _mm_srli_epi32(_mm_cvtsi32_si128(*(const int*)(p0 + 2)), 8);
+        _p11 = _mm_srli_epi32(_mm_cvtsi32_si128(*(const int*)(p1 + 2)), 8);
+    }
+
+    // p00 p01 interleaved per channel
+    __m128i _r0 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_p00, _zero), _mm_unpacklo_epi8(_p01, _zero));
+    __m128i _r1 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_p10, _zero), _mm_unpacklo_epi8(_p11, _zero));
+
+    __m128i _wx = _mm_set1_epi32((WARPAFFINE_ONE - fx) | (fx << 16));
+    __m128i _wy = _mm_set1_epi32((WARPAFFINE_ONE - fy) | (fy << 16));
+
+    __m128i _h0 = _mm_srai_epi32(_mm_madd_epi16(_r0, _wx), 4);
+    __m128i _h1 = _mm_srai_epi32(_mm_madd_epi16(_r1, _wx), 4);
+
+    __m128i _h = _mm_unpacklo_epi16(_mm_packs_epi32(_h0, _h0), _mm_packs_epi32(_h1, _h1));
+    __m128i _out = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(_h, _wy), _mm_set1_epi32(1 << 15)), 16);
+
+    _out = _mm_packs_epi32(_out, _out);
+    int out4 = _mm_cvtsi128_si32(_mm_packus_epi16(_out, _out));
+
+    if (cn == 4)
+    {
+        *(int*)outptr = out4;
+    }
+    else
+    {
+        outptr[0] = out4;
+        outptr[1] = out4 >> 8;
+        outptr[2] = out4 >> 16;
+    }
+}
+#endif // __SSE2__
+
+// sample the source at fixed point X Y, the samples outside the image come from the border
+static inline void warpaffine_bilinear_pixel(const unsigned char* src, int srcw, int srch, int srcstride, int cn, int X, int Y, int type, const unsigned char* border, unsigned char* outp)
+{
+    const int ix = X >> WARPAFFINE_BITS;
+    const int iy = Y >> WARPAFFINE_BITS;
+    const int fx = X & (WARPAFFINE_ONE - 1);
+    const int fy = Y & (WARPAFFINE_ONE - 1);
+
+    if (ix >= 0 && iy >= 0 && ix < srcw - 1 && iy < srch - 1)
+    {
+        const unsigned char* p0 = src + srcstride * iy + ix * cn;
+        const unsigned char* p1 = p0 + srcstride;
+
+#if __SSE2__
+        if (cn != 1)
+        {
+            warpaffine_blend_sse(p0, p1, fx, fy, cn, outp);
+            return;
+        }
+#endif // __SSE2__
+        warpaffine_blend(p0, p0 + cn, p1, p1 + cn, fx, fy, cn, outp);
+        return;
+    }
+
+    if (type == BORDER_CONSTANT && (ix < -1 || iy < -1 || ix >= srcw || iy >= srch))
+    {
+        // all samples are outside
+        for (int k=0; k<cn; k++)
+        {
+            outp[k] = border[k];
+        }
+        return;
+    }
+
+    const unsigned char* p[4];
+    for (int k=0; k<4; k++)
+    {
+        int sx = ix + (k & 1);
+        int sy = iy + (k >> 1);
+
+        if (type == BORDER_REPLICATE)
+        {
+            sx = std::min(std::max(sx, 0), srcw - 1);
+            sy = std::min(std::max(sy, 0), srch - 1);
+        }
+        else if (sx < 0 || sy < 0 || sx >= srcw || sy >= srch)
+        {
+            p[k] = border;
+            continue;
+        }
+
+        p[k] = src + srcstride * sy + sx * cn;
+    }
+
+    warpaffine_blend(p[0], p[1], p[2], p[3], fx, fy, cn, outp);
+}
+
+static void warpaffine_bilinear_rows(const unsigned char* src, int srcw, int srch, int srcstride, int cn, unsigned char* dst, int w, int stride, const float* tm, const int* adelta, const int* bdelta, int type, unsigned int v, int dy_start, int dy_end)
+{
+    unsigned char border[4];
+    border[0] = v;
+    border[1] = v >> 8;
+    border[2] = v >> 16;
+    border[3] = v >> 24;
+
+    for (int y = dy_start; y < dy_end; y++)
+    {
+        unsigned char* outptr = dst + stride * (y - dy_start);
+
+        const int X0 = warpaffine_fixed(tm[1] * (double)y + tm[2]);
+        const int Y0 = warpaffine_fixed(tm[4] * (double)y + tm[5]);
+
+        int x = 0;
+#if __SSE2__
+        if (cn == 1)
+        {
+            const __m128i _zero = _mm_setzero_si128();
+            const __m128i _one = _mm_set1_epi32(WARPAFFINE_ONE);
+            const __m128i _fmask = _mm_set1_epi32(WARPAFFINE_ONE - 1);
+            const __m128i _X0 = _mm_set1_epi32(X0);
+            const __m128i _Y0 = _mm_set1_epi32(Y0);
+
+            for (; x+3<w; x+=4)
+            {
+                __m128i _X = _mm_add_epi32(_X0, _mm_loadu_si128((const __m128i*)(adelta + x)));
+                __m128i _Y = _mm_add_epi32(_Y0, _mm_loadu_si128((const __m128i*)(bdelta + x)));
+
+                int ix[4];
+                int iy[4];
+                _mm_storeu_si128((__m128i*)ix, _mm_srai_epi32(_X, WARPAFFINE_BITS));
+                _mm_storeu_si128((__m128i*)iy, _mm_srai_epi32(_Y, WARPAFFINE_BITS));
+
+                bool inside = true;
+                for (int k=0; k<4; k++)
+                {
+                    inside = inside && ix[k] >= 0 && iy[k] >= 0 && ix[k] < srcw - 1 && iy[k] < srch - 1;
+                }
+                if (!inside)
+                {
+                    for (int k=0; k<4; k++)
+                    {
+                        warpaffine_bilinear_pixel(src, srcw, srch, srcstride, 1, X0 + adelta[x + k], Y0 + bdelta[x + k], type, border, outptr + x + k);
+                    }
+                    continue;
+                }
+
+                const unsigned char* p0[4];
+                for (int k=0; k<4; k++)
+                {
+                    p0[k] = src + srcstride * iy[k] + ix[k];
+                }
+
+                // the left and right samples of each pixel as one ushort, top row then bottom row
+                __m128i _S = _mm_set_epi16(
+                    *(const unsigned short*)(p0[3] + srcstride), *(const unsigned short*)(p0[2] + srcstride),
+                    *(const unsigned short*)(p0[1] + srcstride), *(const unsigned short*)(p0[0] + srcstride),
+                    *(const unsigned short*)p0[3], *(const unsigned short*)p0[2],
+                    *(const unsigned short*)p0[1], *(const unsigned short*)p0[0]);
+
+                __m128i _fx = _mm_and_si128(_X, _fmask);
+                __m128i _fy = _mm_and_si128(_Y, _fmask);
+                __m128i _wx = _mm_or_si128(_mm_sub_epi32(_one, _fx), _mm_slli_epi32(_fx, 16));
+                __m128i _wy = _mm_or_si128(_mm_sub_epi32(_one, _fy), _mm_slli_epi32(_fy, 16));
+
+                __m128i _h0 = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(_S, _zero), _wx), 4);
+                __m128i _h1 = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi8(_S, _zero), _wx), 4);
+
+                // h0 h1 interleaved per pixel
+                __m128i _h = _mm_packs_epi32(_h0, _h1);
+                _h = _mm_unpacklo_epi16(_h, _mm_srli_si128(_h, 8));
+
+                __m128i _out = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(_h, _wy), _mm_set1_epi32(1 << 15)), 16);
+
+                _out = _mm_packs_epi32(_out, _out);
+                *(int*)(outptr + x) = _mm_cvtsi128_si32(_mm_packus_epi16(_out, _out));
+            }
+        }
+#endif // __SSE2__
+        for (; x<w; x++)
+        {
+            warpaffine_bilinear_pixel(src, srcw, srch, srcstride, cn, X0 + adelta[x], Y0 + bdelta[x], type, border, outptr + x * cn);
+        }
+    }
+}
+
+static void warpaffine_bilinear(const unsigned char* src, int srcw, int srch, int srcstride, int cn, unsigned char* dst, int w, int h, int stride, const float* tm, int type, unsigned int v, int num_threads)
+{
+    int* buf = new int[w + w];
+
+    int* adelta = buf;
+    int* bdelta = buf + w;
+
+    for (int x = 0; x < w; x++)
+    {
+        adelta[x] = warpaffine_fixed(tm[0] * (double)x);
+        bdelta[x] = warpaffine_fixed(tm[3] * (double)x);
+    }
+
+    int nbands = std::max(std::min(num_threads, h), 1);
+
+    #pragma omp parallel for num_threads(num_threads)
+    for (int b=0; b<nbands; b++)
+    {
+        int dy_start = h * b / nbands;
+        int dy_end = h * (b + 1) / nbands;
+
+        warpaffine_bilinear_rows(src, srcw, srch, srcstride, cn, dst + stride * dy_start, w, stride, tm, adelta, bdelta, type, v, dy_start, dy_end);
+    }
+
+    delete[] buf;
+}
+
+void warpaffine_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, const float* tm, int type, unsigned int v, int num_threads)
+{
+    warpaffine_bilinear(src, srcw, srch, srcw, 1, dst, w, h, w, tm, type, v, num_threads);
+}
+
+void warpaffine_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, const float* tm, int type, unsigned int v, int num_threads)
+{
+    warpaffine_bilinear(src, srcw, srch, srcw * 3, 3, dst, w, h, w * 3, tm, type, v, num_threads);
+}
+
+void warpaffine_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, const float* tm, int type, unsigned int v, int num_threads)
+{
+    warpaffine_bilinear(src, srcw, srch, srcw * 4, 4, dst, w, h, w * 4, tm, type, v, num_threads);
+}
+
+void warpaffine_bilinear_c1(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h, int stride, const float* tm, int type, unsigned int v, int num_threads)
+{
+    warpaffine_bilinear(src, srcw, srch, srcstride, 1, dst, w, h, stride, tm, type, v, num_threads);
+}
+
+void warpaffine_bilinear_c3(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h, int stride, const float* tm, int type, unsigned int v, int num_threads)
+{
+    warpaffine_bilinear(src, srcw, srch, srcstride, 3, dst, w, h, stride, tm, type, v, num_threads);
+}
+
+void warpaffine_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int h, int stride, const float* tm, int type, unsigned int v, int num_threads)
+{
+    warpaffine_bilinear(src, srcw, srch, srcstride, 4, dst, w, h, stride, tm, type, v, num_threads);
+}
+
+void invert_affine_transform(const float* tm, float* tm_inv)
+{
+    float D = tm[0] * tm[4] - tm[1] * tm[3];
+    D = D != 0.f ? 1.f / D : 0.f;
+
+    float A11 = tm[4] * D;
+    float A22 = tm[0] * D;
+    float A12 = -tm[1] * D;
+    float A21 = -tm[3] * D;
+    float b1 = -A11 * tm[2] - A12 * tm[5];
+    float b2 = -A21 * tm[2] - A22 * tm[5];
+
+    tm_inv[0] = A11;
+    tm_inv[1] = A12;
+    tm_inv[2] = b1;
+    tm_inv[3] = A21;
+    tm_inv[4] = A22;
+    tm_inv[5] = b2;
+}
+
+#undef WARPAFFINE_BITS
+#undef WARPAFFINE_ONE
+#endif // NCNN_PIXEL
+
+} // namespace ncnn
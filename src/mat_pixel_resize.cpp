@@ -19,12 +19,121 @@
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif // __ARM_NEON
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
 #include "platform.h"
 
 namespace ncnn {
 
 #if NCNN_PIXEL
-void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h)
+#if __SSE2__
+// hresize 8 pixels of one channel
+static inline void hresize_bilinear_c1_sse(const unsigned char* S, const int* xofs, const short* ialphap, short* rowsp)
+{
+    const __m128i _zero = _mm_setzero_si128();
+
+    // S[sx] and S[sx+1] of each pixel, one ushort each
+    __m128i _S = _mm_set_epi16(
+        *(const unsigned short*)(S + xofs[7]), *(const unsigned short*)(S + xofs[6]),
+        *(const unsigned short*)(S + xofs[5]), *(const unsigned short*)(S + xofs[4]),
+        *(const unsigned short*)(S + xofs[3]), *(const unsigned short*)(S + xofs[2]),
+        *(const unsigned short*)(S + xofs[1]), *(const unsigned short*)(S + xofs[0]));
+
+    __m128i _rows0 = _mm_madd_epi16(_mm_unpacklo_epi8(_S, _zero), _mm_loadu_si128((const __m128i*)ialphap));
+    __m128i _rows1 = _mm_madd_epi16(_mm_unpackhi_epi8(_S, _zero), _mm_loadu_si128((const __m128i*)(ialphap + 8)));
+
+    _mm_storeu_si128((__m128i*)rowsp, _mm_packs_epi32(_mm_srai_epi32(_rows0, 4), _mm_srai_epi32(_rows1, 4)));
+}
+
+// hresize one pixel of 2 channels
+static inline void hresize_bilinear_c2_sse(const unsigned char* Sp, const short* ialphap, short* rowsp)
+{
+    // s0 s1 s2 s3 to s0 s2 s1 s3
+    __m128i _S = _mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)Sp), _mm_setzero_si128());
+    _S = _mm_shufflelo_epi16(_S, _MM_SHUFFLE(3, 1, 2, 0));
+
+    __m128i _rows = _mm_srai_epi32(_mm_madd_epi16(_S, _mm_set1_epi32(*(const int*)ialphap)), 4);
+
+    *(int*)rowsp = _mm_cvtsi128_si32(_mm_packs_epi32(_rows, _rows));
+}
+
+// hresize one pixel of 3 channels, reads 8 bytes and writes 4 shorts
+static inline void hresize_bilinear_c3_sse(const unsigned char* Sp, const short* ialphap, short* rowsp)
+{
+    // s0 s1 s2 s3 s4 s5 s6 s7 to s0 s3 s1 s4 s2 s5 s3 s6
+    __m128i _S = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)Sp), _mm_setzero_si128());
+    _S = _mm_unpacklo_epi16(_S, _mm_srli_si128(_S, 6));
+
+    __m128i _rows = _mm_srai_epi32(_mm_madd_epi16(_S, _mm_set1_epi32(*(const int*)ialphap)), 4);
+
+    _mm_storel_epi64((__m128i*)rowsp, _mm_packs_epi32(_rows, _rows));
+}
+
+// hresize one pixel of 4 channels
+static inline void hresize_bilinear_c4_sse(const unsigned char* Sp, const short* ialphap, short* rowsp)
+{
+    // s0 s1 s2 s3 s4 s5 s6 s7 to s0 s4 s1 s5 s2 s6 s3 s7
+    __m128i _S = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)Sp), _mm_setzero_si128());
+    _S = _mm_unpacklo_epi16(_S, _mm_srli_si128(_S, 8));
+
+    __m128i _rows = _mm_srai_epi32(_mm_madd_epi16(_S, _mm_set1_epi32(*(const int*)ialphap)), 4);
+
+    _mm_storel_epi64((__m128i*)rowsp, _mm_packs_epi32(_rows, _rows));
+}
+
+// D = (((rows0 * b0) >> 16) + ((rows1 * b1) >> 16) + 2) >> 2, n is a multiple of 8
+static void vresize_bilinear_sse(const short* rows0p, const short* rows1p, unsigned char* Dp, int n, short b0, short b1)
+{
+    int i=0;
+#if __AVX2__
+    __m256i _b0_avx = _mm256_set1_epi16(b0);
+    __m256i _b1_avx = _mm256_set1_epi16(b1);
+    __m256i _v2_avx = _mm256_set1_epi16(2);
+    for (; i+31<n; i+=32)
+    {
+        __m256i _acc0 = _mm256_add_epi16(_mm256_mulhi_epi16(_mm256_loadu_si256((const __m256i*)(rows0p + i)), _b0_avx), _mm256_mulhi_epi16(_mm256_loadu_si256((const __m256i*)(rows1p + i)), _b1_avx));
+        __m256i _acc1 = _mm256_add_epi16(_mm256_mulhi_epi16(_mm256_loadu_si256((const __m256i*)(rows0p + i + 16)), _b0_avx), _mm256_mulhi_epi16(_mm256_loadu_si256((const __m256i*)(rows1p + i + 16)), _b1_avx));
+
+        _acc0 = _mm256_srai_epi16(_mm256_add_epi16(_acc0, _v2_avx), 2);
+        _acc1 = _mm256_srai_epi16(_mm256_add_epi16(_acc1, _v2_avx), 2);
+
+        // packus works within 128bit lanes
+        __m256i _D = _mm256_permute4x64_epi64(_mm256_packus_epi16(_acc0, _acc1), _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm256_storeu_si256((__m256i*)(Dp + i), _D);
+    }
+#endif // __AVX2__
+    __m128i _b0 = _mm_set1_epi16(b0);
+    __m128i _b1 = _mm_set1_epi16(b1);
+    __m128i _v2 = _mm_set1_epi16(2);
+    for (; i+15<n; i+=16)
+    {
+        __m128i _acc0 = _mm_add_epi16(_mm_mulhi_epi16(_mm_loadu_si128((const __m128i*)(rows0p + i)), _b0), _mm_mulhi_epi16(_mm_loadu_si128((const __m128i*)(rows1p + i)), _b1));
+        __m128i _acc1 = _mm_add_epi16(_mm_mulhi_epi16(_mm_loadu_si128((const __m128i*)(rows0p + i + 8)), _b0), _mm_mulhi_epi16(_mm_loadu_si128((const __m128i*)(rows1p + i + 8)), _b1));
+
+        _acc0 = _mm_srai_epi16(_mm_add_epi16(_acc0, _v2), 2);
+        _acc1 = _mm_srai_epi16(_mm_add_epi16(_acc1, _v2), 2);
+
+        _mm_storeu_si128((__m128i*)(Dp + i), _mm_packus_epi16(_acc0, _acc1));
+    }
+    for (; i+7<n; i+=8)
+    {
+        __m128i _acc = _mm_add_epi16(_mm_mulhi_epi16(_mm_loadu_si128((const __m128i*)(rows0p + i)), _b0), _mm_mulhi_epi16(_mm_loadu_si128((const __m128i*)(rows1p + i)), _b1));
+
+        _acc = _mm_srai_epi16(_mm_add_epi16(_acc, _v2), 2);
+
+        _mm_storel_epi64((__m128i*)(Dp + i), _mm_packus_epi16(_acc, _acc));
+    }
+}
+#endif // __SSE2__
+
+// source pixel offsets and 11bit fixed point weights of bilinear resize
+// xofs is in bytes of cn channels, yofs is the source row index
+static void resize_bilinear_coeffs(int srcw, int srch, int w, int h, int cn, int* xofs, int* yofs, short* ialpha, short* ibeta)
 {
     const int INTER_RESIZE_COEF_BITS=11;
     const int INTER_RESIZE_COEF_SCALE=1 << INTER_RESIZE_COEF_BITS;
@@ -33,14 +142,6 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
     double scale_x = (double)srcw / w;
     double scale_y = (double)srch / h;
 
-    int* buf = new int[w + h + w + h];
-
-    int* xofs = buf;//new int[w];
-    int* yofs = buf + w;//new int[h];
-
-    short* ialpha = (short*)(buf + w + h);//new short[w * 2];
-    short* ibeta = (short*)(buf + w + h + w);//new short[h * 2];
-
     float fx;
     float fy;
     int sx;
@@ -65,7 +166,7 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
             fx = 1.f;
         }
 
-        xofs[dx] = sx;
+        xofs[dx] = sx*cn;
 
         float a0 = (1.f - fx) * INTER_RESIZE_COEF_SCALE;
         float a1 =        fx  * INTER_RESIZE_COEF_SCALE;
@@ -101,6 +202,11 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
     }
 
 #undef SATURATE_CAST_SHORT
+}
+
+static void resize_bilinear_c1_rows(const unsigned char* src, int srcstride, unsigned char* dst, int w, int stride, const int* xofs, const int* yofs, const short* ialpha, const short* ibeta, int dy_start, int dy_end)
+{
+    ibeta += dy_start * 2;
 
     // loop body
     Mat rowsbuf0(w, (size_t)2u);
@@ -110,7 +216,7 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
 
     int prev_sy1 = -2;
 
-    for (int dy = 0; dy < h; dy++ )
+    for (int dy = dy_start; dy < dy_end; dy++ )
     {
         int sy = yofs[dy];
 
@@ -124,11 +230,20 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
             short* rows0_old = rows0;
             rows0 = rows1;
             rows1 = rows0_old;
-            const unsigned char *S1 = src + srcw * (sy+1);
+            const unsigned char *S1 = src + srcstride * (sy+1);
 
             const short* ialphap = ialpha;
             short* rows1p = rows1;
-            for ( int dx = 0; dx < w; dx++ )
+            int dx = 0;
+#if __SSE2__
+            for (; dx+7<w; dx+=8)
+            {
+                hresize_bilinear_c1_sse(S1, xofs + dx, ialphap, rows1p + dx);
+
+                ialphap += 16;
+            }
+#endif // __SSE2__
+            for ( ; dx < w; dx++ )
             {
                 int sx = xofs[dx];
                 short a0 = ialphap[0];
@@ -143,13 +258,23 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
         else
         {
             // hresize two rows
-            const unsigned char *S0 = src + srcw * (sy);
-            const unsigned char *S1 = src + srcw * (sy+1);
+            const unsigned char *S0 = src + srcstride * (sy);
+            const unsigned char *S1 = src + srcstride * (sy+1);
 
             const short* ialphap = ialpha;
             short* rows0p = rows0;
             short* rows1p = rows1;
-            for ( int dx = 0; dx < w; dx++ )
+            int dx = 0;
+#if __SSE2__
+            for (; dx+7<w; dx+=8)
+            {
+                hresize_bilinear_c1_sse(S0, xofs + dx, ialphap, rows0p + dx);
+                hresize_bilinear_c1_sse(S1, xofs + dx, ialphap, rows1p + dx);
+
+                ialphap += 16;
+            }
+#endif // __SSE2__
+            for ( ; dx < w; dx++ )
             {
                 int sx = xofs[dx];
                 short a0 = ialphap[0];
@@ -172,10 +297,12 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
 
         short* rows0p = rows0;
         short* rows1p = rows1;
-        unsigned char* Dp = dst + w * (dy);
+        unsigned char* Dp = dst + stride * (dy - dy_start);
 
 #if __ARM_NEON
         int nn = w >> 3;
+#elif __SSE2__
+        int nn = w >> 3;
 #else
         int nn = 0;
 #endif
@@ -267,6 +394,13 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
         }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+        vresize_bilinear_sse(rows0p, rows1p, Dp, nn << 3, b0, b1);
+
+        rows0p += nn << 3;
+        rows1p += nn << 3;
+        Dp += nn << 3;
+#endif // __SSE2__
         for ( ; remain; --remain )
         {
 //             D[x] = (rows0[x]*b0 + rows1[x]*b1) >> INTER_RESIZE_COEF_BITS;
@@ -276,18 +410,15 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned c
         ibeta += 2;
     }
 
-    delete[] buf;
 }
 
-void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h)
+void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h)
 {
-    const int INTER_RESIZE_COEF_BITS=11;
-    const int INTER_RESIZE_COEF_SCALE=1 << INTER_RESIZE_COEF_BITS;
-//     const int ONE=INTER_RESIZE_COEF_SCALE;
-
-    double scale_x = (double)srcw / w;
-    double scale_y = (double)srch / h;
+    resize_bilinear_c1(src, srcw, srch, dst, w, h, 1);
+}
 
+void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads)
+{
     int* buf = new int[w + h + w + h];
 
     int* xofs = buf;//new int[w];
@@ -296,66 +427,27 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
     short* ialpha = (short*)(buf + w + h);//new short[w * 2];
     short* ibeta = (short*)(buf + w + h + w);//new short[h * 2];
 
-    float fx;
-    float fy;
-    int sx;
-    int sy;
+    resize_bilinear_coeffs(srcw, srch, w, h, 1, xofs, yofs, ialpha, ibeta);
 
-#define SATURATE_CAST_SHORT(X) (short)::std::min(::std::max((int)(X + (X >= 0.f ? 0.5f : -0.5f)), SHRT_MIN), SHRT_MAX);
+    // split the output rows into bands, each band keeps its own row buffers
+    // and hresizes at most one source row pair more than a single pass
+    int nbands = std::max(std::min(num_threads, h), 1);
 
-    for (int dx = 0; dx < w; dx++)
+    #pragma omp parallel for num_threads(num_threads)
+    for (int b=0; b<nbands; b++)
     {
-        fx = (float)((dx + 0.5) * scale_x - 0.5);
-        sx = floor(fx);
-        fx -= sx;
-
-        if (sx < 0)
-        {
-            sx = 0;
-            fx = 0.f;
-        }
-        if (sx >= srcw - 1)
-        {
-            sx = srcw - 2;
-            fx = 1.f;
-        }
-
-        xofs[dx] = sx*2;
-
-        float a0 = (1.f - fx) * INTER_RESIZE_COEF_SCALE;
-        float a1 =        fx  * INTER_RESIZE_COEF_SCALE;
+        int dy_start = h * b / nbands;
+        int dy_end = h * (b + 1) / nbands;
 
-        ialpha[dx*2    ] = SATURATE_CAST_SHORT(a0);
-        ialpha[dx*2 + 1] = SATURATE_CAST_SHORT(a1);
+        resize_bilinear_c1_rows(src, srcw, dst + w * dy_start, w, w, xofs, yofs, ialpha, ibeta, dy_start, dy_end);
     }
 
-    for (int dy = 0; dy < h; dy++)
-    {
-        fy = (float)((dy + 0.5) * scale_y - 0.5);
-        sy = floor(fy);
-        fy -= sy;
-
-        if (sy < 0)
-        {
-            sy = 0;
-            fy = 0.f;
-        }
-        if (sy >= srch - 1)
-        {
-            sy = srch - 2;
-            fy = 1.f;
-        }
-
-        yofs[dy] = sy*2;
-
-        float b0 = (1.f - fy) * INTER_RESIZE_COEF_SCALE;
-        float b1 =        fy  * INTER_RESIZE_COEF_SCALE;
-
-        ibeta[dy*2    ] = SATURATE_CAST_SHORT(b0);
-        ibeta[dy*2 + 1] = SATURATE_CAST_SHORT(b1);
-    }
+    delete[] buf;
+}
 
-#undef SATURATE_CAST_SHORT
+static void resize_bilinear_c2_rows(const unsigned char* src, int srcstride, unsigned char* dst, int w, int stride, const int* xofs, const int* yofs, const short* ialpha, const short* ibeta, int dy_start, int dy_end)
+{
+    ibeta += dy_start * 2;
 
     // loop body
     Mat rowsbuf0(w*2+2, (size_t)2u);
@@ -363,9 +455,9 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
     short* rows0 = (short*)rowsbuf0.data;
     short* rows1 = (short*)rowsbuf1.data;
 
-    int prev_sy1 = -4;
+    int prev_sy1 = -2;
 
-    for (int dy = 0; dy < h; dy++ )
+    for (int dy = dy_start; dy < dy_end; dy++ )
     {
         int sy = yofs[dy];
 
@@ -373,13 +465,13 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
         {
             // reuse all rows
         }
-        else if (sy == prev_sy1 + 2)
+        else if (sy == prev_sy1 + 1)
         {
             // hresize one row
             short* rows0_old = rows0;
             rows0 = rows1;
             rows1 = rows0_old;
-            const unsigned char *S1 = src + srcw * (sy+2);
+            const unsigned char *S1 = src + srcstride * (sy+1);
 
             const short* ialphap = ialpha;
             short* rows1p = rows1;
@@ -405,6 +497,8 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
                 int32x4_t _rows1 = vcombine_s32(_rows1low, vget_high_s32(_S1ma0a1));
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                hresize_bilinear_c2_sse(S1p, ialphap, rows1p);
 #else
                 short a0 = ialphap[0];
                 short a1 = ialphap[1];
@@ -420,8 +514,8 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
         else
         {
             // hresize two rows
-            const unsigned char *S0 = src + srcw * (sy);
-            const unsigned char *S1 = src + srcw * (sy+2);
+            const unsigned char *S0 = src + srcstride * (sy);
+            const unsigned char *S1 = src + srcstride * (sy+1);
 
             const short* ialphap = ialpha;
             short* rows0p = rows0;
@@ -429,12 +523,12 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
             for ( int dx = 0; dx < w; dx++ )
             {
                 int sx = xofs[dx];
-                short a0 = ialphap[0];
-                short a1 = ialphap[1];
 
                 const unsigned char* S0p = S0 + sx;
                 const unsigned char* S1p = S1 + sx;
 #if __ARM_NEON
+                short a0 = ialphap[0];
+                short a1 = ialphap[1];
                 int16x4_t _a0 = vdup_n_s16(a0);
                 int16x4_t _a1 = vdup_n_s16(a1);
                 uint8x8_t _S0 = uint8x8_t();
@@ -461,7 +555,13 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
                 int16x4_t _rows1_sr4 = vext_s16(_rows01_sr4, _rows01_sr4, 2);
                 vst1_s16(rows0p, _rows01_sr4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                hresize_bilinear_c2_sse(S0p, ialphap, rows0p);
+                hresize_bilinear_c2_sse(S1p, ialphap, rows1p);
 #else
+                short a0 = ialphap[0];
+                short a1 = ialphap[1];
+
                 rows0p[0] = (S0p[0]*a0 + S0p[2]*a1) >> 4;
                 rows0p[1] = (S0p[1]*a0 + S0p[3]*a1) >> 4;
                 rows1p[0] = (S1p[0]*a0 + S1p[2]*a1) >> 4;
@@ -482,10 +582,12 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
 
         short* rows0p = rows0;
         short* rows1p = rows1;
-        unsigned char* Dp = dst + w * 2 * (dy);
+        unsigned char* Dp = dst + stride * (dy - dy_start);
 
 #if __ARM_NEON
         int nn = (w * 2) >> 3;
+#elif __SSE2__
+        int nn = (w * 2) >> 3;
 #else
         int nn = 0;
 #endif
@@ -577,6 +679,13 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
         }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+        vresize_bilinear_sse(rows0p, rows1p, Dp, nn << 3, b0, b1);
+
+        rows0p += nn << 3;
+        rows1p += nn << 3;
+        Dp += nn << 3;
+#endif // __SSE2__
         for ( ; remain; --remain )
         {
 //             D[x] = (rows0[x]*b0 + rows1[x]*b1) >> INTER_RESIZE_COEF_BITS;
@@ -586,18 +695,15 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned c
         ibeta += 2;
     }
 
-    delete[] buf;
 }
 
-void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h)
+void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h)
 {
-    const int INTER_RESIZE_COEF_BITS=11;
-    const int INTER_RESIZE_COEF_SCALE=1 << INTER_RESIZE_COEF_BITS;
-//     const int ONE=INTER_RESIZE_COEF_SCALE;
-
-    double scale_x = (double)srcw / w;
-    double scale_y = (double)srch / h;
+    resize_bilinear_c2(src, srcw, srch, dst, w, h, 1);
+}
 
+void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads)
+{
     int* buf = new int[w + h + w + h];
 
     int* xofs = buf;//new int[w];
@@ -606,66 +712,27 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned c
     short* ialpha = (short*)(buf + w + h);//new short[w * 2];
     short* ibeta = (short*)(buf + w + h + w);//new short[h * 2];
 
-    float fx;
-    float fy;
-    int sx;
-    int sy;
+    resize_bilinear_coeffs(srcw, srch, w, h, 2, xofs, yofs, ialpha, ibeta);
 
-#define SATURATE_CAST_SHORT(X) (short)::std::min(::std::max((int)(X + (X >= 0.f ? 0.5f : -0.5f)), SHRT_MIN), SHRT_MAX);
+    // split the output rows into bands, each band keeps its own row buffers
+    // and hresizes at most one source row pair more than a single pass
+    int nbands = std::max(std::min(num_threads, h), 1);
 
-    for (int dx = 0; dx < w; dx++)
+    #pragma omp parallel for num_threads(num_threads)
+    for (int b=0; b<nbands; b++)
     {
-        fx = (float)((dx + 0.5) * scale_x - 0.5);
-        sx = floor(fx);
-        fx -= sx;
-
-        if (sx < 0)
-        {
-            sx = 0;
-            fx = 0.f;
-        }
-        if (sx >= srcw - 1)
-        {
-            sx = srcw - 2;
-            fx = 1.f;
-        }
-
-        xofs[dx] = sx*3;
-
-        float a0 = (1.f - fx) * INTER_RESIZE_COEF_SCALE;
-        float a1 =        fx  * INTER_RESIZE_COEF_SCALE;
+        int dy_start = h * b / nbands;
+        int dy_end = h * (b + 1) / nbands;
 
-        ialpha[dx*2    ] = SATURATE_CAST_SHORT(a0);
-        ialpha[dx*2 + 1] = SATURATE_CAST_SHORT(a1);
+        resize_bilinear_c2_rows(src, srcw * 2, dst + w * 2 * dy_start, w, w * 2, xofs, yofs, ialpha, ibeta, dy_start, dy_end);
     }
 
-    for (int dy = 0; dy < h; dy++)
-    {
-        fy = (float)((dy + 0.5) * scale_y - 0.5);
-        sy = floor(fy);
-        fy -= sy;
-
-        if (sy < 0)
-        {
-            sy = 0;
-            fy = 0.f;
-        }
-        if (sy >= srch - 1)
-        {
-            sy = srch - 2;
-            fy = 1.f;
-        }
-
-        yofs[dy] = sy*3;
-
-        float b0 = (1.f - fy) * INTER_RESIZE_COEF_SCALE;
-        float b1 =        fy  * INTER_RESIZE_COEF_SCALE;
-
-        ibeta[dy*2    ] = SATURATE_CAST_SHORT(b0);
-        ibeta[dy*2 + 1] = SATURATE_CAST_SHORT(b1);
-    }
+    delete[] buf;
+}
 
-#undef SATURATE_CAST_SHORT
+static void resize_bilinear_c3_rows(const unsigned char* src, int srcw, int srcstride, unsigned char* dst, int w, int stride, const int* xofs, const int* yofs, const short* ialpha, const short* ibeta, int dy_start, int dy_end)
+{
+    ibeta += dy_start * 2;
 
     // loop body
     Mat rowsbuf0(w*3+1, (size_t)2u);
@@ -673,9 +740,9 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned c
     short* rows0 = (short*)rowsbuf0.data;
     short* rows1 = (short*)rowsbuf1.data;
 
-    int prev_sy1 = -6;
+    int prev_sy1 = -2;
 
-    for (int dy = 0; dy < h; dy++ )
+    for (int dy = dy_start; dy < dy_end; dy++ )
     {
         int sy = yofs[dy];
 
@@ -683,13 +750,13 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned c
         {
             // reuse all rows
         }
-        else if (sy == prev_sy1 + 3)
+        else if (sy == prev_sy1 + 1)
         {
             // hresize one row
             short* rows0_old = rows0;
             rows0 = rows1;
             rows1 = rows0_old;
-            const unsigned char *S1 = src + srcw * (sy+3);
+            const unsigned char *S1 = src + srcstride * (sy+1);
 
             const short* ialphap = ialpha;
             short* rows1p = rows1;
@@ -719,6 +786,17 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned c
                 _rows1 = vmlal_s16(_rows1, _S1high, _a1);
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                if (sx + 8 <= srcw * 3)
+                {
+                    hresize_bilinear_c3_sse(S1p, ialphap, rows1p);
+                }
+                else
+                {
+                    rows1p[0] = (S1p[0]*a0 + S1p[3]*a1) >> 4;
+                    rows1p[1] = (S1p[1]*a0 + S1p[4]*a1) >> 4;
+                    rows1p[2] = (S1p[2]*a0 + S1p[5]*a1) >> 4;
+                }
 #else
                 rows1p[0] = (S1p[0]*a0 + S1p[3]*a1) >> 4;
                 rows1p[1] = (S1p[1]*a0 + S1p[4]*a1) >> 4;
@@ -732,8 +810,8 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned c
         else
         {
             // hresize two rows
-            const unsigned char *S0 = src + srcw * (sy);
-            const unsigned char *S1 = src + srcw * (sy+3);
+            const unsigned char *S0 = src + srcstride * (sy);
+            const unsigned char *S1 = src + srcstride * (sy+1);
 
             const short* ialphap = ialpha;
             short* rows0p = rows0;
@@ -780,6 +858,22 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned c
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows0p, _rows0_sr4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                // the last pixel pair of a row may not have 8 bytes to read
+                if (sx + 8 <= srcw * 3)
+                {
+                    hresize_bilinear_c3_sse(S0p, ialphap, rows0p);
+                    hresize_bilinear_c3_sse(S1p, ialphap, rows1p);
+                }
+                else
+                {
+                    rows0p[0] = (S0p[0]*a0 + S0p[3]*a1) >> 4;
+                    rows0p[1] = (S0p[1]*a0 + S0p[4]*a1) >> 4;
+                    rows0p[2] = (S0p[2]*a0 + S0p[5]*a1) >> 4;
+                    rows1p[0] = (S1p[0]*a0 + S1p[3]*a1) >> 4;
+                    rows1p[1] = (S1p[1]*a0 + S1p[4]*a1) >> 4;
+                    rows1p[2] = (S1p[2]*a0 + S1p[5]*a1) >> 4;
+                }
 #else
                 rows0p[0] = (S0p[0]*a0 + S0p[3]*a1) >> 4;
                 rows0p[1] = (S0p[1]*a0 + S0p[4]*a1) >> 4;
@@ -803,10 +897,12 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned c
 
         short* rows0p = rows0;
         short* rows1p = rows1;
-        unsigned char* Dp = dst + w * 3 * (dy);
+        unsigned char* Dp = dst + stride * (dy - dy_start);
 
 #if __ARM_NEON
         int nn = (w * 3) >> 3;
+#elif __SSE2__
+        int nn = (w * 3) >> 3;
 #else
         int nn = 0;
 #endif
@@ -898,6 +994,13 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned c
         }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+        vresize_bilinear_sse(rows0p, rows1p, Dp, nn << 3, b0, b1);
+
+        rows0p += nn << 3;
+        rows1p += nn << 3;
+        Dp += nn << 3;
+#endif // __SSE2__
         for ( ; remain; --remain )
         {
 //             D[x] = (rows0[x]*b0 + rows1[x]*b1) >> INTER_RESIZE_COEF_BITS;
@@ -907,18 +1010,15 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned c
         ibeta += 2;
     }
 
-    delete[] buf;
 }
 
-void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h)
+void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h)
 {
-    const int INTER_RESIZE_COEF_BITS=11;
-    const int INTER_RESIZE_COEF_SCALE=1 << INTER_RESIZE_COEF_BITS;
-//     const int ONE=INTER_RESIZE_COEF_SCALE;
-
-    double scale_x = (double)srcw / w;
-    double scale_y = (double)srch / h;
+    resize_bilinear_c3(src, srcw, srch, dst, w, h, 1);
+}
 
+void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads)
+{
     int* buf = new int[w + h + w + h];
 
     int* xofs = buf;//new int[w];
@@ -927,66 +1027,27 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
     short* ialpha = (short*)(buf + w + h);//new short[w * 2];
     short* ibeta = (short*)(buf + w + h + w);//new short[h * 2];
 
-    float fx;
-    float fy;
-    int sx;
-    int sy;
+    resize_bilinear_coeffs(srcw, srch, w, h, 3, xofs, yofs, ialpha, ibeta);
 
-#define SATURATE_CAST_SHORT(X) (short)::std::min(::std::max((int)(X + (X >= 0.f ? 0.5f : -0.5f)), SHRT_MIN), SHRT_MAX);
+    // split the output rows into bands, each band keeps its own row buffers
+    // and hresizes at most one source row pair more than a single pass
+    int nbands = std::max(std::min(num_threads, h), 1);
 
-    for (int dx = 0; dx < w; dx++)
+    #pragma omp parallel for num_threads(num_threads)
+    for (int b=0; b<nbands; b++)
     {
-        fx = (float)((dx + 0.5) * scale_x - 0.5);
-        sx = floor(fx);
-        fx -= sx;
+        int dy_start = h * b / nbands;
+        int dy_end = h * (b + 1) / nbands;
 
-        if (sx < 0)
-        {
-            sx = 0;
-            fx = 0.f;
-        }
-        if (sx >= srcw - 1)
-        {
-            sx = srcw - 2;
-            fx = 1.f;
-        }
-
-        xofs[dx] = sx*4;
-
-        float a0 = (1.f - fx) * INTER_RESIZE_COEF_SCALE;
-        float a1 =        fx  * INTER_RESIZE_COEF_SCALE;
-
-        ialpha[dx*2    ] = SATURATE_CAST_SHORT(a0);
-        ialpha[dx*2 + 1] = SATURATE_CAST_SHORT(a1);
+        resize_bilinear_c3_rows(src, srcw, srcw * 3, dst + w * 3 * dy_start, w, w * 3, xofs, yofs, ialpha, ibeta, dy_start, dy_end);
     }
 
-    for (int dy = 0; dy < h; dy++)
-    {
-        fy = (float)((dy + 0.5) * scale_y - 0.5);
-        sy = floor(fy);
-        fy -= sy;
-
-        if (sy < 0)
-        {
-            sy = 0;
-            fy = 0.f;
-        }
-        if (sy >= srch - 1)
-        {
-            sy = srch - 2;
-            fy = 1.f;
-        }
-
-        yofs[dy] = sy*4;
-
-        float b0 = (1.f - fy) * INTER_RESIZE_COEF_SCALE;
-        float b1 =        fy  * INTER_RESIZE_COEF_SCALE;
-
-        ibeta[dy*2    ] = SATURATE_CAST_SHORT(b0);
-        ibeta[dy*2 + 1] = SATURATE_CAST_SHORT(b1);
-    }
+    delete[] buf;
+}
 
-#undef SATURATE_CAST_SHORT
+static void resize_bilinear_c4_rows(const unsigned char* src, int srcstride, unsigned char* dst, int w, int stride, const int* xofs, const int* yofs, const short* ialpha, const short* ibeta, int dy_start, int dy_end)
+{
+    ibeta += dy_start * 2;
 
     // loop body
     Mat rowsbuf0(w*4, (size_t)2u);
@@ -994,9 +1055,9 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
     short* rows0 = (short*)rowsbuf0.data;
     short* rows1 = (short*)rowsbuf1.data;
 
-    int prev_sy1 = -8;
+    int prev_sy1 = -2;
 
-    for (int dy = 0; dy < h; dy++ )
+    for (int dy = dy_start; dy < dy_end; dy++ )
     {
         int sy = yofs[dy];
 
@@ -1004,24 +1065,24 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
         {
             // reuse all rows
         }
-        else if (sy == prev_sy1 + 4)
+        else if (sy == prev_sy1 + 1)
         {
             // hresize one row
             short* rows0_old = rows0;
             rows0 = rows1;
             rows1 = rows0_old;
-            const unsigned char *S1 = src + srcw * (sy+4);
+            const unsigned char *S1 = src + srcstride * (sy+1);
 
             const short* ialphap = ialpha;
             short* rows1p = rows1;
             for ( int dx = 0; dx < w; dx++ )
             {
                 int sx = xofs[dx];
-                short a0 = ialphap[0];
-                short a1 = ialphap[1];
 
                 const unsigned char* S1p = S1 + sx;
 #if __ARM_NEON
+                short a0 = ialphap[0];
+                short a1 = ialphap[1];
                 int16x4_t _a0 = vdup_n_s16(a0);
                 int16x4_t _a1 = vdup_n_s16(a1);
                 uint8x8_t _S1 = vld1_u8(S1p);
@@ -1032,7 +1093,12 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
                 _rows1 = vmlal_s16(_rows1, _S1high, _a1);
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                hresize_bilinear_c4_sse(S1p, ialphap, rows1p);
 #else
+                short a0 = ialphap[0];
+                short a1 = ialphap[1];
+
                 rows1p[0] = (S1p[0]*a0 + S1p[4]*a1) >> 4;
                 rows1p[1] = (S1p[1]*a0 + S1p[5]*a1) >> 4;
                 rows1p[2] = (S1p[2]*a0 + S1p[6]*a1) >> 4;
@@ -1046,8 +1112,8 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
         else
         {
             // hresize two rows
-            const unsigned char *S0 = src + srcw * (sy);
-            const unsigned char *S1 = src + srcw * (sy+4);
+            const unsigned char *S0 = src + srcstride * (sy);
+            const unsigned char *S1 = src + srcstride * (sy+1);
 
             const short* ialphap = ialpha;
             short* rows0p = rows0;
@@ -1055,12 +1121,12 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
             for ( int dx = 0; dx < w; dx++ )
             {
                 int sx = xofs[dx];
-                short a0 = ialphap[0];
-                short a1 = ialphap[1];
 
                 const unsigned char* S0p = S0 + sx;
                 const unsigned char* S1p = S1 + sx;
 #if __ARM_NEON
+                short a0 = ialphap[0];
+                short a1 = ialphap[1];
                 int16x4_t _a0 = vdup_n_s16(a0);
                 int16x4_t _a1 = vdup_n_s16(a1);
                 uint8x8_t _S0 = vld1_u8(S0p);
@@ -1079,7 +1145,13 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows0p, _rows0_sr4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                hresize_bilinear_c4_sse(S0p, ialphap, rows0p);
+                hresize_bilinear_c4_sse(S1p, ialphap, rows1p);
 #else
+                short a0 = ialphap[0];
+                short a1 = ialphap[1];
+
                 rows0p[0] = (S0p[0]*a0 + S0p[4]*a1) >> 4;
                 rows0p[1] = (S0p[1]*a0 + S0p[5]*a1) >> 4;
                 rows0p[2] = (S0p[2]*a0 + S0p[6]*a1) >> 4;
@@ -1104,10 +1176,12 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
 
         short* rows0p = rows0;
         short* rows1p = rows1;
-        unsigned char* Dp = dst + w * 4 * (dy);
+        unsigned char* Dp = dst + stride * (dy - dy_start);
 
 #if __ARM_NEON
         int nn = (w * 4) >> 3;
+#elif __SSE2__
+        int nn = (w * 4) >> 3;
 #else
         int nn = 0;
 #endif
@@ -1199,6 +1273,13 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
         }
 #endif // __aarch64__
 #endif // __ARM_NEON
+#if __SSE2__
+        vresize_bilinear_sse(rows0p, rows1p, Dp, nn << 3, b0, b1);
+
+        rows0p += nn << 3;
+        rows1p += nn << 3;
+        Dp += nn << 3;
+#endif // __SSE2__
         for ( ; remain; --remain )
         {
 //             D[x] = (rows0[x]*b0 + rows1[x]*b1) >> INTER_RESIZE_COEF_BITS;
@@ -1208,10 +1289,47 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned c
         ibeta += 2;
     }
 
+}
+
+void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h)
+{
+    resize_bilinear_c4(src, srcw, srch, dst, w, h, 1);
+}
+
+void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads)
+{
+    int* buf = new int[w + h + w + h];
+
+    int* xofs = buf;//new int[w];
+    int* yofs = buf + w;//new int[h];
+
+    short* ialpha = (short*)(buf + w + h);//new short[w * 2];
+    short* ibeta = (short*)(buf + w + h + w);//new short[h * 2];
+
+    resize_bilinear_coeffs(srcw, srch, w, h, 4, xofs, yofs, ialpha, ibeta);
+
+    // split the output rows into bands, each band keeps its own row buffers
+    // and hresizes at most one source row pair more than a single pass
+    int nbands = std::max(std::min(num_threads, h), 1);
+
+    #pragma omp parallel for num_threads(num_threads)
+    for (int b=0; b<nbands; b++)
+    {
+        int dy_start = h * b / nbands;
+        int dy_end = h * (b + 1) / nbands;
+
+        resize_bilinear_c4_rows(src, srcw * 4, dst + w * 4 * dy_start, w, w * 4, xofs, yofs, ialpha, ibeta, dy_start, dy_end);
+    }
+
     delete[] buf;
 }
 
 void resize_bilinear_yuv420sp(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h)
+{
+    resize_bilinear_yuv420sp(src, srcw, srch, dst, w, h, 1);
+}
+
+void resize_bilinear_yuv420sp(const unsigned char* src, int srcw, int srch, unsigned char* dst, int w, int h, int num_threads)
 {
     // assert srcw % 2 == 0
     // assert srch % 2 == 0
@@ -1220,11 +1338,600 @@ void resize_bilinear_yuv420sp(const unsigned char* src, int srcw, int srch, unsi
 
     const unsigned char* srcY = src;
     unsigned char* dstY = dst;
-    resize_bilinear_c1(srcY, srcw, srch, dstY, w, h);
+    resize_bilinear_c1(srcY, srcw, srch, dstY, w, h, num_threads);
 
     const unsigned char* srcUV = src + srcw * srch;
     unsigned char* dstUV = dst + w * h;
-    resize_bilinear_c2(srcUV, srcw / 2, srch / 2, dstUV, w / 2, h / 2);
+    resize_bilinear_c2(srcUV, srcw / 2, srch / 2, dstUV, w / 2, h / 2, num_threads);
+}
+
+// out channel q of pixel x is rowp[x * cn + chan[q]] * norm[q] + bias[q], stored at outptr[q][x * elempack]
+static void from_pixels_row_normalize(const unsigned char* rowp, int cn, int w, const int* chan, int outc, float* const* outptr, int elempack, const float* norm, const float* bias)
+{
+    if (outc == cn && elempack == cn && (cn == 1 || (chan[0] == 0 && chan[1] == 1 && chan[2] == 2 && chan[3] == 3)))
+    {
+        // the output is laid out like the pixels, convert the whole row with coefficients repeating every cn
+        float* ptr = outptr[0];
+
+        int size = w * cn;
+        int i = 0;
+#if __SSE2__
+        const __m128i _zero = _mm_setzero_si128();
+        __m128 _norm = cn == 1 ? _mm_set1_ps(norm[0]) : _mm_loadu_ps(norm);
+        __m128 _bias = cn == 1 ? _mm_set1_ps(bias[0]) : _mm_loadu_ps(bias);
+        for (; i+15<size; i+=16)
+        {
+            __m128i _p = _mm_loadu_si128((const __m128i*)(rowp + i));
+            __m128i _pl = _mm_unpacklo_epi8(_p, _zero);
+            __m128i _ph = _mm_unpackhi_epi8(_p, _zero);
+
+            _mm_storeu_ps(ptr + i, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_pl, _zero)), _norm), _bias));
+            _mm_storeu_ps(ptr + i + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(_pl, _zero)), _norm), _bias));
+            _mm_storeu_ps(ptr + i + 8, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_ph, _zero)), _norm), _bias));
+            _mm_storeu_ps(ptr + i + 12, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(_ph, _zero)), _norm), _bias));
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            ptr[i] = rowp[i] * norm[i % cn] + bias[i % cn];
+        }
+
+        return;
+    }
+
+    int x = 0;
+#if __SSE2__
+    if (elempack == 1 && (cn == 3 || cn == 4))
+    {
+        // one pixel per 32bit lane, each channel is shifted down and masked out
+        const __m128i _mask = _mm_set1_epi32(0xff);
+
+        __m128i _shift[4];
+        __m128 _norm[4];
+        __m128 _bias[4];
+        for (int q=0; q<outc; q++)
+        {
+            _shift[q] = _mm_cvtsi32_si128(chan[q] * 8);
+            _norm[q] = _mm_set1_ps(norm[q]);
+            _bias[q] = _mm_set1_ps(bias[q]);
+        }
+
+        // the 3 channel gather reads one byte past pixel x+3
+        for (; x+4<w; x+=4)
+        {
+            const unsigned char* p = rowp + x * cn;
+
+            __m128i _p;
+            if (cn == 4)
+                _p = _mm_loadu_si128((const __m128i*)p);
+            else
+                _p = _mm_setr_epi32(*(const int*)p, *(const int*)(p + 3), *(const int*)(p + 6), *(const int*)(p + 9));
+
+            for (int q=0; q<outc; q++)
+            {
+                __m128 _v = _mm_cvtepi32_ps(_mm_and_si128(_mm_srl_epi32(_p, _shift[q]), _mask));
+                _mm_storeu_ps(outptr[q] + x, _mm_add_ps(_mm_mul_ps(_v, _norm[q]), _bias[q]));
+            }
+        }
+    }
+#endif // __SSE2__
+    for (int q=0; q<outc; q++)
+    {
+        const unsigned char* p = rowp + chan[q];
+        float* ptr = outptr[q];
+
+        const float n = norm[q];
+        const float b = bias[q];
+
+        for (int i=x; i<w; i++)
+        {
+            ptr[i * elempack] = p[i * cn] * n + b;
+        }
+    }
+}
+
+// color conversion, mean and normalize of the fused from_pixels functions
+struct from_pixels_normalize_param
+{
+    // source channel count and red channel index
+    int cn;
+    int r;
+
+    // source channel of each output channel
+    int outc;
+    int chan[4];
+    bool to_gray;
+
+    float norm[4];
+    float bias[4];
+};
+
+static bool from_pixels_normalize_setup(int type, const float* mean_vals, const float* norm_vals, from_pixels_normalize_param& p)
+{
+    int type_from = type & Mat::PIXEL_FORMAT_MASK;
+    int type_to = (type & Mat::PIXEL_CONVERT_MASK) ? (type >> Mat::PIXEL_CONVERT_SHIFT) : type_from;
+
+    if (type_from != Mat::PIXEL_RGB && type_from != Mat::PIXEL_BGR && type_from != Mat::PIXEL_GRAY && type_from != Mat::PIXEL_RGBA)
+        return false;
+
+    if (type_to == Mat::PIXEL_RGBA && type_from != Mat::PIXEL_RGBA)
+        return false;
+
+    p.cn = type_from == Mat::PIXEL_GRAY ? 1 : type_from == Mat::PIXEL_RGBA ? 4 : 3;
+    p.r = type_from == Mat::PIXEL_BGR ? 2 : 0;
+
+    p.outc = p.cn;
+    p.chan[0] = 0;
+    p.chan[1] = 1;
+    p.chan[2] = 2;
+    p.chan[3] = 3;
+    p.to_gray = false;
+
+    if (type_to == Mat::PIXEL_GRAY)
+    {
+        p.outc = 1;
+        p.to_gray = p.cn != 1;
+    }
+    else if (type_to == Mat::PIXEL_RGB || type_to == Mat::PIXEL_BGR)
+    {
+        p.outc = 3;
+
+        if (p.cn == 1)
+        {
+            p.chan[1] = 0;
+            p.chan[2] = 0;
+        }
+        else if (p.r != (type_to == Mat::PIXEL_BGR ? 2 : 0))
+        {
+            p.chan[0] = 2;
+            p.chan[2] = 0;
+        }
+    }
+
+    for (int q=0; q<p.outc; q++)
+    {
+        p.norm[q] = norm_vals ? norm_vals[q] : 1.f;
+        p.bias[q] = mean_vals ? -mean_vals[q] * p.norm[q] : 0.f;
+    }
+
+    return true;
+}
+
+static void from_pixels_normalize_create(const from_pixels_normalize_param& p, Mat& m, int w, int h, int elempack, Allocator* allocator)
+{
+    if ((elempack != 4 && elempack != 8) || p.outc % elempack != 0)
+        elempack = 1;
+
+    m.create(w, h, p.outc / elempack, 4u * elempack, elempack, allocator);
+}
+
+// convert the pixel rows dy0 to dy1 into m, row dy starts at rows + rowstride * (dy - dy0)
+static void from_pixels_rows_normalize(const unsigned char* rows, int rowstride, int dy0, int dy1, const from_pixels_normalize_param& p, Mat& m, Mat& graybuf)
+{
+    const int w = m.w;
+    const int elempack = m.elempack;
+
+    for (int dy = dy0; dy < dy1; dy++)
+    {
+        const unsigned char* rowp = rows + rowstride * (dy - dy0);
+        int rowcn = p.cn;
+
+        if (p.to_gray)
+        {
+            // coeffs for r g b = 0.299f, 0.587f, 0.114f
+            const unsigned char Y_shift = 8;//14
+            const unsigned char R2Y = 77;
+            const unsigned char G2Y = 150;
+            const unsigned char B2Y = 29;
+
+            graybuf.create(w, (size_t)1u);
+
+            unsigned char* grayp = graybuf;
+            for (int x=0; x<w; x++)
+            {
+                const unsigned char* ptr = rowp + x * p.cn;
+                grayp[x] = (ptr[p.r] * R2Y + ptr[1] * G2Y + ptr[2 - p.r] * B2Y) >> Y_shift;
+            }
+
+            rowp = grayp;
+            rowcn = 1;
+        }
+
+        float* outptr[4];
+        for (int q=0; q<p.outc; q++)
+        {
+            outptr[q] = m.channel(q / elempack).row(dy) + q % elempack;
+        }
+
+        from_pixels_row_normalize(rowp, rowcn, w, p.chan, p.outc, outptr, elempack, p.norm, p.bias);
+    }
+}
+
+Mat Mat::from_pixels_roi_resize_normalize(const unsigned char* pixels, int type, int w, int h, int stride, int roix, int roiy, int roiw, int roih, int target_width, int target_height, const float* mean_vals, const float* norm_vals, int elempack, Allocator* allocator, int num_threads)
+{
+    from_pixels_normalize_param p;
+    if (!from_pixels_normalize_setup(type, mean_vals, norm_vals, p))
+        return Mat();
+
+    if (roix < 0 || roiy < 0 || roiw <= 0 || roih <= 0 || roix + roiw > w || roiy + roih > h)
+        return Mat();
+
+    const int cn = p.cn;
+
+    Mat m;
+    from_pixels_normalize_create(p, m, target_width, target_height, elempack, allocator);
+    if (m.empty())
+        return m;
+
+    const unsigned char* src = pixels + roiy * stride + roix * cn;
+
+    const bool resize = roiw != target_width || roih != target_height;
+
+    int* buf = 0;
+    int* xofs = 0;
+    int* yofs = 0;
+    short* ialpha = 0;
+    short* ibeta = 0;
+    if (resize)
+    {
+        buf = new int[target_width + target_height + target_width + target_height];
+
+        xofs = buf;
+        yofs = buf + target_width;
+        ialpha = (short*)(buf + target_width + target_height);
+        ibeta = (short*)(buf + target_width + target_height + target_width);
+
+        resize_bilinear_coeffs(roiw, roih, target_width, target_height, cn, xofs, yofs, ialpha, ibeta);
+    }
+
+    // resized rows go through a small strip buffer that stays in cache
+    const int strip_rows = 16;
+
+    int nbands = std::max(std::min(num_threads, target_height), 1);
+
+    #pragma omp parallel for num_threads(num_threads)
+    for (int b=0; b<nbands; b++)
+    {
+        int dy_start = target_height * b / nbands;
+        int dy_end = target_height * (b + 1) / nbands;
+
+        if (!resize)
+        {
+            Mat graybuf;
+            from_pixels_rows_normalize(src + stride * dy_start, stride, dy_start, dy_end, p, m, graybuf);
+            continue;
+        }
+
+        Mat stripbuf(target_width * cn, strip_rows, (size_t)1u);
+        Mat graybuf;
+
+        for (int dy0 = dy_start; dy0 < dy_end; dy0 += strip_rows)
+        {
+            int dy1 = std::min(dy0 + strip_rows, dy_end);
+
+            if (cn == 1)
+                resize_bilinear_c1_rows(src, stride, stripbuf, target_width, target_width, xofs, yofs, ialpha, ibeta, dy0, dy1);
+            if (cn == 3)
+                resize_bilinear_c3_rows(src, roiw, stride, stripbuf, target_width, target_width * 3, xofs, yofs, ialpha, ibeta, dy0, dy1);
+            if (cn == 4)
+                resize_bilinear_c4_rows(src, stride, stripbuf, target_width, target_width * 4, xofs, yofs, ialpha, ibeta, dy0, dy1);
+
+            from_pixels_rows_normalize(stripbuf, target_width * cn, dy0, dy1, p, m, graybuf);
+        }
+    }
+
+    delete[] buf;
+
+    return m;
+}
+
+Mat Mat::from_pixels_warpaffine_normalize(const unsigned char* pixels, int type, int w, int h, int stride, const float* tm, int target_width, int target_height, int border_type, unsigned int border_value, const float* mean_vals, const float* norm_vals, int elempack, Allocator* allocator, int num_threads)
+{
+    from_pixels_normalize_param p;
+    if (!from_pixels_normalize_setup(type, mean_vals, norm_vals, p))
+        return Mat();
+
+    const int cn = p.cn;
+
+    Mat m;
+    from_pixels_normalize_create(p, m, target_width, target_height, elempack, allocator);
+    if (m.empty())
+        return m;
+
+    // warped rows go through a small strip buffer that stays in cache
+    const int strip_rows = 16;
+
+    int nbands = std::max(std::min(num_threads, target_height), 1);
+
+    #pragma omp parallel for num_threads(num_threads)
+    for (int b=0; b<nbands; b++)
+    {
+        int dy_start = target_height * b / nbands;
+        int dy_end = target_height * (b + 1) / nbands;
+
+        Mat stripbuf(target_width * cn, strip_rows, (size_t)1u);
+        Mat graybuf;
+
+        for (int dy0 = dy_start; dy0 < dy_end; dy0 += strip_rows)
+        {
+            int dy1 = std::min(dy0 + strip_rows, dy_end);
+
+            // the strip starts at output row dy0
+            float tm_strip[6];
+            tm_strip[0] = tm[0];
+            tm_strip[1] = tm[1];
+            tm_strip[2] = tm[1] * dy0 + tm[2];
+            tm_strip[3] = tm[3];
+            tm_strip[4] = tm[4];
+            tm_strip[5] = tm[4] * dy0 + tm[5];
+
+            if (cn == 1)
+                warpaffine_bilinear_c1(pixels, w, h, stride, stripbuf, target_width, dy1 - dy0, target_width, tm_strip, border_type, border_value, 1);
+            if (cn == 3)
+                warpaffine_bilinear_c3(pixels, w, h, stride, stripbuf, target_width, dy1 - dy0, target_width * 3, tm_strip, border_type, border_value, 1);
+            if (cn == 4)
+                warpaffine_bilinear_c4(pixels, w, h, stride, stripbuf, target_width, dy1 - dy0, target_width * 4, tm_strip, border_type, border_value, 1);
+
+            from_pixels_rows_normalize(stripbuf, target_width * cn, dy0, dy1, p, m, graybuf);
+        }
+    }
+
+    return m;
+}
+
+Mat Mat::from_pixels_roi_resize(const unsigned char* pixels, int type, int w, int h, int stride, int roix, int roiy, int roiw, int roih, int target_width, int target_height, Allocator* allocator, int num_threads)
+{
+    return from_pixels_roi_resize_normalize(pixels, type, w, h, stride, roix, roiy, roiw, roih, target_width, target_height, 0, 0, 1, allocator, num_threads);
+}
+
+void Mat::from_pixels_roi_resize_batch(const unsigned char* pixels, int type, int w, int h, int stride, const int* rois, int count, int target_width, int target_height, Mat* mats, Allocator* allocator, int num_threads)
+{
+    // one region per thread, which scales better than splitting the rows of small crops
+    #pragma omp parallel for num_threads(num_threads)
+    for (int i=0; i<count; i++)
+    {
+        const int* roi = rois + i * 4;
+
+        mats[i] = from_pixels_roi_resize(pixels, type, w, h, stride, roi[0], roi[1], roi[2], roi[3], target_width, target_height, allocator, 1);
+    }
+}
+
+// convert one row of resized luma and chroma samples to rgb floats, r g b go to outptr[0] [1] [2]
+// chroma samples are up[x * uvstep] and vp[x * uvstep]
+static void yuv420_row_normalize(const unsigned char* yp, const unsigned char* up, const unsigned char* vp, int uvstep, int w, float* const* outptr, const float* norm, const float* bias)
+{
+    float* rptr = outptr[0];
+    float* gptr = outptr[1];
+    float* bptr = outptr[2];
+
+    int x = 0;
+#if __SSE2__
+    const __m128i _zero = _mm_setzero_si128();
+    const __m128i _mask = _mm_set1_epi16(0x00ff);
+    const __m128i _v128 = _mm_set1_epi16(128);
+    const __m128i _v255 = _mm_set1_epi16(255);
+    const __m128i _v90 = _mm_set1_epi16(90);
+    const __m128i _vn46 = _mm_set1_epi16(-46);
+    const __m128i _vn22 = _mm_set1_epi16(-22);
+    const __m128i _v113 = _mm_set1_epi16(113);
+
+    float* ptrs[3] = { rptr, gptr, bptr };
+    __m128 _norm[3];
+    __m128 _bias[3];
+    for (int k=0; k<3; k++)
+    {
+        _norm[k] = _mm_set1_ps(norm[k]);
+        _bias[k] = _mm_set1_ps(bias[k]);
+    }
+
+    // interleaved u and v start at the lower of the two pointers
+    const unsigned char* uvp = std::min(up, vp);
+    const bool v_first = vp < up;
+
+    for (; x+7<w; x+=8)
+    {
+        __m128i _uu;
+        __m128i _vv;
+        if (uvstep == 2)
+        {
+            __m128i _uv = _mm_loadu_si128((const __m128i*)(uvp + x * 2));
+            __m128i _even = _mm_and_si128(_uv, _mask);
+            __m128i _odd = _mm_srli_epi16(_uv, 8);
+            _uu = v_first ? _odd : _even;
+            _vv = v_first ? _even : _odd;
+        }
+        else
+        {
+            _uu = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(up + x)), _zero);
+            _vv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(vp + x)), _zero);
+        }
+
+        _uu = _mm_sub_epi16(_uu, _v128);
+        _vv = _mm_sub_epi16(_vv, _v128);
+
+        // at most 255 * 64 + 113 * 127, fits in short
+        __m128i _yy = _mm_slli_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(yp + x)), _zero), 6);
+
+        __m128i _rgb[3];
+        _rgb[0] = _mm_add_epi16(_yy, _mm_mullo_epi16(_vv, _v90));
+        _rgb[1] = _mm_add_epi16(_yy, _mm_add_epi16(_mm_mullo_epi16(_vv, _vn46), _mm_mullo_epi16(_uu, _vn22)));
+        _rgb[2] = _mm_add_epi16(_yy, _mm_mullo_epi16(_uu, _v113));
+
+        for (int k=0; k<3; k++)
+        {
+            __m128i _p = _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(_rgb[k], 6), _zero), _v255);
+
+            _mm_storeu_ps(ptrs[k] + x, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_p, _zero)), _norm[k]), _bias[k]));
+            _mm_storeu_ps(ptrs[k] + x + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(_p, _zero)), _norm[k]), _bias[k]));
+        }
+    }
+#endif // __SSE2__
+
+#define SATURATE_CAST_UCHAR(X) (unsigned char)::std::min(::std::max((int)(X), 0), 255);
+    for (; x<w; x++)
+    {
+        // same fixed point coefficients as yuv420sp2rgb
+        int u = up[x * uvstep] - 128;
+        int v = vp[x * uvstep] - 128;
+
+        int yy = yp[x] << 6;
+
+        unsigned char r = SATURATE_CAST_UCHAR((yy + 90 * v) >> 6);
+        unsigned char g = SATURATE_CAST_UCHAR((yy - 46 * v - 22 * u) >> 6);
+        unsigned char b = SATURATE_CAST_UCHAR((yy + 113 * u) >> 6);
+
+        rptr[x] = r * norm[0] + bias[0];
+        gptr[x] = g * norm[1] + bias[1];
+        bptr[x] = b * norm[2] + bias[2];
+    }
+#undef SATURATE_CAST_UCHAR
+}
+
+Mat Mat::from_yuv420_resize_normalize(const unsigned char* yuv, int yuv_type, int w, int h, int type, int target_width, int target_height, const float* mean_vals, const float* norm_vals, Allocator* allocator, int num_threads)
+{
+    if (yuv_type != YUV420SP_NV21 && yuv_type != YUV420SP_NV12 && yuv_type != YUV420P_I420)
+        return Mat();
+
+    if (type != PIXEL_RGB && type != PIXEL_BGR && type != PIXEL_GRAY)
+        return Mat();
+
+    // the chroma planes are w/2 x h/2, bilinear resize needs two samples each way
+    if (w % 2 != 0 || h % 2 != 0 || w < 4 || h < 4)
+        return Mat();
+
+    const int outc = type == PIXEL_GRAY ? 1 : 3;
+
+    Mat m(target_width, target_height, outc, 4u, allocator);
+    if (m.empty())
+        return m;
+
+    // norm and bias in r g b order
+    int chan[4] = { 0, 1, 2, 3 };
+    if (type == PIXEL_BGR)
+    {
+        chan[0] = 2;
+        chan[2] = 0;
+    }
+
+    float norm[3];
+    float bias[3];
+    for (int k=0; k<outc; k++)
+    {
+        norm[k] = norm_vals ? norm_vals[chan[k]] : 1.f;
+        bias[k] = mean_vals ? -mean_vals[chan[k]] * norm[k] : 0.f;
+    }
+
+    const int uvw = w / 2;
+    const int uvh = h / 2;
+    const int uvcn = yuv_type == YUV420P_I420 ? 1 : 2;
+
+    const unsigned char* srcY = yuv;
+    const unsigned char* srcUV = yuv + w * h;
+
+    const bool resize_y = w != target_width || h != target_height;
+
+    // luma and chroma coefficients
+    int* buf = new int[(target_width + target_height + target_width + target_height) * 2];
+
+    int* xofs = buf;
+    int* yofs = buf + target_width;
+    short* ialpha = (short*)(buf + target_width + target_height);
+    short* ibeta = (short*)(buf + target_width + target_height + target_width);
+
+    int* uvbuf = buf + target_width + target_height + target_width + target_height;
+    int* uvxofs = uvbuf;
+    int* uvyofs = uvbuf + target_width;
+    short* uvialpha = (short*)(uvbuf + target_width + target_height);
+    short* uvibeta = (short*)(uvbuf + target_width + target_height + target_width);
+
+    if (resize_y)
+        resize_bilinear_coeffs(w, h, target_width, target_height, 1, xofs, yofs, ialpha, ibeta);
+
+    if (outc == 3)
+        resize_bilinear_coeffs(uvw, uvh, target_width, target_height, uvcn, uvxofs, uvyofs, uvialpha, uvibeta);
+
+    // resized rows go through small strip buffers that stay in cache
+    const int strip_rows = 16;
+
+    int nbands = std::max(std::min(num_threads, target_height), 1);
+
+    #pragma omp parallel for num_threads(num_threads)
+    for (int b=0; b<nbands; b++)
+    {
+        int dy_start = target_height * b / nbands;
+        int dy_end = target_height * (b + 1) / nbands;
+
+        Mat ystrip;
+        if (resize_y)
+            ystrip.create(target_width, strip_rows, (size_t)1u);
+
+        // u and v of each output row, interleaved as in the source for yuv420sp, u then v planes for i420
+        Mat uvstrip;
+        if (outc == 3)
+            uvstrip.create(target_width * 2, strip_rows, (size_t)1u);
+
+        for (int dy0 = dy_start; dy0 < dy_end; dy0 += strip_rows)
+        {
+            int dy1 = std::min(dy0 + strip_rows, dy_end);
+
+            const unsigned char* yrows = srcY + w * dy0;
+            int ystride = w;
+            if (resize_y)
+            {
+                resize_bilinear_c1_rows(srcY, w, ystrip, target_width, target_width, xofs, yofs, ialpha, ibeta, dy0, dy1);
+
+                yrows = ystrip;
+                ystride = target_width;
+            }
+
+            if (outc == 3)
+            {
+                if (uvcn == 2)
+                {
+                    resize_bilinear_c2_rows(srcUV, uvw * 2, uvstrip, target_width, target_width * 2, uvxofs, uvyofs, uvialpha, uvibeta, dy0, dy1);
+                }
+                else
+                {
+                    const unsigned char* srcU = srcUV;
+                    const unsigned char* srcV = srcUV + uvw * uvh;
+
+                    resize_bilinear_c1_rows(srcU, uvw, uvstrip, target_width, target_width * 2, uvxofs, uvyofs, uvialpha, uvibeta, dy0, dy1);
+                    resize_bilinear_c1_rows(srcV, uvw, (unsigned char*)uvstrip + target_width, target_width, target_width * 2, uvxofs, uvyofs, uvialpha, uvibeta, dy0, dy1);
+                }
+            }
+
+            for (int dy = dy0; dy < dy1; dy++)
+            {
+                const unsigned char* yp = yrows + ystride * (dy - dy0);
+
+                if (outc == 1)
+                {
+                    float* outptr = m.channel(0).row(dy);
+                    from_pixels_row_normalize(yp, 1, target_width, chan, 1, &outptr, 1, norm, bias);
+                    continue;
+                }
+
+                float* outptr[3];
+                for (int k=0; k<3; k++)
+                {
+                    outptr[k] = m.channel(chan[k]).row(dy);
+                }
+
+                const unsigned char* uvrow = (const unsigned char*)uvstrip + target_width * 2 * (dy - dy0);
+
+                if (yuv_type == YUV420SP_NV21)
+                    yuv420_row_normalize(yp, uvrow + 1, uvrow, 2, target_width, outptr, norm, bias);
+                if (yuv_type == YUV420SP_NV12)
+                    yuv420_row_normalize(yp, uvrow, uvrow + 1, 2, target_width, outptr, norm, bias);
+                if (yuv_type == YUV420P_I420)
+                    yuv420_row_normalize(yp, uvrow, uvrow + target_width, 1, target_width, outptr, norm, bias);
+            }
+        }
+    }
+
+    delete[] buf;
+
+    return m;
 }
 #endif // NCNN_PIXEL
 
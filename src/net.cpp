@@ -19,6 +19,7 @@
 #include "convolution.h"
 #include "convolutiondepthwise.h"
 #include "relu.h"
+#include "cpu.h"
 
 #include <stdarg.h>
 #include <stdio.h>
@@ -163,6 +164,9 @@ int Net::load_param(FILE* fp)
     }
 #endif // NCNN_VULKAN
 
+    // fp16 blob storage converts with f16c
+    if (!NCNN_F16C || !cpu_support_x86_f16c()) opt.use_blob_fp16_storage = false;
+
     ParamDict pd;
 
     int blob_index = 0;
@@ -334,6 +338,9 @@ int Net::load_param_mem(const char* _mem)
     }
 #endif // NCNN_VULKAN
 
+    // fp16 blob storage converts with f16c
+    if (!NCNN_F16C || !cpu_support_x86_f16c()) opt.use_blob_fp16_storage = false;
+
     ParamDict pd;
 
     int blob_index = 0;
@@ -509,6 +516,9 @@ int Net::load_param_bin(FILE* fp)
     }
 #endif // NCNN_VULKAN
 
+    // fp16 blob storage converts with f16c
+    if (!NCNN_F16C || !cpu_support_x86_f16c()) opt.use_blob_fp16_storage = false;
+
     ParamDict pd;
 
     for (int i=0; i<layer_count; i++)
@@ -729,6 +739,9 @@ int Net::load_param(const unsigned char* _mem)
     }
 #endif // NCNN_VULKAN
 
+    // fp16 blob storage converts with f16c
+    if (!NCNN_F16C || !cpu_support_x86_f16c()) opt.use_blob_fp16_storage = false;
+
     ParamDict pd;
 
     for (int i=0; i<layer_count; i++)
@@ -870,6 +883,67 @@ int Net::load_model(const unsigned char* _mem)
 
 int Net::fuse_network()
 {
+    // run depthwise blocks in the 1x1 projection convolution
+    // expand and depthwise layers stay in the graph for extracting the intermediate blobs
+    if (opt.use_depthwise_pointwise_fusion && !opt.use_vulkan_compute)
+    {
+        // projections already running a block can not be the expand of another one
+        std::vector<int> fused(layers.size(), 0);
+
+        for (size_t i=0; i<layers.size(); i++)
+        {
+            if (layers[i]->typeindex != LayerType::ConvolutionDepthWise)
+                continue;
+
+            ConvolutionDepthWise* depthwise = (ConvolutionDepthWise*)layers[i];
+            if (depthwise->bottoms.size() != 1 || depthwise->tops.size() != 1)
+                continue;
+
+            // the depthwise output feeds only the projection
+            Blob& depthwise_top_blob = blobs[depthwise->tops[0]];
+            if (depthwise_top_blob.consumers.size() != 1)
+                continue;
+
+            int project_index = depthwise_top_blob.consumers[0];
+            if (layers[project_index]->typeindex != LayerType::Convolution)
+                continue;
+
+            Convolution* project = (Convolution*)layers[project_index];
+
+            // the expand output feeds only the depthwise
+            Convolution* expand = 0;
+            const Blob& depthwise_bottom_blob = blobs[depthwise->bottoms[0]];
+            if (depthwise_bottom_blob.producer != -1 && depthwise_bottom_blob.consumers.size() == 1
+                && layers[depthwise_bottom_blob.producer]->typeindex == LayerType::Convolution && !fused[depthwise_bottom_blob.producer])
+            {
+                expand = (Convolution*)layers[depthwise_bottom_blob.producer];
+                if (expand->bottoms.size() != 1)
+                    expand = 0;
+            }
+
+            int bottom_blob_index = -1;
+            if (expand && project->create_depthwise_fusion(depthwise, expand, opt) == 0)
+            {
+                bottom_blob_index = expand->bottoms[0];
+            }
+            else if (project->create_depthwise_fusion(depthwise, 0, opt) == 0)
+            {
+                bottom_blob_index = depthwise->bottoms[0];
+            }
+            else
+            {
+                continue;
+            }
+
+            // rewire the projection to the block input
+            depthwise_top_blob.consumers.clear();
+            blobs[bottom_blob_index].consumers.push_back(project_index);
+            project->bottoms[0] = bottom_blob_index;
+
+            fused[project_index] = 1;
+        }
+    }
+
     // set the int8 op fusion:requantize
 #if NCNN_STRING && NCNN_REQUANT    
     // fprintf(stderr, "Test op fusion to int8 implement:\n");
@@ -1263,6 +1337,38 @@ Layer* Net::create_custom_layer(int index)
     return layer_creator();
 }
 
+// fp16 blob storage, the input of a layer without fp16 storage support is converted back to fp32
+static int blob_fp16_storage_load(const Layer* layer, Mat& bottom_blob, const Option& opt)
+{
+    if (!opt.use_blob_fp16_storage || layer->support_fp16_storage || bottom_blob.elemsize != 2u)
+        return 0;
+
+    Mat bottom_blob_fp32;
+    cast_float16_to_float32(bottom_blob, bottom_blob_fp32, opt.workspace_allocator, opt.num_threads);
+    if (bottom_blob_fp32.empty())
+        return -100;
+
+    bottom_blob = bottom_blob_fp32;
+
+    return 0;
+}
+
+// fp16 blob storage, the fp32 output of a layer is stored in fp16
+static int blob_fp16_storage_store(Mat& top_blob, const Option& opt)
+{
+    if (!opt.use_blob_fp16_storage || top_blob.elemsize != 4u || top_blob.elempack != 1)
+        return 0;
+
+    Mat top_blob_fp16;
+    cast_float32_to_float16(top_blob, top_blob_fp16, opt.blob_allocator, opt.num_threads);
+    if (top_blob_fp16.empty())
+        return -100;
+
+    top_blob = top_blob_fp16;
+
+    return 0;
+}
+
 int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt) const
 {
     const Layer* layer = layers[layer_index];
@@ -1284,6 +1390,9 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
 
         Mat bottom_blob = blob_mats[bottom_blob_index];
 
+        if (blob_fp16_storage_load(layer, bottom_blob, opt) != 0)
+            return -100;
+
         if (opt.lightmode)
         {
             // delete after taken in light mode
@@ -1310,6 +1419,9 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
             if (ret != 0)
                 return ret;
 
+            if (blob_fp16_storage_store(bottom_top_blob, opt) != 0)
+                return -100;
+
             // store top blob
             blob_mats[top_blob_index] = bottom_top_blob;
         }
@@ -1327,6 +1439,9 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
             if (ret != 0)
                 return ret;
 
+            if (blob_fp16_storage_store(top_blob, opt) != 0)
+                return -100;
+
             // store top blob
             blob_mats[top_blob_index] = top_blob;
         }
@@ -1349,6 +1464,9 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
 
             bottom_blobs[i] = blob_mats[bottom_blob_index];
 
+            if (blob_fp16_storage_load(layer, bottom_blobs[i], opt) != 0)
+                return -100;
+
             if (opt.lightmode)
             {
                 // delete after taken in light mode
@@ -1381,6 +1499,9 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
             {
                 int top_blob_index = layer->tops[i];
 
+                if (blob_fp16_storage_store(bottom_top_blobs[i], opt) != 0)
+                    return -100;
+
                 blob_mats[top_blob_index] = bottom_top_blobs[i];
             }
         }
@@ -1403,6 +1524,9 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
             {
                 int top_blob_index = layer->tops[i];
 
+                if (blob_fp16_storage_store(top_blobs[i], opt) != 0)
+                    return -100;
+
                 blob_mats[top_blob_index] = top_blobs[i];
             }
         }
@@ -2205,6 +2329,12 @@ int Extractor::extract(int blob_index, Mat& feat)
 
     feat = blob_mats[blob_index];
 
+    // the extracted blob is always fp32
+    if (opt.use_blob_fp16_storage && feat.elemsize == 2u)
+    {
+        cast_float16_to_float32(blob_mats[blob_index], feat, opt.blob_allocator, opt.num_threads);
+    }
+
     return ret;
 }
 
@@ -31,7 +31,13 @@ Option::Option()
 #endif // NCNN_VULKAN
 
     use_winograd_convolution = true;
+    winograd_tile_size = 0;
     use_sgemm_convolution = true;
+    use_depthwise_pointwise_fusion = true;
+    use_autotune = false;
+    use_sparse_weight = true;
+    use_weight_fp16_storage = false;
+    use_blob_fp16_storage = false;
     use_int8_inference = true;
     use_vulkan_compute = false;// TODO enable me
 
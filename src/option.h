@@ -63,12 +63,54 @@ public:
     // enabled by default
     bool use_winograd_convolution;
 
+    // tiles per group of the cache tiled winograd convolution
+    // the tiles of a group are transformed, multiplied and transformed back in cache
+    // 0 = choose from the channel count, negative = the whole feature map at once
+    // default value is 0
+    int winograd_tile_size;
+
     // enable sgemm convolution optimization
     // improve convolution 1x1 stride1 performace, may consume more memory
     // changes should be applied before loading network structure and weight
     // enabled by default
     bool use_sgemm_convolution;
 
+    // run depthwise convolution blocks as one layer
+    // the 1x1 expand, depthwise and 1x1 projection convolutions are computed band by band
+    // without materializing the full intermediate feature maps
+    // changes should be applied before loading network weight
+    // enabled by default
+    bool use_depthwise_pointwise_fusion;
+
+    // time the candidate implementations of a layer on the first forward
+    // of each input shape and use the fastest one from then on
+    // the choices can be saved and loaded across runs, see autotune.h
+    // changes should be applied before loading network structure and weight
+    // disabled by default
+    bool use_autotune;
+
+    // run pruned convolution 1x1 and innerproduct with blocked sparse weight
+    // the weight sparsity is detected when creating pipeline,
+    // the dense kernels are kept if too few weights are zero
+    // changes should be applied before loading network structure and weight
+    // enabled by default
+    bool use_sparse_weight;
+
+    // keep innerproduct weight in fp16 and convert it on the fly with f16c on x86
+    // halves the weight memory and bandwidth of large fully connected layers
+    // changes should be applied before loading network structure and weight
+    // disabled by default
+    bool use_weight_fp16_storage;
+
+    // store the intermediate blobs between layers in fp16 on x86 with f16c
+    // this only halves the footprint of the stored blobs, not the bandwidth,
+    // only split and the elementwise activations take fp16 input directly,
+    // every other layer gets its input converted back to fp32 and its output converted to fp16
+    // the extracted blobs are always fp32
+    // changes should be applied before loading network structure and weight
+    // disabled by default
+    bool use_blob_fp16_storage;
+
     // enable quantized int8 inference
     // use low-precision int8 path for quantized model
     // changes should be applied before loading network structure and weight